@@ -0,0 +1,188 @@
+#ifndef IOT_CORE_BENCH_BENCHMARK_H_
+#define IOT_CORE_BENCH_BENCHMARK_H_
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../src/iot_core/Allocations.h"
+
+/**
+ * Minimal micro-benchmark harness for the host build.
+ *
+ * Each benchmark does its setup and then loops while state.running(), the
+ * harness measures the loop and the number of heap allocations within it.
+ * Results are written as JSON lines, which can be stored and given back as
+ * baseline to detect regressions.
+ */
+namespace bench {
+
+template<typename T>
+inline void doNotOptimize(T const& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobberMemory() {
+  asm volatile("" : : : "memory");
+}
+
+class State final {
+  using Clock = std::chrono::steady_clock;
+
+  std::chrono::nanoseconds _minTime;
+  uint64_t _iterations = 0u;
+  uint64_t _nextCheck = 1u;
+  uint32_t _allocations = 0u;
+  uint64_t _bytes = 0u;
+  Clock::time_point _start {};
+  Clock::duration _elapsed {};
+  bool _started = false;
+
+public:
+  explicit State(std::chrono::nanoseconds minTime) : _minTime(minTime) {}
+
+  bool running() {
+    if (!_started) {
+      _started = true;
+      _allocations = iot_core::AllocationTracker::count();
+      _start = Clock::now();
+      return true;
+    }
+    _iterations += 1u;
+    if (_iterations < _nextCheck) {
+      return true;
+    }
+    _elapsed = Clock::now() - _start;
+    if (_elapsed < _minTime) {
+      _nextCheck = _iterations * 2u;
+      return true;
+    }
+    _allocations = iot_core::AllocationTracker::count() - _allocations;
+    return false;
+  }
+
+  /**
+   * Sets the total number of bytes produced by all iterations, to report the
+   * bytes per op (e.g. the size of an encoded payload).
+   */
+  void setBytes(uint64_t bytes) { _bytes = bytes; }
+
+  uint64_t iterations() const { return _iterations; }
+  double nsPerOp() const { return _iterations == 0u ? 0.0 : double(std::chrono::duration_cast<std::chrono::nanoseconds>(_elapsed).count()) / _iterations; }
+  double allocsPerOp() const { return _iterations == 0u ? 0.0 : double(_allocations) / _iterations; }
+  double bytesPerOp() const { return _iterations == 0u ? 0.0 : double(_bytes) / _iterations; }
+};
+
+struct Result final {
+  double nsPerOp = 0.0;
+  double allocsPerOp = 0.0;
+};
+
+class Suite final {
+  const char* _name;
+  std::vector<std::pair<std::string, std::function<void(State&)>>> _benchmarks {};
+
+public:
+  explicit Suite(const char* name) : _name(name) {}
+
+  Suite& add(const char* name, std::function<void(State&)> benchmark) {
+    _benchmarks.emplace_back(std::string(_name) + "/" + name, benchmark);
+    return *this;
+  }
+
+  const std::vector<std::pair<std::string, std::function<void(State&)>>>& benchmarks() const { return _benchmarks; }
+};
+
+inline std::vector<Suite*>& suites() {
+  static std::vector<Suite*> suites {};
+  return suites;
+}
+
+inline Suite& suite(const char* name) {
+  suites().push_back(new Suite {name});
+  return *suites().back();
+}
+
+/**
+ * Reads results in the output format of run(), lines which cannot be parsed
+ * are skipped.
+ */
+inline std::map<std::string, Result> readResults(FILE* file) {
+  std::map<std::string, Result> results {};
+  char line[512];
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    char name[256];
+    Result result {};
+    if (sscanf(line, "{\"benchmark\":\"%255[^\"]\",\"iterations\":%*u,\"ns_per_op\":%lf,\"allocs_per_op\":%lf", name, &result.nsPerOp, &result.allocsPerOp) == 3) {
+      results[name] = result;
+    }
+  }
+  return results;
+}
+
+struct Options final {
+  const char* filter = nullptr;
+  const char* baseline = nullptr;
+  double thresholdPercent = 10.0;
+  std::chrono::milliseconds minTime {200};
+};
+
+/**
+ * Runs all benchmarks matching the filter and writes one JSON line per
+ * benchmark to stdout. If a baseline is given, the relative change is added
+ * and a regression is reported if ns/op got worse by more than the threshold
+ * or more allocations per op are made.
+ *
+ * Returns the number of regressions.
+ */
+inline int run(const Options& options) {
+  std::map<std::string, Result> baseline {};
+  if (options.baseline != nullptr) {
+    FILE* file = fopen(options.baseline, "r");
+    if (file == nullptr) {
+      fprintf(stderr, "Cannot read baseline '%s'.\n", options.baseline);
+      return -1;
+    }
+    baseline = readResults(file);
+    fclose(file);
+  }
+
+  int regressions = 0;
+  for (auto suite : suites()) {
+    for (auto& [name, benchmark] : suite->benchmarks()) {
+      if (options.filter != nullptr && name.find(options.filter) == std::string::npos) {
+        continue;
+      }
+
+      State state {options.minTime};
+      benchmark(state);
+
+      printf("{\"benchmark\":\"%s\",\"iterations\":%llu,\"ns_per_op\":%.3f,\"allocs_per_op\":%.3f", name.c_str(), (unsigned long long)state.iterations(), state.nsPerOp(), state.allocsPerOp());
+      if (state.bytesPerOp() > 0.0) {
+        printf(",\"bytes_per_op\":%.1f", state.bytesPerOp());
+      }
+      auto base = baseline.find(name);
+      if (base != baseline.end()) {
+        double change = base->second.nsPerOp > 0.0 ? (state.nsPerOp() / base->second.nsPerOp - 1.0) * 100.0 : 0.0;
+        bool regression = change > options.thresholdPercent || state.allocsPerOp() > base->second.allocsPerOp + 0.001;
+        printf(",\"baseline_ns_per_op\":%.3f,\"baseline_allocs_per_op\":%.3f,\"change_percent\":%.1f,\"regression\":%s", base->second.nsPerOp, base->second.allocsPerOp, change, regression ? "true" : "false");
+        if (regression) {
+          regressions += 1;
+          fprintf(stderr, "REGRESSION: %s %.3f -> %.3f ns/op, %.3f -> %.3f allocs/op\n", name.c_str(), base->second.nsPerOp, state.nsPerOp(), base->second.allocsPerOp, state.allocsPerOp());
+        }
+      }
+      printf("}\n");
+      fflush(stdout);
+    }
+  }
+  return regressions;
+}
+
+}
+
+#endif
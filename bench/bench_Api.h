@@ -0,0 +1,184 @@
+#include "Benchmark.h"
+
+#include <memory>
+#include <string>
+
+#include "../src/iot_core/System.h"
+#include "../src/iot_core/api/CborDiagnosticsCollector.h"
+#include "../src/iot_core/api/ChunkedResponse.h"
+#include "../src/iot_core/api/CsvDiagnosticsCollector.h"
+#include "../src/iot_core/api/Deflate.h"
+#include "../src/iot_core/api/JsonDiagnosticsCollector.h"
+#include "../src/iot_core/api/Router.h"
+#include "../src/iot_core/api/Server.h"
+
+namespace {
+  /**
+   * Server which discards the response content, to only measure the
+   * buffering.
+   */
+  struct NullServer {
+    size_t sent = 0u;
+
+    bool chunkedResponseModeStart(int, const char*) { return true; }
+    bool chunkedResponseModeStart(int, const __FlashStringHelper*) { return true; }
+    void sendContent(const char* content, size_t size) { sent += size; bench::doNotOptimize(content); }
+    void chunkedResponseFinalize() {}
+    void send(int, const char*, const char*, size_t) {}
+    void send_P(int, PGM_P, PGM_P, size_t) {}
+  };
+
+  template<size_t BUFFER_SIZE>
+  void writeTokens(bench::State& state) {
+    NullServer server;
+    iot_core::api::ChunkedResponse<NullServer, BUFFER_SIZE> response {server};
+    response.begin(200, F("application/json"));
+    while (state.running()) {
+      response.write('"');
+      response.write(F("someProperty"));
+      response.write("\":\"");
+      response.write("some value");
+      response.write('"');
+      response.write(',');
+    }
+    response.end();
+    bench::doNotOptimize(server.sent);
+  }
+
+  /**
+   * Writes payloads of the given size, which are written through the buffer
+   * if they are at least as large as the buffer.
+   */
+  template<size_t BUFFER_SIZE, size_t PAYLOAD_SIZE>
+  void writePayloads(bench::State& state) {
+    NullServer server;
+    std::string payload(PAYLOAD_SIZE, 'x');
+    iot_core::api::ChunkedResponse<NullServer, BUFFER_SIZE> response {server};
+    response.begin(200, F("application/octet-stream"));
+    while (state.running()) {
+      response.write(toolbox::strref(payload.c_str(), payload.size()));
+    }
+    response.end();
+    bench::doNotOptimize(server.sent);
+  }
+
+  /**
+   * System with a few components, to get diagnostics of realistic size.
+   */
+  struct SystemFixture {
+    host::TemporaryFileSystem fileSystem;
+    gpiobj::DigitalOutput statusLed {2u, false};
+    gpiobj::DigitalInput otaEnable {false};
+    gpiobj::DigitalInput update {false};
+    gpiobj::DigitalInput factoryReset {false};
+    gpiobj::DigitalInput debugEnable {false};
+    iot_core::VersionInfo version {"0000000", "0.0.0"};
+
+    iot_core::System system {"bench", version, "", statusLed, otaEnable, update, factoryReset, debugEnable};
+    iot_core::api::Server server {system, host::freeLocalPort()};
+
+    SystemFixture() {
+      system.addComponent(&server);
+      system.setup();
+      for (int i = 0; i < 100; ++i) {
+        host::advanceTimeUs(250u);
+        system.loop();
+      }
+    }
+  };
+
+  static const bench::Suite& BenchChunkedResponse =
+  bench::suite("ChunkedResponse::write")
+    .add("json tokens 64 bytes buffer", writeTokens<64u>)
+    .add("json tokens 512 bytes buffer", writeTokens<512u>)
+    .add("json tokens 1460 bytes buffer", writeTokens<1460u>)
+    .add("json tokens MSS buffer", writeTokens<iot_core::api::DEFAULT_CHUNK_SIZE>)
+    .add("payload 400 bytes MSS buffer", writePayloads<iot_core::api::DEFAULT_CHUNK_SIZE, 400u>)
+    .add("payload 4096 bytes 512 bytes buffer", writePayloads<512u, 4096u>)
+    .add("payload 4096 bytes MSS buffer", writePayloads<iot_core::api::DEFAULT_CHUNK_SIZE, 4096u>);
+
+  static const bench::Suite& BenchDeflate =
+  bench::suite("DeflateEncoder::write")
+    .add("json tokens gzip", [] (bench::State& state) {
+      NullServer server;
+      auto encoder = std::make_unique<iot_core::api::DeflateEncoder>();
+      iot_core::api::ChunkedResponse<NullServer, 512u> response {server};
+      response.begin(200, F("application/json"), encoder.get(), iot_core::api::ContentEncoding::Gzip);
+      while (state.running()) {
+        response.write('"');
+        response.write(F("someProperty"));
+        response.write("\":\"");
+        response.write("some value");
+        response.write('"');
+        response.write(',');
+      }
+      response.end();
+      bench::doNotOptimize(server.sent);
+    });
+
+  static const bench::Suite& BenchRouter =
+  bench::suite("Router::match")
+    .add("capture among system routes", [] (bench::State& state) {
+      iot_core::api::Router router;
+      auto noop = [] (iot_core::api::IRequest&, iot_core::api::IResponse&) {};
+      for (auto path : {"/api/system/reset", "/api/system/factory-reset", "/api/system/stop", "/api/system/status", "/api/system/logs", "/api/system/components", "/api/system/components/{}", "/api/system/log-level", "/api/system/config", "/api/system/config/{}"}) {
+        router.on(path, iot_core::api::methodMask(iot_core::api::HttpMethod::GET), noop);
+      }
+      router.on("/api/system/components/{}/log-level", iot_core::api::methodMask(iot_core::api::HttpMethod::PUT), noop);
+      iot_core::api::RouteMatch match;
+      while (state.running()) {
+        router.match(iot_core::api::methodMask(iot_core::api::HttpMethod::PUT), "/api/system/components/api/log-level", match);
+      }
+      bench::doNotOptimize(match);
+    });
+
+  static const bench::Suite& BenchJsonDiagnosticsCollector =
+  bench::suite("JsonDiagnosticsCollector")
+    .add("system diagnostics", [] (bench::State& state) {
+      SystemFixture fixture;
+      NullServer server;
+      while (state.running()) {
+        iot_core::api::ChunkedResponse<NullServer> response {server};
+        response.begin(200, F("application/json"));
+        auto writer = jsons::makeWriter(response);
+        iot_core::api::JsonDiagnosticsCollector collector {writer};
+        fixture.system.getDiagnostics(collector);
+        writer.end();
+        response.end();
+      }
+      bench::doNotOptimize(server.sent);
+      state.setBytes(server.sent);
+    });
+
+  static const bench::Suite& BenchDiagnosticsFormats =
+  bench::suite("DiagnosticsFormats")
+    .add("system diagnostics cbor", [] (bench::State& state) {
+      SystemFixture fixture;
+      NullServer server;
+      while (state.running()) {
+        iot_core::api::ChunkedResponse<NullServer> response {server};
+        response.begin(200, F("application/cbor"));
+        iot_core::api::CborWriter writer {response};
+        iot_core::api::CborDiagnosticsCollector collector {writer};
+        fixture.system.getDiagnostics(collector);
+        collector.end();
+        response.end();
+      }
+      bench::doNotOptimize(server.sent);
+      state.setBytes(server.sent);
+    })
+    .add("system diagnostics csv", [] (bench::State& state) {
+      SystemFixture fixture;
+      NullServer server;
+      while (state.running()) {
+        iot_core::api::ChunkedResponse<NullServer> response {server};
+        response.begin(200, F("text/csv"));
+        iot_core::api::CsvDiagnosticsCollector::header(response);
+        iot_core::api::CsvDiagnosticsCollector collector {response};
+        fixture.system.getDiagnostics(collector);
+        response.end();
+      }
+      bench::doNotOptimize(server.sent);
+      state.setBytes(server.sent);
+    });
+}
@@ -0,0 +1,75 @@
+#include "Benchmark.h"
+
+#include "../src/iot_core/Logger.h"
+#include "../src/iot_core/LogSinks.h"
+
+namespace {
+  /**
+   * Log service with an in-memory sink, like in System, but without the UDP
+   * sink to not measure the network stand-in.
+   */
+  struct LogFixture {
+    iot_core::Time time {};
+    iot_core::LogService service {time};
+    iot_core::InMemoryLogSink sink {};
+    iot_core::Logger logger = service.logger(F("bench"));
+
+    LogFixture() {
+      service.addLogSink(sink);
+    }
+  };
+
+  static const bench::Suite& BenchLogger =
+  bench::suite("LogService::log")
+    .add("filtered by category level", [] (bench::State& state) {
+      LogFixture fixture;
+      while (state.running()) {
+        fixture.logger.log(iot_core::LogLevel::Debug, F("not logged"));
+      }
+    })
+    .add("message function filtered by category level", [] (bench::State& state) {
+      LogFixture fixture;
+      while (state.running()) {
+        fixture.logger.log(iot_core::LogLevel::Debug, [] () { return toolbox::format(F("not logged %u"), 42u); });
+      }
+    })
+    .add("filtered by sink level", [] (bench::State& state) {
+      LogFixture fixture;
+      fixture.sink.logLevel(iot_core::LogLevel::Error);
+      while (state.running()) {
+        fixture.logger.log(iot_core::LogLevel::Info, F("not logged"));
+      }
+    })
+    .add("logged", [] (bench::State& state) {
+      LogFixture fixture;
+      while (state.running()) {
+        fixture.logger.log(iot_core::LogLevel::Info, F("Some message of typical length for the log."));
+      }
+    })
+    .add("logged formatted", [] (bench::State& state) {
+      LogFixture fixture;
+      while (state.running()) {
+        fixture.logger.log(iot_core::LogLevel::Info, toolbox::format(F("Reconnected after %u ms."), 1234u));
+      }
+    });
+
+  static const bench::Suite& BenchInMemoryLogSink =
+  bench::suite("InMemoryLogSink")
+    .add("commitLogEntry", [] (bench::State& state) {
+      iot_core::InMemoryLogSink sink;
+      while (state.running()) {
+        sink.commitLogEntry("[0e0w0d01h02m03s456|bench|INF] Some message of typical length for the log.\n");
+      }
+    })
+    .add("output full buffer", [] (bench::State& state) {
+      iot_core::InMemoryLogSink sink;
+      for (int i = 0; i < 100; ++i) {
+        sink.commitLogEntry("[0e0w0d01h02m03s456|bench|INF] Some message of typical length for the log.\n");
+      }
+      size_t entries = 0u;
+      while (state.running()) {
+        sink.output([&] (const char* entry) { entries += 1u; bench::doNotOptimize(entry); });
+      }
+      bench::doNotOptimize(entries);
+    });
+}
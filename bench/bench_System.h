@@ -0,0 +1,58 @@
+#include "Benchmark.h"
+
+#include "../src/iot_core/System.h"
+
+namespace {
+  template<int ID>
+  class LoopComponent final : public iot_core::IApplicationComponent {
+  public:
+    uint32_t loops = 0u;
+
+    toolbox::strref name() const override {
+      static const char* const NAMES[] = {"c0", "c1", "c2", "c3"};
+      return NAMES[ID];
+    }
+    bool configure(const toolbox::strref&, const toolbox::strref&) override { return false; }
+    void getConfig(iot_core::ConfigWriter) const override {}
+    void setup(bool) override {}
+    void loop(iot_core::ConnectionStatus) override { loops += 1u; }
+    void getDiagnostics(iot_core::IDiagnosticsCollector&) const override {}
+  };
+
+  using LoopStaticSystem = iot_core::StaticSystem<LoopComponent<0>, LoopComponent<1>, LoopComponent<2>, LoopComponent<3>>;
+
+  /**
+   * Loops a system with four trivial components, so the time is the overhead
+   * of the system loop and the component dispatch.
+   */
+  template<typename SystemType>
+  void loopSystem(bench::State& state) {
+    host::TemporaryFileSystem fileSystem;
+    gpiobj::DigitalOutput statusLed {2u, false};
+    gpiobj::DigitalInput otaEnable {false};
+    gpiobj::DigitalInput update {false};
+    gpiobj::DigitalInput factoryReset {false};
+    gpiobj::DigitalInput debugEnable {false};
+    iot_core::VersionInfo version {"0000000", "0.0.0"};
+    SystemType system {"bench", version, "", statusLed, otaEnable, update, factoryReset, debugEnable};
+    LoopComponent<0> c0;
+    LoopComponent<1> c1;
+    LoopComponent<2> c2;
+    LoopComponent<3> c3;
+    system.addComponent(&c0);
+    system.addComponent(&c1);
+    system.addComponent(&c2);
+    system.addComponent(&c3);
+    system.setup();
+    WiFi.setStatus(WL_CONNECTED);
+    while (state.running()) {
+      system.loop();
+    }
+    bench::doNotOptimize(c0.loops + c1.loops + c2.loops + c3.loops);
+  }
+
+  static const bench::Suite& BenchSystemLoop =
+  bench::suite("System::loop")
+    .add("4 components dynamic", loopSystem<iot_core::System>)
+    .add("4 components static", loopSystem<LoopStaticSystem>);
+}
@@ -0,0 +1,62 @@
+#include "Benchmark.h"
+
+#include <cstring>
+
+#include "../src/iot_core/Config.h"
+#include "../src/iot_core/DateTime.h"
+#include "../src/iot_core/Utils.h"
+
+namespace {
+  static const bench::Suite& BenchConfigParser =
+  bench::suite("ConfigParser::parse")
+    .add("10 entries", [] (bench::State& state) {
+      char config[] =
+        "interval=1000;\nmode=auto;\nthreshold=42;\nname=living-room;\nenabled=true;\n"
+        "pin=5;\ninverted=false;\ntarget=http://192.168.1.10:8080/api;\nretries=3;\nlogLevel=INF;\n";
+      iot_core::ConfigParser parser {config};
+      size_t length = 0u;
+      while (state.running()) {
+        parser.parse([&] (const toolbox::strref& name, const toolbox::strref& value) {
+          length += name.length() + value.length();
+          return true;
+        });
+      }
+      bench::doNotOptimize(length);
+    });
+
+  static const bench::Suite& BenchFormatTime =
+  bench::suite("formatTime")
+    .add("uptime", [] (bench::State& state) {
+      unsigned long time = 123456789u;
+      while (state.running()) {
+        bench::doNotOptimize(iot_core::formatTime(time++, 1u));
+      }
+    });
+
+  static const bench::Suite& BenchTimingStatistics =
+  bench::suite("TimingStatistics")
+    .add("add", [] (bench::State& state) {
+      iot_core::TimingStatistics<32u> statistics;
+      unsigned long value = 0u;
+      while (state.running()) {
+        statistics.add(value++ % 1000u);
+      }
+      bench::doNotOptimize(statistics);
+    })
+    .add("query all", [] (bench::State& state) {
+      iot_core::TimingStatistics<32u> statistics;
+      for (unsigned long value = 0u; value < 100u; ++value) {
+        statistics.add(value * 7u % 1000u);
+      }
+      while (state.running()) {
+        bench::doNotOptimize(statistics.min());
+        bench::doNotOptimize(statistics.max());
+        bench::doNotOptimize(statistics.avg());
+        bench::doNotOptimize(statistics.count());
+        bench::doNotOptimize(statistics.lifetimeAvg());
+        bench::doNotOptimize(statistics.variance());
+        bench::doNotOptimize(statistics.ewma());
+        bench::clobberMemory();
+      }
+    });
+}
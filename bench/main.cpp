@@ -0,0 +1,38 @@
+#include "Benchmark.h"
+
+#include <cstdlib>
+
+// Include all individual benchmark suites
+#include "bench_Logger.h"
+#include "bench_Utils.h"
+#include "bench_System.h"
+#include "bench_Api.h"
+
+IOT_CORE_ALLOCATION_HOOKS
+
+/**
+ * Usage: iot_core_bench [--filter <text>] [--min-time-ms <ms>]
+ *                       [--baseline <file>] [--threshold <percent>]
+ *
+ * Exits with 1 if a regression compared to the baseline was detected.
+ */
+int main(int argc, char** argv) {
+  bench::Options options {};
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--filter") == 0) {
+      options.filter = argv[i + 1];
+    } else if (strcmp(argv[i], "--min-time-ms") == 0) {
+      options.minTime = std::chrono::milliseconds(atol(argv[i + 1]));
+    } else if (strcmp(argv[i], "--baseline") == 0) {
+      options.baseline = argv[i + 1];
+    } else if (strcmp(argv[i], "--threshold") == 0) {
+      options.thresholdPercent = atof(argv[i + 1]);
+    } else {
+      fprintf(stderr, "Unknown option '%s'.\n", argv[i]);
+      return 2;
+    }
+  }
+
+  int regressions = bench::run(options);
+  return regressions < 0 ? 2 : regressions > 0 ? 1 : 0;
+}
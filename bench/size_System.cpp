@@ -0,0 +1,79 @@
+/**
+ * Program to compare the code size of System and StaticSystem, it is built
+ * twice (with IOT_CORE_SIZE_STATIC 0 and 1) by the iot_core_size target.
+ */
+#include "../src/iot_core/System.h"
+
+#ifndef IOT_CORE_SIZE_STATIC
+#define IOT_CORE_SIZE_STATIC 0
+#endif
+
+namespace {
+  template<int ID>
+  class SizeComponent final : public iot_core::IApplicationComponent {
+    uint32_t _value = 0u;
+
+  public:
+    toolbox::strref name() const override {
+      static const char* const NAMES[] = {"c0", "c1", "c2", "c3"};
+      return NAMES[ID];
+    }
+
+    bool configure(const toolbox::strref& name, const toolbox::strref& value) override {
+      if (name == F("value")) {
+        _value = strtoul(value.toString().c_str(), nullptr, 10);
+        return true;
+      }
+      return false;
+    }
+
+    void getConfig(iot_core::ConfigWriter writer) const override {
+      writer(F("value"), toolbox::convert<uint32_t>::toString(_value, 10));
+    }
+
+    void setup(bool) override {}
+    void loop(iot_core::ConnectionStatus) override { _value += 1u; }
+
+    void getDiagnostics(iot_core::IDiagnosticsCollector& collector) const override {
+      collector.addValue(F("value"), toolbox::convert<uint32_t>::toString(_value, 10));
+    }
+  };
+
+  struct NullCollector final : public iot_core::IDiagnosticsCollector {
+    void beginSection(const toolbox::strref&) override {}
+    void addValue(const toolbox::strref&, const toolbox::strref&) override {}
+    void endSection() override {}
+  };
+
+#if IOT_CORE_SIZE_STATIC
+  using SizeSystem = iot_core::StaticSystem<SizeComponent<0>, SizeComponent<1>, SizeComponent<2>, SizeComponent<3>>;
+#else
+  using SizeSystem = iot_core::System;
+#endif
+}
+
+int main() {
+  gpiobj::DigitalOutput statusLed {2u, false};
+  gpiobj::DigitalInput otaEnable {false};
+  gpiobj::DigitalInput update {false};
+  gpiobj::DigitalInput factoryReset {false};
+  gpiobj::DigitalInput debugEnable {false};
+  iot_core::VersionInfo version {"0000000", "0.0.0"};
+  SizeSystem system {"size", version, "", statusLed, otaEnable, update, factoryReset, debugEnable};
+  SizeComponent<0> c0;
+  SizeComponent<1> c1;
+  SizeComponent<2> c2;
+  SizeComponent<3> c3;
+  system.addComponent(&c0);
+  system.addComponent(&c1);
+  system.addComponent(&c2);
+  system.addComponent(&c3);
+  system.setup();
+  system.loop();
+  char config[] = "c1.value=1;";
+  system.configureAll(iot_core::ConfigParser{config});
+  NullCollector collector;
+  system.getDiagnostics(collector);
+  LittleFS.end();
+  return 0;
+}
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""
+Generates a C++ header with a static asset table (see
+src/iot_core/api/StaticAssets.h) from all files of a directory, e.g.:
+
+  generate_assets.py data/www src/WebAssets.h --namespace web
+
+All content is stored in PROGMEM. Compressible files are gzipped (if that
+makes them smaller) and every asset gets a strong ETag derived from the
+stored content. Files named index.html are also served for their directory.
+
+The table is available as <namespace>::ASSETS with <namespace>::ASSET_COUNT
+entries, to be served via iot_core::api::StaticAssetProvider.
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import sys
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".htm": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".mjs": "application/javascript",
+    ".json": "application/json",
+    ".webmanifest": "application/manifest+json",
+    ".txt": "text/plain",
+    ".csv": "text/csv",
+    ".xml": "application/xml",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+    ".png": "image/png",
+    ".jpg": "image/jpeg",
+    ".jpeg": "image/jpeg",
+    ".gif": "image/gif",
+    ".woff": "font/woff",
+    ".woff2": "font/woff2",
+}
+
+# formats which are compressed already
+UNCOMPRESSIBLE = {".png", ".jpg", ".jpeg", ".gif", ".woff", ".woff2"}
+
+
+def collect(directory):
+    files = []
+    for root, dirs, names in os.walk(directory):
+        dirs.sort()
+        for name in sorted(names):
+            if not name.startswith("."):
+                files.append(os.path.join(root, name))
+    return files
+
+
+def c_string(value):
+    return '"' + value.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def c_bytes(data):
+    lines = []
+    for offset in range(0, len(data), 16):
+        lines.append("  " + ", ".join("0x%02x" % b for b in data[offset:offset + 16]) + ",")
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generates a PROGMEM static asset table.")
+    parser.add_argument("input", help="directory with the assets")
+    parser.add_argument("output", help="header file to generate")
+    parser.add_argument("--namespace", default="assets", help="C++ namespace of the table (default: assets)")
+    parser.add_argument("--prefix", default="/", help="path prefix of the assets (default: /)")
+    parser.add_argument("--no-gzip", action="store_true", help="do not gzip any asset")
+    args = parser.parse_args()
+
+    prefix = "/" + args.prefix.strip("/")
+    prefix = "" if prefix == "/" else prefix
+
+    assets = []
+    for index, file in enumerate(collect(args.input)):
+        relative = os.path.relpath(file, args.input).replace(os.sep, "/")
+        extension = os.path.splitext(file)[1].lower()
+        with open(file, "rb") as f:
+            content = f.read()
+
+        gzipped = False
+        if not args.no_gzip and extension not in UNCOMPRESSIBLE:
+            compressed = gzip.compress(content, compresslevel=9, mtime=0)
+            if len(compressed) < len(content):
+                content = compressed
+                gzipped = True
+
+        paths = [prefix + "/" + relative]
+        if os.path.basename(relative) == "index.html":
+            directory = os.path.dirname(relative)
+            paths.append(prefix + "/" + directory if directory else (prefix or "/"))
+
+        assets.append({
+            "index": index,
+            "paths": paths,
+            "content_type": CONTENT_TYPES.get(extension, "application/octet-stream"),
+            "etag": '"' + hashlib.sha256(content).hexdigest()[:16] + '"',
+            "content": content,
+            "gzipped": gzipped,
+        })
+
+    guard = "ASSETS_" + "".join(c if c.isalnum() else "_" for c in os.path.basename(args.output).upper()) + "_"
+    out = []
+    out.append("// Generated by extras/assets/generate_assets.py, do not edit.")
+    out.append("#ifndef " + guard)
+    out.append("#define " + guard)
+    out.append("")
+    out.append("#include <iot_core/api/StaticAssets.h>")
+    out.append("")
+    out.append("namespace " + args.namespace + " {")
+    out.append("")
+    for asset in assets:
+        i = asset["index"]
+        for n, path in enumerate(asset["paths"]):
+            out.append("static const char ASSET_%d_PATH_%d[] PROGMEM = %s;" % (i, n, c_string(path)))
+        out.append("static const char ASSET_%d_CONTENT_TYPE[] PROGMEM = %s;" % (i, c_string(asset["content_type"])))
+        out.append("static const char ASSET_%d_ETAG[] PROGMEM = %s;" % (i, c_string(asset["etag"])))
+        out.append("static const uint8_t ASSET_%d_CONTENT[] PROGMEM = {" % i)
+        out.append(c_bytes(asset["content"]))
+        out.append("};")
+        out.append("")
+
+    entries = []
+    for asset in assets:
+        i = asset["index"]
+        for n in range(len(asset["paths"])):
+            entries.append("  {ASSET_%d_PATH_%d, ASSET_%d_CONTENT_TYPE, ASSET_%d_ETAG, ASSET_%d_CONTENT, %du, %s}," % (
+                i, n, i, i, i, len(asset["content"]), "true" if asset["gzipped"] else "false"))
+
+    out.append("static const iot_core::api::StaticAsset ASSETS[] PROGMEM = {")
+    out.extend(entries)
+    out.append("};")
+    out.append("")
+    out.append("static constexpr size_t ASSET_COUNT = %du;" % len(entries))
+    out.append("")
+    out.append("}")
+    out.append("")
+    out.append("#endif")
+    out.append("")
+
+    if not entries:
+        print("No assets found in '%s'." % args.input, file=sys.stderr)
+        return 1
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "w", newline="\n") as f:
+        f.write("\n".join(out))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
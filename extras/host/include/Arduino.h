@@ -0,0 +1,185 @@
+#ifndef IOT_CORE_HOST_ARDUINO_H_
+#define IOT_CORE_HOST_ARDUINO_H_
+
+/**
+ * Host stand-in for the Arduino core API (ESP8266 flavor), which allows to
+ * build and run the library as a normal Linux program.
+ *
+ * Time is virtual: millis()/micros() only advance via delay() or the
+ * host::advanceTime*() functions. GPIOs are plain state which can be driven
+ * from the outside via host::setPin().
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+
+#include "pgmspace.h"
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x00
+#define INPUT_PULLUP 0x02
+#define INPUT_PULLDOWN_16 0x04
+#define OUTPUT 0x01
+#define OUTPUT_OPEN_DRAIN 0x03
+
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define ONLOW 0x04
+#define ONHIGH 0x05
+
+#define LED_BUILTIN 2
+#define A0 17
+#define NOT_AN_INTERRUPT -1
+
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+
+#define ADC_TOUT 33
+#define ADC_VCC 255
+#define ADC_MODE(mode) static_assert(true, "ADC_MODE")
+
+namespace host {
+
+static constexpr uint8_t PIN_COUNT = 18u; // GPIO0-16 + A0
+
+struct PinState {
+  uint8_t mode;
+  bool level;
+  bool driven; // level set from the outside via setPin()
+  void (*isr)(void*);
+  void* isrArg;
+  int isrMode;
+};
+
+inline uint64_t g_timeUs = 0u;
+inline PinState g_pins[PIN_COUNT] = {};
+inline uint16_t g_analogValue = 0u;
+
+inline uint64_t timeUs() { return g_timeUs; }
+inline void setTimeUs(uint64_t timeUs) { g_timeUs = timeUs; }
+inline void advanceTimeUs(uint64_t us) { g_timeUs += us; }
+inline void advanceTimeMs(uint64_t ms) { g_timeUs += ms * 1000u; }
+
+/**
+ * Drives the level of an (input) pin and triggers an attached interrupt
+ * handler accordingly.
+ */
+inline void setPin(uint8_t pin, bool level) {
+  if (pin >= PIN_COUNT) {
+    return;
+  }
+  PinState& state = g_pins[pin];
+  bool previous = state.level;
+  state.level = level;
+  state.driven = true;
+  if (state.isr == nullptr || previous == level) {
+    return;
+  }
+  if (state.isrMode == CHANGE || (state.isrMode == RISING && level) || (state.isrMode == FALLING && !level)) {
+    state.isr(state.isrArg);
+  }
+}
+
+inline bool pin(uint8_t pin) {
+  return pin < PIN_COUNT && g_pins[pin].level;
+}
+
+inline void setAnalog(uint16_t value) { g_analogValue = value; }
+
+/**
+ * Resets all pins to their power-on state.
+ */
+inline void resetPins() {
+  for (auto& state : g_pins) {
+    state = {};
+  }
+}
+
+}
+
+inline unsigned long millis() { return (unsigned long)(host::timeUs() / 1000u); }
+inline unsigned long micros() { return (unsigned long)host::timeUs(); }
+inline void delay(unsigned long ms) { host::advanceTimeMs(ms); }
+inline void delayMicroseconds(unsigned int us) { host::advanceTimeUs(us); }
+inline void yield() {}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= host::PIN_COUNT) {
+    return;
+  }
+  host::PinState& state = host::g_pins[pin];
+  state.mode = mode;
+  if (mode == INPUT_PULLUP && !state.driven) {
+    state.level = true;
+  }
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < host::PIN_COUNT) {
+    host::g_pins[pin].level = value != LOW;
+  }
+}
+
+inline int digitalRead(uint8_t pin) { return host::pin(pin) ? HIGH : LOW; }
+inline int analogRead(uint8_t /*pin*/) { return host::g_analogValue; }
+inline void analogWrite(uint8_t /*pin*/, int /*value*/) {}
+
+inline int digitalPinToInterrupt(uint8_t pin) { return pin < 16u ? pin : NOT_AN_INTERRUPT; }
+
+inline void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode) {
+  if (pin < host::PIN_COUNT) {
+    host::g_pins[pin].isr = isr;
+    host::g_pins[pin].isrArg = arg;
+    host::g_pins[pin].isrMode = mode;
+  }
+}
+
+inline void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+  attachInterruptArg(pin, [] (void* arg) { reinterpret_cast<void (*)()>(arg)(); }, reinterpret_cast<void*>(isr), mode);
+}
+
+inline void detachInterrupt(uint8_t pin) {
+  if (pin < host::PIN_COUNT) {
+    host::g_pins[pin].isr = nullptr;
+    host::g_pins[pin].isrArg = nullptr;
+  }
+}
+
+inline void randomSeed(unsigned long seed) { srand(unsigned(seed)); }
+inline long random(long max) { return max <= 0 ? 0 : rand() % max; }
+inline long random(long min, long max) { return min >= max ? min : min + random(max - min); }
+
+/**
+ * Serial port, writes to stdout.
+ */
+class HardwareSerial final : public Stream {
+public:
+  void begin(unsigned long /*baud*/) {}
+  void end() {}
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  size_t write(uint8_t c) override { return fwrite(&c, 1u, 1u, stdout); }
+  size_t write(const uint8_t* buffer, size_t size) override { return fwrite(buffer, 1u, size, stdout); }
+  using Print::write;
+  void flush() override { fflush(stdout); }
+};
+
+inline HardwareSerial Serial;
+
+#include "Esp.h"
+
+#endif
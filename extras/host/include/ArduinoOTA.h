@@ -0,0 +1,72 @@
+#ifndef IOT_CORE_HOST_ARDUINOOTA_H_
+#define IOT_CORE_HOST_ARDUINOOTA_H_
+
+#include <Arduino.h>
+#include <functional>
+
+typedef enum {
+  OTA_AUTH_ERROR,
+  OTA_BEGIN_ERROR,
+  OTA_CONNECT_ERROR,
+  OTA_RECEIVE_ERROR,
+  OTA_END_ERROR,
+} ota_error_t;
+
+/**
+ * Host stand-in for ArduinoOTA. No update is ever received, but one can be
+ * simulated via simulateUpdate() (host only) to run the callbacks.
+ */
+class ArduinoOTAClass final {
+public:
+  using THandlerFunction = std::function<void()>;
+  using THandlerFunction_Error = std::function<void(ota_error_t)>;
+  using THandlerFunction_Progress = std::function<void(unsigned int, unsigned int)>;
+
+private:
+  THandlerFunction _startCallback {};
+  THandlerFunction _endCallback {};
+  THandlerFunction_Error _errorCallback {};
+  THandlerFunction_Progress _progressCallback {};
+  bool _initialized = false;
+  bool _rebootOnSuccess = true;
+  size_t _handleCount = 0u;
+
+public:
+  void setPort(uint16_t /*port*/) {}
+  void setHostname(const char* /*hostname*/) {}
+  void setPassword(const char* /*password*/) {}
+  void setPasswordHash(const char* /*passwordHash*/) {}
+  void setRebootOnSuccess(bool reboot) { _rebootOnSuccess = reboot; }
+
+  void onStart(THandlerFunction callback) { _startCallback = callback; }
+  void onEnd(THandlerFunction callback) { _endCallback = callback; }
+  void onError(THandlerFunction_Error callback) { _errorCallback = callback; }
+  void onProgress(THandlerFunction_Progress callback) { _progressCallback = callback; }
+
+  void begin(bool /*useMDNS*/ = true) { _initialized = true; }
+  void handle() { _handleCount += 1u; }
+  int getCommand() const { return 0; }
+
+  // host only
+  bool initialized() const { return _initialized; }
+  size_t handleCount() const { return _handleCount; }
+
+  void simulateUpdate(unsigned int total, bool fail = false) {
+    if (_startCallback) _startCallback();
+    for (unsigned int progress = 0u; progress <= total; progress += std::max(total / 10u, 1u)) {
+      if (_progressCallback) _progressCallback(progress, total);
+    }
+    if (fail) {
+      if (_errorCallback) _errorCallback(OTA_RECEIVE_ERROR);
+      return;
+    }
+    if (_endCallback) _endCallback();
+    if (_rebootOnSuccess) {
+      ESP.restart();
+    }
+  }
+};
+
+inline ArduinoOTAClass ArduinoOTA;
+
+#endif
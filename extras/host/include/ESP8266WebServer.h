@@ -0,0 +1,578 @@
+#ifndef IOT_CORE_HOST_ESP8266WEBSERVER_H_
+#define IOT_CORE_HOST_ESP8266WEBSERVER_H_
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "Uri.h"
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+enum HTTPRawStatus { RAW_START, RAW_WRITE, RAW_END, RAW_ABORTED };
+enum HTTPClientStatus { HC_NONE, HC_WAIT_READ, HC_WAIT_CLOSE };
+enum HTTPAuthMethod { BASIC_AUTH, DIGEST_AUTH };
+
+#define WEBSERVER_HAS_HOOK 1
+
+#define HTTP_DOWNLOAD_UNIT_SIZE 1460
+#define HTTP_UPLOAD_BUFLEN 2048
+#define HTTP_RAW_BUFLEN 2048
+#define HTTP_MAX_DATA_WAIT 5000 // ms to wait for the client to send the request
+#define HTTP_MAX_POST_WAIT 5000 // ms to wait for POST data to arrive
+#define HTTP_MAX_SEND_WAIT 5000 // ms to wait for data chunk to be ACKed
+#define HTTP_MAX_CLOSE_WAIT 2000 // ms to wait for the client to close the connection
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+#define CONTENT_LENGTH_NOT_SET ((size_t) -2)
+
+struct HTTPUpload {
+  HTTPUploadStatus status;
+  String filename;
+  String name;
+  String type;
+  size_t totalSize;
+  size_t currentSize;
+  size_t contentLength;
+  uint8_t buf[HTTP_UPLOAD_BUFLEN];
+};
+
+struct HTTPRaw {
+  HTTPRawStatus status;
+  size_t totalSize;
+  size_t currentSize;
+  void* data;
+  uint8_t buf[HTTP_RAW_BUFLEN];
+};
+
+#include "detail/RequestHandler.h"
+
+namespace esp8266webserver {
+
+/**
+ * Host stand-in for the ESP8266WebServer over a real local socket (see
+ * WiFiServer).
+ *
+ * Like on the device, one request is handled per handleClient() call and the
+ * client is released afterwards, which closes the connection unless a copy
+ * of the client is kept (e.g. to continue the response later). Reading the request waits in real time
+ * (up to HTTP_MAX_DATA_WAIT ms), as the client is usually another thread or
+ * process on the host.
+ */
+template<typename ServerType>
+class ESP8266WebServerTemplate {
+public:
+  using ClientType = typename ServerType::ClientType;
+  using RequestHandlerType = RequestHandler<ServerType>;
+  using THandlerFunction = std::function<void(void)>;
+
+protected:
+  struct RequestArgument {
+    String key;
+    String value;
+  };
+
+  ServerType _server;
+  ClientType _currentClient {};
+  HTTPMethod _currentMethod = HTTP_ANY;
+  String _currentUri {};
+  uint8_t _currentVersion = 0u;
+  HTTPClientStatus _currentStatus = HC_NONE;
+
+  RequestHandlerType* _currentHandler = nullptr;
+  std::unique_ptr<HTTPRaw> _currentRaw {};
+  RequestHandlerType* _firstHandler = nullptr;
+  RequestHandlerType* _lastHandler = nullptr;
+  THandlerFunction _notFoundHandler {};
+
+  std::vector<RequestArgument> _currentArgs {};
+  std::vector<RequestArgument> _currentHeaders {};
+  std::vector<String> _headerKeys {};
+
+  size_t _contentLength = CONTENT_LENGTH_NOT_SET;
+  String _responseHeaders {};
+  String _hostHeader {};
+  bool _chunked = false;
+  bool _corsEnabled = false;
+
+  static String urlDecode(const String& text) {
+    String decoded;
+    for (unsigned int i = 0u; i < text.length(); ++i) {
+      char c = text[i];
+      if (c == '+') {
+        decoded += ' ';
+      } else if (c == '%' && i + 2u < text.length() && isxdigit(text[i + 1u]) && isxdigit(text[i + 2u])) {
+        char hex[3] = {text[i + 1u], text[i + 2u], '\0'};
+        decoded += char(strtol(hex, nullptr, 16));
+        i += 2u;
+      } else {
+        decoded += c;
+      }
+    }
+    return decoded;
+  }
+
+  static HTTPMethod parseMethod(const String& method) {
+    if (method == "GET") return HTTP_GET;
+    if (method == "HEAD") return HTTP_HEAD;
+    if (method == "POST") return HTTP_POST;
+    if (method == "PUT") return HTTP_PUT;
+    if (method == "PATCH") return HTTP_PATCH;
+    if (method == "DELETE") return HTTP_DELETE;
+    if (method == "OPTIONS") return HTTP_OPTIONS;
+    return HTTP_ANY;
+  }
+
+  void parseArguments(const String& data) {
+    int start = 0;
+    while (start < int(data.length())) {
+      int end = data.indexOf('&', start);
+      if (end < 0) {
+        end = data.length();
+      }
+      String pair = data.substring(start, end);
+      int equals = pair.indexOf('=');
+      if (!pair.isEmpty()) {
+        _currentArgs.push_back({urlDecode(equals < 0 ? pair : pair.substring(0, equals)), equals < 0 ? String() : urlDecode(pair.substring(equals + 1))});
+      }
+      start = end + 1;
+    }
+  }
+
+  bool readLine(ClientType& client, String& line) {
+    line = client.readStringUntil('\n');
+    if (line.endsWith("\r")) {
+      line.remove(line.length() - 1u);
+    }
+    return true;
+  }
+
+  bool _parseRequest(ClientType& client) {
+    client.setTimeout(HTTP_MAX_DATA_WAIT);
+
+    String requestLine;
+    readLine(client, requestLine);
+    int methodEnd = requestLine.indexOf(' ');
+    int urlEnd = requestLine.indexOf(' ', methodEnd + 1);
+    if (methodEnd < 0 || urlEnd < 0) {
+      return false;
+    }
+
+    _currentMethod = parseMethod(requestLine.substring(0, methodEnd));
+    _currentVersion = requestLine.substring(urlEnd + 1) == "HTTP/1.1" ? 1u : 0u;
+    String url = requestLine.substring(methodEnd + 1, urlEnd);
+    int queryStart = url.indexOf('?');
+    _currentUri = queryStart < 0 ? url : url.substring(0, queryStart);
+    _currentArgs.clear();
+    _currentHeaders.clear();
+    for (const auto& key : _headerKeys) {
+      _currentHeaders.push_back({key, String()});
+    }
+    if (queryStart >= 0) {
+      parseArguments(url.substring(queryStart + 1));
+    }
+
+    size_t contentLength = 0u;
+    String contentType;
+    String line;
+    while (readLine(client, line) && !line.isEmpty()) {
+      int separator = line.indexOf(':');
+      if (separator < 0) {
+        continue;
+      }
+      String name = line.substring(0, separator);
+      String value = line.substring(separator + 1);
+      name.trim();
+      value.trim();
+      for (auto& header : _currentHeaders) {
+        if (header.key.equalsIgnoreCase(name)) {
+          header.value = value;
+        }
+      }
+      if (name.equalsIgnoreCase("Content-Length")) {
+        contentLength = size_t(value.toInt());
+      } else if (name.equalsIgnoreCase("Content-Type")) {
+        contentType = value;
+      } else if (name.equalsIgnoreCase("Host")) {
+        _hostHeader = value;
+      }
+    }
+
+    _currentHandler = nullptr;
+    for (RequestHandlerType* handler = _firstHandler; handler != nullptr; handler = handler->next()) {
+      if (handler->canHandle(_currentMethod, _currentUri)) {
+        _currentHandler = handler;
+        break;
+      }
+    }
+
+    bool isForm = contentType.startsWith("application/x-www-form-urlencoded");
+    if (contentLength > 0u && !isForm && _currentHandler != nullptr && _currentHandler->canRaw(_currentUri)) {
+      // like on the device, the handler gets the body in pieces as it arrives
+      client.setTimeout(HTTP_MAX_POST_WAIT);
+      _currentRaw.reset(new HTTPRaw());
+      _currentRaw->status = RAW_START;
+      _currentRaw->totalSize = 0u;
+      _currentRaw->currentSize = 0u;
+      _currentHandler->raw(*this, _currentUri, *_currentRaw);
+      _currentRaw->status = RAW_WRITE;
+      while (_currentRaw->totalSize < contentLength) {
+        size_t read = client.readBytes(_currentRaw->buf, std::min(size_t(HTTP_RAW_BUFLEN), contentLength - _currentRaw->totalSize));
+        _currentRaw->currentSize = read;
+        _currentRaw->totalSize += read;
+        if (read == 0u) {
+          _currentRaw->status = RAW_ABORTED;
+          _currentHandler->raw(*this, _currentUri, *_currentRaw);
+          return false;
+        }
+        _currentHandler->raw(*this, _currentUri, *_currentRaw);
+      }
+      _currentRaw->status = RAW_END;
+      _currentHandler->raw(*this, _currentUri, *_currentRaw);
+    } else if (contentLength > 0u) {
+      client.setTimeout(HTTP_MAX_POST_WAIT);
+      String body;
+      body.reserve(contentLength);
+      char buffer[512];
+      while (body.length() < contentLength) {
+        size_t read = client.readBytes(buffer, std::min(sizeof(buffer), contentLength - body.length()));
+        if (read == 0u) {
+          return false;
+        }
+        body.concat(buffer, read);
+      }
+
+      if (isForm) {
+        parseArguments(body);
+      } else {
+        _currentArgs.push_back({F("plain"), body});
+      }
+    }
+
+    return true;
+  }
+
+  void _handleRequest() {
+    bool handled = false;
+    if (_currentHandler != nullptr) {
+      handled = _currentHandler->handle(*this, _currentMethod, _currentUri);
+    }
+    if (!handled && _notFoundHandler) {
+      _notFoundHandler();
+      handled = true;
+    }
+    if (!handled) {
+      send(404, "text/plain", String(F("Not found: ")) + _currentUri);
+    }
+    _finalizeResponse();
+  }
+
+  void _finalizeResponse() {
+    if (_chunked) {
+      sendContent(emptyString);
+    }
+  }
+
+  void _resetRequest() {
+    _currentUri = emptyString;
+    _currentArgs.clear();
+    _currentHeaders.clear();
+    _currentHandler = nullptr;
+    _currentRaw.reset();
+    _contentLength = CONTENT_LENGTH_NOT_SET;
+    _responseHeaders = emptyString;
+    _hostHeader = emptyString;
+    _chunked = false;
+  }
+
+  static String responseCodeToString(int code) {
+    switch (code) {
+      case 200: return F("OK");
+      case 201: return F("Created");
+      case 202: return F("Accepted");
+      case 204: return F("No Content");
+      case 206: return F("Partial Content");
+      case 301: return F("Moved Permanently");
+      case 302: return F("Found");
+      case 303: return F("See Other");
+      case 304: return F("Not Modified");
+      case 307: return F("Temporary Redirect");
+      case 308: return F("Permanent Redirect");
+      case 400: return F("Bad Request");
+      case 401: return F("Unauthorized");
+      case 403: return F("Forbidden");
+      case 404: return F("Not Found");
+      case 405: return F("Method Not Allowed");
+      case 406: return F("Not Acceptable");
+      case 408: return F("Request Time-out");
+      case 409: return F("Conflict");
+      case 410: return F("Gone");
+      case 411: return F("Length Required");
+      case 412: return F("Precondition Failed");
+      case 413: return F("Request Entity Too Large");
+      case 415: return F("Unsupported Media Type");
+      case 429: return F("Too Many Requests");
+      case 500: return F("Internal Server Error");
+      case 501: return F("Not Implemented");
+      case 502: return F("Bad Gateway");
+      case 503: return F("Service Unavailable");
+      case 504: return F("Gateway Time-out");
+      case 505: return F("HTTP Version not supported");
+      case 507: return F("Insufficient Storage");
+      default: return F("");
+    }
+  }
+
+  void _prepareHeader(String& response, int code, const char* contentType, size_t contentLength) {
+    response = String(F("HTTP/1.")) + String(_currentVersion) + ' ' + String(code) + ' ' + responseCodeToString(code) + F("\r\n");
+
+    if (contentType == nullptr) {
+      contentType = "text/html";
+    }
+    sendHeader(F("Content-Type"), contentType, true);
+
+    if (_contentLength == CONTENT_LENGTH_NOT_SET) {
+      sendHeader(F("Content-Length"), String((unsigned long)contentLength));
+    } else if (_contentLength != CONTENT_LENGTH_UNKNOWN) {
+      sendHeader(F("Content-Length"), String((unsigned long)_contentLength));
+    } else if (_currentVersion == 1u) {
+      _chunked = true;
+      sendHeader(F("Accept-Ranges"), F("none"));
+      sendHeader(F("Transfer-Encoding"), F("chunked"));
+    }
+    if (_corsEnabled) {
+      sendHeader(F("Access-Control-Allow-Origin"), F("*"));
+    }
+    sendHeader(F("Connection"), F("close"));
+
+    response += _responseHeaders;
+    response += F("\r\n");
+    _responseHeaders = emptyString;
+  }
+
+  void _streamContent(const char* content, size_t length) {
+    if (_currentMethod != HTTP_HEAD) {
+      _currentClient.write(content, length);
+    }
+  }
+
+public:
+  explicit ESP8266WebServerTemplate(int port = 80) : _server(port) {}
+  ESP8266WebServerTemplate(IPAddress address, int port = 80) : _server(address, port) {}
+
+  ESP8266WebServerTemplate(const ESP8266WebServerTemplate&) = delete;
+  ESP8266WebServerTemplate& operator=(const ESP8266WebServerTemplate&) = delete;
+
+  ~ESP8266WebServerTemplate() {
+    close();
+    RequestHandlerType* handler = _firstHandler;
+    while (handler != nullptr) {
+      RequestHandlerType* next = handler->next();
+      delete handler;
+      handler = next;
+    }
+  }
+
+  void begin() { _server.begin(); }
+  void begin(uint16_t port) { _server.begin(port); }
+
+  void handleClient() {
+    _currentClient = _server.accept();
+    if (!_currentClient) {
+      return;
+    }
+
+    _currentStatus = HC_WAIT_READ;
+    if (_parseRequest(_currentClient)) {
+      _handleRequest();
+    }
+    _currentClient = ClientType();
+    _currentStatus = HC_NONE;
+    _resetRequest();
+  }
+
+  void close() {
+    _server.close();
+    _currentStatus = HC_NONE;
+  }
+
+  void stop() { close(); }
+
+  void on(const Uri& uri, THandlerFunction handler) { on(uri, HTTP_ANY, handler); }
+  void on(const Uri& uri, HTTPMethod method, THandlerFunction fn) { on(uri, method, fn, {}); }
+  void on(const Uri& uri, HTTPMethod method, THandlerFunction fn, THandlerFunction uploadFn) {
+    addHandler(new FunctionRequestHandler<ServerType>(fn, uploadFn, uri, method));
+  }
+
+  void addHandler(RequestHandlerType* handler) {
+    if (_lastHandler == nullptr) {
+      _firstHandler = handler;
+    } else {
+      _lastHandler->next(handler);
+    }
+    _lastHandler = handler;
+  }
+
+  void onNotFound(THandlerFunction fn) { _notFoundHandler = fn; }
+
+  void enableCORS(bool enable = true) { _corsEnabled = enable; }
+  void enableCrossOrigin(bool enable = true) { enableCORS(enable); }
+
+  const String& uri() const { return _currentUri; }
+  HTTPMethod method() const { return _currentMethod; }
+  ClientType& client() { return _currentClient; }
+  HTTPRaw& raw() { return *_currentRaw; }
+
+  const String& pathArg(unsigned int i) const {
+    return _currentHandler != nullptr ? _currentHandler->pathArg(i) : emptyString;
+  }
+
+  const String& arg(const String& name) const {
+    for (const auto& argument : _currentArgs) {
+      if (argument.key == name) {
+        return argument.value;
+      }
+    }
+    return emptyString;
+  }
+
+  const String& arg(int i) const { return i >= 0 && size_t(i) < _currentArgs.size() ? _currentArgs[i].value : emptyString; }
+  const String& argName(int i) const { return i >= 0 && size_t(i) < _currentArgs.size() ? _currentArgs[i].key : emptyString; }
+  int args() const { return int(_currentArgs.size()); }
+
+  bool hasArg(const String& name) const {
+    for (const auto& argument : _currentArgs) {
+      if (argument.key == name) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Sets the request headers to collect, adding to the ones set before.
+   */
+  template<typename... Args>
+  bool collectHeaders(const Args&... args) {
+    for (const String& key : {String(args)...}) {
+      bool known = false;
+      for (const auto& headerKey : _headerKeys) {
+        known = known || headerKey.equalsIgnoreCase(key);
+      }
+      if (!known) {
+        _headerKeys.push_back(key);
+      }
+    }
+    return true;
+  }
+
+  const String& header(const String& name) const {
+    for (const auto& header : _currentHeaders) {
+      if (header.key.equalsIgnoreCase(name)) {
+        return header.value;
+      }
+    }
+    return emptyString;
+  }
+
+  const String& header(int i) const { return i >= 0 && size_t(i) < _currentHeaders.size() ? _currentHeaders[i].value : emptyString; }
+  const String& headerName(int i) const { return i >= 0 && size_t(i) < _currentHeaders.size() ? _currentHeaders[i].key : emptyString; }
+  int headers() const { return int(_currentHeaders.size()); }
+
+  bool hasHeader(const String& name) const {
+    for (const auto& header : _currentHeaders) {
+      if (header.key.equalsIgnoreCase(name) && !header.value.isEmpty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  const String& hostHeader() const { return _hostHeader; }
+
+  void send(int code, const char* contentType = nullptr, const String& content = emptyString) {
+    send(code, contentType, content.c_str(), content.length());
+  }
+
+  void send(int code, char* contentType, const String& content) { send(code, (const char*)contentType, content); }
+  void send(int code, const String& contentType, const String& content) { send(code, contentType.c_str(), content); }
+  void send(int code, const char* contentType, const char* content) { send(code, contentType, content, content == nullptr ? 0u : strlen(content)); }
+
+  void send(int code, const char* contentType, const char* content, size_t contentLength) {
+    String header;
+    _prepareHeader(header, code, contentType, contentLength);
+    _currentClient.write(header.c_str(), header.length());
+    if (contentLength > 0u) {
+      sendContent(content, contentLength);
+    }
+  }
+
+  void send(int code, const char* contentType, const uint8_t* content, size_t contentLength) {
+    send(code, contentType, reinterpret_cast<const char*>(content), contentLength);
+  }
+
+  void send_P(int code, PGM_P contentType, PGM_P content) { send(code, contentType, content); }
+  void send_P(int code, PGM_P contentType, PGM_P content, size_t contentLength) { send(code, contentType, content, contentLength); }
+
+  void sendHeader(const String& name, const String& value, bool first = false) {
+    String headerLine = name + F(": ") + value + F("\r\n");
+    if (first) {
+      _responseHeaders = headerLine + _responseHeaders;
+    } else {
+      _responseHeaders += headerLine;
+    }
+  }
+
+  void setContentLength(const size_t contentLength) { _contentLength = contentLength; }
+
+  void sendContent(const String& content) { sendContent(content.c_str(), content.length()); }
+
+  void sendContent(const char* content, size_t contentLength) {
+    if (_currentMethod == HTTP_HEAD) {
+      return;
+    }
+    if (_chunked) {
+      char chunkSize[12];
+      snprintf(chunkSize, sizeof(chunkSize), "%zx\r\n", contentLength);
+      _currentClient.write(chunkSize, strlen(chunkSize));
+    }
+    _streamContent(content, contentLength);
+    if (_chunked) {
+      _currentClient.write("\r\n", 2u);
+      if (contentLength == 0u) {
+        _chunked = false;
+      }
+    }
+  }
+
+  void sendContent_P(PGM_P content) { sendContent(content, strlen(content)); }
+  void sendContent_P(PGM_P content, size_t size) { sendContent(content, size); }
+
+  bool chunkedResponseModeStart_P(int code, PGM_P contentType) {
+    if (_currentVersion == 0u) {
+      return false;
+    }
+    setContentLength(CONTENT_LENGTH_UNKNOWN);
+    send_P(code, contentType, "");
+    return true;
+  }
+
+  bool chunkedResponseModeStart(int code, const char* contentType) { return chunkedResponseModeStart_P(code, contentType); }
+  bool chunkedResponseModeStart(int code, const String& contentType) { return chunkedResponseModeStart_P(code, contentType.c_str()); }
+
+  bool chunkedResponseFinalize() {
+    if (!_chunked) {
+      return false;
+    }
+    sendContent(emptyString);
+    return true;
+  }
+};
+
+}
+
+using ESP8266WebServer = esp8266webserver::ESP8266WebServerTemplate<WiFiServer>;
+using RequestHandler = esp8266webserver::RequestHandler<WiFiServer>;
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef IOT_CORE_HOST_ESP8266WIFI_H_
+#define IOT_CORE_HOST_ESP8266WIFI_H_
+
+#include <Arduino.h>
+#include "IPAddress.h"
+#include "WiFiClient.h"
+#include "WiFiServer.h"
+
+enum wl_status_t {
+  WL_NO_SHIELD = 255,
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_WRONG_PASSWORD = 6,
+  WL_DISCONNECTED = 7,
+};
+
+enum WiFiMode_t {
+  WIFI_OFF = 0,
+  WIFI_STA = 1,
+  WIFI_AP = 2,
+  WIFI_AP_STA = 3,
+};
+
+/**
+ * Host stand-in for the WiFi object. There is no actual WiFi, the state is
+ * controlled by the host program via the setters marked "host only".
+ *
+ * The station is connected to the saved network "host" by default, which is
+ * forgotten with disconnect(true).
+ */
+class ESP8266WiFiClass final {
+  wl_status_t _status = WL_CONNECTED;
+  WiFiMode_t _mode = WIFI_STA;
+  String _ssid {F("host")};
+  String _hostname {F("esp-host")};
+  int32_t _rssi = -60;
+  IPAddress _localIP {127, 0, 0, 1};
+  bool _autoReconnect = true;
+
+public:
+  wl_status_t status() const { return _status; }
+  bool isConnected() const { return _status == WL_CONNECTED; }
+
+  bool mode(WiFiMode_t mode) { _mode = mode; return true; }
+  WiFiMode_t getMode() const { return _mode; }
+
+  wl_status_t begin() {
+    _status = _ssid.isEmpty() ? WL_NO_SSID_AVAIL : WL_CONNECTED;
+    return _status;
+  }
+
+  wl_status_t begin(const char* ssid, const char* /*passphrase*/ = nullptr) {
+    _ssid = ssid;
+    return begin();
+  }
+
+  bool reconnect() { begin(); return isConnected(); }
+
+  bool disconnect(bool wifiOff = false) {
+    _status = WL_DISCONNECTED;
+    if (wifiOff) {
+      _ssid.clear();
+    }
+    return true;
+  }
+
+  bool setAutoReconnect(bool autoReconnect) { _autoReconnect = autoReconnect; return true; }
+  bool getAutoReconnect() const { return _autoReconnect; }
+
+  bool hostname(const char* hostname) { _hostname = hostname; return true; }
+  bool hostname(const String& hostname) { _hostname = hostname; return true; }
+  const String& hostname() const { return _hostname; }
+
+  String SSID() const { return _ssid; }
+  int32_t RSSI() const { return isConnected() ? _rssi : 31; }
+  IPAddress localIP() const { return isConnected() ? _localIP : IPAddress {}; }
+  IPAddress gatewayIP() const { return isConnected() ? IPAddress {127, 0, 0, 1} : IPAddress {}; }
+  IPAddress subnetMask() const { return IPAddress {255, 0, 0, 0}; }
+  String macAddress() const { return F("02:00:00:c0:ff:ee"); }
+
+  // host only
+  void setStatus(wl_status_t status) { _status = status; }
+  void setRSSI(int32_t rssi) { _rssi = rssi; }
+  void setLocalIP(IPAddress ip) { _localIP = ip; }
+};
+
+inline ESP8266WiFiClass WiFi;
+
+#endif
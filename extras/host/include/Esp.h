@@ -0,0 +1,62 @@
+#ifndef IOT_CORE_HOST_ESP_H_
+#define IOT_CORE_HOST_ESP_H_
+
+#include <cstdint>
+#include <chrono>
+#include <functional>
+#include "WString.h"
+
+/**
+ * Host stand-in for the ESP object, reports fixed plausible values.
+ *
+ * restart() does not terminate the program, it only counts the restarts and
+ * calls the handler set via onRestart() (host only).
+ */
+class EspClass final {
+  uint32_t _restartCount = 0u;
+  std::function<void()> _restartHandler {};
+
+public:
+  uint32_t getChipId() const { return 0x00c0ffeeu; }
+  uint32_t getFlashChipId() const { return 0x001640efu; }
+  uint32_t getFlashChipSize() const { return 4u * 1024u * 1024u; }
+  String getSketchMD5() const { return F("00000000000000000000000000000000"); }
+  String getCoreVersion() const { return F("host"); }
+  const char* getSdkVersion() const { return "host"; }
+  String getFullVersion() const { return F("host"); }
+  uint8_t getCpuFreqMHz() const { return 80u; }
+  uint16_t getVcc() const { return 3300u; }
+  String getResetReason() const { return F("Power On"); }
+  String getResetInfo() const { return F("Power On"); }
+  uint32_t getFreeHeap() const { return 40960u; }
+  uint8_t getHeapFragmentation() const { return 0u; }
+  uint32_t getMaxFreeBlockSize() const { return 40960u; }
+  uint32_t getFreeContStack() const { return 4096u; }
+  uint32_t getSketchSize() const { return 0u; }
+  uint32_t getFreeSketchSpace() const { return 0u; }
+
+  /**
+   * Cycle count of a virtual 80 MHz CPU, derived from the real (steady) time.
+   */
+  uint32_t getCycleCount() const {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    return uint32_t(uint64_t(ns) * getCpuFreqMHz() / 1000u);
+  }
+
+  void restart() {
+    _restartCount += 1u;
+    if (_restartHandler) {
+      _restartHandler();
+    }
+  }
+
+  void reset() { restart(); }
+
+  // host only
+  void onRestart(std::function<void()> handler) { _restartHandler = handler; }
+  uint32_t restartCount() const { return _restartCount; }
+};
+
+inline EspClass ESP;
+
+#endif
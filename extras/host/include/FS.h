@@ -0,0 +1,233 @@
+#ifndef IOT_CORE_HOST_FS_H_
+#define IOT_CORE_HOST_FS_H_
+
+#include <Arduino.h>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+
+namespace fs {
+
+enum SeekMode {
+  SeekSet = 0,
+  SeekCur = 1,
+  SeekEnd = 2,
+};
+
+/**
+ * Host stand-in for a file, backed by a stdio file.
+ */
+class File final : public Stream {
+  std::shared_ptr<FILE> _file {};
+  String _name {};
+
+public:
+  File() {}
+  File(FILE* file, const String& name) : _file(file, &fclose), _name(name) {}
+
+  operator bool() const { return bool(_file); }
+
+  size_t write(uint8_t c) override { return write(&c, 1u); }
+  size_t write(const uint8_t* buffer, size_t size) override { return _file ? fwrite(buffer, 1u, size, _file.get()) : 0u; }
+  using Print::write;
+
+  int available() override {
+    if (!_file) {
+      return 0;
+    }
+    return int(size() - position());
+  }
+
+  int read() override {
+    return _file ? fgetc(_file.get()) : -1;
+  }
+
+  int read(uint8_t* buffer, size_t size) override {
+    return _file ? int(fread(buffer, 1u, size, _file.get())) : 0;
+  }
+
+  size_t readBytes(char* buffer, size_t length) override {
+    return size_t(read(reinterpret_cast<uint8_t*>(buffer), length));
+  }
+
+  int peek() override {
+    if (!_file) {
+      return -1;
+    }
+    int c = fgetc(_file.get());
+    if (c >= 0) {
+      ungetc(c, _file.get());
+    }
+    return c;
+  }
+
+  void flush() override {
+    if (_file) {
+      fflush(_file.get());
+    }
+  }
+
+  bool seek(uint32_t position, SeekMode mode = SeekSet) {
+    return _file && fseek(_file.get(), long(position), mode == SeekSet ? SEEK_SET : mode == SeekCur ? SEEK_CUR : SEEK_END) == 0;
+  }
+
+  size_t position() const { return _file ? size_t(ftell(_file.get())) : 0u; }
+
+  size_t size() const {
+    if (!_file) {
+      return 0u;
+    }
+    long current = ftell(_file.get());
+    fseek(_file.get(), 0, SEEK_END);
+    long end = ftell(_file.get());
+    fseek(_file.get(), current, SEEK_SET);
+    return size_t(end);
+  }
+
+  void close() { _file.reset(); }
+
+  const char* name() const {
+    const char* slash = strrchr(_name.c_str(), '/');
+    return slash == nullptr ? _name.c_str() : slash + 1;
+  }
+
+  const char* fullName() const { return _name.c_str(); }
+  bool isFile() const { return bool(_file); }
+  bool isDirectory() const { return false; }
+};
+
+/**
+ * Host stand-in for a file system, which is stored in a directory of the host
+ * file system. If no root directory is set (host only), a temporary
+ * directory is created on begin() and removed again on destruction.
+ *
+ * Like LittleFS, files can only be accessed while mounted and parent
+ * directories are created when opening a file for writing.
+ */
+class FS final {
+  std::string _root {};
+  bool _temporary = false;
+  bool _mounted = false;
+
+  void removeTemporary() {
+    if (_temporary) {
+      std::error_code error;
+      std::filesystem::remove_all(_root, error);
+      _temporary = false;
+    }
+  }
+
+  std::filesystem::path path(const char* path) const {
+    return std::filesystem::path(_root) / std::filesystem::path(path).relative_path();
+  }
+
+public:
+  FS() {}
+  FS(const FS&) = delete;
+  FS& operator=(const FS&) = delete;
+
+  ~FS() { removeTemporary(); }
+
+  /**
+   * Creates a new directory in the host's temporary directory (host only),
+   * returns an empty string if that fails.
+   */
+  static std::string createTemporaryDirectory() {
+    const char* tmp = getenv("TMPDIR");
+    std::string pattern = std::string(tmp != nullptr ? tmp : "/tmp") + "/iot_core_fs_XXXXXX";
+    return mkdtemp(&pattern[0]) == nullptr ? std::string() : pattern;
+  }
+
+  bool begin() {
+    if (_root.empty()) {
+      _root = createTemporaryDirectory();
+      _temporary = !_root.empty();
+      if (_root.empty()) {
+        return false;
+      }
+    }
+    std::error_code error;
+    std::filesystem::create_directories(_root, error);
+    _mounted = !error;
+    return _mounted;
+  }
+
+  void end() { _mounted = false; }
+
+  bool format() {
+    if (_root.empty()) {
+      return begin();
+    }
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(_root, error)) {
+      std::filesystem::remove_all(entry.path(), error);
+    }
+    return !error;
+  }
+
+  File open(const char* filePath, const char* mode) {
+    if (!_mounted) {
+      return {};
+    }
+    auto hostPath = path(filePath);
+    if (mode[0] == 'w' || mode[0] == 'a') {
+      std::error_code error;
+      std::filesystem::create_directories(hostPath.parent_path(), error);
+    } else if (!std::filesystem::is_regular_file(hostPath)) {
+      return {};
+    }
+    FILE* file = fopen(hostPath.c_str(), mode);
+    return file == nullptr ? File {} : File {file, filePath};
+  }
+
+  File open(const String& filePath, const char* mode) { return open(filePath.c_str(), mode); }
+
+  bool exists(const char* filePath) const { return _mounted && std::filesystem::exists(path(filePath)); }
+  bool exists(const String& filePath) const { return exists(filePath.c_str()); }
+
+  bool remove(const char* filePath) {
+    std::error_code error;
+    return _mounted && std::filesystem::remove(path(filePath), error);
+  }
+
+  bool remove(const String& filePath) { return remove(filePath.c_str()); }
+
+  bool rename(const char* from, const char* to) {
+    std::error_code error;
+    std::filesystem::rename(path(from), path(to), error);
+    return _mounted && !error;
+  }
+
+  bool mkdir(const char* directory) {
+    std::error_code error;
+    std::filesystem::create_directories(path(directory), error);
+    return _mounted && !error;
+  }
+
+  bool rmdir(const char* directory) {
+    std::error_code error;
+    return _mounted && std::filesystem::remove(path(directory), error);
+  }
+
+  // host only
+  void root(const std::string& root) {
+    removeTemporary();
+    _root = root;
+  }
+  const std::string& root() const { return _root; }
+  bool mounted() const { return _mounted; }
+};
+
+}
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif
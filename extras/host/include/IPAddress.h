@@ -0,0 +1,59 @@
+#ifndef IOT_CORE_HOST_IPADDRESS_H_
+#define IOT_CORE_HOST_IPADDRESS_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "WString.h"
+
+/**
+ * Host stand-in for IPAddress (IPv4 only). The address is stored in network
+ * byte order, like on the device.
+ */
+class IPAddress final {
+  uint8_t _bytes[4] = {};
+
+public:
+  IPAddress() {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d} {}
+  IPAddress(uint32_t address) { memcpy(_bytes, &address, sizeof(_bytes)); }
+  IPAddress(const uint8_t* address) { memcpy(_bytes, address, sizeof(_bytes)); }
+
+  operator uint32_t() const {
+    uint32_t address;
+    memcpy(&address, _bytes, sizeof(address));
+    return address;
+  }
+
+  uint32_t v4() const { return uint32_t(*this); }
+  bool isSet() const { return uint32_t(*this) != 0u; }
+  bool isV4() const { return true; }
+
+  uint8_t operator[](int index) const { return _bytes[index]; }
+  uint8_t& operator[](int index) { return _bytes[index]; }
+
+  bool operator==(const IPAddress& other) const { return uint32_t(*this) == uint32_t(other); }
+  bool operator!=(const IPAddress& other) const { return !(*this == other); }
+  bool operator==(uint32_t address) const { return uint32_t(*this) == address; }
+  bool operator!=(uint32_t address) const { return uint32_t(*this) != address; }
+
+  bool fromString(const char* address) {
+    unsigned int a, b, c, d;
+    char rest;
+    if (sscanf(address, "%u.%u.%u.%u%c", &a, &b, &c, &d, &rest) != 4 || a > 255u || b > 255u || c > 255u || d > 255u) {
+      return false;
+    }
+    *this = IPAddress(uint8_t(a), uint8_t(b), uint8_t(c), uint8_t(d));
+    return true;
+  }
+
+  bool fromString(const String& address) { return fromString(address.c_str()); }
+
+  String toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+    return buffer;
+  }
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef IOT_CORE_HOST_LITTLEFS_H_
+#define IOT_CORE_HOST_LITTLEFS_H_
+
+#include "FS.h"
+
+inline fs::FS LittleFS;
+
+namespace host {
+
+/**
+ * Gives LittleFS its own temporary root directory for the lifetime of this
+ * object (e.g. a test fixture), which is unmounted and removed afterwards.
+ * Files written by one fixture (e.g. the persisted config) are thus not seen
+ * by the next one.
+ */
+class TemporaryFileSystem final {
+  std::string _previousRoot;
+  std::string _root;
+
+public:
+  TemporaryFileSystem() : _previousRoot(LittleFS.root()), _root(fs::FS::createTemporaryDirectory()) {
+    LittleFS.end();
+    LittleFS.root(_root);
+  }
+
+  TemporaryFileSystem(const TemporaryFileSystem&) = delete;
+  TemporaryFileSystem& operator=(const TemporaryFileSystem&) = delete;
+
+  ~TemporaryFileSystem() {
+    LittleFS.end();
+    std::error_code error;
+    std::filesystem::remove_all(_root, error);
+    LittleFS.root(_previousRoot);
+  }
+
+  const std::string& root() const { return _root; }
+};
+
+}
+
+#endif
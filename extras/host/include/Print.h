@@ -0,0 +1,79 @@
+#ifndef IOT_CORE_HOST_PRINT_H_
+#define IOT_CORE_HOST_PRINT_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+/**
+ * Host stand-in for the Arduino Print base class.
+ */
+class Print {
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t written = 0u;
+    while (written < size && write(buffer[written]) == 1u) {
+      written += 1u;
+    }
+    return written;
+  }
+
+  size_t write(const char* str) { return str == nullptr ? 0u : write(reinterpret_cast<const uint8_t*>(str), strlen(str)); }
+  size_t write(const char* buffer, size_t size) { return write(reinterpret_cast<const uint8_t*>(buffer), size); }
+  size_t write(char c) { return write(uint8_t(c)); }
+
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const __FlashStringHelper* pstr) { return write(reinterpret_cast<const char*>(pstr)); }
+  size_t print(const String& string) { return write(string.c_str(), string.length()); }
+  size_t print(const char* str) { return write(str); }
+  size_t print(char c) { return write(c); }
+  size_t print(unsigned char value, int base = DEC) { return print(String(value, base)); }
+  size_t print(int value, int base = DEC) { return print(String(value, base)); }
+  size_t print(unsigned int value, int base = DEC) { return print(String(value, base)); }
+  size_t print(long value, int base = DEC) { return print(String(value, base)); }
+  size_t print(unsigned long value, int base = DEC) { return print(String(value, base)); }
+  size_t print(double value, int decimalPlaces = 2) { return print(String(value, decimalPlaces)); }
+
+  size_t println() { return write("\r\n"); }
+  template<typename T>
+  size_t println(const T& value) { return print(value) + println(); }
+  template<typename T>
+  size_t println(const T& value, int format) { return print(value, format) + println(); }
+
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length < 0) {
+      return 0u;
+    }
+    if (size_t(length) < sizeof(buffer)) {
+      return write(buffer, size_t(length));
+    }
+    char* large = new char[length + 1u];
+    va_start(args, format);
+    vsnprintf(large, length + 1u, format, args);
+    va_end(args);
+    size_t written = write(large, size_t(length));
+    delete[] large;
+    return written;
+  }
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef IOT_CORE_HOST_STREAM_H_
+#define IOT_CORE_HOST_STREAM_H_
+
+#include <chrono>
+#include "Print.h"
+
+/**
+ * Host stand-in for the Arduino Stream base class.
+ *
+ * As millis() is virtual on the host, the read timeout is measured in real
+ * time instead.
+ */
+class Stream : public Print {
+protected:
+  unsigned long _timeout = 1000u;
+
+  int timedRead() {
+    auto start = std::chrono::steady_clock::now();
+    do {
+      int c = read();
+      if (c >= 0) {
+        return c;
+      }
+      waitForData();
+    } while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(_timeout));
+    return -1;
+  }
+
+  /**
+   * Blocks (for a short time) until data may be available.
+   */
+  virtual void waitForData() {}
+
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  virtual int read(uint8_t* buffer, size_t size) {
+    size_t count = 0u;
+    int c;
+    while (count < size && available() > 0 && (c = read()) >= 0) {
+      buffer[count] = uint8_t(c);
+      count += 1u;
+    }
+    return int(count);
+  }
+
+  void setTimeout(unsigned long timeout) { _timeout = timeout; }
+  unsigned long getTimeout() const { return _timeout; }
+
+  virtual size_t readBytes(char* buffer, size_t length) {
+    size_t count = 0u;
+    while (count < length) {
+      int c = timedRead();
+      if (c < 0) {
+        break;
+      }
+      buffer[count] = char(c);
+      count += 1u;
+    }
+    return count;
+  }
+
+  size_t readBytes(uint8_t* buffer, size_t length) { return readBytes(reinterpret_cast<char*>(buffer), length); }
+
+  String readString() {
+    String string;
+    int c;
+    while ((c = timedRead()) >= 0) {
+      string += char(c);
+    }
+    return string;
+  }
+
+  String readStringUntil(char terminator) {
+    String string;
+    int c;
+    while ((c = timedRead()) >= 0 && c != terminator) {
+      string += char(c);
+    }
+    return string;
+  }
+};
+
+#endif
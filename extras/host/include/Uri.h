@@ -0,0 +1,26 @@
+#ifndef IOT_CORE_HOST_URI_H_
+#define IOT_CORE_HOST_URI_H_
+
+#include <Arduino.h>
+#include <vector>
+
+/**
+ * Host stand-in for the Uri class of the ESP8266WebServer library, matches
+ * the request URI exactly.
+ */
+class Uri {
+protected:
+  const String _uri;
+
+public:
+  Uri(const char* uri) : _uri(uri) {}
+  Uri(const String& uri) : _uri(uri) {}
+  Uri(const __FlashStringHelper* uri) : _uri(uri) {}
+  virtual ~Uri() {}
+
+  virtual Uri* clone() const { return new Uri(_uri); }
+  virtual void initPathArgs(std::vector<String>& /*pathArgs*/) {}
+  virtual bool canHandle(const String& requestUri, std::vector<String>& /*pathArgs*/) { return _uri == requestUri; }
+};
+
+#endif
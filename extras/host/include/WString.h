@@ -0,0 +1,184 @@
+#ifndef IOT_CORE_HOST_WSTRING_H_
+#define IOT_CORE_HOST_WSTRING_H_
+
+/**
+ * Host stand-in for the Arduino String class, backed by std::string.
+ *
+ * Like the ESP8266 String, only up to 11 characters are stored inline, longer
+ * strings are always on the heap, so allocation counts match the device.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <strings.h>
+#include "pgmspace.h"
+
+class __FlashStringHelper;
+#define FPSTR(pstr_pointer) (reinterpret_cast<const __FlashStringHelper*>(pstr_pointer))
+#define F(string_literal) (FPSTR(PSTR(string_literal)))
+
+class String final {
+  // the inline capacity of the ESP8266 String, std::string keeps up to 15 characters inline
+  static constexpr size_t SSO_LENGTH = 11u;
+  static constexpr size_t HEAP_CAPACITY = 16u;
+
+  std::string _string {};
+
+  void spill() {
+    if (_string.length() > SSO_LENGTH && _string.capacity() < HEAP_CAPACITY) {
+      _string.reserve(HEAP_CAPACITY);
+    }
+  }
+
+  static std::string fromNumber(unsigned long long value, bool negative, unsigned char base) {
+    char buffer[66];
+    char* end = buffer + sizeof(buffer) - 1u;
+    char* start = end;
+    *end = '\0';
+    do {
+      unsigned digit = unsigned(value % base);
+      *--start = char(digit < 10u ? '0' + digit : 'a' + digit - 10u);
+      value /= base;
+    } while (value > 0u);
+    if (negative) {
+      *--start = '-';
+    }
+    return start;
+  }
+
+  template<typename T>
+  static std::string fromSigned(T value, unsigned char base) {
+    if (value < 0 && base == 10u) {
+      return fromNumber((unsigned long long)(-(long long)value), true, base);
+    }
+    return fromNumber((unsigned long long)(std::make_unsigned_t<T>)value, false, base);
+  }
+
+  static std::string fromFloat(double value, unsigned char decimalPlaces) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+    return buffer;
+  }
+
+public:
+  String() {}
+  String(const char* cstr) : _string(cstr == nullptr ? "" : cstr) { spill(); }
+  String(const char* cstr, unsigned int length) : _string(cstr, length) { spill(); }
+  String(const __FlashStringHelper* pstr) : String(reinterpret_cast<const char*>(pstr)) {}
+  String(const String& other) : _string(other._string) { spill(); }
+  String(String&& other) noexcept : _string(std::move(other._string)) { spill(); }
+  String& operator=(const String& other) { _string = other._string; spill(); return *this; }
+  String& operator=(String&& other) noexcept { _string = std::move(other._string); spill(); return *this; }
+  String(const std::string& string) : _string(string) { spill(); }
+  explicit String(char c) : _string(1u, c) { spill(); }
+  explicit String(unsigned char value, unsigned char base = 10u) : _string(fromNumber(value, false, base)) { spill(); }
+  explicit String(int value, unsigned char base = 10u) : _string(fromSigned(value, base)) { spill(); }
+  explicit String(unsigned int value, unsigned char base = 10u) : _string(fromNumber(value, false, base)) { spill(); }
+  explicit String(long value, unsigned char base = 10u) : _string(fromSigned(value, base)) { spill(); }
+  explicit String(unsigned long value, unsigned char base = 10u) : _string(fromNumber(value, false, base)) { spill(); }
+  explicit String(long long value, unsigned char base = 10u) : _string(fromSigned(value, base)) { spill(); }
+  explicit String(unsigned long long value, unsigned char base = 10u) : _string(fromNumber(value, false, base)) { spill(); }
+  explicit String(float value, unsigned char decimalPlaces = 2u) : _string(fromFloat(value, decimalPlaces)) { spill(); }
+  explicit String(double value, unsigned char decimalPlaces = 2u) : _string(fromFloat(value, decimalPlaces)) { spill(); }
+
+  const char* c_str() const { return _string.c_str(); }
+  char* begin() { return &_string[0]; }
+  char* end() { return begin() + _string.length(); }
+  const char* begin() const { return c_str(); }
+  const char* end() const { return c_str() + _string.length(); }
+  unsigned int length() const { return _string.length(); }
+  bool isEmpty() const { return _string.empty(); }
+  bool reserve(unsigned int size) { _string.reserve(size > SSO_LENGTH ? std::max<size_t>(size, HEAP_CAPACITY) : size); return true; }
+  void clear() { _string.clear(); }
+  const std::string& str() const { return _string; }
+
+  bool concat(const String& string) { _string += string._string; spill(); return true; }
+  bool concat(const char* cstr) { if (cstr == nullptr) return false; _string += cstr; spill(); return true; }
+  bool concat(const char* cstr, unsigned int length) { if (cstr == nullptr) return false; _string.append(cstr, length); spill(); return true; }
+  bool concat(const __FlashStringHelper* pstr) { return concat(reinterpret_cast<const char*>(pstr)); }
+  bool concat(char c) { _string += c; spill(); return true; }
+  bool concat(unsigned char value) { return concat(String(value)); }
+  bool concat(int value) { return concat(String(value)); }
+  bool concat(unsigned int value) { return concat(String(value)); }
+  bool concat(long value) { return concat(String(value)); }
+  bool concat(unsigned long value) { return concat(String(value)); }
+  bool concat(long long value) { return concat(String(value)); }
+  bool concat(unsigned long long value) { return concat(String(value)); }
+  bool concat(float value) { return concat(String(value)); }
+  bool concat(double value) { return concat(String(value)); }
+
+  template<typename T>
+  String& operator+=(const T& value) { concat(value); return *this; }
+
+  template<typename T>
+  friend String operator+(const String& lhs, const T& rhs) { String result {lhs}; result.concat(rhs); return result; }
+  friend String operator+(const char* lhs, const String& rhs) { String result {lhs}; result.concat(rhs); return result; }
+
+  bool equals(const String& other) const { return _string == other._string; }
+  bool equals(const char* cstr) const { return _string == (cstr == nullptr ? "" : cstr); }
+  bool equalsIgnoreCase(const String& other) const { return length() == other.length() && strcasecmp(c_str(), other.c_str()) == 0; }
+  int compareTo(const String& other) const { return _string.compare(other._string); }
+  bool operator==(const String& other) const { return equals(other); }
+  bool operator==(const char* cstr) const { return equals(cstr); }
+  bool operator!=(const String& other) const { return !equals(other); }
+  bool operator!=(const char* cstr) const { return !equals(cstr); }
+  bool operator<(const String& other) const { return _string < other._string; }
+  bool operator>(const String& other) const { return _string > other._string; }
+  bool operator<=(const String& other) const { return _string <= other._string; }
+  bool operator>=(const String& other) const { return _string >= other._string; }
+  bool startsWith(const String& prefix) const { return _string.compare(0u, prefix.length(), prefix._string) == 0; }
+  bool startsWith(const String& prefix, unsigned int offset) const { return offset <= length() && _string.compare(offset, prefix.length(), prefix._string) == 0; }
+  bool endsWith(const String& suffix) const { return length() >= suffix.length() && _string.compare(length() - suffix.length(), suffix.length(), suffix._string) == 0; }
+
+  char charAt(unsigned int index) const { return index < length() ? _string[index] : '\0'; }
+  void setCharAt(unsigned int index, char c) { if (index < length()) _string[index] = c; }
+  char operator[](unsigned int index) const { return charAt(index); }
+  char& operator[](unsigned int index) { return _string[index]; }
+  void toCharArray(char* buffer, unsigned int bufferSize, unsigned int index = 0u) const {
+    if (bufferSize == 0u) return;
+    size_t copied = index < length() ? _string.copy(buffer, bufferSize - 1u, index) : 0u;
+    buffer[copied] = '\0';
+  }
+
+  int indexOf(char c, unsigned int fromIndex = 0u) const { auto index = _string.find(c, fromIndex); return index == std::string::npos ? -1 : int(index); }
+  int indexOf(const String& string, unsigned int fromIndex = 0u) const { auto index = _string.find(string._string, fromIndex); return index == std::string::npos ? -1 : int(index); }
+  int lastIndexOf(char c) const { auto index = _string.rfind(c); return index == std::string::npos ? -1 : int(index); }
+  int lastIndexOf(const String& string) const { auto index = _string.rfind(string._string); return index == std::string::npos ? -1 : int(index); }
+  String substring(unsigned int beginIndex) const { return beginIndex < length() ? String(_string.substr(beginIndex)) : String(); }
+  String substring(unsigned int beginIndex, unsigned int endIndex) const {
+    if (beginIndex > endIndex) std::swap(beginIndex, endIndex);
+    return beginIndex < length() ? String(_string.substr(beginIndex, endIndex - beginIndex)) : String();
+  }
+
+  void replace(char find, char replace) { for (auto& c : _string) if (c == find) c = replace; }
+  void replace(const String& find, const String& replace) {
+    if (find.isEmpty()) return;
+    for (size_t index = _string.find(find._string); index != std::string::npos; index = _string.find(find._string, index + replace.length())) {
+      _string.replace(index, find.length(), replace._string);
+    }
+    spill();
+  }
+  void remove(unsigned int index) { if (index < length()) _string.erase(index); }
+  void remove(unsigned int index, unsigned int count) { if (index < length()) _string.erase(index, count); }
+  void toLowerCase() { for (auto& c : _string) c = char(tolower(c)); }
+  void toUpperCase() { for (auto& c : _string) c = char(toupper(c)); }
+  void trim() {
+    size_t first = _string.find_first_not_of(" \t\r\n");
+    size_t last = _string.find_last_not_of(" \t\r\n");
+    _string = first == std::string::npos ? std::string() : _string.substr(first, last - first + 1u);
+  }
+
+  long toInt() const { return atol(c_str()); }
+  float toFloat() const { return float(atof(c_str())); }
+  double toDouble() const { return atof(c_str()); }
+};
+
+inline const String emptyString {};
+
+#endif
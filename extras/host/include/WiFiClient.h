@@ -0,0 +1,221 @@
+#ifndef IOT_CORE_HOST_WIFICLIENT_H_
+#define IOT_CORE_HOST_WIFICLIENT_H_
+
+#include <Arduino.h>
+#include "IPAddress.h"
+#include "host/Socket.h"
+
+namespace host {
+
+inline int g_writeCapacity = 1460;
+
+/**
+ * Sets what availableForWrite() returns for all clients, e.g. 0 to simulate
+ * clients which do not read (the send buffer is full).
+ */
+inline void setWriteCapacity(int bytes) { g_writeCapacity = bytes; }
+
+}
+
+/**
+ * Host stand-in for WiFiClient over a real TCP socket. Copies share the same
+ * connection, like on the device.
+ */
+class WiFiClient : public Stream {
+  host::SocketPtr _socket {};
+  int _peeked = -1;
+
+protected:
+  void waitForData() override {
+    if (_socket) {
+      _socket->waitReadable(10);
+    }
+  }
+
+public:
+  WiFiClient() {}
+  explicit WiFiClient(host::SocketPtr socket) : _socket(socket) {}
+
+  int connect(IPAddress ip, uint16_t port) {
+    stop();
+    auto socket = std::make_shared<host::Socket>(::socket(AF_INET, SOCK_STREAM, 0));
+    if (!socket->valid()) {
+      return 0;
+    }
+    sockaddr_in address = host::toSocketAddress(ip, port);
+    if (::connect(socket->fd(), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 && errno != EINPROGRESS) {
+      return 0;
+    }
+    if (!socket->waitWritable(int(_timeout))) {
+      return 0;
+    }
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (getsockopt(socket->fd(), SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+      return 0;
+    }
+    _socket = socket;
+    return 1;
+  }
+
+  int connect(const char* hostName, uint16_t port) {
+    IPAddress ip;
+    if (strcmp(hostName, "localhost") == 0) {
+      ip = host::LOOPBACK;
+    } else if (!ip.fromString(hostName)) {
+      return 0;
+    }
+    return connect(ip, port);
+  }
+
+  int connect(const String& hostName, uint16_t port) { return connect(hostName.c_str(), port); }
+
+  uint8_t connected() {
+    if (!_socket || !_socket->valid()) {
+      return 0u;
+    }
+    if (_peeked >= 0) {
+      return 1u;
+    }
+    char c;
+    ssize_t result = recv(_socket->fd(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return result > 0 || (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) ? 1u : 0u;
+  }
+
+  operator bool() { return connected(); }
+
+  uint8_t status() { return connected() ? 4u /* ESTABLISHED */ : 0u /* CLOSED */; }
+
+  int available() override {
+    if (!_socket || !_socket->valid()) {
+      return 0;
+    }
+    int count = 0;
+    if (ioctl(_socket->fd(), FIONREAD, &count) != 0) {
+      count = 0;
+    }
+    return count + (_peeked >= 0 ? 1 : 0);
+  }
+
+  int read() override {
+    if (_peeked >= 0) {
+      int c = _peeked;
+      _peeked = -1;
+      return c;
+    }
+    uint8_t c;
+    return read(&c, 1u) == 1 ? c : -1;
+  }
+
+  int read(uint8_t* buffer, size_t size) override {
+    if (!_socket || !_socket->valid() || size == 0u) {
+      return 0;
+    }
+    size_t count = 0u;
+    if (_peeked >= 0) {
+      buffer[count++] = uint8_t(_peeked);
+      _peeked = -1;
+    }
+    ssize_t result = recv(_socket->fd(), buffer + count, size - count, MSG_DONTWAIT);
+    return int(count) + (result > 0 ? int(result) : 0);
+  }
+
+  int peek() override {
+    if (_peeked < 0) {
+      _peeked = read();
+    }
+    return _peeked;
+  }
+
+  size_t write(uint8_t c) override { return write(&c, 1u); }
+
+  size_t write(const uint8_t* buffer, size_t size) override {
+    if (!_socket || !_socket->valid()) {
+      return 0u;
+    }
+    size_t written = 0u;
+    while (written < size) {
+      ssize_t result = send(_socket->fd(), buffer + written, size - written, MSG_NOSIGNAL);
+      if (result > 0) {
+        written += size_t(result);
+      } else if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        if (!_socket->waitWritable(int(_timeout))) {
+          break;
+        }
+      } else {
+        break;
+      }
+    }
+    return written;
+  }
+
+  using Print::write;
+
+  size_t write_P(PGM_P buffer, size_t size) { return write(reinterpret_cast<const uint8_t*>(buffer), size); }
+
+  int availableForWrite() override { return _socket && _socket->valid() ? host::g_writeCapacity : 0; }
+
+  void flush() override {}
+
+  bool flush(unsigned int /*maxWaitMs*/) { return true; }
+
+  bool stop(unsigned int /*maxWaitMs*/ = 0u) {
+    if (_socket) {
+      _socket->close();
+      _socket.reset();
+    }
+    _peeked = -1;
+    return true;
+  }
+
+  IPAddress remoteIP() const {
+    sockaddr_in address {};
+    socklen_t length = sizeof(address);
+    if (!_socket || getpeername(_socket->fd(), reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+      return {};
+    }
+    return host::fromSocketAddress(address);
+  }
+
+  uint16_t remotePort() const {
+    sockaddr_in address {};
+    socklen_t length = sizeof(address);
+    if (!_socket || getpeername(_socket->fd(), reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+      return 0u;
+    }
+    return ntohs(address.sin_port);
+  }
+
+  IPAddress localIP() const {
+    sockaddr_in address {};
+    socklen_t length = sizeof(address);
+    if (!_socket || getsockname(_socket->fd(), reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+      return {};
+    }
+    return host::fromSocketAddress(address);
+  }
+
+  uint16_t localPort() const {
+    sockaddr_in address {};
+    socklen_t length = sizeof(address);
+    if (!_socket || getsockname(_socket->fd(), reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+      return 0u;
+    }
+    return ntohs(address.sin_port);
+  }
+
+  void setNoDelay(bool noDelay) {
+    if (_socket) {
+      int value = noDelay ? 1 : 0;
+      setsockopt(_socket->fd(), IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+    }
+  }
+
+  void keepAlive(uint16_t /*idleSec*/ = 0u, uint16_t /*intvSec*/ = 0u, uint8_t /*count*/ = 0u) {}
+  void disableKeepAlive() {}
+
+  bool operator==(const WiFiClient& other) const { return _socket == other._socket; }
+  bool operator!=(const WiFiClient& other) const { return _socket != other._socket; }
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef IOT_CORE_HOST_WIFIMANAGER_H_
+#define IOT_CORE_HOST_WIFIMANAGER_H_
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+/**
+ * Host stand-in for WiFiManager, which never opens a configuration portal
+ * and simply (re)connects the host WiFi with the saved network.
+ */
+class WiFiManager final {
+  bool _configPortalBlocking = true;
+  bool _autoReconnect = true;
+  String _hostname {};
+  size_t _processCount = 0u;
+
+public:
+  void setConfigPortalBlocking(bool blocking) { _configPortalBlocking = blocking; }
+  void setWiFiAutoReconnect(bool autoReconnect) { _autoReconnect = autoReconnect; WiFi.setAutoReconnect(autoReconnect); }
+  void setDebugOutput(bool /*debug*/) {}
+  void setConfigPortalTimeout(unsigned long /*seconds*/) {}
+
+  bool setHostname(const char* hostname) { _hostname = hostname; return WiFi.hostname(hostname); }
+  bool setHostname(String hostname) { return setHostname(hostname.c_str()); }
+
+  bool autoConnect() { return autoConnect(_hostname.c_str()); }
+
+  bool autoConnect(const char* /*apName*/, const char* /*apPassword*/ = nullptr) {
+    WiFi.mode(WIFI_STA);
+    if (!WiFi.isConnected()) {
+      WiFi.begin();
+    }
+    return WiFi.isConnected();
+  }
+
+  bool startConfigPortal(const char* /*apName*/ = nullptr, const char* /*apPassword*/ = nullptr) { return WiFi.isConnected(); }
+
+  bool process() {
+    _processCount += 1u;
+    return false;
+  }
+
+  bool getWiFiIsSaved() { return !WiFi.SSID().isEmpty(); }
+
+  void resetSettings() { WiFi.disconnect(true); }
+  bool erase() { return erase(false); }
+  bool erase(bool /*opt*/) { resetSettings(); return true; }
+
+  // host only
+  size_t processCount() const { return _processCount; }
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef IOT_CORE_HOST_WIFISERVER_H_
+#define IOT_CORE_HOST_WIFISERVER_H_
+
+#include "WiFiClient.h"
+
+/**
+ * Host stand-in for WiFiServer, listens on a real TCP socket bound to the
+ * loopback interface.
+ */
+class WiFiServer {
+public:
+  using ClientType = WiFiClient;
+
+private:
+  uint16_t _port;
+  host::SocketPtr _listener {};
+  bool _noDelay = false;
+
+public:
+  explicit WiFiServer(uint16_t port) : _port(port) {}
+  WiFiServer(IPAddress /*address*/, uint16_t port) : _port(port) {}
+
+  void begin() { begin(_port); }
+
+  void begin(uint16_t port, uint8_t backlog = 5u) {
+    close();
+    _port = port;
+    auto listener = std::make_shared<host::Socket>(::socket(AF_INET, SOCK_STREAM, 0));
+    if (!listener->valid()) {
+      return;
+    }
+    int reuse = 1;
+    setsockopt(listener->fd(), SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = host::toSocketAddress(host::LOOPBACK, _port);
+    if (bind(listener->fd(), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener->fd(), backlog) != 0) {
+      return;
+    }
+    socklen_t length = sizeof(address);
+    if (_port == 0u && getsockname(listener->fd(), reinterpret_cast<sockaddr*>(&address), &length) == 0) {
+      _port = ntohs(address.sin_port);
+    }
+    _listener = listener;
+  }
+
+  void close() { _listener.reset(); }
+  void stop() { close(); }
+
+  uint8_t status() const { return _listener ? 1u /* LISTEN */ : 0u /* CLOSED */; }
+  uint16_t port() const { return _port; }
+
+  bool hasClient() const { return _listener && _listener->waitReadable(0); }
+
+  WiFiClient accept() {
+    if (!_listener) {
+      return {};
+    }
+    int fd = ::accept(_listener->fd(), nullptr, nullptr);
+    if (fd < 0) {
+      return {};
+    }
+    WiFiClient client {std::make_shared<host::Socket>(fd)};
+    client.setNoDelay(_noDelay);
+    return client;
+  }
+
+  WiFiClient available() { return accept(); }
+
+  void setNoDelay(bool noDelay) { _noDelay = noDelay; }
+  bool getNoDelay() const { return _noDelay; }
+};
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef IOT_CORE_HOST_WIFIUDP_H_
+#define IOT_CORE_HOST_WIFIUDP_H_
+
+#include <Arduino.h>
+#include <vector>
+#include "IPAddress.h"
+#include "host/Socket.h"
+
+/**
+ * Host stand-in for WiFiUDP over a real UDP socket. To keep the host
+ * contained, all packets are sent to the loopback interface (keeping the
+ * destination port) and receiving sockets are bound to it.
+ */
+class WiFiUDP : public Stream {
+  host::SocketPtr _socket {};
+  uint16_t _localPort = 0u;
+
+  std::vector<uint8_t> _txBuffer {};
+  uint16_t _txPort = 0u;
+  bool _txActive = false;
+
+  std::vector<uint8_t> _rxBuffer {};
+  size_t _rxPosition = 0u;
+  IPAddress _rxAddress {};
+  uint16_t _rxPort = 0u;
+
+  bool open() {
+    if (!_socket) {
+      auto socket = std::make_shared<host::Socket>(::socket(AF_INET, SOCK_DGRAM, 0));
+      if (!socket->valid()) {
+        return false;
+      }
+      _socket = socket;
+    }
+    return true;
+  }
+
+public:
+  uint8_t begin(uint16_t port) {
+    stop();
+    if (!open()) {
+      return 0u;
+    }
+    int reuse = 1;
+    setsockopt(_socket->fd(), SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = host::toSocketAddress(host::LOOPBACK, port);
+    if (bind(_socket->fd(), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+      stop();
+      return 0u;
+    }
+    socklen_t length = sizeof(address);
+    getsockname(_socket->fd(), reinterpret_cast<sockaddr*>(&address), &length);
+    _localPort = ntohs(address.sin_port);
+    return 1u;
+  }
+
+  void stop() {
+    _socket.reset();
+    _localPort = 0u;
+    _txBuffer.clear();
+    _txActive = false;
+    _rxBuffer.clear();
+    _rxPosition = 0u;
+  }
+
+  int beginPacket(IPAddress /*ip*/, uint16_t port) {
+    if (!open()) {
+      return 0;
+    }
+    _txBuffer.clear();
+    _txPort = port;
+    _txActive = true;
+    return 1;
+  }
+
+  int beginPacket(const char* /*hostName*/, uint16_t port) { return beginPacket(IPAddress {}, port); }
+
+  int endPacket() {
+    if (!_txActive || !_socket) {
+      return 0;
+    }
+    _txActive = false;
+    sockaddr_in address = host::toSocketAddress(host::LOOPBACK, _txPort);
+    ssize_t sent = sendto(_socket->fd(), _txBuffer.data(), _txBuffer.size(), 0, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    _txBuffer.clear();
+    return sent >= 0 ? 1 : 0;
+  }
+
+  size_t write(uint8_t c) override { return write(&c, 1u); }
+
+  size_t write(const uint8_t* buffer, size_t size) override {
+    if (!_txActive) {
+      return 0u;
+    }
+    _txBuffer.insert(_txBuffer.end(), buffer, buffer + size);
+    return size;
+  }
+
+  using Print::write;
+
+  int parsePacket() {
+    _rxBuffer.clear();
+    _rxPosition = 0u;
+    if (!_socket || _localPort == 0u) {
+      return 0;
+    }
+    uint8_t buffer[1536];
+    sockaddr_in address {};
+    socklen_t length = sizeof(address);
+    ssize_t received = recvfrom(_socket->fd(), buffer, sizeof(buffer), MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&address), &length);
+    if (received <= 0) {
+      return 0;
+    }
+    _rxBuffer.assign(buffer, buffer + received);
+    _rxAddress = host::fromSocketAddress(address);
+    _rxPort = ntohs(address.sin_port);
+    return int(received);
+  }
+
+  int available() override { return int(_rxBuffer.size() - _rxPosition); }
+
+  int read() override { return _rxPosition < _rxBuffer.size() ? _rxBuffer[_rxPosition++] : -1; }
+
+  int read(uint8_t* buffer, size_t size) override {
+    size_t count = std::min(size, _rxBuffer.size() - _rxPosition);
+    memcpy(buffer, _rxBuffer.data() + _rxPosition, count);
+    _rxPosition += count;
+    return int(count);
+  }
+
+  int read(char* buffer, size_t size) { return read(reinterpret_cast<uint8_t*>(buffer), size); }
+
+  int peek() override { return _rxPosition < _rxBuffer.size() ? _rxBuffer[_rxPosition] : -1; }
+
+  void flush() override { _rxPosition = _rxBuffer.size(); }
+
+  IPAddress remoteIP() const { return _rxAddress; }
+  uint16_t remotePort() const { return _rxPort; }
+  uint16_t localPort() const { return _localPort; }
+};
+
+#endif
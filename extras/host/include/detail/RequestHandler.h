@@ -0,0 +1,103 @@
+#ifndef IOT_CORE_HOST_DETAIL_REQUESTHANDLER_H_
+#define IOT_CORE_HOST_DETAIL_REQUESTHANDLER_H_
+
+#include <Arduino.h>
+#include <vector>
+#include <cassert>
+
+namespace esp8266webserver {
+
+template<typename ServerType>
+class ESP8266WebServerTemplate;
+
+/**
+ * Host stand-in for the RequestHandler base class of the ESP8266WebServer
+ * library.
+ */
+template<typename ServerType>
+class RequestHandler {
+  using WebServerType = ESP8266WebServerTemplate<ServerType>;
+
+  RequestHandler<ServerType>* _next = nullptr;
+
+protected:
+  std::vector<String> pathArgs;
+
+public:
+  virtual ~RequestHandler() {}
+
+  virtual bool canHandle(HTTPMethod /*method*/, const String& /*uri*/) { return false; }
+  virtual bool canUpload(const String& /*uri*/) { return false; }
+  virtual bool canRaw(const String& /*uri*/) { return false; }
+  virtual bool handle(WebServerType& /*server*/, HTTPMethod /*requestMethod*/, const String& /*requestUri*/) { return false; }
+  virtual void upload(WebServerType& /*server*/, const String& /*requestUri*/, HTTPUpload& /*upload*/) {}
+  virtual void raw(WebServerType& /*server*/, const String& /*requestUri*/, HTTPRaw& /*raw*/) {}
+
+  RequestHandler<ServerType>* next() { return _next; }
+  void next(RequestHandler<ServerType>* handler) { _next = handler; }
+
+  const String& pathArg(unsigned int i) const {
+    assert(i < pathArgs.size());
+    return pathArgs[i];
+  }
+};
+
+/**
+ * Handler which calls a function for requests matching a Uri and method.
+ */
+template<typename ServerType>
+class FunctionRequestHandler : public RequestHandler<ServerType> {
+  using WebServerType = ESP8266WebServerTemplate<ServerType>;
+
+  typename WebServerType::THandlerFunction _function;
+  typename WebServerType::THandlerFunction _uploadFunction;
+  Uri* _uri;
+  HTTPMethod _method;
+
+public:
+  FunctionRequestHandler(typename WebServerType::THandlerFunction function, typename WebServerType::THandlerFunction uploadFunction, const Uri& uri, HTTPMethod method)
+    : _function(function), _uploadFunction(uploadFunction), _uri(uri.clone()), _method(method) {
+    _uri->initPathArgs(this->pathArgs);
+  }
+
+  ~FunctionRequestHandler() { delete _uri; }
+
+  bool canHandle(HTTPMethod requestMethod, const String& requestUri) override {
+    if (_method != HTTP_ANY && _method != requestMethod) {
+      return false;
+    }
+    return _uri->canHandle(requestUri, this->pathArgs);
+  }
+
+  bool canUpload(const String& requestUri) override {
+    return _uploadFunction && _method == HTTP_POST && _uri->canHandle(requestUri, this->pathArgs);
+  }
+
+  bool canRaw(const String& requestUri) override {
+    return _uploadFunction && _method != HTTP_GET && _uri->canHandle(requestUri, this->pathArgs);
+  }
+
+  bool handle(WebServerType& /*server*/, HTTPMethod requestMethod, const String& requestUri) override {
+    if (!canHandle(requestMethod, requestUri)) {
+      return false;
+    }
+    _function();
+    return true;
+  }
+
+  void upload(WebServerType& /*server*/, const String& requestUri, HTTPUpload& /*upload*/) override {
+    if (canUpload(requestUri)) {
+      _uploadFunction();
+    }
+  }
+
+  void raw(WebServerType& /*server*/, const String& requestUri, HTTPRaw& /*raw*/) override {
+    if (canRaw(requestUri)) {
+      _uploadFunction();
+    }
+  }
+};
+
+}
+
+#endif
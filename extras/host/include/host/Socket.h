@@ -0,0 +1,104 @@
+#ifndef IOT_CORE_HOST_SOCKET_H_
+#define IOT_CORE_HOST_SOCKET_H_
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../IPAddress.h"
+
+namespace host {
+
+/**
+ * Owner of a (non-blocking) POSIX socket, shared between copies of the
+ * Arduino networking classes (like WiFiClient on the device).
+ */
+class Socket final {
+  int _fd;
+
+public:
+  explicit Socket(int fd) : _fd(fd) {
+    if (_fd >= 0) {
+      fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+    }
+  }
+
+  Socket(const Socket&) = delete;
+  Socket& operator=(const Socket&) = delete;
+
+  ~Socket() { close(); }
+
+  int fd() const { return _fd; }
+  bool valid() const { return _fd >= 0; }
+
+  void close() {
+    if (_fd >= 0) {
+      ::close(_fd);
+      _fd = -1;
+    }
+  }
+
+  /**
+   * Waits (in real time) until the socket is readable or the timeout expired.
+   */
+  bool waitReadable(int timeoutMs) const {
+    if (_fd < 0) {
+      return false;
+    }
+    pollfd descriptor {_fd, POLLIN, 0};
+    return poll(&descriptor, 1, timeoutMs) > 0;
+  }
+
+  bool waitWritable(int timeoutMs) const {
+    if (_fd < 0) {
+      return false;
+    }
+    pollfd descriptor {_fd, POLLOUT, 0};
+    return poll(&descriptor, 1, timeoutMs) > 0;
+  }
+};
+
+using SocketPtr = std::shared_ptr<Socket>;
+
+inline sockaddr_in toSocketAddress(IPAddress address, uint16_t port) {
+  sockaddr_in socketAddress {};
+  socketAddress.sin_family = AF_INET;
+  socketAddress.sin_port = htons(port);
+  socketAddress.sin_addr.s_addr = uint32_t(address);
+  return socketAddress;
+}
+
+inline IPAddress fromSocketAddress(const sockaddr_in& socketAddress) {
+  return IPAddress(uint32_t(socketAddress.sin_addr.s_addr));
+}
+
+inline const IPAddress LOOPBACK {127, 0, 0, 1};
+
+/**
+ * Returns a currently unused local TCP port, e.g. to start a server on.
+ */
+inline uint16_t freeLocalPort() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in address = toSocketAddress(LOOPBACK, 0u);
+  socklen_t length = sizeof(address);
+  uint16_t port = 0u;
+  if (fd >= 0 && bind(fd, reinterpret_cast<sockaddr*>(&address), length) == 0 && getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) == 0) {
+    port = ntohs(address.sin_port);
+  }
+  if (fd >= 0) {
+    ::close(fd);
+  }
+  return port;
+}
+
+}
+
+#endif
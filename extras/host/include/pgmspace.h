@@ -0,0 +1,47 @@
+#ifndef IOT_CORE_HOST_PGMSPACE_H_
+#define IOT_CORE_HOST_PGMSPACE_H_
+
+/**
+ * Host stand-in for the PROGMEM API. There is no separate flash address space
+ * on the host, so everything maps to the plain memory functions.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstdarg>
+#include <strings.h>
+
+#define PROGMEM
+#define PGM_P const char*
+#define PGM_VOID_P const void*
+#define PSTR(s) (s)
+
+#define pgm_read_byte(addr) (*reinterpret_cast<const uint8_t*>(addr))
+#define pgm_read_word(addr) (*reinterpret_cast<const uint16_t*>(addr))
+#define pgm_read_dword(addr) (*reinterpret_cast<const uint32_t*>(addr))
+#define pgm_read_float(addr) (*reinterpret_cast<const float*>(addr))
+#define pgm_read_ptr(addr) (*reinterpret_cast<const void* const*>(addr))
+
+#define memcpy_P memcpy
+#define memcmp_P memcmp
+#define memchr_P memchr
+#define strlen_P strlen
+#define strnlen_P strnlen
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strcat_P strcat
+#define strncat_P strncat
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcasecmp_P strcasecmp
+#define strncasecmp_P strncasecmp
+#define strstr_P strstr
+#define strchr_P strchr
+#define strrchr_P strrchr
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+#define vsnprintf_P vsnprintf
+#define printf_P printf
+
+#endif
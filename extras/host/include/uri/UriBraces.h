@@ -0,0 +1,63 @@
+#ifndef IOT_CORE_HOST_URI_URIBRACES_H_
+#define IOT_CORE_HOST_URI_URIBRACES_H_
+
+#include "../Uri.h"
+
+/**
+ * Host stand-in for UriBraces, where each "{}" captures a path argument.
+ */
+class UriBraces : public Uri {
+public:
+  explicit UriBraces(const char* uri) : Uri(uri) {}
+  explicit UriBraces(const String& uri) : Uri(uri) {}
+
+  Uri* clone() const override final { return new UriBraces(_uri); }
+
+  void initPathArgs(std::vector<String>& pathArgs) override final {
+    size_t count = 0u;
+    for (int start = _uri.indexOf("{}"); start >= 0; start = _uri.indexOf("{}", start + 2)) {
+      count += 1u;
+    }
+    pathArgs.resize(count);
+  }
+
+  bool canHandle(const String& requestUri, std::vector<String>& pathArgs) override final {
+    if (Uri::canHandle(requestUri, pathArgs)) {
+      return true;
+    }
+
+    size_t uriLength = _uri.length();
+    unsigned int pathArgIndex = 0u;
+    unsigned int requestUriIndex = 0u;
+    for (unsigned int i = 0u; i < uriLength; ++i, ++requestUriIndex) {
+      char uriChar = _uri[i];
+      char requestUriChar = requestUri[requestUriIndex];
+
+      if (uriChar == requestUriChar) {
+        continue;
+      }
+      if (uriChar != '{') {
+        return false;
+      }
+
+      i += 2u; // index of char after '}'
+      if (i >= uriLength) {
+        // there is no char after '}'
+        pathArgs[pathArgIndex] = requestUri.substring(requestUriIndex);
+        return pathArgs[pathArgIndex].indexOf('/') == -1; // path argument may not contain a '/'
+      } else {
+        int uriIndex = requestUri.indexOf(_uri[i], requestUriIndex);
+        if (uriIndex < 0) {
+          return false;
+        }
+        pathArgs[pathArgIndex] = requestUri.substring(requestUriIndex, uriIndex);
+        requestUriIndex = (unsigned int)uriIndex;
+      }
+      pathArgIndex += 1u;
+    }
+
+    return requestUriIndex >= requestUri.length();
+  }
+};
+
+#endif
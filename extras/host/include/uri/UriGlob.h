@@ -0,0 +1,22 @@
+#ifndef IOT_CORE_HOST_URI_URIGLOB_H_
+#define IOT_CORE_HOST_URI_URIGLOB_H_
+
+#include "../Uri.h"
+#include <fnmatch.h>
+
+/**
+ * Host stand-in for UriGlob, matches the request URI against a glob pattern.
+ */
+class UriGlob : public Uri {
+public:
+  explicit UriGlob(const char* uri) : Uri(uri) {}
+  explicit UriGlob(const String& uri) : Uri(uri) {}
+
+  Uri* clone() const override final { return new UriGlob(_uri); }
+
+  bool canHandle(const String& requestUri, std::vector<String>& /*pathArgs*/) override final {
+    return fnmatch(_uri.c_str(), requestUri.c_str(), 0) == 0;
+  }
+};
+
+#endif
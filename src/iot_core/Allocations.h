@@ -0,0 +1,304 @@
+#ifndef IOT_CORE_ALLOCATIONS_H_
+#define IOT_CORE_ALLOCATIONS_H_
+
+#include <toolbox.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include "Interfaces.h"
+
+#if defined(IOT_CORE_TRACK_ALLOCATIONS) && defined(ARDUINO_ARCH_ESP8266) && defined(UMM_STATS_FULL)
+#define IOT_CORE_UMM_ALLOCATIONS 1
+#include <umm_malloc/umm_malloc.h>
+#elif defined(IOT_CORE_TRACK_ALLOCATIONS) && defined(IOT_CORE_HOST) && defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define IOT_CORE_MALLOC_ALLOCATIONS 1
+#endif
+
+namespace iot_core {
+
+/**
+ * Global counters of the heap allocations.
+ *
+ * Counting is only done if IOT_CORE_TRACK_ALLOCATIONS is defined, where the
+ * counts come from depends on the platform:
+ *
+ *  - ESP8266 with UMM_STATS_FULL defined for the core (e.g. in build_opt.h):
+ *    the counters of umm_malloc, so all allocations including those made via
+ *    malloc (e.g. by Arduino Strings) are counted. umm_malloc does not sum up
+ *    the allocated bytes, so bytes are always 0, the peak is available.
+ *  - Host (glibc): malloc and friends are replaced to count all allocations.
+ *  - Otherwise: operator new/delete are replaced, allocations made directly
+ *    via malloc are not counted.
+ *
+ * The replacements (if any) have to be defined in exactly one translation
+ * unit of the application with IOT_CORE_ALLOCATION_HOOKS.
+ */
+class AllocationTracker final {
+#ifdef IOT_CORE_UMM_ALLOCATIONS
+  // the used heap is derived from the free heap, relative to a base larger than any ESP8266 heap
+  static constexpr uint32_t HEAP_BASE = 0x100000u;
+
+  static inline uint32_t _peak = 0u; // the minimum free heap of umm_malloc is reset when a peak is set
+
+public:
+  static constexpr bool enabled() { return true; }
+
+  static uint32_t count() { return uint32_t(umm_get_malloc_count() + umm_get_realloc_count()); }
+  static uint32_t current() { return HEAP_BASE - uint32_t(umm_free_heap_size()); }
+  static uint32_t bytes() { return 0u; }
+
+  static uint32_t peak() {
+    return std::max(_peak, HEAP_BASE - uint32_t(umm_free_heap_size_min()));
+  }
+
+  static void peak(uint32_t peak) {
+    _peak = peak;
+    umm_free_heap_size_min_reset();
+  }
+#else
+  static inline uint32_t _count = 0u;
+  static inline uint32_t _bytes = 0u;
+  static inline uint32_t _current = 0u;
+  static inline uint32_t _peak = 0u;
+
+public:
+  static constexpr bool enabled() {
+#ifdef IOT_CORE_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  static void allocated(size_t size) {
+    _count += 1u;
+    _bytes += size;
+    _current += size;
+    _peak = std::max(_peak, _current);
+  }
+
+  static void freed(size_t size) {
+    _current -= size;
+  }
+
+  static uint32_t count() { return _count; }
+  static uint32_t bytes() { return _bytes; }
+  static uint32_t current() { return _current; }
+  static uint32_t peak() { return _peak; }
+
+  static void peak(uint32_t peak) { _peak = peak; }
+#endif
+};
+
+/**
+ * Allocations made within a scope: count and bytes of all allocations and
+ * the peak of the live bytes above those at the start of the scope.
+ */
+struct AllocationCounters final {
+  uint32_t count = 0u;
+  uint32_t bytes = 0u;
+  uint32_t peak = 0u;
+};
+
+/**
+ * Accumulated allocations of repeatedly executed scopes, e.g. each pass of
+ * the loop or each request.
+ */
+class AllocationStatistics final {
+  uint32_t _passes = 0u;
+  uint32_t _count = 0u;
+  uint32_t _bytes = 0u;
+  uint32_t _peak = 0u;
+  AllocationCounters _last {};
+
+public:
+  void add(const AllocationCounters& counters) {
+    _passes += 1u;
+    _count += counters.count;
+    _bytes += counters.bytes;
+    _peak = std::max(_peak, counters.peak);
+    _last = counters;
+  }
+
+  uint32_t passes() const { return _passes; }
+  uint32_t count() const { return _count; }
+  uint32_t bytes() const { return _bytes; }
+  uint32_t peak() const { return _peak; }
+  const AllocationCounters& last() const { return _last; }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const {
+    collector.addNumber(F("passes"), _passes);
+    collector.addNumber(F("count"), _count);
+    collector.addNumber(F("bytes"), _bytes);
+    collector.addNumber(F("peak"), _peak);
+    collector.addNumber(F("lastCount"), _last.count);
+  }
+};
+
+/**
+ * Measures the allocations made while it exists, the result is either stored
+ * in the given counters or added to the given statistics. Scopes can be
+ * nested.
+ */
+class AllocationScope final {
+#ifdef IOT_CORE_TRACK_ALLOCATIONS
+  AllocationCounters* _result = nullptr;
+  AllocationStatistics* _statistics = nullptr;
+  uint32_t _count;
+  uint32_t _bytes;
+  uint32_t _current;
+  uint32_t _outerPeak;
+
+  AllocationScope(AllocationCounters* result, AllocationStatistics* statistics)
+    : _result(result),
+    _statistics(statistics),
+    _count(AllocationTracker::count()),
+    _bytes(AllocationTracker::bytes()),
+    _current(AllocationTracker::current()),
+    _outerPeak(AllocationTracker::peak())
+  {
+    AllocationTracker::peak(_current);
+  }
+
+public:
+  explicit AllocationScope(AllocationCounters& result) : AllocationScope(&result, nullptr) {}
+  explicit AllocationScope(AllocationStatistics& statistics) : AllocationScope(nullptr, &statistics) {}
+
+  ~AllocationScope() {
+    uint32_t peak = AllocationTracker::peak();
+    AllocationCounters counters {AllocationTracker::count() - _count, AllocationTracker::bytes() - _bytes, peak - _current};
+    AllocationTracker::peak(std::max(_outerPeak, peak));
+    if (_result != nullptr) {
+      *_result = counters;
+    }
+    if (_statistics != nullptr) {
+      _statistics->add(counters);
+    }
+  }
+#else
+public:
+  explicit AllocationScope(AllocationCounters& result) { result = {}; }
+  explicit AllocationScope(AllocationStatistics&) {}
+#endif
+
+  AllocationScope(const AllocationScope&) = delete;
+  AllocationScope& operator=(const AllocationScope&) = delete;
+};
+
+#ifndef IOT_CORE_UMM_ALLOCATIONS
+namespace detail {
+
+// The size is stored in front of each block, so it is known when freed.
+static constexpr size_t ALLOCATION_HEADER_SIZE = alignof(std::max_align_t);
+
+inline void* trackedAllocate(size_t size) {
+  char* block = static_cast<char*>(malloc(size + ALLOCATION_HEADER_SIZE));
+  if (block == nullptr) {
+    return nullptr;
+  }
+  *reinterpret_cast<size_t*>(block) = size;
+  AllocationTracker::allocated(size);
+  return block + ALLOCATION_HEADER_SIZE;
+}
+
+inline void* trackedAllocateOrFail(size_t size) {
+  void* pointer = trackedAllocate(size);
+  if (pointer == nullptr) {
+#ifdef __cpp_exceptions
+    throw std::bad_alloc {};
+#else
+    abort();
+#endif
+  }
+  return pointer;
+}
+
+inline void trackedFree(void* pointer) {
+  if (pointer == nullptr) {
+    return;
+  }
+  char* block = static_cast<char*>(pointer) - ALLOCATION_HEADER_SIZE;
+  AllocationTracker::freed(*reinterpret_cast<size_t*>(block));
+  free(block);
+}
+
+}
+#endif
+
+}
+
+#if defined(IOT_CORE_UMM_ALLOCATIONS)
+// umm_malloc counts the allocations itself
+#define IOT_CORE_ALLOCATION_HOOKS
+#elif defined(IOT_CORE_MALLOC_ALLOCATIONS)
+#include <cerrno>
+#include <malloc.h>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* pointer);
+}
+
+namespace iot_core::detail {
+
+inline void* countAllocation(void* pointer) {
+  if (pointer != nullptr) {
+    AllocationTracker::allocated(malloc_usable_size(pointer));
+  }
+  return pointer;
+}
+
+inline void countFree(void* pointer) {
+  if (pointer != nullptr) {
+    AllocationTracker::freed(malloc_usable_size(pointer));
+  }
+}
+
+}
+
+/**
+ * Replaces malloc and friends of glibc (host only) to count all allocations,
+ * including those of operator new, has to be used in exactly one translation
+ * unit. The usable size of the blocks is counted.
+ */
+#define IOT_CORE_ALLOCATION_HOOKS \
+  extern "C" void* malloc(size_t size) { return iot_core::detail::countAllocation(__libc_malloc(size)); } \
+  extern "C" void* calloc(size_t count, size_t size) { return iot_core::detail::countAllocation(__libc_calloc(count, size)); } \
+  extern "C" void* memalign(size_t alignment, size_t size) { return iot_core::detail::countAllocation(__libc_memalign(alignment, size)); } \
+  extern "C" void* aligned_alloc(size_t alignment, size_t size) { return memalign(alignment, size); } \
+  extern "C" int posix_memalign(void** pointer, size_t alignment, size_t size) { *pointer = memalign(alignment, size); return *pointer == nullptr ? ENOMEM : 0; } \
+  extern "C" void free(void* pointer) { iot_core::detail::countFree(pointer); __libc_free(pointer); } \
+  extern "C" void* realloc(void* pointer, size_t size) { \
+    size_t previous = pointer != nullptr ? malloc_usable_size(pointer) : 0u; \
+    void* reallocated = __libc_realloc(pointer, size); \
+    if (reallocated != nullptr || size == 0u) { \
+      iot_core::AllocationTracker::freed(previous); \
+      iot_core::detail::countAllocation(reallocated); \
+    } \
+    return reallocated; \
+  }
+#elif defined(IOT_CORE_TRACK_ALLOCATIONS)
+/**
+ * Replaces the global operator new/delete to count the allocations, has to
+ * be used in exactly one translation unit (e.g. the sketch).
+ */
+#define IOT_CORE_ALLOCATION_HOOKS \
+  void* operator new(size_t size) { return iot_core::detail::trackedAllocateOrFail(size); } \
+  void* operator new[](size_t size) { return iot_core::detail::trackedAllocateOrFail(size); } \
+  void* operator new(size_t size, const std::nothrow_t&) noexcept { return iot_core::detail::trackedAllocate(size); } \
+  void* operator new[](size_t size, const std::nothrow_t&) noexcept { return iot_core::detail::trackedAllocate(size); } \
+  void operator delete(void* pointer) noexcept { iot_core::detail::trackedFree(pointer); } \
+  void operator delete[](void* pointer) noexcept { iot_core::detail::trackedFree(pointer); } \
+  void operator delete(void* pointer, size_t) noexcept { iot_core::detail::trackedFree(pointer); } \
+  void operator delete[](void* pointer, size_t) noexcept { iot_core::detail::trackedFree(pointer); } \
+  void operator delete(void* pointer, const std::nothrow_t&) noexcept { iot_core::detail::trackedFree(pointer); } \
+  void operator delete[](void* pointer, const std::nothrow_t&) noexcept { iot_core::detail::trackedFree(pointer); }
+#else
+#define IOT_CORE_ALLOCATION_HOOKS
+#endif
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef IOT_CORE_CLOCK_H_
+#define IOT_CORE_CLOCK_H_
+
+#include <Arduino.h>
+#include <algorithm>
+#include <limits>
+
+#if !defined(ESP8266)
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <chrono>
+#endif
+
+namespace iot_core {
+
+/**
+ * Clocks used for instrumentation (e.g. TimingStatistics and TimingHistogram).
+ *
+ * A clock provides a free running 32-bit tick counter via now(), which may
+ * wrap around. Durations are measured by since(start), which returns the
+ * elapsed time in the unit of the clock (see below) and is wrap-around safe
+ * as long as less than 2^32 ticks have elapsed.
+ */
+
+/**
+ * Clock based on micros(), measures in microseconds.
+ */
+struct MicrosClock final {
+  static uint32_t now() { return micros(); }
+  static uint32_t toNanos(uint32_t ticks) { return std::min<uint64_t>(uint64_t(ticks) * 1000u, std::numeric_limits<uint32_t>::max()); }
+  static uint32_t since(uint32_t startTicks) { return now() - startTicks; }
+};
+
+#if defined(ESP8266)
+
+/**
+ * CPU cycle counter of the ESP8266, which wraps around after ~53s (80 MHz)
+ * or ~26s (160 MHz).
+ */
+struct EspCycleCounter final {
+  static uint32_t IRAM_ATTR now() { return ESP.getCycleCount(); }
+  static uint32_t cyclesPerMicro() { return ESP.getCpuFreqMHz(); }
+};
+
+using CycleCounter = EspCycleCounter;
+
+#elif defined(__x86_64__) || defined(__i386__)
+
+/**
+ * Time stamp counter of the host CPU, its frequency is calibrated once
+ * against the steady clock.
+ */
+struct TscCycleCounter final {
+  static uint32_t now() { return uint32_t(__rdtsc()); }
+
+  static uint32_t cyclesPerMicro() {
+    static const uint32_t frequency = calibrate();
+    return frequency;
+  }
+
+private:
+  static uint32_t calibrate() {
+    using namespace std::chrono;
+    auto start = steady_clock::now();
+    uint64_t startTicks = __rdtsc();
+    while (steady_clock::now() - start < milliseconds(10)) {}
+    uint64_t ticks = __rdtsc() - startTicks;
+    uint64_t elapsedUs = duration_cast<microseconds>(steady_clock::now() - start).count();
+    return std::max<uint32_t>(uint32_t(ticks / std::max<uint64_t>(elapsedUs, 1u)), 1u);
+  }
+};
+
+using CycleCounter = TscCycleCounter;
+
+#else
+
+/**
+ * Fallback for other hosts, counts nanoseconds of the steady clock.
+ */
+struct SteadyCycleCounter final {
+  static uint32_t now() { return uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count()); }
+  static uint32_t cyclesPerMicro() { return 1000u; }
+};
+
+using CycleCounter = SteadyCycleCounter;
+
+#endif
+
+/**
+ * Class template for a clock based on a cycle counter, measures in
+ * nanoseconds. Much cheaper and more precise than micros() and thus suited to
+ * time short code paths.
+ */
+template<typename Counter>
+struct BasicCycleClock final {
+  static uint32_t now() { return Counter::now(); }
+  static uint32_t toNanos(uint32_t ticks) { return std::min<uint64_t>(uint64_t(ticks) * 1000u / Counter::cyclesPerMicro(), std::numeric_limits<uint32_t>::max()); }
+  static uint32_t since(uint32_t startTicks) { return toNanos(now() - startTicks); }
+};
+
+using CycleClock = BasicCycleClock<CycleCounter>;
+
+}
+
+#endif
@@ -0,0 +1,303 @@
+#ifndef IOT_CORE_COMPONENTREGISTRY_H_
+#define IOT_CORE_COMPONENTREGISTRY_H_
+
+#include <toolbox.h>
+#include "Interfaces.h"
+#include "Histogram.h"
+#include "Allocations.h"
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace iot_core {
+
+enum ComponentFlags : uint8_t {
+  COMPONENT_FLAG_NONE = 0u,
+  COMPONENT_FLAG_SET_UP = 1u << 0,
+};
+
+/**
+ * Everything the system keeps per registered component, stored contiguously
+ * so that the loop can iterate over it without any lookups.
+ */
+struct ComponentRecord final {
+  IApplicationComponent* component;
+  toolbox::strref name; // interned on registration, component names must not change
+  uint32_t nameHash;
+  uint8_t flags;
+  TimingHistogram<> timing;
+  AllocationStatistics allocations;
+
+  bool hasFlag(ComponentFlags flag) const { return (flags & flag) != 0u; }
+  void setFlag(ComponentFlags flag) { flags |= flag; }
+};
+
+/**
+ * Functions to call the IApplicationComponent methods on a component. If the
+ * concrete component type is known (see StaticComponentRegistry::forEachTyped),
+ * the calls are qualified and thus bypass the virtual dispatch.
+ */
+template<typename T>
+void componentSetup(T& component, bool connected) { component.T::setup(connected); }
+inline void componentSetup(IApplicationComponent& component, bool connected) { component.setup(connected); }
+
+template<typename T>
+void componentLoop(T& component, ConnectionStatus status) { component.T::loop(status); }
+inline void componentLoop(IApplicationComponent& component, ConnectionStatus status) { component.loop(status); }
+
+template<typename T>
+bool componentConfigure(T& component, const toolbox::strref& name, const toolbox::strref& value) { return component.T::configure(name, value); }
+inline bool componentConfigure(IApplicationComponent& component, const toolbox::strref& name, const toolbox::strref& value) { return component.configure(name, value); }
+
+template<typename T>
+void componentGetConfig(const T& component, ConfigWriter writer) { component.T::getConfig(writer); }
+inline void componentGetConfig(const IApplicationComponent& component, ConfigWriter writer) { component.getConfig(writer); }
+
+template<typename T>
+void componentGetDiagnostics(const T& component, IDiagnosticsCollector& collector) { component.T::getDiagnostics(collector); }
+inline void componentGetDiagnostics(const IApplicationComponent& component, IDiagnosticsCollector& collector) { component.getDiagnostics(collector); }
+
+inline uint32_t hashComponentName(const toolbox::strref& name) {
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  const char* chars = name.cstr();
+  for (size_t i = 0u; i < name.length(); ++i) {
+    hash ^= uint8_t(pgm_read_byte(chars + i));
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * Registry of application components, which hands out handles (indices) for
+ * registered components and resolves component names via a hash index.
+ *
+ * Components are called via their IApplicationComponent interface, the
+ * system records timing and allocations per component.
+ */
+class ComponentRegistry final {
+public:
+  static constexpr bool COMPONENT_STATISTICS = true;
+
+private:
+  struct NameIndexEntry {
+    uint32_t hash;
+    size_t index;
+
+    bool operator<(const NameIndexEntry& other) const { return hash < other.hash; }
+  };
+
+  std::vector<ComponentRecord> _records {};
+  std::vector<NameIndexEntry> _nameIndex {}; // sorted by hash
+
+  size_t findIndex(const toolbox::strref& name) const {
+    uint32_t hash = hashComponentName(name);
+    auto entry = std::lower_bound(_nameIndex.begin(), _nameIndex.end(), NameIndexEntry{hash, 0u});
+    for (; entry != _nameIndex.end() && entry->hash == hash; ++entry) {
+      if (_records[entry->index].name == name) {
+        return entry->index;
+      }
+    }
+    return INVALID_COMPONENT_HANDLE.index;
+  }
+
+public:
+  /**
+   * Adds the component, returns an invalid handle if there already is a
+   * component with the same name.
+   */
+  ComponentHandle add(IApplicationComponent* component) {
+    ComponentHandle handle {_records.size()};
+    toolbox::strref name = component->name();
+    if (findIndex(name) != INVALID_COMPONENT_HANDLE.index) {
+      return INVALID_COMPONENT_HANDLE;
+    }
+    uint32_t hash = hashComponentName(name);
+    _records.push_back({component, name, hash, COMPONENT_FLAG_NONE, {}, {}});
+    NameIndexEntry entry {hash, handle.index};
+    _nameIndex.insert(std::upper_bound(_nameIndex.begin(), _nameIndex.end(), entry), entry);
+    return handle;
+  }
+
+  IApplicationComponent* find(const toolbox::strref& name) const {
+    return get({findIndex(name)});
+  }
+
+  IApplicationComponent* get(ComponentHandle handle) const {
+    return handle.index < _records.size() ? _records[handle.index].component : nullptr;
+  }
+
+  size_t size() const { return _records.size(); }
+
+  /**
+   * Calls the given function with each component and its record.
+   */
+  template<typename F>
+  void forEach(F&& function) {
+    for (auto& record : _records) {
+      function(*record.component, record);
+    }
+  }
+
+  template<typename F>
+  void forEach(F&& function) const {
+    for (auto& record : _records) {
+      function(static_cast<const IApplicationComponent&>(*record.component), record);
+    }
+  }
+
+  /**
+   * Same as forEach(), the component types are not known.
+   */
+  template<typename F>
+  void forEachTyped(F&& function) {
+    forEach(function);
+  }
+
+  /**
+   * Calls the given function with the component of the given name and its
+   * record, if such a component exists.
+   */
+  template<typename F>
+  bool visit(const toolbox::strref& name, F&& function) {
+    size_t index = findIndex(name);
+    if (index >= _records.size()) {
+      return false;
+    }
+    function(*_records[index].component, _records[index]);
+    return true;
+  }
+
+  template<typename F>
+  bool visit(const toolbox::strref& name, F&& function) const {
+    size_t index = findIndex(name);
+    if (index >= _records.size()) {
+      return false;
+    }
+    function(static_cast<const IApplicationComponent&>(*_records[index].component), _records[index]);
+    return true;
+  }
+};
+
+/**
+ * Registry for a set of components which is fixed at compile time.
+ *
+ * Each component type can be added exactly once via add(T*). Adding
+ * components via their IApplicationComponent interface is not possible.
+ *
+ * forEachTyped() (i.e. the system loop) is unrolled at compile time and calls
+ * the components with their concrete type (without virtual dispatch) and
+ * without timing them individually (the system's yield timing still covers
+ * them). Everything else is rarely called, so it uses the interface to save
+ * code size. The few names are compared directly, without a hash index.
+ */
+template<typename... Components>
+class StaticComponentRegistry final {
+public:
+  static constexpr bool COMPONENT_STATISTICS = false;
+
+private:
+  static constexpr size_t COUNT = sizeof...(Components);
+
+  template<typename T, typename... Ts>
+  struct IndexOf;
+
+  template<typename T, typename... Ts>
+  struct IndexOf<T, T, Ts...> : std::integral_constant<size_t, 0u> {};
+
+  template<typename T, typename U, typename... Ts>
+  struct IndexOf<T, U, Ts...> : std::integral_constant<size_t, 1u + IndexOf<T, Ts...>::value> {};
+
+  std::tuple<Components*...> _components {};
+  ComponentRecord _records[COUNT] = {};
+
+  size_t findIndex(const toolbox::strref& name) const {
+    for (size_t i = 0u; i < COUNT; ++i) {
+      if (_records[i].component != nullptr && _records[i].name == name) {
+        return i;
+      }
+    }
+    return INVALID_COMPONENT_HANDLE.index;
+  }
+
+  template<size_t I, typename F>
+  void call(F& function) {
+    if (std::get<I>(_components) != nullptr) {
+      function(*std::get<I>(_components), _records[I]);
+    }
+  }
+
+  template<typename F, size_t... I>
+  void forEachTyped(F& function, std::index_sequence<I...>) { (call<I>(function), ...); }
+
+public:
+  template<typename T>
+  ComponentHandle add(T* component) {
+    constexpr size_t index = IndexOf<T, Components...>::value;
+    toolbox::strref name = component->name();
+    std::get<index>(_components) = component;
+    _records[index] = {component, name, 0u, COMPONENT_FLAG_NONE, {}, {}};
+    return {index};
+  }
+
+  ComponentHandle add(IApplicationComponent* /*component*/) {
+    return INVALID_COMPONENT_HANDLE;
+  }
+
+  IApplicationComponent* find(const toolbox::strref& name) const {
+    return get({findIndex(name)});
+  }
+
+  IApplicationComponent* get(ComponentHandle handle) const {
+    return handle.index < COUNT ? _records[handle.index].component : nullptr;
+  }
+
+  size_t size() const { return COUNT; }
+
+  template<typename F>
+  void forEach(F&& function) {
+    for (auto& record : _records) {
+      if (record.component != nullptr) {
+        function(*record.component, record);
+      }
+    }
+  }
+
+  template<typename F>
+  void forEach(F&& function) const {
+    for (auto& record : _records) {
+      if (record.component != nullptr) {
+        function(static_cast<const IApplicationComponent&>(*record.component), record);
+      }
+    }
+  }
+
+  template<typename F>
+  void forEachTyped(F&& function) { forEachTyped(function, std::index_sequence_for<Components...>{}); }
+
+  template<typename F>
+  bool visit(const toolbox::strref& name, F&& function) {
+    size_t index = findIndex(name);
+    if (index >= COUNT) {
+      return false;
+    }
+    function(*_records[index].component, _records[index]);
+    return true;
+  }
+
+  template<typename F>
+  bool visit(const toolbox::strref& name, F&& function) const {
+    size_t index = findIndex(name);
+    if (index >= COUNT) {
+      return false;
+    }
+    function(static_cast<const IApplicationComponent&>(*_records[index].component), _records[index]);
+    return true;
+  }
+};
+
+}
+
+#endif
@@ -54,6 +54,66 @@ public:
   }
 };
 
+/**
+ * Parses the config incrementally while reading it from an input, so only a
+ * single entry has to fit into RAM at once. The input is consumed, i.e. the
+ * config can only be parsed once.
+ */
+class StreamingConfigParser final : public IConfigParser {
+public:
+  static constexpr size_t MAX_ENTRY_SIZE = 128u;
+
+private:
+  toolbox::IInput& _input;
+
+  static void consume(char* entry, size_t& size, size_t count) {
+    memmove(entry, entry + count, size - count);
+    size -= count;
+  }
+
+public:
+  explicit StreamingConfigParser(toolbox::IInput& input) : _input(input) {}
+
+  bool parse(std::function<bool(const toolbox::strref& name, const toolbox::strref& value)> processEntry) const override {
+    char entry[MAX_ENTRY_SIZE + 1u];
+    size_t size = 0u;
+
+    while (true) {
+      size_t read = _input.read(entry + size, MAX_ENTRY_SIZE - size);
+      size += read;
+
+      size_t newlines = 0u;
+      while (newlines < size && entry[newlines] == '\n') {
+        newlines += 1u;
+      }
+      consume(entry, size, newlines);
+
+      char* end = static_cast<char*>(memchr(entry, ConfigParser::END, size));
+      if (end == nullptr) {
+        if (_input.available() == 0u) {
+          return size == 0u;
+        }
+        if (read == 0u) {
+          return false; // entry too long or input stalled
+        }
+        continue;
+      }
+
+      char* separator = static_cast<char*>(memchr(entry, ConfigParser::SEPARATOR, end - entry));
+      if (separator == nullptr) {
+        return false;
+      }
+
+      *separator = '\0';
+      *end = '\0';
+      if (!processEntry(toolbox::strref(entry), toolbox::strref(separator + 1))) {
+        return false;
+      }
+      consume(entry, size, end + 1 - entry);
+    }
+  }
+};
+
 static const char CONFIG_FILE_HEADER[] = "~C1.0";
 static constexpr size_t MAX_CONFIG_SIZE = 256u;
 static char CONFIG_BUFFER[MAX_CONFIG_SIZE + 1u];
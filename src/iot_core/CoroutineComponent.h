@@ -0,0 +1,259 @@
+#ifndef IOT_CORE_COROUTINECOMPONENT_H_
+#define IOT_CORE_COROUTINECOMPONENT_H_
+
+/**
+ * Optional support for writing application components as C++20 coroutines.
+ *
+ * Only available if the toolchain supports coroutines (e.g. compiled with
+ * -std=gnu++20 / -fcoroutines), otherwise this header is a no-op and
+ * IOT_CORE_COROUTINES_AVAILABLE is not defined.
+ */
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+
+#define IOT_CORE_COROUTINES_AVAILABLE 1
+
+#include <coroutine>
+#include <exception>
+#include <algorithm>
+#include <cstddef>
+#include "Interfaces.h"
+
+#ifndef IOT_CORE_COROUTINE_FRAME_SIZE
+#define IOT_CORE_COROUTINE_FRAME_SIZE 256u
+#endif
+
+#ifndef IOT_CORE_COROUTINE_FRAME_COUNT
+#define IOT_CORE_COROUTINE_FRAME_COUNT 4u
+#endif
+
+namespace iot_core {
+
+/**
+ * Class template for a fixed pool of equally sized memory blocks, which is
+ * used to allocate coroutine frames without touching the heap.
+ */
+template<size_t BLOCK_SIZE, size_t BLOCK_COUNT>
+class FramePool final {
+  alignas(std::max_align_t) uint8_t _blocks[BLOCK_COUNT][BLOCK_SIZE] = {};
+  bool _used[BLOCK_COUNT] = {};
+  size_t _usedCount = 0u;
+  size_t _peakCount = 0u;
+  size_t _failedCount = 0u;
+  size_t _failedSize = 0u;
+
+public:
+  void* allocate(size_t size) {
+    if (size <= BLOCK_SIZE) {
+      for (size_t i = 0u; i < BLOCK_COUNT; ++i) {
+        if (!_used[i]) {
+          _used[i] = true;
+          _usedCount += 1u;
+          _peakCount = std::max(_peakCount, _usedCount);
+          return _blocks[i];
+        }
+      }
+    }
+    _failedCount += 1u;
+    _failedSize = size;
+    return nullptr;
+  }
+
+  void release(void* block) {
+    for (size_t i = 0u; i < BLOCK_COUNT; ++i) {
+      if (_blocks[i] == block) {
+        _used[i] = false;
+        _usedCount -= 1u;
+        return;
+      }
+    }
+  }
+
+  size_t blockSize() const { return BLOCK_SIZE; }
+  size_t capacity() const { return BLOCK_COUNT; }
+  size_t used() const { return _usedCount; }
+  size_t peak() const { return _peakCount; }
+  size_t failed() const { return _failedCount; }
+
+  /**
+   * Size of the last allocation which failed (0 if none did).
+   */
+  size_t failedSize() const { return _failedSize; }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const {
+    collector.addNumber(F("blockSize"), BLOCK_SIZE);
+    collector.addNumber(F("capacity"), BLOCK_COUNT);
+    collector.addNumber(F("used"), _usedCount);
+    collector.addNumber(F("peak"), _peakCount);
+    collector.addNumber(F("failed"), _failedCount);
+  }
+};
+
+using CoroutineFramePool = FramePool<IOT_CORE_COROUTINE_FRAME_SIZE, IOT_CORE_COROUTINE_FRAME_COUNT>;
+static CoroutineFramePool g_coroutineFrames; // Globally shared pool for all coroutine frames
+
+/**
+ * Coroutine return type for the main routine of a CoroutineComponent.
+ *
+ * The coroutine is created suspended and is only resumed by its owning
+ * component from within its loop() (i.e. driven by the System loop). If no
+ * frame is available in the pool, the task is invalid.
+ */
+class ComponentTask final {
+public:
+  struct promise_type {
+    ComponentTask get_return_object() { return ComponentTask{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+    static ComponentTask get_return_object_on_allocation_failure() { return ComponentTask{}; }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+
+    static void* operator new(size_t size) noexcept { return g_coroutineFrames.allocate(size); }
+    static void operator delete(void* frame) { g_coroutineFrames.release(frame); }
+  };
+
+private:
+  std::coroutine_handle<promise_type> _handle {};
+
+  explicit ComponentTask(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+
+public:
+  ComponentTask() {}
+  ComponentTask(const ComponentTask&) = delete;
+  ComponentTask(ComponentTask&& other) : _handle(other._handle) { other._handle = {}; }
+
+  ~ComponentTask() { destroy(); }
+
+  ComponentTask& operator=(const ComponentTask&) = delete;
+  ComponentTask& operator=(ComponentTask&& other) {
+    if (this != &other) {
+      destroy();
+      _handle = other._handle;
+      other._handle = {};
+    }
+    return *this;
+  }
+
+  bool valid() const { return bool(_handle); }
+  bool done() const { return !_handle || _handle.done(); }
+
+  void resume() {
+    if (!done()) {
+      _handle.resume();
+    }
+  }
+
+  void destroy() {
+    if (_handle) {
+      _handle.destroy();
+      _handle = {};
+    }
+  }
+};
+
+/**
+ * Base class for application components which implement their behavior as a
+ * coroutine instead of a hand-written state machine in loop().
+ *
+ * The run() coroutine is started on the first loop() and resumed from within
+ * the System loop whenever the condition it awaits is fulfilled. It must only
+ * suspend via the awaitables provided by this class. When run() finishes, it
+ * is started again on the next loop (like the Arduino loop()).
+ */
+class CoroutineComponent : public IApplicationComponent {
+  enum struct Wait : uint8_t {
+    None,
+    NextLoop,
+    Sleep,
+    Connected,
+  };
+
+  struct Awaiter {
+    CoroutineComponent& _component;
+    Wait _wait;
+    unsigned long _durationMs;
+
+    bool await_ready() const {
+      return _wait == Wait::Connected && _component.isConnected();
+    }
+
+    void await_suspend(std::coroutine_handle<>) {
+      _component._wait = _wait;
+      _component._sleepStartMs = millis();
+      _component._sleepDurationMs = _durationMs;
+    }
+
+    void await_resume() {}
+  };
+
+  ComponentTask _task {};
+  Wait _wait = Wait::None;
+  unsigned long _sleepStartMs = 0u;
+  unsigned long _sleepDurationMs = 0u;
+  ConnectionStatus _status = ConnectionStatus::Disconnected;
+
+  bool isConnected() const {
+    return _status == ConnectionStatus::Connected || _status == ConnectionStatus::Reconnected;
+  }
+
+  bool resumable() const {
+    switch (_wait) {
+      case Wait::None: return true;
+      case Wait::NextLoop: return true;
+      case Wait::Sleep: return millis() - _sleepStartMs >= _sleepDurationMs; // wrap-around safe
+      case Wait::Connected: return isConnected();
+      default: return false;
+    }
+  }
+
+protected:
+  /**
+   * The main routine of the component.
+   */
+  virtual ComponentTask run() = 0;
+
+  /**
+   * Suspends until the next loop of this component.
+   */
+  Awaiter nextLoop() { return {*this, Wait::NextLoop, 0u}; }
+
+  /**
+   * Suspends for (at least) the given time. Resolution is one loop.
+   */
+  Awaiter sleepFor(unsigned long durationMs) { return {*this, Wait::Sleep, durationMs}; }
+
+  /**
+   * Suspends until the system is connected (continues immediately if it
+   * already is).
+   */
+  Awaiter connected() { return {*this, Wait::Connected, 0u}; }
+
+  /**
+   * Connection status as passed to the current loop.
+   */
+  ConnectionStatus status() const { return _status; }
+
+public:
+  void loop(ConnectionStatus status) override final {
+    _status = status;
+
+    if (_task.done()) {
+      _task = run();
+      _wait = Wait::None;
+      if (!_task.valid()) {
+        return; // no frame available, retry on next loop
+      }
+    }
+
+    if (resumable()) {
+      _wait = Wait::None;
+      _task.resume();
+    }
+  }
+};
+
+}
+
+#endif
+
+#endif
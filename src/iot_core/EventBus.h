@@ -0,0 +1,238 @@
+#ifndef IOT_CORE_EVENTBUS_H_
+#define IOT_CORE_EVENTBUS_H_
+
+#include <toolbox.h>
+#include "Interfaces.h"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <new>
+
+#ifndef IOT_CORE_MAX_EVENT_TOPICS
+#define IOT_CORE_MAX_EVENT_TOPICS 16u
+#endif
+
+#ifndef IOT_CORE_EVENT_BUS_MEMORY
+#define IOT_CORE_EVENT_BUS_MEMORY 1024u
+#endif
+
+namespace iot_core {
+
+/**
+ * Class template for a fixed-capacity FIFO queue, which drops new entries if
+ * it is full.
+ */
+template<typename T, size_t CAPACITY>
+class RingQueue final {
+  T _entries[CAPACITY] = {};
+  size_t _head = 0u;
+  size_t _size = 0u;
+  size_t _highWaterMark = 0u;
+  size_t _dropped = 0u;
+
+public:
+  bool push(const T& entry) {
+    if (_size == CAPACITY) {
+      _dropped += 1u;
+      return false;
+    }
+    _entries[(_head + _size) % CAPACITY] = entry;
+    _size += 1u;
+    _highWaterMark = std::max(_highWaterMark, _size);
+    return true;
+  }
+
+  bool pop(T& entry) {
+    if (_size == 0u) {
+      return false;
+    }
+    entry = _entries[_head];
+    _head = (_head + 1u) % CAPACITY;
+    _size -= 1u;
+    return true;
+  }
+
+  size_t size() const { return _size; }
+  size_t capacity() const { return CAPACITY; }
+  size_t highWaterMark() const { return _highWaterMark; }
+  size_t dropped() const { return _dropped; }
+};
+
+/**
+ * Base class template for event topics. A topic is a type which defines a
+ * unique ID (< IOT_CORE_MAX_EVENT_TOPICS), the event type and the size of
+ * its queue, plus a name for diagnostics, e.g.:
+ *
+ *   struct TemperatureChanged : iot_core::EventTopic<1u, float> {
+ *     static toolbox::strref name() { return F("temperatureChanged"); }
+ *   };
+ */
+template<uint8_t ID, typename EVENT, size_t CAPACITY = 4u, size_t MAX_SUBSCRIBERS = 4u>
+struct EventTopic {
+  using Event = EVENT;
+  static constexpr uint8_t id = ID;
+  static constexpr size_t capacity = CAPACITY;
+  static constexpr size_t maxSubscribers = MAX_SUBSCRIBERS;
+};
+
+class IEventChannel : public IDiagnosticsProvider {
+public:
+  virtual ~IEventChannel() {}
+  virtual toolbox::strref name() const = 0;
+  virtual void deliver() = 0;
+};
+
+template<typename Topic>
+class EventChannel final : public IEventChannel {
+public:
+  using Event = typename Topic::Event;
+  using Handler = std::function<void(const Event& event)>;
+
+private:
+  RingQueue<Event, Topic::capacity> _queue {};
+  Handler _subscribers[Topic::maxSubscribers] = {};
+  size_t _subscriberCount = 0u;
+  size_t _published = 0u;
+
+public:
+  toolbox::strref name() const override {
+    return Topic::name();
+  }
+
+  bool subscribe(Handler handler) {
+    if (_subscriberCount == Topic::maxSubscribers) {
+      return false;
+    }
+    _subscribers[_subscriberCount] = handler;
+    _subscriberCount += 1u;
+    return true;
+  }
+
+  bool publish(const Event& event) {
+    _published += 1u;
+    return _queue.push(event);
+  }
+
+  void deliver() override {
+    // Only deliver what has been queued so far, events published by the
+    // subscribers are delivered on the next run.
+    Event event;
+    for (size_t pending = _queue.size(); pending > 0u && _queue.pop(event); --pending) {
+      for (size_t i = 0u; i < _subscriberCount; ++i) {
+        _subscribers[i](event);
+      }
+    }
+  }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const override {
+    collector.addNumber(F("subscribers"), _subscriberCount);
+    collector.addNumber(F("published"), _published);
+    collector.addNumber(F("queued"), _queue.size());
+    collector.addNumber(F("highWaterMark"), _queue.highWaterMark());
+    collector.addNumber(F("capacity"), _queue.capacity());
+    collector.addNumber(F("dropped"), _queue.dropped());
+  }
+};
+
+/**
+ * Typed publish/subscribe event bus.
+ *
+ * Each topic has its own fixed-size queue, so publishing an event only
+ * copies it into the queue of its topic. Queued events are delivered to the
+ * subscribers when deliver() is called (by the System in lyield()).
+ *
+ * The channels of the topics are created on first use within a fixed memory
+ * area of the bus (IOT_CORE_EVENT_BUS_MEMORY bytes).
+ */
+class EventBus final : public IDiagnosticsProvider {
+  struct Slot {
+    IEventChannel* channel;
+    const void* topicTag;
+  };
+
+  alignas(std::max_align_t) uint8_t _memory[IOT_CORE_EVENT_BUS_MEMORY] = {};
+  size_t _memoryUsed = 0u;
+  Slot _slots[IOT_CORE_MAX_EVENT_TOPICS] = {};
+  size_t _rejected = 0u;
+  bool _delivering = false;
+
+  template<typename Topic>
+  static const void* topicTag() {
+    static const char tag = 0;
+    return &tag;
+  }
+
+  template<typename Topic>
+  EventChannel<Topic>* channel() {
+    static_assert(Topic::id < IOT_CORE_MAX_EVENT_TOPICS, "Event topic ID out of range, increase IOT_CORE_MAX_EVENT_TOPICS.");
+    Slot& slot = _slots[Topic::id];
+    if (slot.channel == nullptr) {
+      size_t offset = (_memoryUsed + alignof(EventChannel<Topic>) - 1u) / alignof(EventChannel<Topic>) * alignof(EventChannel<Topic>);
+      if (offset + sizeof(EventChannel<Topic>) > sizeof(_memory)) {
+        _rejected += 1u;
+        return nullptr; // out of memory, increase IOT_CORE_EVENT_BUS_MEMORY
+      }
+      slot.channel = new (_memory + offset) EventChannel<Topic>();
+      slot.topicTag = topicTag<Topic>();
+      _memoryUsed = offset + sizeof(EventChannel<Topic>);
+    } else if (slot.topicTag != topicTag<Topic>()) {
+      _rejected += 1u;
+      return nullptr; // ID already used by another topic
+    }
+    return static_cast<EventChannel<Topic>*>(slot.channel);
+  }
+
+public:
+  EventBus() {}
+  EventBus(const EventBus&) = delete;
+  EventBus& operator=(const EventBus&) = delete;
+
+  ~EventBus() {
+    for (auto& slot : _slots) {
+      if (slot.channel != nullptr) {
+        slot.channel->~IEventChannel();
+      }
+    }
+  }
+
+  template<typename Topic>
+  bool subscribe(typename EventChannel<Topic>::Handler handler) {
+    auto topicChannel = channel<Topic>();
+    return topicChannel != nullptr && topicChannel->subscribe(handler);
+  }
+
+  template<typename Topic>
+  bool publish(const typename Topic::Event& event) {
+    auto topicChannel = channel<Topic>();
+    return topicChannel != nullptr && topicChannel->publish(event);
+  }
+
+  void deliver() {
+    if (_delivering) {
+      return;
+    }
+    _delivering = true;
+    for (auto& slot : _slots) {
+      if (slot.channel != nullptr) {
+        slot.channel->deliver();
+      }
+    }
+    _delivering = false;
+  }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const override {
+    collector.addNumber(F("memoryUsed"), _memoryUsed);
+    collector.addNumber(F("rejected"), _rejected);
+    for (auto& slot : _slots) {
+      if (slot.channel != nullptr) {
+        collector.beginSection(slot.channel->name());
+        slot.channel->getDiagnostics(collector);
+        collector.endSection();
+      }
+    }
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,251 @@
+#ifndef IOT_CORE_HISTOGRAM_H_
+#define IOT_CORE_HISTOGRAM_H_
+
+#include <Arduino.h>
+#include <toolbox.h>
+#include "Interfaces.h"
+#include "Clock.h"
+#include <algorithm>
+#include <limits>
+
+namespace iot_core {
+
+/**
+ * Class template for the bucket layout of a logarithmic (HDR-style)
+ * histogram: values are grouped by their highest set bit and each of these
+ * groups is split linearly into 2^SUB_BUCKET_BITS sub-buckets. Values below
+ * 2^SUB_BUCKET_BITS are counted exactly and values of VALUE_BITS bits or more
+ * are counted in the last bucket.
+ *
+ * The relative error of any value derived from the buckets is thus below
+ * 1 / 2^SUB_BUCKET_BITS (25% for the default of 2 bits).
+ */
+template<uint8_t VALUE_BITS, uint8_t SUB_BUCKET_BITS>
+struct LogBuckets final {
+  static_assert(SUB_BUCKET_BITS < VALUE_BITS && VALUE_BITS <= 32u, "Invalid histogram layout.");
+
+  static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+  static constexpr size_t COUNT = (VALUE_BITS - SUB_BUCKET_BITS + 1u) * SUB_BUCKETS;
+  static constexpr uint32_t MAX_VALUE = VALUE_BITS == 32u ? std::numeric_limits<uint32_t>::max() : (1u << VALUE_BITS) - 1u;
+
+  static size_t index(uint32_t value) {
+    value = std::min(value, MAX_VALUE);
+    if (value < SUB_BUCKETS) {
+      return value;
+    }
+    uint8_t exponent = 31u - __builtin_clz(value);
+    uint8_t group = exponent - SUB_BUCKET_BITS + 1u;
+    uint32_t subBucket = (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1u);
+    return group * SUB_BUCKETS + subBucket;
+  }
+
+  static uint32_t lowerBound(size_t index) {
+    size_t group = index / SUB_BUCKETS;
+    uint32_t subBucket = index % SUB_BUCKETS;
+    if (group == 0u) {
+      return subBucket;
+    }
+    return (SUB_BUCKETS | subBucket) << (group - 1u);
+  }
+
+  static uint32_t upperBound(size_t index) {
+    size_t group = index / SUB_BUCKETS;
+    if (group == 0u) {
+      return lowerBound(index);
+    }
+    return lowerBound(index) + ((1u << (group - 1u)) - 1u);
+  }
+};
+
+/**
+ * Class template for a set of histogram counters plus exact aggregates.
+ *
+ * When a bucket is full, all buckets are halved (rounding up, so no bucket
+ * becomes empty). The ratios between the buckets and thus the percentiles
+ * hold, with the values before the halving weighted less. Only the
+ * aggregates (e.g. count()) cover all values exactly.
+ */
+template<typename Buckets, typename COUNTER>
+class HistogramCounters final {
+  COUNTER _buckets[Buckets::COUNT] = {};
+  uint32_t _count = 0u;
+  uint32_t _min = std::numeric_limits<uint32_t>::max();
+  uint32_t _max = 0u;
+  uint64_t _sum = 0u;
+
+  void halve() {
+    for (auto& bucket : _buckets) {
+      bucket -= bucket / 2u;
+    }
+  }
+
+public:
+  void record(uint32_t value) {
+    COUNTER& bucket = _buckets[Buckets::index(value)];
+    if (bucket == std::numeric_limits<COUNTER>::max()) {
+      halve();
+    }
+    bucket += 1u;
+    _count += 1u;
+    _min = std::min(_min, value);
+    _max = std::max(_max, value);
+    _sum += value;
+  }
+
+  void clear() {
+    *this = {};
+  }
+
+  uint32_t count() const { return _count; }
+  uint32_t min() const { return _count == 0u ? 0u : _min; }
+  uint32_t max() const { return _max; }
+  uint32_t avg() const { return _count == 0u ? 0u : uint32_t(_sum / _count); }
+
+  /**
+   * Returns the (approximated) value below or at which the given percentage
+   * (0-100) of all recorded values are.
+   */
+  uint32_t percentile(float percent) const {
+    if (_count == 0u) {
+      return 0u;
+    }
+
+    uint32_t total = 0u;
+    for (auto bucket : _buckets) {
+      total += bucket;
+    }
+
+    uint32_t rank = uint32_t(percent / 100.0f * total + 0.5f);
+    rank = std::max(rank, 1u);
+    uint32_t seen = 0u;
+    for (size_t i = 0u; i < Buckets::COUNT; ++i) {
+      seen += _buckets[i];
+      if (seen >= rank) {
+        return std::min(std::max(Buckets::upperBound(i), min()), max());
+      }
+    }
+    return max();
+  }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const {
+    collector.addNumber(F("count"), count());
+    collector.addNumber(F("avg"), avg());
+    collector.addNumber(F("min"), min());
+    collector.addNumber(F("max"), max());
+    collector.addNumber(F("p50"), percentile(50.0f));
+    collector.addNumber(F("p99"), percentile(99.0f));
+    collector.addNumber(F("p999"), percentile(99.9f));
+  }
+};
+
+/**
+ * Class template for a constant-memory histogram with logarithmic buckets,
+ * which keeps a lifetime view and a windowed view of the recorded values.
+ *
+ * The window covers the values of the current time slice (one minute by
+ * default), a new slice starts with the first value recorded after the
+ * previous one ended. Reading does not change the window, so all readers see
+ * the same values. With a window time of 0, the window is only reset
+ * explicitly, e.g. on read by a single reader. The window uses smaller
+ * counters to save memory, which are halved when one is full.
+ */
+template<uint8_t VALUE_BITS = 27u, uint8_t SUB_BUCKET_BITS = 2u>
+class Histogram final {
+public:
+  using Buckets = LogBuckets<VALUE_BITS, SUB_BUCKET_BITS>;
+  using Lifetime = HistogramCounters<Buckets, uint32_t>;
+  using Window = HistogramCounters<Buckets, uint16_t>;
+
+  static constexpr uint32_t DEFAULT_WINDOW_MS = 60000u;
+
+private:
+  Lifetime _lifetime {};
+  Window _window {};
+  uint32_t _windowMs = DEFAULT_WINDOW_MS;
+  uint32_t _windowStart = 0u;
+
+public:
+  Histogram() {}
+  explicit Histogram(uint32_t windowMs) : _windowMs(windowMs) {}
+
+  void record(uint32_t value) {
+    if (_windowMs > 0u && millis() - _windowStart >= _windowMs) {
+      _window.clear();
+      _windowStart = millis();
+    }
+    _lifetime.record(value);
+    _window.record(value);
+  }
+
+  const Lifetime& lifetime() const { return _lifetime; }
+  const Window& window() const { return _window; }
+
+  void resetWindow() {
+    _window.clear();
+    _windowStart = millis();
+  }
+
+  /**
+   * Adds the lifetime values and a "window" section with the windowed values.
+   */
+  void getDiagnostics(IDiagnosticsCollector& collector) const {
+    _lifetime.getDiagnostics(collector);
+    collector.beginSection(F("window"));
+    _window.getDiagnostics(collector);
+    collector.endSection();
+  }
+
+  /**
+   * Like getDiagnostics(), but starts a new window after reading, for a
+   * single reader which wants the values since its last read.
+   */
+  void getDiagnosticsAndReset(IDiagnosticsCollector& collector) {
+    getDiagnostics(collector);
+    resetWindow();
+  }
+};
+
+/**
+ * Class template to measure durations (in the unit of the given Clock, i.e.
+ * microseconds by default) into a histogram.
+ */
+template<uint8_t VALUE_BITS = 27u, uint8_t SUB_BUCKET_BITS = 2u, typename Clock = MicrosClock>
+class TimingHistogram final {
+  Histogram<VALUE_BITS, SUB_BUCKET_BITS> _histogram {};
+  uint32_t _startTicks = 0u;
+
+public:
+  TimingHistogram() {}
+  explicit TimingHistogram(uint32_t windowMs) : _histogram(windowMs) {}
+
+  void start() {
+    _startTicks = Clock::now();
+  }
+
+  void stop() {
+    _histogram.record(Clock::since(_startTicks));
+  }
+
+  template<typename F>
+  auto wrap(F f) {
+    return [this,f] () {
+      this->start();
+      f();
+      this->stop();
+    };
+  }
+
+  const Histogram<VALUE_BITS, SUB_BUCKET_BITS>& histogram() const { return _histogram; }
+
+  void getDiagnosticsAndReset(IDiagnosticsCollector& collector) {
+    _histogram.getDiagnosticsAndReset(collector);
+  }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const {
+    _histogram.getDiagnostics(collector);
+  }
+};
+
+}
+
+#endif
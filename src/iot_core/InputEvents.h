@@ -0,0 +1,212 @@
+#ifndef IOT_CORE_INPUTEVENTS_H_
+#define IOT_CORE_INPUTEVENTS_H_
+
+#include <Arduino.h>
+#include <toolbox.h>
+#include "Interfaces.h"
+#include <atomic>
+#include <functional>
+
+#ifndef IOT_CORE_MAX_INPUTS
+#define IOT_CORE_MAX_INPUTS 8u
+#endif
+
+#ifndef IOT_CORE_INPUT_EDGE_QUEUE_SIZE
+#define IOT_CORE_INPUT_EDGE_QUEUE_SIZE 32u
+#endif
+
+namespace iot_core {
+
+enum struct InputEventType : uint8_t {
+  Pressed,
+  Released,
+  LongPressed,
+};
+
+struct InputEvent {
+  uint8_t pin;
+  InputEventType type;
+  unsigned long timeUs; // when the (debounced) change happened
+  unsigned long durationMs; // how long the input was pressed (for Released and LongPressed)
+};
+
+using InputEventHandler = std::function<void(const InputEvent& event)>;
+
+struct InputOptions {
+  bool activeLow = true; // e.g. button to GND with pull-up
+  unsigned long debounceMs = 20u;
+  unsigned long longPressMs = 0u; // 0 = no long press detection
+};
+
+/**
+ * Access to the GPIOs used by BasicInputEvents (see InputEvents), can be
+ * replaced for testing.
+ */
+struct ArduinoGpio {
+  static bool read(uint8_t pin) { return digitalRead(pin) == HIGH; }
+  static void attach(uint8_t pin, void (*isr)(void*), void* arg) { attachInterruptArg(digitalPinToInterrupt(pin), isr, arg, CHANGE); }
+  static void detach(uint8_t pin) { detachInterrupt(digitalPinToInterrupt(pin)); }
+  static unsigned long micros() { return ::micros(); }
+};
+
+/**
+ * Class template for a service which captures input pin changes via
+ * interrupts and delivers debounced press, release and long press events to
+ * handlers from within the loop (see process()).
+ *
+ * The interrupt handlers only put a timestamped edge into a lock-free
+ * single-producer/single-consumer queue, thus short pulses are not missed
+ * even if the loop is slow. Debouncing and long press detection is done when
+ * processing the queued edges in timestamp order.
+ */
+template<typename Gpio>
+class BasicInputEvents final {
+  struct Edge {
+    uint8_t input;
+    bool level;
+    unsigned long timeUs;
+  };
+
+  struct Input {
+    BasicInputEvents* owner;
+    uint8_t index;
+    uint8_t pin;
+    InputOptions options;
+    InputEventHandler handler;
+    bool rawActive;
+    unsigned long rawSinceUs;
+    bool active;
+    unsigned long activeSinceUs;
+    bool longPressReported;
+  };
+
+  Input _inputs[IOT_CORE_MAX_INPUTS] = {};
+  size_t _inputCount = 0u;
+
+  Edge _edges[IOT_CORE_INPUT_EDGE_QUEUE_SIZE] = {};
+  std::atomic<size_t> _edgesHead {0u}; // written by ISR only
+  std::atomic<size_t> _edgesTail {0u}; // written by process() only
+  std::atomic<size_t> _edgesDropped {0u};
+  size_t _eventCount = 0u;
+
+  static void IRAM_ATTR onChange(void* arg) {
+    Input* input = static_cast<Input*>(arg);
+    input->owner->pushEdge(input->index, Gpio::read(input->pin), Gpio::micros());
+  }
+
+  void IRAM_ATTR pushEdge(uint8_t input, bool level, unsigned long timeUs) {
+    size_t head = _edgesHead.load(std::memory_order_relaxed);
+    size_t next = (head + 1u) % IOT_CORE_INPUT_EDGE_QUEUE_SIZE;
+    if (next == _edgesTail.load(std::memory_order_acquire)) {
+      _edgesDropped.store(_edgesDropped.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+      return;
+    }
+    _edges[head] = {input, level, timeUs};
+    _edgesHead.store(next, std::memory_order_release);
+  }
+
+  bool popEdge(Edge& edge) {
+    size_t tail = _edgesTail.load(std::memory_order_relaxed);
+    if (tail == _edgesHead.load(std::memory_order_acquire)) {
+      return false;
+    }
+    edge = _edges[tail];
+    _edgesTail.store((tail + 1u) % IOT_CORE_INPUT_EDGE_QUEUE_SIZE, std::memory_order_release);
+    return true;
+  }
+
+  void emit(Input& input, InputEventType type, unsigned long timeUs, unsigned long durationMs) {
+    _eventCount += 1u;
+    if (input.handler) {
+      input.handler({input.pin, type, timeUs, durationMs});
+    }
+  }
+
+  /**
+   * Applies the debounced state of the input as of the given time, i.e. if
+   * the raw level has been stable for the debounce time.
+   */
+  void settle(Input& input, unsigned long nowUs) {
+    if (input.rawActive != input.active && (nowUs - input.rawSinceUs) / 1000u >= input.options.debounceMs) {
+      input.active = input.rawActive;
+      if (input.active) {
+        input.activeSinceUs = input.rawSinceUs;
+        input.longPressReported = false;
+        emit(input, InputEventType::Pressed, input.rawSinceUs, 0u);
+      } else {
+        emit(input, InputEventType::Released, input.rawSinceUs, (input.rawSinceUs - input.activeSinceUs) / 1000u);
+      }
+    }
+
+    if (input.active && !input.longPressReported && input.options.longPressMs > 0u) {
+      // only consider the time up to a pending (not yet debounced) release
+      unsigned long untilUs = input.rawActive ? nowUs : input.rawSinceUs;
+      unsigned long pressedMs = (untilUs - input.activeSinceUs) / 1000u;
+      if (pressedMs >= input.options.longPressMs) {
+        input.longPressReported = true;
+        emit(input, InputEventType::LongPressed, input.activeSinceUs + input.options.longPressMs * 1000u, pressedMs);
+      }
+    }
+  }
+
+public:
+  BasicInputEvents() {}
+  BasicInputEvents(const BasicInputEvents&) = delete;
+  BasicInputEvents& operator=(const BasicInputEvents&) = delete;
+
+  ~BasicInputEvents() {
+    for (size_t i = 0u; i < _inputCount; ++i) {
+      Gpio::detach(_inputs[i].pin);
+    }
+  }
+
+  /**
+   * Starts watching the given pin (which must already be configured as
+   * input) and calls the handler for each event from within process().
+   */
+  bool watch(uint8_t pin, InputEventHandler handler, InputOptions options = {}) {
+    if (_inputCount == IOT_CORE_MAX_INPUTS) {
+      return false;
+    }
+
+    Input& input = _inputs[_inputCount];
+    bool active = Gpio::read(pin) != options.activeLow;
+    unsigned long nowUs = Gpio::micros();
+    input = {this, uint8_t(_inputCount), pin, options, handler, active, nowUs, active, nowUs, true};
+    _inputCount += 1u;
+
+    Gpio::attach(pin, &BasicInputEvents::onChange, &input);
+    return true;
+  }
+
+  /**
+   * Processes all captured pin changes and delivers the resulting events.
+   */
+  void process() {
+    Edge edge;
+    while (popEdge(edge)) {
+      Input& input = _inputs[edge.input];
+      settle(input, edge.timeUs);
+      bool active = edge.level != input.options.activeLow;
+      if (active != input.rawActive) {
+        input.rawActive = active;
+        input.rawSinceUs = edge.timeUs;
+      }
+    }
+
+    unsigned long nowUs = Gpio::micros();
+    for (size_t i = 0u; i < _inputCount; ++i) {
+      settle(_inputs[i], nowUs);
+    }
+  }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const {
+    collector.addNumber(F("inputs"), _inputCount);
+    collector.addNumber(F("events"), _eventCount);
+    collector.addNumber(F("droppedEdges"), _edgesDropped.load(std::memory_order_relaxed));
+  }
+};
+
+}
+
+#endif
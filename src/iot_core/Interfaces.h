@@ -16,6 +16,13 @@ enum struct ConnectionStatus {
   Disconnecting,
 };
 
+class EventBus;
+template<uint8_t VALUE_BITS, uint8_t SUB_BUCKET_BITS> class Histogram;
+
+template<typename Gpio> class BasicInputEvents;
+struct ArduinoGpio;
+using InputEvents = BasicInputEvents<ArduinoGpio>;
+
 class ISystem {
 public:
   virtual toolbox::strref id() const = 0;
@@ -28,14 +35,29 @@ public:
   virtual Logger logger(const toolbox::strref& category) = 0;
   virtual ILocalLogSink& localLogSink() = 0;
   virtual void lyield() = 0;
+
+  /**
+   * Time spent in the loop between yields (in µs).
+   */
+  virtual const Histogram<27u, 2u>& yieldTiming() const = 0;
   virtual DateTime const& currentDateTime() const = 0;
   virtual void schedule(std::function<void()> function) = 0;
+  virtual EventBus& events() = 0;
+  virtual InputEvents& inputs() = 0;
 };
 
 class IDiagnosticsCollector {
 public:
   virtual void beginSection(const toolbox::strref& name) = 0;
   virtual void addValue(const toolbox::strref& name, const toolbox::strref& value) = 0;
+
+  /**
+   * Adds a value which is always a number, so formats can encode it as such.
+   */
+  virtual void addNumber(const toolbox::strref& name, uint32_t value) {
+    addValue(name, toolbox::convert<uint32_t>::toString(value, 10));
+  }
+
   virtual void endSection() = 0;
 };
 
@@ -64,10 +86,22 @@ public:
   virtual void loop(ConnectionStatus status) = 0;
 };
 
+/**
+ * Handle of a component registered in an application container.
+ */
+struct ComponentHandle final {
+  size_t index;
+
+  bool valid() const { return index != SIZE_MAX; }
+};
+
+static constexpr ComponentHandle INVALID_COMPONENT_HANDLE {SIZE_MAX};
+
 class IApplicationContainer : public IDiagnosticsProvider {
 public:
   virtual const VersionInfo& version() const = 0;
-  virtual void addComponent(IApplicationComponent* component) = 0;
+  virtual ComponentHandle addComponent(IApplicationComponent* component) = 0;
+  virtual IApplicationComponent* getComponent(ComponentHandle handle) = 0;
   virtual IApplicationComponent const* getComponent(const toolbox::strref& name) const = 0;
   virtual IApplicationComponent* getComponent(const toolbox::strref& name) = 0;
   virtual void forEachComponent(std::function<void(const IApplicationComponent* component)> handler) const = 0;
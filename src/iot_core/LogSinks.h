@@ -7,28 +7,33 @@
 
 namespace iot_core {
 
+/**
+ * Keeps the latest log entries in a ring buffer. Positions are counted in
+ * bytes since the start (wrapping around), so cursors stay valid while new
+ * entries are added.
+ */
 class InMemoryLogSink final : public ILocalLogSink {
-  static const size_t LOG_BUFFER_SIZE = 4096u;
+  static const size_t LOG_BUFFER_SIZE = 4096u; // has to be a power of two
 
   bool _enabled = true;
   LogLevel _logLevel = LogLevel::Info;
 
   char _logBuffer[LOG_BUFFER_SIZE] = {};
-  size_t _logBufferStart = 0u;
-  size_t _logBufferEnd = 0u;
+  uint32_t _begin = 0u; // position of the oldest entry
+  uint32_t _end = 0u; // position after the newest entry
 
-  void advanceBufferStart() {
-    while (_logBuffer[_logBufferStart] != LOG_ENTRY_SEPARATOR) {
-      _logBufferStart = (_logBufferStart + 1u) % LOG_BUFFER_SIZE;
-    }
-    _logBufferStart = (_logBufferStart + 1u) % LOG_BUFFER_SIZE;
+  char at(uint32_t position) const {
+    return _logBuffer[position % LOG_BUFFER_SIZE];
   }
 
-public:
-  InMemoryLogSink() {
-    memset(_logBuffer, LOG_ENTRY_SEPARATOR, LOG_BUFFER_SIZE);
+  void dropOldestEntry() {
+    while (at(_begin) != LOG_ENTRY_SEPARATOR) {
+      _begin += 1u;
+    }
+    _begin += 1u;
   }
 
+public:
   void enable(bool enabled) override {
     _enabled = enabled;
   }
@@ -51,39 +56,43 @@ public:
     }
 
     for (unsigned short i = 0u; entry[i] != '\0'; ++i) {
-      if (_logBufferEnd == LOG_BUFFER_SIZE) {
-        _logBufferEnd = 0u;
-        if (_logBufferStart == 0u) {
-          advanceBufferStart();
-        }
-      } else if (_logBufferStart == _logBufferEnd && _logBufferStart != 0u) {
-        advanceBufferStart();
+      if (_end - _begin == LOG_BUFFER_SIZE) {
+        dropOldestEntry();
       }
-
-      _logBuffer[_logBufferEnd] = entry[i];
-      _logBufferEnd += 1u;
+      _logBuffer[_end % LOG_BUFFER_SIZE] = entry[i];
+      _end += 1u;
     }
   }
 
   void output(std::function<void(const char* entry)> handler) const override {
-    if (_logBuffer[_logBufferStart] != LOG_ENTRY_SEPARATOR) {
-      unsigned short bufferIndex = _logBufferStart;
-      unsigned short entryIndex = 0u;
-      do {
-        bufferIndex = bufferIndex % LOG_BUFFER_SIZE;
-        g_logEntry.buffer[entryIndex] = _logBuffer[bufferIndex];
-
-        if (g_logEntry.buffer[entryIndex] == LOG_ENTRY_SEPARATOR) {
-          g_logEntry.buffer[entryIndex + 1u] = '\0';
-          handler(g_logEntry.buffer);
-          entryIndex = 0u;
-        } else {
-          entryIndex += 1u;
-        }
-
-        bufferIndex = bufferIndex + 1u;
-      } while (bufferIndex != _logBufferEnd);
+    LogCursor position = cursor();
+    while (outputNext(position, handler)) {}
+  }
+
+  LogCursor cursor() const override {
+    return {_begin, _end};
+  }
+
+  bool outputNext(LogCursor& cursor, std::function<void(const char* entry)> handler) const override {
+    if (int32_t(cursor.position - _begin) < 0) {
+      cursor.position = _begin; // entries were dropped since
     }
+    if (int32_t(cursor.end - cursor.position) <= 0) {
+      return false;
+    }
+
+    size_t length = 0u;
+    char c;
+    do {
+      c = at(cursor.position);
+      cursor.position += 1u;
+      if (length < MAX_LOG_ENTRY_LENGTH) {
+        g_logEntry.buffer[length++] = c;
+      }
+    } while (c != LOG_ENTRY_SEPARATOR && cursor.position != _end);
+    g_logEntry.buffer[length] = '\0';
+    handler(g_logEntry.buffer);
+    return true;
   }
 };
 
@@ -83,9 +83,26 @@ public:
   virtual void commitLogEntry(const char* entry) = 0;
 };
 
+/**
+ * Position of a reader in a local log, which can be resumed later on.
+ */
+struct LogCursor final {
+  uint32_t position;
+  uint32_t end;
+};
+
 class ILocalLogSink : public ILogSink {
 public:
   virtual void output(std::function<void(const char* entry)> handler) const = 0;
+  /**
+   * Returns a cursor over the entries stored right now.
+   */
+  virtual LogCursor cursor() const = 0;
+  /**
+   * Outputs the next entry of the cursor and advances it. Returns false if
+   * there are no more entries. Entries dropped in the meantime are skipped.
+   */
+  virtual bool outputNext(LogCursor& cursor, std::function<void(const char* entry)> handler) const = 0;
 };
 
 class LogService final {
@@ -197,12 +214,12 @@ void Logger::log(T message) const {
   _service->log(_category, message);
 }
 
-template<typename T, std::enable_if_t<!std::is_invocable<T>::value, bool> = true>
+template<typename T, std::enable_if_t<!std::is_invocable<T>::value, bool>>
 void Logger::log(LogLevel level, T message) const {
   _service->log(level, _category, message);
 };
 
-template<typename T, std::enable_if_t<std::is_invocable<T>::value, bool> = true>
+template<typename T, std::enable_if_t<std::is_invocable<T>::value, bool>>
 void Logger::log(LogLevel level, T messageFunction) const {
   _service->log(level, _category, messageFunction);
 };
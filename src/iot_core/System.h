@@ -13,21 +13,35 @@
 #include "Logger.h"
 #include "LogSinks.h"
 #include "DateTime.h"
+#include "Histogram.h"
+#include "Allocations.h"
+#include "ComponentRegistry.h"
+#include "CoroutineComponent.h"
+#include "EventBus.h"
+#include "InputEvents.h"
 #include "Utils.h"
 #include "Version.h"
-#include <vector>
 
 // Enable measurement of chip's VCC
 ADC_MODE(ADC_VCC);
 
 namespace iot_core {
 
-class System final : public ISystem, public IApplicationContainer {
+/**
+ * The core of an application, which manages WiFi, OTA updates, logging,
+ * configuration and all application components.
+ *
+ * The container for the components is given as template parameter, use the
+ * System or StaticSystem aliases below.
+ */
+template<typename Registry>
+class BasicSystem final : public ISystem, public IApplicationContainer {
   static const unsigned long FACTORY_RESET_TRIGGER_TIME = 5000ul; // 5 seconds
   static const unsigned long DISCONNECTED_RESET_TIMEOUT = 300000ul; // 5 minutes
   
   
   bool _stopped = false;
+  bool _setUp = false;
   Time _uptime = {};
   unsigned long _disconnectedSinceMs = 1u;
   ConnectionStatus _status = ConnectionStatus::Disconnected;
@@ -37,7 +51,9 @@ class System final : public ISystem, public IApplicationContainer {
   UdpLogSink _udpLog;
   Logger _logger;
   WiFiManager _wifiManager {};
-  std::vector<IApplicationComponent*> _components {};
+  Registry _components {};
+  EventBus _events {};
+  InputEvents _inputs {};
   
   toolbox::str<8> _chipId;
   toolbox::strref _name;
@@ -49,13 +65,17 @@ class System final : public ISystem, public IApplicationContainer {
   gpiobj::DigitalInput& _factoryResetPin;
   gpiobj::DigitalInput& _debugEnablePin;
 
-  TimingStatistics<20> _yieldTiming {};
-  std::map<toolbox::strref, TimingStatistics<10>> _componentTiming {};
+  TimingHistogram<> _yieldTiming {};
+  AllocationStatistics _loopAllocations {};
 
   std::function<void()> _scheduledFunction {};
 
+#ifdef IOT_CORE_COROUTINES_AVAILABLE
+  bool _frameFailureLogged = false;
+#endif
+
 public:
-  System(const toolbox::strref& name, const VersionInfo& version, const char* otaPassword, gpiobj::DigitalOutput& statusLedPin, gpiobj::DigitalInput& otaEnablePin, gpiobj::DigitalInput& updatePin, gpiobj::DigitalInput& factoryResetPin, gpiobj::DigitalInput& debugEnablePin)
+  BasicSystem(const toolbox::strref& name, const VersionInfo& version, const char* otaPassword, gpiobj::DigitalOutput& statusLedPin, gpiobj::DigitalInput& otaEnablePin, gpiobj::DigitalInput& updatePin, gpiobj::DigitalInput& factoryResetPin, gpiobj::DigitalInput& debugEnablePin)
     : _logService(_uptime),
     _memoryLog(),
     _udpLog(),
@@ -86,23 +106,39 @@ public:
     return _version;
   }
 
-  void addComponent(IApplicationComponent* component) override {
-    _components.emplace_back(component);
-    _componentTiming[component->name()] = {};
+  /**
+   * Adds the component, which fails if there already is one with the same
+   * name. Components added after setup() are set up right away.
+   */
+  ComponentHandle addComponent(IApplicationComponent* component) override {
+    return add(component);
+  }
+
+  /**
+   * Adds a component of the given type, which is required for the
+   * StaticSystem (the type has to be one of its components).
+   */
+  template<typename T>
+  ComponentHandle addComponent(T* component) {
+    return add(component);
+  }
+
+  IApplicationComponent* getComponent(ComponentHandle handle) override {
+    return _components.get(handle);
   }
 
   IApplicationComponent const* getComponent(const toolbox::strref& name) const override {
-    return findComponentByName(name);
+    return _components.find(name);
   }
 
   IApplicationComponent* getComponent(const toolbox::strref& name) override {
-    return findComponentByName(name);
+    return _components.find(name);
   }
 
   void forEachComponent(std::function<void(const IApplicationComponent* component)> handler) const override {
-    for (auto component : _components) {
-      handler(component);
-    }
+    _components.forEach([&] (const IApplicationComponent& component, const ComponentRecord&) {
+      handler(&component);
+    });
   }
 
   void setup() {
@@ -135,10 +171,10 @@ public:
     
     _logger.log(LogLevel::Info, F("System setup done."));
 
-    for (auto component : _components) {
-      restoreConfiguration(component);
-      component->setup(connected);
-    }
+    _components.forEach([&] (auto& component, ComponentRecord& record) {
+      setupComponent(component, record, connected);
+    });
+    _setUp = true;
 
     _logger.log(LogLevel::Info, F("All setup done."));
     
@@ -146,12 +182,15 @@ public:
   }
 
   void loop() {
+    AllocationScope allocationScope {_loopAllocations};
     _yieldTiming.start();
 
     _uptime.update();
 
     lyield();
 
+    _inputs.process();
+
     if (_factoryResetPin && _factoryResetPin.hasNotChangedFor(FACTORY_RESET_TRIGGER_TIME)) {
       factoryReset();
     }
@@ -204,6 +243,7 @@ public:
   }
 
   void lyield() override {
+    _events.deliver();
     _yieldTiming.stop();
     yield();
     _wifiManager.process();
@@ -214,6 +254,10 @@ public:
     _yieldTiming.start();
   }
 
+  const Histogram<>& yieldTiming() const override {
+    return _yieldTiming.histogram();
+  }
+
   void reset() override {
     ESP.restart();
   }
@@ -258,30 +302,33 @@ public:
     }
   }
 
+  EventBus& events() override {
+    return _events;
+  }
+
+  InputEvents& inputs() override {
+    return _inputs;
+  }
+
   void setDateTimeSource(const IDateTimeSource* dateTimeSource) {
     _dateTimeSource = dateTimeSource;
   }
 
   bool configure(const toolbox::strref& category, IConfigParser const& config) override {
-    auto component = findComponentByName(category);
-    if (component == nullptr) {
-      return false;
-    }
-    if (config.parse([&] (const toolbox::strref& name, const toolbox::strref& value) { return component->configure(name, value); })) {
-      persistConfiguration(component);
-      return true;
-    } else {
-      return false;
-    }
+    bool success = false;
+    _components.visit(category, [&] (auto& component, ComponentRecord& record) {
+      if (config.parse([&] (const toolbox::strref& name, const toolbox::strref& value) { return componentConfigure(component, name, value); })) {
+        persistConfiguration(record.component);
+        success = true;
+      }
+    });
+    return success;
   }
 
   void getConfig(const toolbox::strref& category, ConfigWriter writer) const override {
-    auto component = findComponentByName(category);
-    if (component == nullptr) {
-      return;
-    }
-
-    component->getConfig(writer);
+    _components.visit(category, [&] (const auto& component, const ComponentRecord&) {
+      componentGetConfig(component, writer);
+    });
   }
 
   bool configureAll(IConfigParser const& config) override {
@@ -292,13 +339,12 @@ public:
       }
 
       auto category = path.substring(0, categoryEnd);
-      auto component = findComponentByName(category);
-      if (component == nullptr) {
-        return false;
-      } else {
-        auto name = path.skip(categoryEnd + 1);
-        return component->configure(name, value);
-      }
+      auto name = path.skip(categoryEnd + 1);
+      bool success = false;
+      _components.visit(category, [&] (auto& component, ComponentRecord&) {
+        success = componentConfigure(component, name, value);
+      });
+      return success;
     })) {
       persistAllConfigurations();
       return true;
@@ -308,11 +354,11 @@ public:
   }
 
   void getAllConfig(ConfigWriter writer) const override {
-    for (auto component : _components) {
-      component->getConfig([&] (const toolbox::strref& name, const toolbox::strref& value) {
-        writer(toolbox::format("%s.%s", component->name().cstr(), name.cstr()), value);
+    _components.forEach([&] (const auto& component, const ComponentRecord& record) {
+      componentGetConfig(component, [&] (const toolbox::strref& name, const toolbox::strref& value) {
+        writer(toolbox::format("%s.%s", record.name.cstr(), name.cstr()), value);
       });  
-    }
+    });
   }
 
   LogService& logs() override { return _logService; }
@@ -332,71 +378,105 @@ public:
     collector.addValue(F("iotCoreVersion"), IOT_CORE_VERSION);
     collector.addValue(F("espCoreVersion"), ESP.getCoreVersion());
     collector.addValue(F("espSdkVersion"), ESP.getSdkVersion());
-    collector.addValue(F("cpuFreq"), toolbox::format("%u", ESP.getCpuFreqMHz()));
+    collector.addNumber(F("cpuFreq"), ESP.getCpuFreqMHz());
     collector.addValue(F("chipVcc"), toolbox::format("%1.2f", ESP.getVcc() / 1000.0));
     collector.addValue(F("resetReason"), ESP.getResetReason());
     collector.addValue(F("uptime"), _uptime.format());
-    collector.addValue(F("freeHeap"), toolbox::format("%u", ESP.getFreeHeap()));
-    collector.addValue(F("heapFragmentation"), toolbox::format("%u", ESP.getHeapFragmentation()));
-    collector.addValue(F("maxFreeBlockSize"), toolbox::format("%u", ESP.getMaxFreeBlockSize()));
+    collector.addNumber(F("freeHeap"), ESP.getFreeHeap());
+    collector.addNumber(F("heapFragmentation"), ESP.getHeapFragmentation());
+    collector.addNumber(F("maxFreeBlockSize"), ESP.getMaxFreeBlockSize());
     collector.addValue(F("wifiRssi"), toolbox::format("%i", WiFi.RSSI()));
     collector.addValue(F("ip"), WiFi.localIP().toString());
 
     collector.beginSection(F("timing"));
 
     collector.beginSection(F("yield"));
-    collector.addValue(F("count"), toolbox::convert<size_t>::toString(_yieldTiming.count(), 10));
-    collector.addValue(F("avg"), toolbox::convert<unsigned long>::toString(_yieldTiming.avg(), 10));
-    collector.addValue(F("min"), toolbox::convert<unsigned long>::toString(_yieldTiming.min(), 10));
-    collector.addValue(F("max"), toolbox::convert<unsigned long>::toString(_yieldTiming.max(), 10));
+    _yieldTiming.getDiagnostics(collector);
+    collector.endSection();
+
+    if constexpr (Registry::COMPONENT_STATISTICS) {
+      _components.forEach([&] (const IApplicationComponent&, const ComponentRecord& record) {
+        collector.beginSection(record.name);
+        record.timing.getDiagnostics(collector);
+        collector.endSection();
+      });
+    }
+
     collector.endSection();
 
-    for (auto& [componentName, timing] : _componentTiming) {
-      collector.beginSection(componentName);
-      collector.addValue(F("count"), toolbox::convert<size_t>::toString(timing.count(), 10));
-      collector.addValue(F("avg"), toolbox::convert<unsigned long>::toString(timing.avg(), 10));
-      collector.addValue(F("min"), toolbox::convert<unsigned long>::toString(timing.min(), 10));
-      collector.addValue(F("max"), toolbox::convert<unsigned long>::toString(timing.max(), 10));
+    if (AllocationTracker::enabled()) {
+      collector.beginSection(F("allocations"));
+
+      collector.beginSection(F("loop"));
+      _loopAllocations.getDiagnostics(collector);
+      collector.endSection();
+
+      if constexpr (Registry::COMPONENT_STATISTICS) {
+        _components.forEach([&] (const IApplicationComponent&, const ComponentRecord& record) {
+          collector.beginSection(record.name);
+          record.allocations.getDiagnostics(collector);
+          collector.endSection();
+        });
+      }
+
       collector.endSection();
     }
 
+    collector.beginSection(F("events"));
+    _events.getDiagnostics(collector);
+    collector.endSection();
+
+    collector.beginSection(F("inputs"));
+    _inputs.getDiagnostics(collector);
+    collector.endSection();
+
+#ifdef IOT_CORE_COROUTINES_AVAILABLE
+    collector.beginSection(F("coroutineFrames"));
+    g_coroutineFrames.getDiagnostics(collector);
     collector.endSection();
+#endif
+
     collector.endSection();
 
-    for (auto component : _components) {
-      collector.beginSection(component->name());
-      component->getDiagnostics(collector);
+    _components.forEach([&] (const auto& component, const ComponentRecord& record) {
+      collector.beginSection(record.name);
+      componentGetDiagnostics(component, collector);
       collector.endSection();
-    }
+    });
   }
 
 private:
   void loopComponents() {
-    for (auto component : _components) {
-      auto& timing = _componentTiming[component->name()];
-      timing.start();
-      component->loop(_status);
-      timing.stop();
-      lyield();
-    }
-  }
-
-  IApplicationComponent* findComponentByName(const toolbox::strref& name) {
-    for (auto component : _components) {
-      if (component->name() == name) {
-        return component;
+    _components.forEachTyped([this] (auto& component, ComponentRecord& record) {
+      if (!record.hasFlag(COMPONENT_FLAG_SET_UP)) {
+        return;
       }
-    }
-    return nullptr;
-  }
-
-  IApplicationComponent const* findComponentByName(const toolbox::strref& name) const {
-    for (auto component : _components) {
-      if (component->name() == name) {
-        return component;
+      if constexpr (Registry::COMPONENT_STATISTICS) {
+        record.timing.start();
+        {
+          AllocationScope allocationScope {record.allocations};
+          componentLoop(component, _status);
+        }
+        record.timing.stop();
+      } else {
+        componentLoop(component, _status);
       }
+      lyield();
+    });
+    checkCoroutineFrames();
+  }
+
+  /**
+   * Logs (once) that a coroutine frame did not fit into the pool, as the
+   * component then never runs.
+   */
+  void checkCoroutineFrames() {
+#ifdef IOT_CORE_COROUTINES_AVAILABLE
+    if (!_frameFailureLogged && g_coroutineFrames.failed() > 0u) {
+      _frameFailureLogged = true;
+      _logger.log(LogLevel::Error, toolbox::format(F("Coroutine frame of %u bytes not available (%u blocks of %u bytes)."), unsigned(g_coroutineFrames.failedSize()), unsigned(g_coroutineFrames.capacity()), unsigned(g_coroutineFrames.blockSize())));
     }
-    return nullptr;
+#endif
   }
 
   void setupOTA() {
@@ -419,12 +499,34 @@ private:
     _statusLedPin.toggleIfUnchangedFor(250ul);
   }
 
-  void restoreConfiguration(IConfigurable* configurable) {
-    ConfigParser parser = readConfigFile(toolbox::format(F("/config/%s"), configurable->name().cstr()));
-    if (parser.parse([&] (const toolbox::strref& name, const toolbox::strref& value) { return configurable->configure(name, value); })) {
-      _logger.log(LogLevel::Info, toolbox::format(F("Restored config for '%s'."), configurable->name().cstr()));
+  template<typename T>
+  ComponentHandle add(T* component) {
+    ComponentHandle handle = _components.add(component);
+    if (!handle.valid()) {
+      _logger.log(LogLevel::Error, toolbox::format(F("Cannot add component '%s'."), component->name().cstr()));
+    } else if (_setUp) {
+      _logger.log(LogLevel::Warning, toolbox::format(F("Component '%s' added after setup."), component->name().cstr()));
+      _components.visit(component->name(), [&] (auto& added, ComponentRecord& record) {
+        setupComponent(added, record, connected());
+      });
+    }
+    return handle;
+  }
+
+  template<typename T>
+  void setupComponent(T& component, ComponentRecord& record, bool connected) {
+    restoreConfiguration(component, record.name);
+    componentSetup(component, connected);
+    record.setFlag(COMPONENT_FLAG_SET_UP);
+  }
+
+  template<typename T>
+  void restoreConfiguration(T& component, const toolbox::strref& name) {
+    ConfigParser parser = readConfigFile(toolbox::format(F("/config/%s"), name.cstr()));
+    if (parser.parse([&] (const toolbox::strref& key, const toolbox::strref& value) { return componentConfigure(component, key, value); })) {
+      _logger.log(LogLevel::Info, toolbox::format(F("Restored config for '%s'."), name.cstr()));
     } else {
-      _logger.log(LogLevel::Error, toolbox::format(F("failed to restore config for '%s'."), configurable->name().cstr()));
+      _logger.log(LogLevel::Error, toolbox::format(F("failed to restore config for '%s'."), name.cstr()));
     }
   }
 
@@ -433,12 +535,29 @@ private:
   }
 
   void persistAllConfigurations() {
-    for (auto component : _components) {
-      persistConfiguration(component);
-    }
+    _components.forEach([this] (const IApplicationComponent&, ComponentRecord& record) {
+      persistConfiguration(record.component);
+    });
   }
 };
 
+/**
+ * System with components added at runtime via addComponent().
+ */
+using System = BasicSystem<ComponentRegistry>;
+
+/**
+ * System with a fixed set of components given as template arguments. Every
+ * component type has to be added exactly once via addComponent(T*).
+ *
+ * The loop is unrolled at compile time and calls the components without
+ * virtual dispatch and without per-component timing and allocation
+ * statistics (see the System::loop benchmarks and the iot_core_size host
+ * target).
+ */
+template<typename... Components>
+using StaticSystem = BasicSystem<StaticComponentRegistry<Components...>>;
+
 }
 
 #endif
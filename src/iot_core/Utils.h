@@ -2,6 +2,7 @@
 #define IOT_CORE_UTILS_H_
 
 #include <toolbox.h>
+#include "Clock.h"
 #include <algorithm>
 #include <functional>
 #include <map>
@@ -24,69 +25,118 @@ public:
 };
 
 
-template<size_t SAMPLES>
+/**
+ * Class template for a monotonic deque over a sliding window of samples,
+ * whose front is always the extremum (according to Compare) of the window.
+ */
+template<size_t SAMPLES, typename Compare>
+class MonotonicWindow final {
+  struct Entry {
+    uint32_t sequence;
+    unsigned long value;
+  };
+
+  Entry _entries[SAMPLES] = {};
+  size_t _head = 0u;
+  size_t _size = 0u;
+
+  Entry& back() { return _entries[(_head + _size - 1u) % SAMPLES]; }
+
+public:
+  /**
+   * Adds the sample with the given sequence number, removing all samples
+   * which dropped out of the window.
+   */
+  void push(uint32_t sequence, unsigned long value) {
+    uint32_t oldestSequence = sequence - (SAMPLES - 1u);
+    while (_size > 0u && int32_t(_entries[_head].sequence - oldestSequence) < 0) {
+      _head = (_head + 1u) % SAMPLES;
+      _size -= 1u;
+    }
+    while (_size > 0u && !Compare()(back().value, value)) {
+      _size -= 1u;
+    }
+    _entries[(_head + _size) % SAMPLES] = {sequence, value};
+    _size += 1u;
+  }
+
+  unsigned long front() const { return _size == 0u ? 0u : _entries[_head].value; }
+};
+
+/**
+ * Class template to measure durations (in the unit of the given Clock, i.e.
+ * microseconds by default) and keep running
+ * statistics over the last SAMPLES samples (window) and all samples
+ * (lifetime). All statistics are updated with each sample, so queries are
+ * O(1).
+ */
+template<size_t SAMPLES, typename Clock = MicrosClock>
 class TimingStatistics final {
+  static const uint8_t EWMA_SHIFT = 3u; // smoothing factor of 1/8
+
   unsigned long _samples[SAMPLES] = {};
-  bool _hasSamples = false;
-  size_t _oldestSampleIndex = 0u;
-  size_t _newestSampleIndex = 0u;
-
-  unsigned long _startTime = 0u;
-
-  void newSample(unsigned long value) {
-    if (_hasSamples) {
-      _newestSampleIndex = (_newestSampleIndex + 1) % SAMPLES;
-      if (_newestSampleIndex == _oldestSampleIndex) {
-        _oldestSampleIndex = (_oldestSampleIndex + 1) % SAMPLES;
-      }
-    }
+  uint64_t _sampleCount = 0u; // does not wrap in practice, even at 1 MHz
+  uint64_t _windowSum = 0u;
+  MonotonicWindow<SAMPLES, std::less<unsigned long>> _windowMin {};
+  MonotonicWindow<SAMPLES, std::greater<unsigned long>> _windowMax {};
 
-    _samples[_newestSampleIndex] = value;
+  unsigned long _lifetimeMin = 0u;
+  unsigned long _lifetimeMax = 0u;
+  uint64_t _lifetimeSum = 0u;
+  double _mean = 0.0; // Welford's algorithm, a float stops updating after ~2^24 samples
+  double _squaredDistances = 0.0;
+  unsigned long _ewma = 0u;
+
+  uint32_t _startTicks = 0u;
 
-    _hasSamples = true;
-  }
-  
 public:
   void start() {
-    _startTime = micros();
+    _startTicks = Clock::now();
   }
 
   void stop() {
-    newSample(micros() - _startTime);
+    add(Clock::since(_startTicks));
   }
 
-  unsigned long min() const {
-    size_t numberOfSamples = count();
-    unsigned long result = _samples[_oldestSampleIndex];
-    for (size_t i = 1u; i < numberOfSamples; ++i) {
-      result = std::min(_samples[(_oldestSampleIndex + i) % SAMPLES], result);
+  void add(unsigned long value) {
+    size_t index = _sampleCount % SAMPLES;
+    if (_sampleCount >= SAMPLES) {
+      _windowSum -= _samples[index];
     }
-    return result;
-  }
-
-  unsigned long max() const {
-    size_t numberOfSamples = count();
-    unsigned long result = _samples[_oldestSampleIndex];
-    for (size_t i = 1u; i < numberOfSamples; ++i) {
-      result = std::max(_samples[(_oldestSampleIndex + i) % SAMPLES], result);
+    _samples[index] = value;
+    _windowSum += value;
+    _windowMin.push(uint32_t(_sampleCount), value); // sequences are compared wrap-around safe
+    _windowMax.push(uint32_t(_sampleCount), value);
+
+    if (_sampleCount == 0u) {
+      _lifetimeMin = value;
+      _lifetimeMax = value;
+      _ewma = value;
+    } else {
+      _lifetimeMin = std::min(_lifetimeMin, value);
+      _lifetimeMax = std::max(_lifetimeMax, value);
+      _ewma = value >= _ewma ? _ewma + ((value - _ewma) >> EWMA_SHIFT) : _ewma - ((_ewma - value) >> EWMA_SHIFT);
     }
-    return result;
+    _lifetimeSum += value;
+    _sampleCount += 1u;
+
+    double delta = double(value) - _mean;
+    _mean += delta / double(_sampleCount);
+    _squaredDistances += delta * (double(value) - _mean);
   }
 
-  unsigned long avg() const {
-    size_t numberOfSamples = count();
-    if (numberOfSamples == 0u) {
-      return 0u;
-    }
+  unsigned long min() const { return _windowMin.front(); }
+  unsigned long max() const { return _windowMax.front(); }
+  unsigned long avg() const { return count() == 0u ? 0u : (unsigned long)(_windowSum / count()); }
+  size_t count() const { return std::min<size_t>(_sampleCount, SAMPLES); }
 
-    unsigned long result = _samples[_oldestSampleIndex] / numberOfSamples;
-    for (size_t i = 1u; i < numberOfSamples; ++i) {
-      result += _samples[(_oldestSampleIndex + i) % SAMPLES] / numberOfSamples;
-    }
-    return result;
-  }
+  unsigned long lifetimeMin() const { return _lifetimeMin; }
+  unsigned long lifetimeMax() const { return _lifetimeMax; }
+  unsigned long lifetimeAvg() const { return _sampleCount == 0u ? 0u : (unsigned long)(_lifetimeSum / _sampleCount); }
+  uint64_t lifetimeCount() const { return _sampleCount; }
 
-  size_t count() const { return _hasSamples ? (_newestSampleIndex >= _oldestSampleIndex ? (_newestSampleIndex - _oldestSampleIndex + 1) : (SAMPLES - _oldestSampleIndex + _newestSampleIndex + 1)) : 0u; }
+  float variance() const { return _sampleCount < 2u ? 0.0f : float(_squaredDistances / double(_sampleCount - 1u)); }
+  unsigned long ewma() const { return _ewma; }
 
   template<typename F>
   auto wrap(F f) {
@@ -1 +1,6 @@
-#define IOT_CORE_VERSION "0.11.0"
\ No newline at end of file
+#ifndef IOT_CORE_VERSION_H_
+#define IOT_CORE_VERSION_H_
+
+#define IOT_CORE_VERSION "0.11.0"
+
+#endif
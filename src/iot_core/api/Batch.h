@@ -0,0 +1,350 @@
+#ifndef IOT_CORE_API_BATCH_H_
+#define IOT_CORE_API_BATCH_H_
+
+#include <toolbox.h>
+#include "ResponseCache.h"
+#include "Router.h"
+#include "Interfaces.h"
+
+namespace iot_core::api {
+
+static const char BATCH_BOUNDARY[] PROGMEM = "iot-core-batch-%04x%04x";
+static const char BATCH_CONTENT_TYPE[] PROGMEM = "multipart/mixed; boundary=";
+
+/**
+ * Request of a route called internally, which has no args, headers or body.
+ */
+class InternalRequest final : public IRequest {
+  class Body final : public IRequestBody {
+    toolbox::strref _empty {};
+
+  public:
+    const toolbox::strref& contentType() const override { return _empty; }
+    const toolbox::strref& content() override { return _empty; }
+    size_t available() const override { return 0u; }
+    size_t read(char* /*buffer*/, size_t /*bufferSize*/) override { return 0u; }
+
+    size_t readString(char* buffer, size_t bufferSize) override {
+      if (bufferSize > 0u) {
+        buffer[0] = '\0';
+      }
+      return 0u;
+    }
+  };
+
+  const RouteMatch& _match;
+  Body _body {};
+
+public:
+  explicit InternalRequest(const RouteMatch& match) : _match(match) {}
+
+  bool hasArg(const toolbox::strref& /*name*/) const override { return false; }
+  toolbox::strref arg(const toolbox::strref& /*name*/) const override { return {}; }
+  toolbox::strref pathArg(unsigned int i) const override { return _match.capture(i); }
+  toolbox::strref header(const toolbox::strref& /*name*/) const override { return {}; }
+  IRequestBody& body() override { return _body; }
+};
+
+/**
+ * Response of a route called internally, which passes everything on to the
+ * given response. It keeps the code, content type and bytes written of the
+ * response for the route statistics and captures the body for the response
+ * cache. Generated bodies are continued by the caller, so they are neither
+ * counted nor cached.
+ */
+class InternalResponse final : public IResponse {
+  class Body final : public IResponseBody {
+    IResponseBody* _body = nullptr;
+    CachedResponse* _capture = nullptr;
+    size_t _bytesWritten = 0u;
+
+  public:
+    IResponseBody& begin(IResponseBody& body, CachedResponse* capture) {
+      _body = &body;
+      _capture = capture;
+      return *this;
+    }
+
+    size_t bytesWritten() const { return _bytesWritten; }
+    void count(size_t size) { _bytesWritten += size; }
+    bool valid() const override { return _body != nullptr && _body->valid(); }
+
+    size_t write(const toolbox::strref& content) override {
+      size_t written = _body != nullptr ? _body->write(content) : 0u;
+      _bytesWritten += written;
+      if (_capture != nullptr) {
+        _capture->append(written == content.length() ? content : content.substring(0u, written));
+      }
+      return written;
+    }
+
+    size_t write(char c) override {
+      size_t written = _body != nullptr ? _body->write(c) : 0u;
+      _bytesWritten += written;
+      if (_capture != nullptr && written == 1u) {
+        _capture->append(c);
+      }
+      return written;
+    }
+  };
+
+  IResponse& _response;
+  CachedResponse* _capture;
+  int _code = mapResponseCode(ResponseCode::NotImplemented);
+  toolbox::strref _contentType = mapContentType(ContentType::TextPlain);
+  Body _body {};
+
+public:
+  InternalResponse(IResponse& response, CachedResponse* capture) : _response(response), _capture(capture) {}
+
+  int statusCode() const { return _code; }
+  const toolbox::strref& contentTypeValue() const { return _contentType; }
+  size_t bytesSent() const { return _body.bytesWritten(); }
+
+  IResponse& code(ResponseCode code) override {
+    _code = mapResponseCode(code);
+    _response.code(code);
+    return *this;
+  }
+
+  IResponse& contentType(ContentType contentType) override {
+    _contentType = mapContentType(contentType);
+    _response.contentType(contentType);
+    return *this;
+  }
+
+  IResponse& contentType(const toolbox::strref& contentType) override {
+    _contentType = contentType;
+    _response.contentType(contentType);
+    return *this;
+  }
+
+  IResponse& header(const toolbox::strref& name, const toolbox::strref& value) override {
+    _response.header(name, value);
+    return *this;
+  }
+
+  IResponseBody& sendChunkedBody() override {
+    return _body.begin(_response.sendChunkedBody(), _capture);
+  }
+
+  IResponseBody& sendSingleBody() override {
+    return _body.begin(_response.sendSingleBody(), _capture);
+  }
+
+  void sendProgmemBody(const uint8_t* content, size_t size) override {
+    if (_capture != nullptr) {
+      _capture->skip(); // already in flash, no need to copy into RAM
+    }
+    _response.sendProgmemBody(content, size);
+    _body.count(size);
+  }
+
+  bool sendGeneratedBody(ResponseGenerator generator) override {
+    if (_capture != nullptr) {
+      _capture->skip();
+    }
+    return _response.sendGeneratedBody(std::move(generator));
+  }
+};
+
+/**
+ * Response of a sub-request, written as part of a multipart batch body. Each
+ * part is an "application/http" message with the status line and headers of
+ * the sub-response. A generated body is continued by the batch afterwards.
+ */
+class BatchPartResponse final : public IResponse {
+public:
+  static constexpr size_t HEADER_BUFFER_SIZE = 128u;
+
+private:
+  IResponseBody& _body;
+  const char* _boundary;
+  const char* _path;
+  int _code = mapResponseCode(ResponseCode::NotImplemented);
+  toolbox::strref _contentType = mapContentType(ContentType::TextPlain);
+  char _headers[HEADER_BUFFER_SIZE] = {};
+  size_t _headersSize = 0u;
+  bool _started = false;
+  ResponseGenerator _generator {};
+
+  void start() {
+    if (_started) {
+      return;
+    }
+    _started = true;
+    _body.write(F("--"));
+    _body.write(_boundary);
+    _body.write(F("\r\nContent-Type: application/http\r\nContent-Location: "));
+    _body.write(_path);
+    _body.write(F("\r\n\r\nHTTP/1.1 "));
+    _body.write(toolbox::convert<uint32_t>::toString(_code, 10));
+    _body.write(F(" \r\nContent-Type: "));
+    _body.write(_contentType);
+    _body.write(F("\r\n"));
+    _body.write(toolbox::strref(_headers, _headersSize));
+    _body.write(F("\r\n"));
+  }
+
+public:
+  BatchPartResponse(IResponseBody& body, const char* boundary, const char* path) : _body(body), _boundary(boundary), _path(path) {}
+
+  IResponse& code(ResponseCode code) override {
+    _code = mapResponseCode(code);
+    return *this;
+  }
+
+  IResponse& contentType(ContentType contentType) override {
+    _contentType = mapContentType(contentType);
+    return *this;
+  }
+
+  IResponse& contentType(const toolbox::strref& contentType) override {
+    _contentType = contentType;
+    return *this;
+  }
+
+  /**
+   * Headers not fitting into the buffer are dropped.
+   */
+  IResponse& header(const toolbox::strref& name, const toolbox::strref& value) override {
+    size_t length = name.length() + value.length() + 4u;
+    if (!_started && length <= HEADER_BUFFER_SIZE - _headersSize) {
+      _headersSize += name.copy(_headers + _headersSize, name.length(), false);
+      _headers[_headersSize++] = ':';
+      _headers[_headersSize++] = ' ';
+      _headersSize += value.copy(_headers + _headersSize, value.length(), false);
+      _headers[_headersSize++] = '\r';
+      _headers[_headersSize++] = '\n';
+    }
+    return *this;
+  }
+
+  IResponseBody& sendChunkedBody() override {
+    start();
+    return _body;
+  }
+
+  IResponseBody& sendSingleBody() override {
+    start();
+    return _body;
+  }
+
+  void sendProgmemBody(const uint8_t* content, size_t size) override {
+    start();
+    char buffer[64];
+    for (size_t offset = 0u; offset < size; offset += sizeof(buffer)) {
+      size_t length = std::min(size - offset, sizeof(buffer));
+      memcpy_P(buffer, content + offset, length);
+      _body.write(toolbox::strref(buffer, length));
+    }
+  }
+
+  bool sendGeneratedBody(ResponseGenerator generator) override {
+    start();
+    _generator = std::move(generator);
+    return true;
+  }
+
+  /**
+   * Writes the head of the part if no body was sent, returns the generator
+   * of the body if the part has to be continued.
+   */
+  ResponseGenerator end() {
+    start();
+    return std::move(_generator);
+  }
+};
+
+/**
+ * Generates a multipart body with the responses of a list of GET paths
+ * (separated by ","), which are called one after the other. Only one
+ * sub-response is in progress at any time, so the memory needed does not
+ * grow with the number of paths.
+ *
+ * The boundary between the parts is random per batch, so a part body is
+ * unlikely to contain it.
+ */
+class BatchGenerator final {
+public:
+  static constexpr size_t MAX_PATHS = 8u;
+  static constexpr size_t BOUNDARY_LENGTH = 23u; // "iot-core-batch-" and 8 hex digits
+  static constexpr size_t CONTENT_TYPE_SIZE = sizeof(BATCH_CONTENT_TYPE) + BOUNDARY_LENGTH;
+
+private:
+  IServer* _server;
+  String _paths;
+  size_t _position = 0u;
+  ResponseGenerator _part {};
+  char _boundary[BOUNDARY_LENGTH + 1u] = {};
+
+  static void endPart(IResponseBody& body) {
+    body.write(F("\r\n"));
+  }
+
+public:
+  BatchGenerator(IServer& server, const toolbox::strref& paths) : _server(&server), _paths(paths.toString()) {
+    snprintf_P(_boundary, sizeof(_boundary), BATCH_BOUNDARY, unsigned(random(0x10000)), unsigned(random(0x10000)));
+  }
+
+  /**
+   * Writes the content type incl. the boundary into the buffer, which has to
+   * stay valid until the head of the response is sent.
+   */
+  toolbox::strref contentType(char (&buffer)[CONTENT_TYPE_SIZE]) const {
+    strcpy_P(buffer, BATCH_CONTENT_TYPE);
+    strcat(buffer, _boundary);
+    return toolbox::strref(buffer);
+  }
+
+  /**
+   * Returns false if the list is empty or has too many paths.
+   */
+  static bool valid(const toolbox::strref& paths) {
+    size_t count = 1u;
+    for (size_t i = 0u; i < paths.length(); ++i) {
+      count += paths.cstr()[i] == ',' ? 1u : 0u;
+    }
+    return !paths.empty() && count <= MAX_PATHS;
+  }
+
+  bool operator()(IResponseBody& body) {
+    if (_part) {
+      if (!_part(body)) {
+        _part = nullptr;
+        endPart(body);
+      }
+      return true;
+    }
+
+    if (_position > _paths.length()) {
+      body.write(F("--"));
+      body.write(_boundary);
+      body.write(F("--\r\n"));
+      return false;
+    }
+
+    int separator = _paths.indexOf(',', _position);
+    size_t end = separator < 0 ? _paths.length() : size_t(separator);
+    size_t length = end - _position;
+    char path[RouteMatch::MAX_PATH_LENGTH + 1u];
+    toolbox::strref(_paths.c_str() + _position, std::min(length, RouteMatch::MAX_PATH_LENGTH)).copy(path, RouteMatch::MAX_PATH_LENGTH, true);
+    _position = end + 1u;
+
+    BatchPartResponse response {body, _boundary, path};
+    if (length > RouteMatch::MAX_PATH_LENGTH) {
+      response.code(ResponseCode::BadRequest);
+    } else if (!_server->call(path, response)) {
+      response.code(ResponseCode::BadRequestNotFound);
+    }
+    _part = response.end();
+    if (!_part) {
+      endPart(body);
+    }
+    return true;
+  }
+};
+
+}
+
+#endif
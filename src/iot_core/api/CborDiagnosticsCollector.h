@@ -0,0 +1,93 @@
+#ifndef IOT_CORE_API_CBORDIAGNOSTICSCOLLECTOR_H_
+#define IOT_CORE_API_CBORDIAGNOSTICSCOLLECTOR_H_
+
+#include <iot_core/Interfaces.h>
+#include <toolbox.h>
+
+namespace iot_core::api {
+
+/**
+ * Minimal CBOR (RFC 8949) writer, maps and arrays have indefinite length so
+ * they can be streamed.
+ */
+class CborWriter final {
+  toolbox::IOutput& _output;
+
+  void head(uint8_t major, uint32_t value) {
+    uint8_t type = uint8_t(major << 5u);
+    if (value < 24u) {
+      _output.write(char(type | value));
+    } else if (value <= 0xFFu) {
+      _output.write(char(type | 24u));
+      _output.write(char(value));
+    } else if (value <= 0xFFFFu) {
+      _output.write(char(type | 25u));
+      _output.write(char(value >> 8u));
+      _output.write(char(value));
+    } else {
+      _output.write(char(type | 26u));
+      _output.write(char(value >> 24u));
+      _output.write(char(value >> 16u));
+      _output.write(char(value >> 8u));
+      _output.write(char(value));
+    }
+  }
+
+public:
+  explicit CborWriter(toolbox::IOutput& output) : _output(output) {}
+
+  void openMap() { _output.write(char(0xBF)); }
+  void openArray() { _output.write(char(0x9F)); }
+  void close() { _output.write(char(0xFF)); }
+
+  void number(uint32_t value) {
+    head(0u, value);
+  }
+
+  void string(const toolbox::strref& value) {
+    head(3u, value.length());
+    _output.write(value);
+  }
+};
+
+/**
+ * Collector writing diagnostics as CBOR map of maps, with the same structure
+ * as the JSON. Numbers are written as unsigned integers (smaller than the
+ * text), all other values as text, so the type of a value does not change.
+ */
+class CborDiagnosticsCollector final : public iot_core::IDiagnosticsCollector {
+private:
+  CborWriter& _writer;
+
+public:
+  CborDiagnosticsCollector(CborWriter& writer) : _writer(writer) {
+    _writer.openMap();
+  }
+
+  void beginSection(const toolbox::strref& name) override {
+    _writer.string(name);
+    _writer.openMap();
+  }
+
+  void addValue(const toolbox::strref& name, const toolbox::strref& value) override {
+    _writer.string(name);
+    _writer.string(value);
+  }
+
+  void addNumber(const toolbox::strref& name, uint32_t value) override {
+    _writer.string(name);
+    _writer.number(value);
+  }
+
+  void endSection() override {
+    _writer.close();
+  }
+
+  void end() {
+    _writer.close();
+  }
+};
+
+}
+
+#endif
@@ -3,22 +3,123 @@
 
 #include <toolbox.h>
 #include <toolbox/Streams.h>
+#include "Deflate.h"
 
 namespace iot_core::api {
 
+/**
+ * Maximum segment size of the TCP stack, taken from lwIP on the ESP8266 (it
+ * depends on the selected lwIP variant). Other platforms (e.g. the host,
+ * where TCP_MSS is a socket option) use the Ethernet MSS. It can be set
+ * explicitly by defining IOT_CORE_TCP_MSS.
+ */
+#ifndef IOT_CORE_TCP_MSS
+#if defined(ARDUINO_ARCH_ESP8266) && defined(TCP_MSS)
+#define IOT_CORE_TCP_MSS TCP_MSS
+#else
+#define IOT_CORE_TCP_MSS 1460
+#endif
+#endif
+
+/**
+ * Size of the pieces in which content is passed to the TCP stack, matching
+ * the maximum segment size.
+ */
+static constexpr size_t TCP_SEGMENT_SIZE = IOT_CORE_TCP_MSS;
+
+/**
+ * Maximum overhead of a chunk, i.e. the hex size and two CRLF.
+ */
+static constexpr size_t CHUNK_OVERHEAD = 8u;
+
+/**
+ * Default buffer size, such that a full chunk fits into a TCP segment.
+ */
+static constexpr size_t DEFAULT_CHUNK_SIZE = TCP_SEGMENT_SIZE - CHUNK_OVERHEAD;
+
 /**
  * Class template to send a chunked HTTP response to a client.
  * 
  * The buffer size influences how many chunks have to be sent and each chunk
  * incurs a (small) processing and transmission overhead. Thus setting the
  * size too low may reduce performance.
+ *
+ * Writes of at least the buffer size (in RAM) are sent directly as a single
+ * chunk once the buffer is empty, without copying them into the buffer.
+ *
+ * The content can optionally be compressed by a deflate encoder, the
+ * Content-Encoding header has to be sent before by the caller.
+ *
+ * A deferred response (see beginDeferred()) is only started as chunked
+ * response once the content outgrows the buffer. Otherwise it is sent as a
+ * single response with an exact Content-Length when it ends.
  */
-template<typename T, size_t BUFFER_SIZE = 512u>
+template<typename T, size_t BUFFER_SIZE = DEFAULT_CHUNK_SIZE>
 class ChunkedResponse final : public toolbox::IOutput {
   T& _server;
   char _buffer[BUFFER_SIZE + 1u] = {}; // +1 for null-termination
   size_t _size = 0u;
   bool _valid = false;
+  bool _deferred = false;
+  bool _failed = false;
+  bool _chunked = false;
+  int _code = 0;
+  toolbox::strref _contentType {};
+  DeflateEncoder* _encoder = nullptr;
+  uint32_t _chunks = 0u;
+  uint32_t _segments = 0u;
+  uint32_t _writeThroughs = 0u;
+
+  bool start() {
+    _deferred = false;
+    if (_contentType.isInProgmem()) {
+      _valid = _server.chunkedResponseModeStart(_code, _contentType.fpstr());
+    } else {
+      _valid = _server.chunkedResponseModeStart(_code, _contentType.cstr());
+    }
+    _chunked = _valid;
+    _failed = !_valid;
+    return _valid;
+  }
+
+  void sendChunk(const char* data, size_t size) {
+    if (_deferred && !start()) {
+      return;
+    }
+    _server.sendContent(data, size);
+    _chunks += 1u;
+    _segments += (size + CHUNK_OVERHEAD + TCP_SEGMENT_SIZE - 1u) / TCP_SEGMENT_SIZE;
+  }
+
+  static void encoderOutput(void* context, const char* data, size_t size) {
+    static_cast<ChunkedResponse*>(context)->append(data, size);
+  }
+
+  void append(const char* data, size_t size) {
+    while (size > 0u) {
+      size_t copied = std::min(size, BUFFER_SIZE - _size);
+      memcpy(_buffer + _size, data, copied);
+      _size += copied;
+      if (_size == BUFFER_SIZE) {
+        flush();
+      }
+      data += copied;
+      size -= copied;
+    }
+  }
+
+  void reset(int code, const toolbox::strref& contentType) {
+    clear();
+    _code = code;
+    _contentType = contentType;
+    _encoder = nullptr;
+    _deferred = false;
+    _failed = false;
+    _chunked = false;
+    _chunks = 0u;
+    _segments = 0u;
+    _writeThroughs = 0u;
+  }
 
 public:
   explicit ChunkedResponse(T& server) : _server(server) {}
@@ -37,22 +138,72 @@ public:
     _size = 0u;
   }
 
-  bool begin(int code, const toolbox::strref& contentType) {
-    clear();
-    if (contentType.isInProgmem()) {
-      _valid = _server.chunkedResponseModeStart(code, contentType.fpstr());
-    } else {
-      _valid = _server.chunkedResponseModeStart(code, contentType.cstr());
+  bool begin(int code, const toolbox::strref& contentType, DeflateEncoder* encoder = nullptr, ContentEncoding encoding = ContentEncoding::Identity) {
+    reset(code, contentType);
+    start();
+    if (_valid && encoder != nullptr && encoding != ContentEncoding::Identity) {
+      _encoder = encoder;
+      _encoder->begin(encoding, &ChunkedResponse::encoderOutput, this);
     }
     return _valid;
   }
 
+  /**
+   * Begins a response which is buffered and only sent when it ends, unless
+   * the content does not fit into the buffer. Then it is upgraded to a
+   * chunked response, which fails if the output cannot start one (the API
+   * servers delimit the body by closing the connection for HTTP/1.0).
+   */
+  void beginDeferred(int code, const toolbox::strref& contentType) {
+    reset(code, contentType);
+    _deferred = true;
+    _valid = true;
+  }
+
+  bool encoded() const {
+    return _encoder != nullptr;
+  }
+
+  /**
+   * Returns true if the response was (or is being) sent chunked.
+   */
+  bool chunked() const {
+    return _chunked;
+  }
+
+  /**
+   * Returns true if the chunked response could not be started, i.e. the
+   * client does not support HTTP/1.1.
+   */
+  bool failed() const {
+    return _failed;
+  }
+
+  /**
+   * Number of chunks sent in this response (excl. the final empty chunk).
+   */
+  uint32_t chunks() const { return _chunks; }
+
+  /**
+   * Number of TCP segments needed for the chunks, if each chunk is sent in
+   * its own segments.
+   */
+  uint32_t segments() const { return _segments; }
+
+  /**
+   * Number of writes sent directly, bypassing the buffer.
+   */
+  uint32_t writeThroughs() const { return _writeThroughs; }
+
   void flush() {
     if (!_valid || _size == 0u) {
       return;
     }
+    if (_deferred && !start()) {
+      return;
+    }
 
-    _server.sendContent(_buffer, _size);
+    sendChunk(_buffer, _size);
     clear();
   }
 
@@ -61,6 +212,22 @@ public:
       return;
     }
 
+    if (_deferred) {
+      _deferred = false;
+      _valid = false;
+      if (_contentType.isInProgmem()) {
+        _server.send_P(_code, _contentType.cstr(), _buffer, _size);
+      } else {
+        _server.send(_code, _contentType.cstr(), _buffer, _size);
+      }
+      clear();
+      return;
+    }
+
+    if (_encoder != nullptr) {
+      _encoder->end();
+      _encoder = nullptr;
+    }
     flush();
     _server.chunkedResponseFinalize();
     _valid = false;
@@ -70,9 +237,15 @@ public:
     if (!_valid) {
       return 0u;
     }
+    if (_encoder != nullptr) {
+      return _encoder->write(c);
+    }
     
     if (_size >= BUFFER_SIZE) {
       flush();
+      if (!_valid) {
+        return 0u;
+      }
     }
     _buffer[_size] = c;
     _size += 1u;
@@ -83,21 +256,71 @@ public:
     if (!_valid) {
       return 0u;
     }
+    if (_encoder != nullptr) {
+      return _encoder->write(string);
+    }
 
     toolbox::strref remaining = string;
     while (!remaining.empty()) {
+      if (_size == BUFFER_SIZE) {
+        flush(); // deferred responses only start chunking when the content outgrows the buffer
+        if (!_valid) {
+          return string.length() - remaining.length();
+        }
+      }
+      if (_size == 0u && remaining.length() >= BUFFER_SIZE + (_deferred ? 1u : 0u) && !remaining.isInProgmem()) {
+        sendChunk(remaining.cstr(), remaining.length());
+        if (!_valid) {
+          return 0u;
+        }
+        _writeThroughs += 1u;
+        break;
+      }
       size_t copiedLength = remaining.copy(_buffer + _size, BUFFER_SIZE - _size, false);
       _size += copiedLength;
-      if (_size == BUFFER_SIZE) {
+      remaining = remaining.skip(copiedLength);
+      if (_size == BUFFER_SIZE && !_deferred) {
         flush();
       }
-      remaining = remaining.skip(copiedLength);
     }
     
     return string.length();
   }
 };
 
+/**
+ * Statistics of the chunking of responses, to tune the buffer size.
+ */
+class ChunkStatistics final {
+  uint32_t _responses = 0u;
+  uint32_t _chunks = 0u;
+  uint32_t _segments = 0u;
+  uint32_t _writeThroughs = 0u;
+  uint32_t _maxChunks = 0u;
+
+public:
+  void record(uint32_t chunks, uint32_t segments, uint32_t writeThroughs) {
+    _responses += 1u;
+    _chunks += chunks;
+    _segments += segments;
+    _writeThroughs += writeThroughs;
+    _maxChunks = std::max(_maxChunks, chunks);
+  }
+
+  uint32_t responses() const { return _responses; }
+  uint32_t chunks() const { return _chunks; }
+  uint32_t segments() const { return _segments; }
+  uint32_t writeThroughs() const { return _writeThroughs; }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const {
+    collector.addNumber(F("responses"), _responses);
+    collector.addNumber(F("chunks"), _chunks);
+    collector.addNumber(F("maxChunks"), _maxChunks);
+    collector.addNumber(F("segments"), _segments);
+    collector.addNumber(F("writeThroughs"), _writeThroughs);
+  }
+};
+
 }
 
 #endif
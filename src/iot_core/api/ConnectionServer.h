@@ -0,0 +1,1016 @@
+#ifndef IOT_CORE_API_CONNECTIONSERVER_H_
+#define IOT_CORE_API_CONNECTIONSERVER_H_
+
+#include <iot_core/Interfaces.h>
+#include <iot_core/Histogram.h>
+#include <iot_core/Allocations.h>
+#include <toolbox.h>
+#include <ESP8266WiFi.h>
+#include <cctype>
+#include <cerrno>
+#include <memory>
+#include <optional>
+#include "Server.h"
+
+namespace iot_core::api {
+
+/**
+ * Single client connection of the ConnectionServer, which receives requests
+ * as far as data is available and writes the responses directly to the
+ * client.
+ *
+ * The request head is received into a fixed buffer and parsed in place, all
+ * arguments and headers are views into it. Bodies which fit into the buffer
+ * are received completely before the request is dispatched, larger ones are
+ * read from the client by the handler. Data of pipelined requests stays in
+ * the buffer for the next request.
+ *
+ * Only receiving the request does not block. Reading larger bodies and
+ * writing the response wait for the client (up to its timeout), like the
+ * web server of Server does.
+ */
+class Connection final {
+public:
+  static constexpr size_t BUFFER_SIZE = 1024u;
+  static constexpr size_t HEADER_BUFFER_SIZE = 256u;
+  static constexpr size_t MAX_ARGS = 8u;
+  static constexpr size_t MAX_HEADERS = 16u;
+  static constexpr size_t MAX_CONTENT_LENGTH = 65536u;
+
+  enum struct Status {
+    Pending, // request is not complete yet
+    Ready, // request can be dispatched
+    Closed, // client closed the connection
+    Invalid, // request cannot be handled, see reject()
+  };
+
+private:
+  static constexpr size_t HEAD_BUFFER_SIZE = 192u;
+
+  struct Entry final {
+    toolbox::strref name;
+    toolbox::strref value;
+  };
+
+  WiFiClient _client {};
+  bool _open = false;
+  bool _keepAlive = false;
+  bool _http11 = false;
+  bool _closeDelimited = false;
+  bool _responded = false;
+  uint32_t _lastActivity = 0u;
+  uint32_t _requests = 0u;
+  char _buffer[BUFFER_SIZE + 1u] = {}; // +1 for null-termination
+  size_t _size = 0u;
+  size_t _headSize = 0u;
+  uint8_t _method = 0u;
+  const char* _path = "";
+  Entry _args[MAX_ARGS] = {};
+  size_t _argCount = 0u;
+  Entry _headers[MAX_HEADERS] = {};
+  size_t _headerCount = 0u;
+  size_t _contentLength = 0u;
+  size_t _bodyBuffered = 0u;
+  size_t _bodyRead = 0u;
+  int _error = 0;
+  char _responseHeaders[HEADER_BUFFER_SIZE + 2u] = {}; // +2 for the final line break
+  size_t _responseHeadersSize = 0u;
+
+  static uint8_t parseMethod(const char* method) {
+    if (strcmp_P(method, PSTR("GET")) == 0) return methodMask(HttpMethod::GET);
+    if (strcmp_P(method, PSTR("HEAD")) == 0) return methodMask(HttpMethod::HEAD);
+    if (strcmp_P(method, PSTR("POST")) == 0) return methodMask(HttpMethod::POST);
+    if (strcmp_P(method, PSTR("PUT")) == 0) return methodMask(HttpMethod::PUT);
+    if (strcmp_P(method, PSTR("PATCH")) == 0) return methodMask(HttpMethod::PATCH);
+    if (strcmp_P(method, PSTR("DELETE")) == 0) return methodMask(HttpMethod::DELETE);
+    if (strcmp_P(method, PSTR("OPTIONS")) == 0) return methodMask(HttpMethod::OPTIONS);
+    return 0u;
+  }
+
+  static void urlDecode(char* value) {
+    char* out = value;
+    for (const char* in = value; *in != '\0'; ++in) {
+      if (*in == '+') {
+        *out++ = ' ';
+      } else if (*in == '%' && isxdigit(in[1]) && isxdigit(in[2])) {
+        char hex[3] = {in[1], in[2], '\0'};
+        *out++ = char(strtoul(hex, nullptr, 16));
+        in += 2;
+      } else {
+        *out++ = *in;
+      }
+    }
+    *out = '\0';
+  }
+
+  /**
+   * Terminates the line and returns the start of the next one, if any.
+   */
+  static char* nextLine(char* line) {
+    char* end = strstr(line, "\r\n");
+    if (end == nullptr) {
+      return nullptr;
+    }
+    *end = '\0';
+    return end + 2;
+  }
+
+  void parseQuery(char* query) {
+    while (query != nullptr && *query != '\0') {
+      char* next = strchr(query, '&');
+      if (next != nullptr) {
+        *next++ = '\0';
+      }
+      char* value = strchr(query, '=');
+      if (value != nullptr) {
+        *value++ = '\0';
+      } else {
+        value = query + strlen(query);
+      }
+      if (*query != '\0' && _argCount < MAX_ARGS) {
+        urlDecode(query);
+        urlDecode(value);
+        _args[_argCount++] = {query, value};
+      }
+      query = next;
+    }
+  }
+
+  /**
+   * Parses the Content-Length, only a single one of digits up to
+   * MAX_CONTENT_LENGTH is accepted.
+   */
+  bool parseContentLength(const char* value, bool repeated) {
+    char* end = nullptr;
+    errno = 0;
+    unsigned long length = isdigit(value[0]) ? strtoul(value, &end, 10) : 0ul;
+    if (end == nullptr || *end != '\0' || (repeated && length != _contentLength)) {
+      return false;
+    }
+    if (errno == ERANGE || length > MAX_CONTENT_LENGTH) {
+      _error = mapResponseCode(ResponseCode::BadRequestPayloadTooLarge);
+      return false;
+    }
+    _contentLength = size_t(length);
+    return true;
+  }
+
+  /**
+   * Parses the request head in place, which ends at the given position.
+   * Headers beyond MAX_HEADERS are not available to the handler.
+   */
+  bool parseHead(char* end) {
+    *end = '\0';
+    char* line = _buffer;
+    char* next = nextLine(line);
+
+    char* target = strchr(line, ' ');
+    char* version = target != nullptr ? strchr(target + 1, ' ') : nullptr;
+    if (version == nullptr) {
+      return false;
+    }
+    *target++ = '\0';
+    *version++ = '\0';
+    if (strncmp_P(version, PSTR("HTTP/1."), 7u) != 0) {
+      _error = mapResponseCode(ResponseCode::HttpVersionNotSupported);
+      return false;
+    }
+    _http11 = version[7] != '0';
+    _keepAlive = _http11;
+    _method = parseMethod(line);
+    if (_method == 0u) {
+      _error = mapResponseCode(ResponseCode::NotImplemented);
+      return false;
+    }
+    char* query = strchr(target, '?');
+    if (query != nullptr) {
+      *query++ = '\0';
+    }
+    _path = target;
+    parseQuery(query);
+
+    bool contentLength = false;
+    while ((line = next) != nullptr) {
+      next = nextLine(line);
+      char* value = strchr(line, ':');
+      if (value == nullptr) {
+        return false;
+      }
+      *value++ = '\0';
+      while (*value == ' ' || *value == '\t') {
+        value += 1;
+      }
+      for (char* last = value + strlen(value); last > value && (last[-1] == ' ' || last[-1] == '\t'); --last) {
+        last[-1] = '\0';
+      }
+
+      if (strcasecmp_P(line, HEADER_CONTENT_LENGTH) == 0) {
+        if (!parseContentLength(value, contentLength)) {
+          return false;
+        }
+        contentLength = true;
+      } else if (strcasecmp_P(line, PSTR("Connection")) == 0) {
+        if (strcasecmp_P(value, PSTR("close")) == 0) {
+          _keepAlive = false;
+        } else if (strcasecmp_P(value, PSTR("keep-alive")) == 0) {
+          _keepAlive = true;
+        }
+      } else if (strcasecmp_P(line, PSTR("Transfer-Encoding")) == 0) {
+        _error = mapResponseCode(ResponseCode::BadRequestLengthRequired); // chunked request bodies are not supported
+        return false;
+      }
+      if (_headerCount < MAX_HEADERS) {
+        _headers[_headerCount++] = {line, value};
+      }
+    }
+    return true;
+  }
+
+  void resetRequest() {
+    _headSize = 0u;
+    _method = 0u;
+    _path = "";
+    _argCount = 0u;
+    _headerCount = 0u;
+    _contentLength = 0u;
+    _bodyBuffered = 0u;
+    _bodyRead = 0u;
+    _error = 0;
+    _responseHeadersSize = 0u;
+    _closeDelimited = false;
+    _responded = false;
+  }
+
+  void write(const char* data, size_t size) {
+    if (size > 0u && _client.write(reinterpret_cast<const uint8_t*>(data), size) != size) {
+      _keepAlive = false; // the response is incomplete, so the client cannot continue
+    }
+  }
+
+  void writeHead(int code, const toolbox::strref& contentType, bool chunked, size_t contentLength) {
+    char head[HEAD_BUFFER_SIZE];
+    size_t size = 0u;
+    auto append = [&] (const toolbox::strref& string) {
+      size += string.copy(head + size, HEAD_BUFFER_SIZE - size, false);
+    };
+    append(F("HTTP/1.1 "));
+    append(toolbox::convert<uint32_t>::toString(code, 10));
+    append(F(" \r\nContent-Type: ")); // the reason phrase is optional
+    append(contentType);
+    if (chunked) {
+      append(F("\r\nTransfer-Encoding: chunked"));
+    } else if (code != 204 && code != 304 && !_closeDelimited) {
+      append(F("\r\nContent-Length: "));
+      append(toolbox::convert<uint32_t>::toString(contentLength, 10));
+    }
+    append(_keepAlive ? F("\r\nConnection: keep-alive") : F("\r\nConnection: close"));
+    append(F("\r\nAccess-Control-Allow-Origin: *\r\n"));
+    write(head, size);
+    _responseHeaders[_responseHeadersSize++] = '\r';
+    _responseHeaders[_responseHeadersSize++] = '\n';
+    write(_responseHeaders, _responseHeadersSize);
+    _responded = true;
+  }
+
+public:
+  bool open() const { return _open; }
+  bool keepAlive() const { return _keepAlive; }
+  bool responded() const { return _responded; }
+  uint32_t lastActivity() const { return _lastActivity; }
+  uint32_t requests() const { return _requests; }
+  WiFiClient& client() { return _client; }
+
+  /**
+   * Returns true if the connection is kept alive after a request and waits
+   * for the next one, without having received anything of it yet.
+   */
+  bool idle() const { return _open && _requests > 0u && _size == 0u; }
+
+  void begin(const WiFiClient& client, uint32_t now) {
+    _client = client;
+    _open = true;
+    _keepAlive = false;
+    _lastActivity = now;
+    _requests = 0u;
+    _size = 0u;
+    resetRequest();
+  }
+
+  void close() {
+    _client.stop();
+    detach();
+  }
+
+  /**
+   * Releases the client without closing it, e.g. when a generated response
+   * took it over.
+   */
+  void detach() {
+    _client = WiFiClient();
+    _open = false;
+    _size = 0u;
+    resetRequest();
+  }
+
+  /**
+   * Receives what is available from the client, returns Ready once the next
+   * request can be dispatched.
+   */
+  Status receive(uint32_t now) {
+    if (_size < BUFFER_SIZE && _client.available() > 0) {
+      int read = _client.read(reinterpret_cast<uint8_t*>(_buffer + _size), BUFFER_SIZE - _size);
+      if (read > 0) {
+        _size += size_t(read);
+        _lastActivity = now;
+      }
+    }
+
+    if (_headSize == 0u) {
+      _buffer[_size] = '\0';
+      char* end = strstr(_buffer, "\r\n\r\n");
+      if (end == nullptr) {
+        if (_size == BUFFER_SIZE) {
+          _error = 431; // Request Header Fields Too Large
+          return Status::Invalid;
+        }
+        return _client.connected() ? Status::Pending : Status::Closed;
+      }
+      _headSize = size_t(end - _buffer) + 4u;
+      if (!parseHead(end)) {
+        _error = _error != 0 ? _error : mapResponseCode(ResponseCode::BadRequest);
+        return Status::Invalid;
+      }
+    }
+
+    bool buffered = _contentLength <= BUFFER_SIZE - _headSize; // small bodies are received before dispatching
+    if (buffered && _size - _headSize < _contentLength) {
+      return _client.connected() ? Status::Pending : Status::Closed;
+    }
+    _bodyBuffered = std::min(_size - _headSize, _contentLength);
+    return Status::Ready;
+  }
+
+  /**
+   * Completes the current request and moves data of pipelined requests to
+   * the start of the buffer. Returns false if the connection has to be
+   * closed, i.e. it is not kept alive or the body was not read completely.
+   */
+  bool finish() {
+    _requests += 1u;
+    size_t streamedRead = _bodyRead > _bodyBuffered ? _bodyRead - _bodyBuffered : 0u;
+    if (_contentLength - _bodyBuffered > streamedRead) {
+      _keepAlive = false; // rather close than reading the rest of a large body
+    }
+    size_t consumed = _headSize + _bodyBuffered;
+    memmove(_buffer, _buffer + consumed, _size - consumed);
+    _size -= consumed;
+    resetRequest();
+    return _keepAlive;
+  }
+
+  uint8_t method() const { return _method; }
+  const char* path() const { return _path; }
+  bool hasQuery() const { return _argCount > 0u; }
+
+  const toolbox::strref* findArg(const toolbox::strref& name) const {
+    for (size_t i = 0u; i < _argCount; ++i) {
+      if (_args[i].name == name) {
+        return &_args[i].value;
+      }
+    }
+    return nullptr;
+  }
+
+  toolbox::strref header(const toolbox::strref& name) const {
+    for (size_t i = 0u; i < _headerCount; ++i) {
+      const toolbox::strref& header = _headers[i].name;
+      if (header.length() == name.length() && strncasecmp_P(header.cstr(), name.cstr(), name.length()) == 0) {
+        return _headers[i].value;
+      }
+    }
+    return {};
+  }
+
+  size_t bodyAvailable() const {
+    return _contentLength - _bodyRead;
+  }
+
+  /**
+   * Reads the body from the buffer first and then from the client, which
+   * waits for the data (up to the timeout of the client).
+   */
+  size_t readBody(char* buffer, size_t size) {
+    size = std::min(size, _contentLength - _bodyRead);
+    size_t read = 0u;
+    if (_bodyRead < _bodyBuffered) {
+      read = std::min(size, _bodyBuffered - _bodyRead);
+      memcpy(buffer, _buffer + _headSize + _bodyRead, read);
+    }
+    if (read < size) {
+      read += _client.readBytes(buffer + read, size - read);
+    }
+    _bodyRead += read;
+    return read;
+  }
+
+  /**
+   * Adds a header to the response, returns false if it does not fit into
+   * the buffer or the head was sent already.
+   */
+  bool addHeader(const toolbox::strref& name, const toolbox::strref& value) {
+    size_t length = name.length() + value.length() + 4u;
+    if (_responded || name.empty() || length > HEADER_BUFFER_SIZE - _responseHeadersSize) {
+      return false;
+    }
+    _responseHeadersSize += name.copy(_responseHeaders + _responseHeadersSize, name.length(), false);
+    _responseHeaders[_responseHeadersSize++] = ':';
+    _responseHeaders[_responseHeadersSize++] = ' ';
+    _responseHeadersSize += value.copy(_responseHeaders + _responseHeadersSize, value.length(), false);
+    _responseHeaders[_responseHeadersSize++] = '\r';
+    _responseHeaders[_responseHeadersSize++] = '\n';
+    return true;
+  }
+
+  toolbox::strref responseHeaders() const {
+    return {_responseHeaders, _responseHeadersSize};
+  }
+
+  /**
+   * Responds with a body stored in RAM.
+   */
+  void respond(int code, const toolbox::strref& contentType, const char* content, size_t size) {
+    writeHead(code, contentType, false, size);
+    write(content, size);
+  }
+
+  /**
+   * Responds with a body stored in PROGMEM.
+   */
+  void respond_P(int code, const toolbox::strref& contentType, PGM_P content, size_t size) {
+    writeHead(code, contentType, false, size);
+    for (size_t offset = 0u; offset < size; offset += TCP_SEGMENT_SIZE) {
+      size_t length = std::min(size - offset, TCP_SEGMENT_SIZE);
+      if (_client.write_P(content + offset, length) != length) {
+        _keepAlive = false;
+        break;
+      }
+    }
+  }
+
+  /**
+   * Responds to an invalid request with the error code, the connection is
+   * closed afterwards.
+   */
+  void reject() {
+    _keepAlive = false;
+    respond(_error, mapContentType(ContentType::TextPlain), "", 0u);
+  }
+
+  // output interface of ChunkedResponse
+
+  /**
+   * Starts a streamed body, which is chunked for HTTP/1.1 clients. HTTP/1.0
+   * has no chunked encoding, so the body is delimited by closing the
+   * connection instead.
+   */
+  bool chunkedResponseModeStart(int code, const toolbox::strref& contentType) {
+    if (!_http11) {
+      _keepAlive = false;
+      _closeDelimited = true;
+    }
+    writeHead(code, contentType, _http11, 0u);
+    return true;
+  }
+
+  bool chunkedResponseModeStart(int code, const char* contentType) {
+    return chunkedResponseModeStart(code, toolbox::strref(contentType));
+  }
+
+  bool chunkedResponseModeStart(int code, const __FlashStringHelper* contentType) {
+    return chunkedResponseModeStart(code, toolbox::strref(contentType));
+  }
+
+  void sendContent(const char* content, size_t size) {
+    if (_closeDelimited) {
+      write(content, size);
+      return;
+    }
+    const char* chunkSize = toolbox::convert<uint32_t>::toString(size, 16);
+    char framing[12];
+    size_t length = toolbox::strref(chunkSize).copy(framing, sizeof(framing) - 2u, false);
+    framing[length++] = '\r';
+    framing[length++] = '\n';
+    write(framing, length);
+    write(content, size);
+    write("\r\n", 2u);
+  }
+
+  void chunkedResponseFinalize() {
+    if (!_closeDelimited) {
+      write("0\r\n\r\n", 5u);
+    }
+  }
+
+  void send(int code, const char* contentType, const char* content, size_t size) {
+    respond(code, contentType, content, size);
+  }
+
+  void send_P(int code, PGM_P contentType, PGM_P content, size_t size) {
+    // only the content type is in PROGMEM, content is the response buffer
+    respond(code, FPSTR(contentType), content, size);
+  }
+};
+
+/**
+ * Request of a connection of the ConnectionServer.
+ */
+class ConnectionRequest final : public IRequest {
+  /**
+   * Body of the request, streamed from the connection. It is only held in
+   * RAM if the content is requested as a whole.
+   */
+  class Body final : public IRequestBody {
+    Connection& _connection;
+    toolbox::strref _contentTypeHeader;
+    bool _streamed;
+    String _content;
+    toolbox::strref _contentRef;
+    toolbox::StringInput _stream;
+
+  public:
+    explicit Body(Connection& connection) : _connection(connection), _contentTypeHeader(connection.header(FPSTR(HEADER_CONTENT_TYPE))), _streamed(true), _content(), _contentRef(), _stream(_contentRef) {}
+
+    const toolbox::strref& contentType() const override {
+      return _contentTypeHeader;
+    }
+
+    const toolbox::strref& content() override {
+      if (_streamed) {
+        _content.reserve(_connection.bodyAvailable());
+        char buffer[64];
+        size_t read;
+        while ((read = this->read(buffer, sizeof(buffer))) > 0u) {
+          _content.concat(buffer, read);
+        }
+        _streamed = false;
+        _contentRef = _content;
+        _stream = toolbox::StringInput(_contentRef);
+      }
+      return _contentRef;
+    }
+
+    size_t available() const override {
+      return _streamed ? _connection.bodyAvailable() : _stream.available();
+    }
+
+    size_t read(char* buffer, size_t bufferSize) override {
+      return _streamed ? _connection.readBody(buffer, bufferSize) : _stream.read(buffer, bufferSize);
+    }
+
+    size_t readString(char* buffer, size_t bufferSize) override {
+      if (!_streamed) {
+        return _stream.readString(buffer, bufferSize);
+      }
+      if (bufferSize == 0u) {
+        return 0u;
+      }
+      size_t read = this->read(buffer, bufferSize - 1u);
+      buffer[read] = '\0';
+      return read;
+    }
+  };
+
+  Connection& _connection;
+  const RouteMatch& _match;
+  Body _body;
+
+public:
+  ConnectionRequest(Connection& connection, const RouteMatch& match) : _connection(connection), _match(match), _body(connection) {}
+
+  bool hasArg(const toolbox::strref& name) const override {
+    return _connection.findArg(name) != nullptr;
+  }
+
+  toolbox::strref arg(const toolbox::strref& name) const override {
+    const toolbox::strref* value = _connection.findArg(name);
+    return value != nullptr ? *value : toolbox::strref();
+  }
+
+  toolbox::strref pathArg(unsigned int i) const override {
+    return _match.capture(i);
+  }
+
+  toolbox::strref header(const toolbox::strref& name) const override {
+    return _connection.header(name);
+  }
+
+  IRequestBody& body() override {
+    return _body;
+  }
+};
+
+/**
+ * Response of a connection of the ConnectionServer. Headers are written
+ * into the buffer of the connection, which sends them with the head.
+ */
+class ConnectionResponse final : public IResponse {
+  Connection& _connection;
+  ResponseBody<Connection> _body;
+  GeneratedResponses<WiFiClient>& _generated;
+  DeflateEncoder* _encoder;
+  ContentEncoding _encoding;
+  int _code;
+  toolbox::strref _contentType;
+  size_t _progmemBytesSent;
+  CachedResponse* _capture;
+  bool _ended;
+  bool _encoded;
+  bool _detached;
+
+public:
+  ConnectionResponse(Connection& connection, GeneratedResponses<WiFiClient>& generated, DeflateEncoder* encoder = nullptr, ContentEncoding encoding = ContentEncoding::Identity) : _connection(connection), _body(connection), _generated(generated), _encoder(encoder), _encoding(encoder == nullptr ? ContentEncoding::Identity : encoding), _code(mapResponseCode(ResponseCode::NotImplemented)), _contentType(mapContentType(ContentType::TextPlain)), _progmemBytesSent(0u), _capture(nullptr), _ended(false), _encoded(false), _detached(false) {}
+
+  virtual ~ConnectionResponse() {
+    end();
+  }
+
+  int statusCode() const { return _code; }
+
+  const toolbox::strref& contentTypeValue() const { return _contentType; }
+
+  void capture(CachedResponse* capture) {
+    _capture = capture;
+    _body.capture(capture);
+  }
+
+  size_t bytesSent() const { return _body.bytesSent() + _progmemBytesSent; }
+
+  bool encoded() const { return _encoded; }
+
+  bool chunked() const { return _body.chunked(); }
+  const ChunkedResponse<Connection>& chunkedResponse() const { return _body.response(); }
+
+  /**
+   * Returns true if a generated response took over the client.
+   */
+  bool detached() const { return _detached; }
+
+  void end() {
+    if (_ended) {
+      return;
+    }
+    _ended = true;
+    if (_body.valid()) {
+      _body.end();
+    } else {
+      _connection.respond(_code, _contentType, "", 0u);
+    }
+  }
+
+  IResponse& code(ResponseCode code) override {
+    _code = mapResponseCode(code);
+    return *this;
+  }
+
+  IResponse& contentType(ContentType contentType) override {
+    _contentType = mapContentType(contentType);
+    return *this;
+  }
+
+  IResponse& contentType(const toolbox::strref& contentType) override {
+    _contentType = contentType;
+    return *this;
+  }
+
+  /**
+   * Headers which do not fit into the buffer of the connection are dropped.
+   */
+  IResponse& header(const toolbox::strref& name, const toolbox::strref& value) override {
+    _connection.addHeader(name, value);
+    return *this;
+  }
+
+  IResponseBody& sendChunkedBody() override {
+    if (_encoding != ContentEncoding::Identity) {
+      header(F("Content-Encoding"), contentEncodingToString(_encoding));
+      header(F("Vary"), FPSTR(HEADER_ACCEPT_ENCODING));
+    }
+    _body.beginChunked(_code, _contentType, _encoder, _encoding);
+    _encoded = _body.encoded();
+    return _body;
+  }
+
+  void sendProgmemBody(const uint8_t* content, size_t size) override {
+    if (_ended || _body.valid()) {
+      return;
+    }
+    _ended = true;
+    _connection.respond_P(_code, _contentType, reinterpret_cast<PGM_P>(content), size);
+    _progmemBytesSent = size;
+    if (_capture != nullptr) {
+      _capture->skip(); // already in flash, no need to copy into RAM
+    }
+  }
+
+  IResponseBody& sendSingleBody() override {
+    _body.beginSingle(_code, _contentType);
+    return _body;
+  }
+
+  /**
+   * The generated response takes over the client, the connection is then
+   * released without closing it.
+   */
+  bool sendGeneratedBody(ResponseGenerator generator) override {
+    if (_ended || _body.valid()) {
+      return false;
+    }
+    GeneratedResponse<WiFiClient>* generated = _generated.acquire();
+    if (generated == nullptr) {
+      code(ResponseCode::ServiceUnavailable);
+      contentType(ContentType::TextPlain);
+      sendSingleBody().write(F("too many responses"));
+      return false;
+    }
+    header(F("Access-Control-Allow-Origin"), F("*"));
+    _ended = true;
+    _detached = true;
+    generated->begin(_connection.client(), _code, _contentType, _connection.responseHeaders(), std::move(generator));
+    if (_capture != nullptr) {
+      _capture->skip();
+    }
+    return true;
+  }
+};
+
+/**
+ * Alternative to Server, which serves multiple clients concurrently from a
+ * small pool of connections instead of one client at a time.
+ *
+ * Connections are kept alive and handle pipelined requests in order, one
+ * request per connection and loop. Connections idle for longer than the
+ * idle timeout are closed, and the longest idle one is closed early if a
+ * new client waits for a free connection. The loop budget is checked
+ * before each connection is served, remaining connections are served first
+ * in the next loop. A dispatched request is always completed, so a slow
+ * client or handler can still exceed the budget.
+ */
+class ConnectionServer final : public IServer, public IContainer, public IApplicationComponent {
+public:
+  static constexpr size_t MAX_CONNECTIONS = 4u;
+  static constexpr uint32_t DEFAULT_IDLE_TIMEOUT = 5000u;
+  static constexpr uint32_t DEFAULT_LOOP_BUDGET = 20000u;
+  static constexpr size_t DEFAULT_CACHE_MEMORY = Dispatcher::DEFAULT_CACHE_MEMORY;
+
+private:
+  /**
+   * Request received by a connection, as dispatched by the dispatcher.
+   */
+  class Exchange final {
+    Connection& _connection;
+    std::optional<ConnectionResponse>& _response;
+    ConnectionRequest _request;
+
+  public:
+    Exchange(Connection& connection, std::optional<ConnectionResponse>& response, const RouteMatch& match) : _connection(connection), _response(response), _request(connection, match) {}
+
+    uint8_t method() const { return _connection.method(); }
+    uint32_t remoteIP() { return uint32_t(_connection.client().remoteIP()); }
+    bool hasQuery() const { return _connection.hasQuery(); }
+    const char* path() const { return _connection.path(); }
+    ConnectionRequest& request() { return _request; }
+
+    void reject(int code, uint32_t retryAfter) {
+      _connection.addHeader(F("Retry-After"), toolbox::convert<uint32_t>::toString(retryAfter, 10));
+      _connection.respond_P(code, mapContentType(ContentType::TextPlain), PSTR(""), 0u);
+    }
+
+    void respond(int code, const char* contentType, const char* content, size_t size) {
+      _connection.respond(code, contentType, content, size);
+    }
+
+    ConnectionResponse& beginResponse(GeneratedResponses<WiFiClient>& generated, DeflateEncoder* encoder, ContentEncoding encoding) {
+      return _response.emplace(_connection, generated, encoder, encoding);
+    }
+
+    void endResponse() {
+      if (_response->detached()) {
+        _connection.detach();
+      }
+      _response.reset();
+    }
+  };
+
+  WiFiServer _listener;
+  std::unique_ptr<Connection> _connections[MAX_CONNECTIONS];
+  size_t _next;
+  uint32_t _idleTimeout;
+  uint32_t _loopBudget;
+  RouteMatch _match;
+  Dispatcher _dispatcher;
+  std::optional<ConnectionResponse> _response; // kept out of the (4 KiB) loop stack, as it contains the chunk buffer
+  uint32_t _accepted;
+  uint32_t _reused;
+  uint32_t _timeouts;
+  uint32_t _evicted;
+  uint32_t _invalid;
+  uint32_t _deferred;
+
+  /**
+   * Returns a free connection (allocated on first use), or the longest idle
+   * one to be closed for a new client.
+   */
+  Connection* freeConnection(uint32_t now) {
+    Connection* longestIdle = nullptr;
+    for (auto& connection : _connections) {
+      if (!connection) {
+        connection.reset(new Connection());
+      }
+      if (!connection->open()) {
+        return connection.get();
+      }
+      if (connection->idle() && (longestIdle == nullptr || now - connection->lastActivity() > now - longestIdle->lastActivity())) {
+        longestIdle = connection.get();
+      }
+    }
+    if (longestIdle != nullptr) {
+      longestIdle->close();
+      _evicted += 1u;
+    }
+    return longestIdle;
+  }
+
+  void accept(uint32_t now) {
+    while (_listener.hasClient()) {
+      Connection* connection = freeConnection(now);
+      if (connection == nullptr) {
+        return; // the client waits until a connection is free
+      }
+      connection->begin(_listener.accept(), now);
+      _accepted += 1u;
+    }
+  }
+
+  void dispatch(Connection& connection) {
+    if (!_dispatcher.match(connection.method(), connection.path(), _match)) {
+      connection.respond_P(mapResponseCode(ResponseCode::BadRequestNotFound), mapContentType(ContentType::TextPlain), PSTR("Not found"), 9u);
+      return;
+    }
+
+    Exchange exchange {connection, _response, _match};
+    _dispatcher.dispatch(_match, exchange);
+  }
+
+  void serve(Connection& connection, uint32_t now) {
+    switch (connection.receive(now)) {
+      case Connection::Status::Pending:
+        if (now - connection.lastActivity() >= _idleTimeout) {
+          _timeouts += 1u;
+          connection.close();
+        }
+        break;
+      case Connection::Status::Closed:
+        connection.close();
+        break;
+      case Connection::Status::Invalid:
+        _invalid += 1u;
+        connection.reject();
+        connection.close();
+        break;
+      case Connection::Status::Ready:
+        if (connection.requests() > 0u) {
+          _reused += 1u;
+        }
+        dispatch(connection);
+        if (connection.open() && !connection.finish()) {
+          connection.close();
+        }
+        break;
+    }
+  }
+
+  void serve() {
+    uint32_t startTime = MicrosClock::now();
+    uint32_t now = millis();
+    accept(now);
+    size_t served = 0u;
+    for (; served < MAX_CONNECTIONS; ++served) {
+      if (MicrosClock::since(startTime) >= _loopBudget) {
+        _deferred += 1u;
+        break;
+      }
+      auto& connection = _connections[(_next + served) % MAX_CONNECTIONS];
+      if (connection && connection->open()) {
+        serve(*connection, now);
+      }
+    }
+    // the next loop starts with the first connection not served, or rotates
+    _next = (_next + (served < MAX_CONNECTIONS ? served : 1u)) % MAX_CONNECTIONS;
+  }
+
+  void closeAll() {
+    for (auto& connection : _connections) {
+      if (connection && connection->open()) {
+        connection->close();
+      }
+    }
+  }
+
+public:
+  ConnectionServer(ISystem& system, int port = 80, size_t cacheMemory = DEFAULT_CACHE_MEMORY) : _listener(port), _connections(), _next(0u), _idleTimeout(DEFAULT_IDLE_TIMEOUT), _loopBudget(DEFAULT_LOOP_BUDGET), _match(), _dispatcher(system, cacheMemory), _response(), _accepted(0u), _reused(0u), _timeouts(0u), _evicted(0u), _invalid(0u), _deferred(0u) {}
+
+  void on(const toolbox::strref& path, HttpMethod method, std::function<void(IRequest&, IResponse&)> handler) override {
+    _dispatcher.on(path, method, handler);
+  }
+
+  void on(const StaticRoute* routes, size_t count, void* context) override {
+    _dispatcher.on(routes, count, context);
+  }
+
+  bool cache(const toolbox::strref& path, HttpMethod method, uint32_t ttl, size_t maxSize) override {
+    return _dispatcher.cache(path, method, ttl, maxSize);
+  }
+
+  void invalidateCache() override {
+    _dispatcher.invalidateCache();
+  }
+
+  bool exempt(const toolbox::strref& path, HttpMethod method) override {
+    return _dispatcher.exempt(path, method);
+  }
+
+  bool call(const char* path, IResponse& response) override {
+    return _dispatcher.call(path, response);
+  }
+
+  void addProvider(IProvider* provider) override {
+    _dispatcher.addProvider(provider);
+  }
+
+  toolbox::strref name() const override {
+    return F("api");
+  }
+
+  bool configure(const toolbox::strref& name, const toolbox::strref& value) override {
+    if (name == F("idleTimeout")) {
+      _idleTimeout = strtoul(value.toString().c_str(), nullptr, 10);
+      return _idleTimeout > 0u;
+    }
+    if (name == F("loopBudget")) {
+      _loopBudget = strtoul(value.toString().c_str(), nullptr, 10);
+      return _loopBudget > 0u;
+    }
+    return _dispatcher.configure(name, value);
+  }
+
+  void getConfig(iot_core::ConfigWriter writer) const override {
+    writer(F("idleTimeout"), toolbox::convert<uint32_t>::toString(_idleTimeout, 10));
+    writer(F("loopBudget"), toolbox::convert<uint32_t>::toString(_loopBudget, 10));
+    _dispatcher.getConfig(writer);
+  }
+
+  void setup(bool /*connected*/) override {
+    _dispatcher.setup(*this);
+  }
+
+  void loop(ConnectionStatus status) override {
+    switch (status) {
+      case ConnectionStatus::Reconnected:
+        _listener.begin();
+        _listener.setNoDelay(true);
+        break;
+      case ConnectionStatus::Connected:
+        _dispatcher.loop([this]() { serve(); });
+        break;
+      case ConnectionStatus::Disconnecting:
+        closeAll();
+        _listener.close();
+        break;
+      case ConnectionStatus::Disconnected:
+        // do nothing
+        break;
+    }
+  }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const override {
+    size_t open = 0u;
+    for (const auto& connection : _connections) {
+      open += connection && connection->open() ? 1u : 0u;
+    }
+    collector.beginSection(F("connections"));
+    collector.addNumber(F("open"), open);
+    collector.addNumber(F("accepted"), _accepted);
+    collector.addNumber(F("reused"), _reused);
+    collector.addNumber(F("timeouts"), _timeouts);
+    collector.addNumber(F("evicted"), _evicted);
+    collector.addNumber(F("invalid"), _invalid);
+    collector.addNumber(F("deferred"), _deferred);
+    collector.endSection();
+
+    _dispatcher.getDiagnostics(collector);
+  }
+};
+
+}
+
+#endif
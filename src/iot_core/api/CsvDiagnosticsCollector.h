@@ -0,0 +1,98 @@
+#ifndef IOT_CORE_API_CSVDIAGNOSTICSCOLLECTOR_H_
+#define IOT_CORE_API_CSVDIAGNOSTICSCOLLECTOR_H_
+
+#include <iot_core/Interfaces.h>
+#include <toolbox.h>
+
+namespace iot_core::api {
+
+/**
+ * Writes a CSV (RFC 4180) field, which is quoted if needed.
+ */
+inline void writeCsvField(toolbox::IOutput& output, const toolbox::strref& field) {
+  const char* chars = field.cstr();
+  bool quoted = false;
+  for (size_t i = 0u; i < field.length() && !quoted; ++i) {
+    char c = char(pgm_read_byte(chars + i));
+    quoted = c == ',' || c == '"' || c == '\r' || c == '\n';
+  }
+  if (!quoted) {
+    output.write(field);
+    return;
+  }
+  output.write('"');
+  for (size_t i = 0u; i < field.length(); ++i) {
+    char c = char(pgm_read_byte(chars + i));
+    if (c == '"') {
+      output.write('"');
+    }
+    output.write(c);
+  }
+  output.write('"');
+}
+
+/**
+ * Collector writing diagnostics as CSV with a row per value, which has the
+ * path (section and value names separated by "/") and the value.
+ */
+class CsvDiagnosticsCollector final : public iot_core::IDiagnosticsCollector {
+public:
+  static constexpr size_t MAX_PATH_LENGTH = 128u;
+  static constexpr size_t MAX_DEPTH = 8u;
+
+private:
+  toolbox::IOutput& _output;
+  char _path[MAX_PATH_LENGTH] = {};
+  size_t _sectionEnds[MAX_DEPTH] = {};
+  size_t _depth = 0u;
+  size_t _ignoredDepth = 0u;
+
+  size_t pathLength() const {
+    return _depth == 0u ? 0u : _sectionEnds[_depth - 1u];
+  }
+
+public:
+  CsvDiagnosticsCollector(toolbox::IOutput& output) : _output(output) {}
+
+  static void header(toolbox::IOutput& output) {
+    output.write(F("path,value\r\n"));
+  }
+
+  void beginSection(const toolbox::strref& name) override {
+    size_t length = pathLength();
+    if (_ignoredDepth > 0u || _depth == MAX_DEPTH || length + name.length() + 1u > MAX_PATH_LENGTH) {
+      _ignoredDepth += 1u; // values too deeply nested are not included
+      return;
+    }
+    length += name.copy(_path + length, name.length(), false);
+    _path[length++] = '/';
+    _sectionEnds[_depth++] = length;
+  }
+
+  void addValue(const toolbox::strref& name, const toolbox::strref& value) override {
+    if (_ignoredDepth > 0u) {
+      return;
+    }
+    size_t length = pathLength();
+    if (length + name.length() > MAX_PATH_LENGTH) {
+      return;
+    }
+    length += name.copy(_path + length, name.length(), false);
+    writeCsvField(_output, toolbox::strref(_path, length));
+    _output.write(',');
+    writeCsvField(_output, value);
+    _output.write(F("\r\n"));
+  }
+
+  void endSection() override {
+    if (_ignoredDepth > 0u) {
+      _ignoredDepth -= 1u;
+    } else if (_depth > 0u) {
+      _depth -= 1u;
+    }
+  }
+};
+
+}
+
+#endif
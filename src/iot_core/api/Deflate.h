@@ -0,0 +1,441 @@
+#ifndef IOT_CORE_API_DEFLATE_H_
+#define IOT_CORE_API_DEFLATE_H_
+
+#include <Arduino.h>
+#include <iot_core/Clock.h>
+#include <iot_core/Histogram.h>
+#include <iot_core/Interfaces.h>
+#include <toolbox.h>
+#include <algorithm>
+#include "Negotiation.h"
+
+#ifndef IOT_CORE_DEFLATE_WINDOW_BITS
+#define IOT_CORE_DEFLATE_WINDOW_BITS 10
+#endif
+
+namespace iot_core::api {
+
+enum struct ContentEncoding : uint8_t {
+  Identity,
+  Deflate,
+  Gzip,
+};
+
+inline toolbox::strref contentEncodingToString(ContentEncoding encoding) {
+  switch (encoding) {
+    default:
+    case ContentEncoding::Identity: return F("identity");
+    case ContentEncoding::Deflate: return F("deflate");
+    case ContentEncoding::Gzip: return F("gzip");
+  }
+}
+
+/**
+ * Chooses the content encoding with the highest quality in an
+ * Accept-Encoding header, gzip is preferred over deflate over identity for
+ * the same quality. Codings with quality 0 are not accepted, "*" applies to
+ * the codings not listed. Identity is the fallback if nothing else is
+ * accepted, even if refused (the body is then sent as is instead of a 406).
+ */
+inline ContentEncoding negotiateContentEncoding(const toolbox::strref& acceptEncoding) {
+  static constexpr int32_t UNLISTED = -1;
+  int32_t gzip = UNLISTED;
+  int32_t deflate = UNLISTED;
+  int32_t identity = UNLISTED;
+  int32_t any = UNLISTED;
+  toolbox::strref remaining = acceptEncoding;
+  while (!remaining.empty()) {
+    int end = remaining.indexOf(',');
+    toolbox::strref coding = end < 0 ? remaining : remaining.substring(0u, end);
+    remaining = end < 0 ? toolbox::strref() : remaining.skip(end + 1);
+
+    int parameters = coding.indexOf(';');
+    toolbox::strref name = detail::trimSpaces(parameters < 0 ? coding : coding.substring(0u, parameters));
+    int32_t quality = parameters < 0 ? 1000 : detail::parseQuality(coding.skip(parameters + 1));
+    if (name == F("gzip")) {
+      gzip = quality;
+    } else if (name == F("deflate")) {
+      deflate = quality;
+    } else if (name == F("identity")) {
+      identity = quality;
+    } else if (name == F("*")) {
+      any = quality;
+    }
+  }
+  gzip = gzip == UNLISTED ? any : gzip;
+  deflate = deflate == UNLISTED ? any : deflate;
+  identity = identity == UNLISTED ? (any == 0 ? 0 : 1) : identity; // acceptable unless refused, but least preferred
+  if (gzip > 0 && gzip >= deflate && gzip >= identity) {
+    return ContentEncoding::Gzip;
+  }
+  if (deflate > 0 && deflate >= identity) {
+    return ContentEncoding::Deflate;
+  }
+  return ContentEncoding::Identity;
+}
+
+namespace detail {
+
+static const uint16_t DEFLATE_LENGTH_BASE[29] PROGMEM = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t DEFLATE_LENGTH_EXTRA[29] PROGMEM = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DEFLATE_DISTANCE_BASE[30] PROGMEM = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t DEFLATE_DISTANCE_EXTRA[30] PROGMEM = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+static const uint32_t CRC32_NIBBLES[16] PROGMEM = {
+  0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+  0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+};
+
+}
+
+/**
+ * Streaming deflate encoder (RFC 1951) with zlib (RFC 1950) or gzip
+ * (RFC 1952) framing, sized for small RAM.
+ *
+ * Uses a single block with the static Huffman codes and greedy LZ77 matching
+ * against the last 1-2 window sizes of input (2^IOT_CORE_DEFLATE_WINDOW_BITS
+ * bytes), with one candidate per hash bucket. This compresses repetitive text
+ * like JSON well, at a fraction of the memory and CPU cost of zlib.
+ *
+ * The encoded output is passed on in small pieces to the output function.
+ */
+class DeflateEncoder final {
+public:
+  static constexpr size_t WINDOW_SIZE = size_t(1u) << IOT_CORE_DEFLATE_WINDOW_BITS;
+  using Output = void(*)(void* context, const char* data, size_t size);
+
+private:
+  static constexpr size_t MIN_MATCH = 3u;
+  static constexpr size_t MAX_MATCH = 258u;
+  static constexpr size_t BUFFER_SIZE = 2u * WINDOW_SIZE;
+  static constexpr uint8_t HASH_BITS = 9u;
+  static constexpr size_t HASH_SIZE = size_t(1u) << HASH_BITS;
+  static constexpr size_t OUTPUT_SIZE = 64u;
+
+  static_assert(IOT_CORE_DEFLATE_WINDOW_BITS >= 9 && IOT_CORE_DEFLATE_WINDOW_BITS <= 14, "window must be 512 bytes to 16 KiB");
+
+  uint8_t _buffer[BUFFER_SIZE];
+  uint16_t _head[HASH_SIZE]; // position + 1 of the last occurrence of a hash, 0 if none
+  size_t _size = 0u;
+  size_t _position = 0u;
+  uint32_t _bits = 0u;
+  uint8_t _bitCount = 0u;
+  char _output[OUTPUT_SIZE];
+  size_t _outputSize = 0u;
+  Output _sink = nullptr;
+  void* _context = nullptr;
+  ContentEncoding _encoding = ContentEncoding::Identity;
+  uint32_t _checksum = 0u;
+  uint32_t _bytesIn = 0u;
+  uint32_t _bytesOut = 0u;
+  uint32_t _cpuTime = 0u;
+  uint32_t _sinkTime = 0u;
+  bool _active = false;
+
+  static uint16_t reverse(uint16_t code, uint8_t length) {
+    uint16_t reversed = 0u;
+    for (uint8_t i = 0u; i < length; ++i) {
+      reversed = (reversed << 1) | (code & 1u);
+      code >>= 1;
+    }
+    return reversed;
+  }
+
+  void flushOutput() {
+    if (_outputSize == 0u) {
+      return;
+    }
+    uint32_t start = CycleClock::now();
+    _sink(_context, _output, _outputSize);
+    _sinkTime += CycleClock::since(start);
+    _bytesOut += _outputSize;
+    _outputSize = 0u;
+  }
+
+  void putByte(uint8_t byte) {
+    _output[_outputSize++] = char(byte);
+    if (_outputSize == OUTPUT_SIZE) {
+      flushOutput();
+    }
+  }
+
+  void putBits(uint32_t value, uint8_t count) {
+    _bits |= value << _bitCount;
+    _bitCount += count;
+    while (_bitCount >= 8u) {
+      putByte(uint8_t(_bits));
+      _bits >>= 8;
+      _bitCount -= 8u;
+    }
+  }
+
+  void alignToByte() {
+    if (_bitCount > 0u) {
+      putBits(0u, 8u - _bitCount);
+    }
+  }
+
+  void putSymbol(uint16_t symbol) {
+    if (symbol < 144u) {
+      putBits(reverse(0x30u + symbol, 8u), 8u);
+    } else if (symbol < 256u) {
+      putBits(reverse(0x190u + symbol - 144u, 9u), 9u);
+    } else if (symbol < 280u) {
+      putBits(reverse(symbol - 256u, 7u), 7u);
+    } else {
+      putBits(reverse(0xC0u + symbol - 280u, 8u), 8u);
+    }
+  }
+
+  void putMatch(size_t length, size_t distance) {
+    uint8_t code = 28u;
+    while (pgm_read_word(&detail::DEFLATE_LENGTH_BASE[code]) > length) {
+      code -= 1u;
+    }
+    putSymbol(257u + code);
+    putBits(length - pgm_read_word(&detail::DEFLATE_LENGTH_BASE[code]), pgm_read_byte(&detail::DEFLATE_LENGTH_EXTRA[code]));
+
+    code = 29u;
+    while (pgm_read_word(&detail::DEFLATE_DISTANCE_BASE[code]) > distance) {
+      code -= 1u;
+    }
+    putBits(reverse(code, 5u), 5u);
+    putBits(distance - pgm_read_word(&detail::DEFLATE_DISTANCE_BASE[code]), pgm_read_byte(&detail::DEFLATE_DISTANCE_EXTRA[code]));
+  }
+
+  uint16_t hash(size_t position) const {
+    uint32_t value = uint32_t(_buffer[position]) << 16 | uint32_t(_buffer[position + 1u]) << 8 | _buffer[position + 2u];
+    return uint16_t((value * 2654435761u) >> (32u - HASH_BITS));
+  }
+
+  void insert(size_t position) {
+    _head[hash(position)] = uint16_t(position + 1u);
+  }
+
+  void encodeNext(size_t available) {
+    if (available >= MIN_MATCH) {
+      uint16_t h = hash(_position);
+      size_t candidate = _head[h];
+      _head[h] = uint16_t(_position + 1u);
+      if (candidate != 0u) {
+        candidate -= 1u;
+        size_t maxLength = std::min(available, MAX_MATCH);
+        size_t length = 0u;
+        while (length < maxLength && _buffer[candidate + length] == _buffer[_position + length]) {
+          length += 1u;
+        }
+        if (length >= MIN_MATCH) {
+          putMatch(length, _position - candidate);
+          for (size_t i = 1u; i < length && _position + i + MIN_MATCH <= _size; ++i) {
+            insert(_position + i);
+          }
+          _position += length;
+          return;
+        }
+      }
+    }
+    putSymbol(_buffer[_position]);
+    _position += 1u;
+  }
+
+  /**
+   * Encodes the buffered input, keeping enough lookahead for the longest
+   * match unless finishing.
+   */
+  void encode(bool finish) {
+    while (_position < _size && (finish || _size - _position >= MAX_MATCH)) {
+      encodeNext(_size - _position);
+    }
+  }
+
+  void slide() {
+    memmove(_buffer, _buffer + WINDOW_SIZE, _size - WINDOW_SIZE);
+    _size -= WINDOW_SIZE;
+    _position -= WINDOW_SIZE;
+    for (auto& head : _head) {
+      head = head > WINDOW_SIZE ? uint16_t(head - WINDOW_SIZE) : 0u;
+    }
+  }
+
+  void updateChecksum(const uint8_t* data, size_t size) {
+    if (_encoding == ContentEncoding::Gzip) {
+      uint32_t crc = ~_checksum;
+      for (size_t i = 0u; i < size; ++i) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ pgm_read_dword(&detail::CRC32_NIBBLES[crc & 0x0Fu]);
+        crc = (crc >> 4) ^ pgm_read_dword(&detail::CRC32_NIBBLES[crc & 0x0Fu]);
+      }
+      _checksum = ~crc;
+    } else {
+      uint32_t a = _checksum & 0xFFFFu;
+      uint32_t b = _checksum >> 16;
+      for (size_t i = 0u; i < size; ++i) {
+        a = (a + data[i]) % 65521u;
+        b = (b + a) % 65521u;
+      }
+      _checksum = (b << 16) | a;
+    }
+  }
+
+  void putHeader() {
+    if (_encoding == ContentEncoding::Gzip) {
+      static const uint8_t GZIP_HEADER[10] PROGMEM = {0x1f, 0x8b, 8u, 0u, 0u, 0u, 0u, 0u, 0u, 0xff};
+      for (size_t i = 0u; i < sizeof(GZIP_HEADER); ++i) {
+        putByte(pgm_read_byte(&GZIP_HEADER[i]));
+      }
+    } else {
+      // matches can reach back up to the buffer size
+      uint8_t cmf = uint8_t((IOT_CORE_DEFLATE_WINDOW_BITS + 1 - 8) << 4 | 8u);
+      putByte(cmf);
+      putByte(uint8_t(31u - (uint16_t(cmf) << 8) % 31u));
+    }
+    // single final block with static Huffman codes
+    putBits(1u | (1u << 1), 3u);
+  }
+
+  void putTrailer() {
+    putSymbol(256u);
+    alignToByte();
+    if (_encoding == ContentEncoding::Gzip) {
+      for (uint8_t shift = 0u; shift < 32u; shift += 8u) {
+        putByte(uint8_t(_checksum >> shift));
+      }
+      for (uint8_t shift = 0u; shift < 32u; shift += 8u) {
+        putByte(uint8_t(_bytesIn >> shift));
+      }
+    } else {
+      for (int8_t shift = 24; shift >= 0; shift -= 8) {
+        putByte(uint8_t(_checksum >> shift));
+      }
+    }
+  }
+
+  void account(uint32_t start) {
+    uint32_t elapsed = CycleClock::since(start);
+    _cpuTime += elapsed > _sinkTime ? elapsed - _sinkTime : 0u;
+    _sinkTime = 0u;
+  }
+
+public:
+  DeflateEncoder() {}
+  DeflateEncoder(const DeflateEncoder&) = delete;
+
+  /**
+   * Starts a new stream with deflate (i.e. zlib) or gzip framing.
+   */
+  void begin(ContentEncoding encoding, Output sink, void* context) {
+    _encoding = encoding == ContentEncoding::Gzip ? ContentEncoding::Gzip : ContentEncoding::Deflate;
+    _sink = sink;
+    _context = context;
+    _size = 0u;
+    _position = 0u;
+    _bits = 0u;
+    _bitCount = 0u;
+    _outputSize = 0u;
+    _checksum = _encoding == ContentEncoding::Gzip ? 0u : 1u;
+    _bytesIn = 0u;
+    _bytesOut = 0u;
+    _cpuTime = 0u;
+    _sinkTime = 0u;
+    memset(_head, 0, sizeof(_head));
+    _active = true;
+
+    uint32_t start = CycleClock::now();
+    putHeader();
+    account(start);
+  }
+
+  bool active() const { return _active; }
+
+  size_t write(const toolbox::strref& content) {
+    if (!_active) {
+      return 0u;
+    }
+    uint32_t start = CycleClock::now();
+    toolbox::strref remaining = content;
+    while (!remaining.empty()) {
+      if (_size == BUFFER_SIZE) {
+        slide();
+      }
+      size_t copied = remaining.copy(reinterpret_cast<char*>(_buffer + _size), BUFFER_SIZE - _size, false);
+      updateChecksum(_buffer + _size, copied);
+      _size += copied;
+      _bytesIn += copied;
+      remaining = remaining.skip(copied);
+      encode(false);
+    }
+    account(start);
+    return content.length();
+  }
+
+  size_t write(char c) {
+    return write(toolbox::strref(&c, 1u));
+  }
+
+  /**
+   * Encodes the remaining input and writes the trailer.
+   */
+  void end() {
+    if (!_active) {
+      return;
+    }
+    uint32_t start = CycleClock::now();
+    encode(true);
+    putTrailer();
+    flushOutput();
+    account(start);
+    _active = false;
+  }
+
+  uint32_t bytesIn() const { return _bytesIn; }
+  uint32_t bytesOut() const { return _bytesOut; }
+
+  /**
+   * CPU time spent for encoding in ns, excluding the time of the output.
+   */
+  uint32_t cpuTime() const { return _cpuTime; }
+};
+
+/**
+ * Statistics of compressed responses.
+ */
+class CompressionStatistics final {
+  HistogramCounters<LogBuckets<20u, 1u>, uint32_t> _cpuTime {};
+  uint32_t _bytesIn = 0u;
+  uint32_t _bytesOut = 0u;
+  uint8_t _lastRatio = 0u;
+
+public:
+  void record(uint32_t bytesIn, uint32_t bytesOut, uint32_t cpuTimeNs) {
+    _cpuTime.record(cpuTimeNs / 1000u);
+    _bytesIn += bytesIn;
+    _bytesOut += bytesOut;
+    _lastRatio = bytesIn == 0u ? 100u : uint8_t(std::min<uint32_t>(uint64_t(bytesOut) * 100u / bytesIn, 255u));
+  }
+
+  uint32_t responses() const { return _cpuTime.count(); }
+  uint32_t bytesIn() const { return _bytesIn; }
+  uint32_t bytesOut() const { return _bytesOut; }
+
+  /**
+   * CPU time for encoding the responses in µs.
+   */
+  const HistogramCounters<LogBuckets<20u, 1u>, uint32_t>& cpuTime() const { return _cpuTime; }
+
+  /**
+   * Compressed size of the last response in percent of the uncompressed size.
+   */
+  uint8_t lastRatio() const { return _lastRatio; }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const {
+    collector.addNumber(F("bytesIn"), _bytesIn);
+    collector.addNumber(F("bytesOut"), _bytesOut);
+    collector.addNumber(F("lastRatio"), _lastRatio);
+    collector.beginSection(F("cpuTime"));
+    _cpuTime.getDiagnostics(collector);
+    collector.endSection();
+  }
+};
+
+}
+
+#endif
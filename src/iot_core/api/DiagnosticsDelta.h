@@ -0,0 +1,363 @@
+#ifndef IOT_CORE_API_DIAGNOSTICSDELTA_H_
+#define IOT_CORE_API_DIAGNOSTICSDELTA_H_
+
+#include <iot_core/Interfaces.h>
+#include <jsons/Writer.h>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace iot_core::api {
+
+/**
+ * Continues an FNV-1a hash with the characters of the string.
+ */
+inline uint32_t continueHash(uint32_t hash, const toolbox::strref& string) {
+  const char* chars = string.cstr();
+  for (size_t i = 0u; i < string.length(); ++i) {
+    hash ^= uint8_t(pgm_read_byte(chars + i));
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static constexpr uint32_t HASH_SEED = 2166136261u;
+
+/**
+ * Snapshot of diagnostic values, which only keeps a hash of the path and of
+ * the value of each entry (8 bytes per value).
+ */
+class DiagnosticsSnapshot final {
+  struct Entry final {
+    uint32_t key;
+    uint32_t value;
+  };
+
+  std::vector<Entry> _entries {};
+  size_t _position = 0u;
+
+public:
+  /**
+   * Starts a comparison, values are expected in the same order as before.
+   */
+  void rewind() {
+    _position = 0u;
+  }
+
+  /**
+   * Updates the value of the key, returns true if it changed (or is new).
+   */
+  bool update(uint32_t key, uint32_t value) {
+    size_t index = _position;
+    if (index >= _entries.size() || _entries[index].key != key) {
+      // the values changed their structure, so look for the key
+      index = 0u;
+      while (index < _entries.size() && _entries[index].key != key) {
+        ++index;
+      }
+      if (index == _entries.size()) {
+        index = std::min(_position, _entries.size());
+        _entries.insert(_entries.begin() + index, Entry{key, ~value});
+      }
+    }
+    _position = index + 1u;
+    bool changed = _entries[index].value != value;
+    _entries[index].value = value;
+    return changed;
+  }
+
+  /**
+   * Releases the capacity left over from building the snapshot, the number
+   * of values rarely changes after the first collection.
+   */
+  void shrink() {
+    _entries.shrink_to_fit();
+  }
+
+  size_t size() const { return _entries.size(); }
+};
+
+/**
+ * Collector writing diagnostics as JSON object, which only includes values
+ * changed since the last collection into the snapshot (all values on the first
+ * collection) and within one of the filtered paths. Sections are only written
+ * if they contain any such value. Values outside of the filter are not kept
+ * in the snapshot.
+ *
+ * Paths are the section and value names separated by "/", the filter is a
+ * list of path prefixes separated by "," (all values if empty).
+ *
+ * With a limit, the values are collected in multiple passes over the
+ * provider, each writing up to the limit and continuing where the previous
+ * one stopped. If the values changed their structure in between, the
+ * collection ends early (the values not written stay changed for the next).
+ */
+class DiagnosticsDeltaCollector final : public iot_core::IDiagnosticsCollector {
+public:
+  static constexpr size_t MAX_PATH_LENGTH = 128u;
+  static constexpr size_t MAX_DEPTH = 8u;
+
+private:
+  jsons::IWriter& _writer;
+  DiagnosticsSnapshot& _snapshot;
+  toolbox::strref _filter;
+  bool _full;
+  char _path[MAX_PATH_LENGTH + 1u] = {};
+  size_t _sectionStarts[MAX_DEPTH] = {};
+  size_t _sectionEnds[MAX_DEPTH] = {};
+  uint32_t _hashes[MAX_DEPTH + 1u] = {HASH_SEED};
+  size_t _depth = 0u;
+  size_t _ignoredDepth = 0u;
+  size_t _writtenDepth = 0u;
+  size_t _changes = 0u;
+  size_t _limit = SIZE_MAX;
+  size_t _passChanges = 0u;
+  size_t _values = 0u;
+  size_t _resume = 0u;
+  uint32_t _resumeKey = 0u;
+  bool _stopped = false;
+
+  size_t pathLength() const {
+    return _depth == 0u ? 0u : _sectionEnds[_depth - 1u];
+  }
+
+  /**
+   * Appends a segment to the path, returns the new length or SIZE_MAX if it
+   * does not fit.
+   */
+  size_t append(size_t length, const toolbox::strref& name) {
+    size_t separator = length == 0u ? 0u : 1u;
+    if (length + separator + name.length() > MAX_PATH_LENGTH) {
+      return SIZE_MAX;
+    }
+    if (separator > 0u) {
+      _path[length] = '/';
+    }
+    name.copy(_path + length + separator, name.length(), false);
+    return length + separator + name.length();
+  }
+
+  /**
+   * Returns true if the current pass reached values not written before.
+   */
+  bool collecting() const {
+    return !_stopped && _values > _resume;
+  }
+
+  bool included(size_t length) const {
+    if (_filter.empty()) {
+      return true;
+    }
+    const char* filter = _filter.cstr();
+    size_t start = 0u;
+    while (start <= _filter.length()) {
+      const char* separator = static_cast<const char*>(memchr(filter + start, ',', _filter.length() - start));
+      size_t end = separator == nullptr ? _filter.length() : size_t(separator - filter);
+      size_t prefix = end - start;
+      if (prefix <= length && strncmp(filter + start, _path, prefix) == 0 && (prefix == length || _path[prefix] == '/' || prefix == 0u)) {
+        return true;
+      }
+      start = end + 1u;
+    }
+    return false;
+  }
+
+public:
+  DiagnosticsDeltaCollector(jsons::IWriter& writer, DiagnosticsSnapshot& snapshot, const toolbox::strref& filter, bool full) : _writer(writer), _snapshot(snapshot), _filter(filter), _full(full) {
+    _snapshot.rewind();
+    _writer.openObject();
+  }
+
+  void beginSection(const toolbox::strref& name) override {
+    size_t end = _ignoredDepth == 0u && _depth < MAX_DEPTH ? append(pathLength(), name) : SIZE_MAX;
+    if (end == SIZE_MAX) {
+      _ignoredDepth += 1u; // values too deeply nested are not included
+      return;
+    }
+    _sectionStarts[_depth] = end - name.length();
+    _sectionEnds[_depth] = end;
+    _hashes[_depth + 1u] = continueHash(continueHash(_hashes[_depth], F("/")), name);
+    _depth += 1u;
+  }
+
+  void addValue(const toolbox::strref& name, const toolbox::strref& value) override {
+    if (_ignoredDepth > 0u) {
+      return;
+    }
+    size_t ordinal = _values++;
+    if (_stopped || ordinal < _resume) {
+      return; // written by a previous pass, or after the limit of this one
+    }
+    uint32_t key = continueHash(continueHash(_hashes[_depth], F("/")), name);
+    if (ordinal == _resume && _resume > 0u && key != _resumeKey) {
+      _resume = SIZE_MAX; // the structure changed, so the open sections do not match anymore
+      return;
+    }
+    if (_passChanges == _limit) {
+      _stopped = true;
+      _resume = ordinal;
+      _resumeKey = key;
+      return;
+    }
+    size_t length = append(pathLength(), name);
+    if (length == SIZE_MAX) {
+      return;
+    }
+    if (!included(length)) {
+      return;
+    }
+    if (!_snapshot.update(key, continueHash(HASH_SEED, value)) && !_full) {
+      return;
+    }
+    for (; _writtenDepth < _depth; ++_writtenDepth) {
+      _writer.property(toolbox::strref(_path + _sectionStarts[_writtenDepth], _sectionEnds[_writtenDepth] - _sectionStarts[_writtenDepth]));
+      _writer.openObject();
+    }
+    _writer.property(name).string(value);
+    _changes += 1u;
+    _passChanges += 1u;
+  }
+
+  void endSection() override {
+    if (_ignoredDepth > 0u) {
+      _ignoredDepth -= 1u;
+      return;
+    }
+    if (_writtenDepth == _depth && collecting()) {
+      _writer.close();
+      _writtenDepth -= 1u;
+    }
+    _depth -= 1u;
+  }
+
+  /**
+   * Limits the number of values written per pass.
+   */
+  void limit(size_t values) {
+    _limit = std::max(values, size_t(1u));
+  }
+
+  /**
+   * Starts the next pass, after the previous one stopped.
+   */
+  void resume() {
+    _values = 0u;
+    _passChanges = 0u;
+    _stopped = false;
+  }
+
+  /**
+   * Returns true if the last pass stopped at the limit, i.e. values are left.
+   */
+  bool stopped() const { return _stopped; }
+
+  void end() {
+    for (; _writtenDepth > 0u; --_writtenDepth) {
+      _writer.close();
+    }
+    _writer.close();
+  }
+
+  /**
+   * Number of values written.
+   */
+  size_t changes() const { return _changes; }
+};
+
+/**
+ * Generates server-sent events with the diagnostics of the application: a
+ * "snapshot" event with all values first, then every interval a "delta"
+ * event with the changed values only.
+ *
+ * An event is written in steps of STEP_VALUES values (a few hundred bytes),
+ * one per call, so a snapshot is spread over multiple loops.
+ */
+class DiagnosticsEvents final {
+public:
+  static constexpr uint32_t MIN_INTERVAL = 500u; // collecting all diagnostics takes a while
+  static constexpr uint32_t DEFAULT_INTERVAL = 1000u;
+  static constexpr size_t STEP_VALUES = 16u;
+
+private:
+  /**
+   * Output of an event, forwarding to the body of the current step.
+   */
+  class EventOutput final : public toolbox::IOutput {
+    IResponseBody* _body;
+
+  public:
+    explicit EventOutput(IResponseBody& body) : _body(&body) {}
+
+    void body(IResponseBody& body) { _body = &body; }
+
+    size_t write(const toolbox::strref& content) override { return _body->write(content); }
+    size_t write(char c) override { return _body->write(c); }
+  };
+
+  using Writer = decltype(jsons::makeWriter(std::declval<toolbox::IOutput&>()));
+
+  /**
+   * Event in progress, which is kept between the steps.
+   */
+  struct Event final {
+    EventOutput output;
+    Writer writer;
+    DiagnosticsDeltaCollector collector;
+
+    Event(IResponseBody& body, DiagnosticsSnapshot& snapshot, const toolbox::strref& filter, bool full) : output(body), writer(jsons::makeWriter(output)), collector(writer, snapshot, filter, full) {
+      collector.limit(STEP_VALUES);
+    }
+  };
+
+  /**
+   * State shared by the copies of the generator.
+   */
+  struct State final {
+    DiagnosticsSnapshot snapshot {};
+    std::unique_ptr<Event> event {};
+    uint32_t lastEvent = 0u;
+    bool started = false;
+  };
+
+  const iot_core::IDiagnosticsProvider* _provider;
+  String _filter;
+  uint32_t _interval;
+  std::shared_ptr<State> _state {new State()};
+
+public:
+  DiagnosticsEvents(const iot_core::IDiagnosticsProvider& provider, const toolbox::strref& filter, uint32_t interval) : _provider(&provider), _filter(filter.toString()), _interval(std::max(interval, MIN_INTERVAL)) {}
+
+  bool operator()(IResponseBody& body) {
+    State& state = *_state;
+    if (!state.event) {
+      uint32_t now = millis();
+      if (state.started && now - state.lastEvent < _interval) {
+        return true; // nothing to send for now
+      }
+      body.write(state.started ? F("event: delta\ndata: ") : F("event: snapshot\ndata: "));
+      state.event.reset(new Event(body, state.snapshot, toolbox::strref(_filter), !state.started));
+      state.lastEvent = now;
+    }
+    Event& event = *state.event;
+    event.output.body(body);
+    event.collector.resume();
+    _provider->getDiagnostics(event.collector);
+    if (event.collector.stopped()) {
+      return !event.writer.failed(); // continued by the next call
+    }
+    event.collector.end();
+    event.writer.end();
+    body.write(F("\n\n"));
+    bool failed = event.writer.failed();
+    if (!state.started) {
+      state.snapshot.shrink();
+    }
+    state.started = true;
+    state.event.reset();
+    return !failed;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,305 @@
+#ifndef IOT_CORE_API_DISPATCHER_H_
+#define IOT_CORE_API_DISPATCHER_H_
+
+#include <iot_core/Interfaces.h>
+#include <iot_core/Histogram.h>
+#include <iot_core/Allocations.h>
+#include <toolbox.h>
+#include <ESP8266WiFi.h>
+#include <memory>
+#include <vector>
+#include "Batch.h"
+#include "ChunkedResponse.h"
+#include "GeneratedResponse.h"
+#include "Negotiation.h"
+#include "RateLimiter.h"
+#include "ResponseCache.h"
+#include "Router.h"
+#include "Interfaces.h"
+
+namespace iot_core::api {
+
+static const char HEADER_ACCEPT[] PROGMEM = "Accept";
+static const char HEADER_CONTENT_TYPE[] PROGMEM = "Content-Type";
+static const char HEADER_CONTENT_LENGTH[] PROGMEM = "Content-Length";
+static const char HEADER_ACCEPT_ENCODING[] PROGMEM = "Accept-Encoding";
+static const char HEADER_IF_NONE_MATCH[] PROGMEM = "If-None-Match";
+
+inline toolbox::strref methodsToString(uint8_t methods) {
+  switch (methods) {
+    case METHODS_ANY: return F("ANY");
+    case methodMask(HttpMethod::GET): return F("GET");
+    case methodMask(HttpMethod::HEAD): return F("HEAD");
+    case methodMask(HttpMethod::POST): return F("POST");
+    case methodMask(HttpMethod::PUT): return F("PUT");
+    case methodMask(HttpMethod::PATCH): return F("PATCH");
+    case methodMask(HttpMethod::DELETE): return F("DELETE");
+    case methodMask(HttpMethod::OPTIONS): return F("OPTIONS");
+    default: return F("MULTIPLE");
+  }
+}
+
+/**
+ * Request handling shared by the web server engines (Server and
+ * ConnectionServer): routes, response cache, request limits, compression
+ * and their statistics. The engines receive the requests and pass them to
+ * dispatch() as an exchange, which provides:
+ *
+ *   uint8_t method(); // mask of the request method
+ *   uint32_t remoteIP();
+ *   bool hasQuery();
+ *   const char* path();
+ *   Request& request();
+ *   void reject(int code, uint32_t retryAfter); // empty response with Retry-After
+ *   void respond(int code, const char* contentType, const char* content, size_t size);
+ *   Response& beginResponse(GeneratedResponses<WiFiClient>& generated, DeflateEncoder* encoder, ContentEncoding encoding);
+ *   void endResponse(); // after the response ended
+ */
+class Dispatcher final {
+public:
+  static constexpr size_t DEFAULT_CACHE_MEMORY = 8192u;
+
+private:
+  Logger _logger;
+  std::vector<IProvider*> _providers;
+  Router _router;
+  ResponseCache _cache;
+  bool _compression;
+  std::unique_ptr<DeflateEncoder> _encoder;
+  CompressionStatistics _compressionStatistics;
+  ChunkStatistics _chunkStatistics;
+  GeneratedResponses<WiFiClient> _generated;
+  RequestLimiter _limiter;
+  TimingHistogram<> _callTiming;
+  AllocationStatistics _callAllocations;
+
+  ContentEncoding negotiateEncoding(const toolbox::strref& acceptEncoding) {
+    if (!_compression) {
+      return ContentEncoding::Identity;
+    }
+    ContentEncoding encoding = negotiateContentEncoding(acceptEncoding);
+    if (encoding != ContentEncoding::Identity && !_encoder) {
+      _encoder.reset(new DeflateEncoder()); // only allocated once a client asks for compression
+    }
+    return encoding;
+  }
+
+public:
+  Dispatcher(ISystem& system, size_t cacheMemory) : _logger(system.logger(F("api"))), _providers(), _router(), _cache(cacheMemory), _compression(true), _encoder(), _compressionStatistics(), _chunkStatistics(), _generated(), _limiter(system.yieldTiming()), _callTiming(), _callAllocations() {}
+
+  bool match(uint8_t method, const char* path, RouteMatch& match) const {
+    return _router.match(method, path, match);
+  }
+
+  template<typename Exchange>
+  void dispatch(const RouteMatch& match, Exchange& exchange) {
+    AllocationScope allocationScope {_callAllocations};
+    _callTiming.start();
+    uint32_t startTime = MicrosClock::now();
+    uint32_t retryAfter;
+    RequestLimiter::Decision decision = _limiter.check(exchange.remoteIP(), exchange.method(), _router.exempt(match.route()), retryAfter);
+    if (decision != RequestLimiter::Decision::Accept) {
+      int code = mapResponseCode(decision == RequestLimiter::Decision::Shed ? ResponseCode::ServiceUnavailable : ResponseCode::BadRequestTooManyRequests);
+      exchange.reject(code, retryAfter);
+      _router.record(match, code, 0u, MicrosClock::since(startTime));
+      _callTiming.stop();
+      return;
+    }
+    CachedResponse* cached = exchange.method() == methodMask(HttpMethod::GET) && !exchange.hasQuery() ? _cache.find(match.route()) : nullptr;
+    auto& request = exchange.request();
+    toolbox::strref accept = request.header(FPSTR(HEADER_ACCEPT));
+    if (cached != nullptr && cached->fresh(exchange.path(), millis()) && acceptsContentType(accept, cached->contentType())) {
+      cached->hit();
+      exchange.respond(cached->code(), cached->contentType(), cached->content(), cached->size());
+      _router.record(match, cached->code(), cached->size(), MicrosClock::since(startTime));
+    } else {
+      ContentEncoding encoding = negotiateEncoding(request.header(FPSTR(HEADER_ACCEPT_ENCODING)));
+      auto& response = exchange.beginResponse(_generated, _encoder.get(), encoding);
+      if (cached != nullptr && !acceptsContentType(accept, F("*/*"))) {
+        cached = nullptr; // only representations for any client are cached
+      }
+      if (cached != nullptr) {
+        cached->begin(exchange.path());
+        response.capture(cached);
+      }
+      _router.call(match, request, response);
+      response.end();
+      if (cached != nullptr) {
+        cached->end(response.statusCode(), response.contentTypeValue(), millis());
+      }
+      _router.record(match, response.statusCode(), response.bytesSent(), MicrosClock::since(startTime));
+      if (response.chunked()) {
+        const auto& chunked = response.chunkedResponse();
+        _chunkStatistics.record(chunked.chunks(), chunked.segments(), chunked.writeThroughs());
+      }
+      if (response.encoded()) {
+        _compressionStatistics.record(_encoder->bytesIn(), _encoder->bytesOut(), _encoder->cpuTime());
+      }
+      exchange.endResponse();
+    }
+    _callTiming.stop();
+  }
+
+  void on(const toolbox::strref& path, HttpMethod method, std::function<void(IRequest&, IResponse&)> handler) {
+    if (!_router.on(path, methodMask(method), handler)) {
+      _logger.log(LogLevel::Error, toolbox::format(F("Invalid route '%s'."), path.cstr()));
+    }
+  }
+
+  void on(const StaticRoute* routes, size_t count, void* context) {
+    if (!_router.on(routes, count, context)) {
+      _logger.log(LogLevel::Error, F("Invalid route in static table."));
+    }
+  }
+
+  bool cache(const toolbox::strref& path, HttpMethod method, uint32_t ttl, size_t maxSize) {
+    size_t route = _router.routeIndex(path, methodMask(method));
+    if (route == SIZE_MAX || !_cache.enable(route, ttl, maxSize)) {
+      _logger.log(LogLevel::Warning, toolbox::format(F("Cannot cache route '%s'."), path.cstr()));
+      return false;
+    }
+    return true;
+  }
+
+  void invalidateCache() {
+    _cache.invalidate();
+  }
+
+  bool exempt(const toolbox::strref& path, HttpMethod method) {
+    size_t route = _router.routeIndex(path, methodMask(method));
+    if (route == SIZE_MAX) {
+      _logger.log(LogLevel::Warning, toolbox::format(F("Cannot exempt route '%s'."), path.cstr()));
+      return false;
+    }
+    _router.exempt(route, true);
+    return true;
+  }
+
+  /**
+   * Calls a route internally, with the same response cache, route statistics
+   * and allocation tracking as requests of clients.
+   */
+  bool call(const char* path, IResponse& response) {
+    RouteMatch match;
+    if (!_router.match(methodMask(HttpMethod::GET), path, match)) {
+      return false;
+    }
+    AllocationScope allocationScope {_callAllocations};
+    uint32_t startTime = MicrosClock::now();
+    CachedResponse* cached = _cache.find(match.route());
+    if (cached != nullptr && cached->fresh(path, millis())) {
+      cached->hit();
+      response
+        .code(static_cast<ResponseCode>(cached->code()))
+        .contentType(toolbox::strref(cached->contentType()))
+        .sendSingleBody()
+        .write(toolbox::strref(cached->content(), cached->size()));
+      _router.record(match, cached->code(), cached->size(), MicrosClock::since(startTime));
+      return true;
+    }
+    if (cached != nullptr) {
+      cached->begin(path);
+    }
+    InternalRequest request {match};
+    InternalResponse internal {response, cached};
+    _router.call(match, request, internal);
+    if (cached != nullptr) {
+      cached->end(internal.statusCode(), internal.contentTypeValue(), millis());
+    }
+    _router.record(match, internal.statusCode(), internal.bytesSent(), MicrosClock::since(startTime));
+    return true;
+  }
+
+  void addProvider(IProvider* provider) {
+    _providers.emplace_back(provider);
+  }
+
+  bool configure(const toolbox::strref& name, const toolbox::strref& value) {
+    if (name == F("compression")) {
+      if (value == F("true")) {
+        _compression = true;
+      } else if (value == F("false")) {
+        _compression = false;
+      } else {
+        return false;
+      }
+      return true;
+    }
+    return _limiter.configure(name, value);
+  }
+
+  void getConfig(iot_core::ConfigWriter writer) const {
+    writer(F("compression"), _compression ? F("true") : F("false"));
+    _limiter.getConfig(writer);
+  }
+
+  /**
+   * Adds the generic routes and those of the providers to the given server.
+   */
+  void setup(IServer& server) {
+    // generic OPTIONS reply to make "pre-flight" checks work
+    on(F("*"), HttpMethod::OPTIONS, [](IRequest&, IResponse& response) {
+      response.code(ResponseCode::OkNoContent).header(F("Access-Control-Allow-Methods"), F("GET, POST, PUT, DELETE, OPTIONS"));
+    });
+
+    for (auto provider : _providers) {
+      provider->setupApi(server);
+    }
+  }
+
+  /**
+   * Serves the clients via the given function, with the request limits
+   * updated before and the generated responses continued after.
+   */
+  template<typename Serve>
+  void loop(Serve serve) {
+    _limiter.loop();
+    serve();
+    _generated.loop();
+  }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const {
+    collector.beginSection(F("calls"));
+    _callTiming.getDiagnostics(collector);
+    if (AllocationTracker::enabled()) {
+      collector.beginSection(F("allocations"));
+      _callAllocations.getDiagnostics(collector);
+      collector.endSection();
+    }
+    collector.endSection();
+
+    collector.beginSection(F("chunked"));
+    _chunkStatistics.getDiagnostics(collector);
+    collector.endSection();
+
+    collector.beginSection(F("generated"));
+    _generated.getDiagnostics(collector);
+    collector.endSection();
+
+    collector.beginSection(F("compression"));
+    _compressionStatistics.getDiagnostics(collector);
+    collector.endSection();
+
+    collector.beginSection(F("limits"));
+    _limiter.getDiagnostics(collector);
+    collector.endSection();
+
+    collector.beginSection(F("routes"));
+    for (size_t route = 0u; route < _router.routeCount(); ++route) {
+      collector.beginSection(toolbox::format(F("%s %s"), methodsToString(_router.routeMethods(route)).cstr(), _router.routePath(route).cstr()));
+      _router.routeStatistics(route).getDiagnostics(collector);
+      const CachedResponse* cached = _cache.find(route);
+      if (cached != nullptr) {
+        collector.beginSection(F("cache"));
+        cached->getDiagnostics(collector);
+        collector.endSection();
+      }
+      collector.endSection();
+    }
+    collector.endSection();
+  }
+};
+
+}
+
+#endif
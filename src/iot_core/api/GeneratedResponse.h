@@ -0,0 +1,205 @@
+#ifndef IOT_CORE_API_GENERATEDRESPONSE_H_
+#define IOT_CORE_API_GENERATEDRESPONSE_H_
+
+#include <toolbox.h>
+#include <algorithm>
+#include <memory>
+#include "ChunkedResponse.h"
+#include "Interfaces.h"
+
+namespace iot_core::api {
+
+/**
+ * Output of a generated response, writing directly to the client. The body
+ * is delimited by closing the connection, so no chunk framing is needed.
+ */
+template<typename C>
+class ClientOutput final {
+  C _client {};
+
+public:
+  C& client() { return _client; }
+
+  bool chunkedResponseModeStart(int, const char*) { return true; }
+  bool chunkedResponseModeStart(int, const __FlashStringHelper*) { return true; }
+  void sendContent(const char* content, size_t size) { _client.write(reinterpret_cast<const uint8_t*>(content), size); }
+  void chunkedResponseFinalize() {}
+  void send(int, const char*, const char*, size_t) {}
+  void send_P(int, PGM_P, PGM_P, size_t) {}
+};
+
+/**
+ * Response of which the body is generated over multiple loops, detached from
+ * the web server. Each loop the generator is called until a chunk was sent,
+ * it has nothing to write for now or the body is complete.
+ *
+ * Nothing is generated while the client cannot take a full chunk, so
+ * writing does not block (as long as the generator writes less than a chunk
+ * at a time). A client which does not take anything for STALL_TIMEOUT is
+ * closed.
+ */
+template<typename C>
+class GeneratedResponse final : public IResponseBody {
+public:
+  static constexpr uint32_t STALL_TIMEOUT = 10000u;
+
+private:
+  ClientOutput<C> _output {};
+  ChunkedResponse<ClientOutput<C>> _response {_output};
+  ResponseGenerator _generator {};
+  size_t _written = 0u;
+  uint32_t _lastWritable = 0u;
+
+  void close() {
+    _response.end();
+    _output.client().stop();
+    _output.client() = C();
+    _generator = nullptr; // releases everything captured by the generator
+  }
+
+public:
+  bool active() const {
+    return bool(_generator);
+  }
+
+  /**
+   * Takes over the client and writes the response head, the headers have
+   * to include the final line break.
+   */
+  void begin(const C& client, int code, const toolbox::strref& contentType, const toolbox::strref& headers, ResponseGenerator generator) {
+    _output.client() = client;
+    _generator = std::move(generator);
+    _written = 0u;
+    _lastWritable = millis();
+    _response.begin(code, contentType);
+    _response.write(F("HTTP/1.1 "));
+    _response.write(toolbox::convert<uint32_t>::toString(code, 10));
+    _response.write(F(" \r\nContent-Type: ")); // the reason phrase is optional
+    _response.write(contentType);
+    _response.write(F("\r\nConnection: close\r\n"));
+    _response.write(headers);
+    _response.write(F("\r\n"));
+  }
+
+  /**
+   * Generates the next part of the body. Returns false once the response is
+   * complete (or the client is gone) and the connection was closed.
+   */
+  bool loop(bool& completed) {
+    completed = false;
+    if (!_output.client().connected()) {
+      close();
+      return false;
+    }
+    if (size_t(std::max(_output.client().availableForWrite(), 0)) < DEFAULT_CHUNK_SIZE) {
+      if (millis() - _lastWritable >= STALL_TIMEOUT) {
+        close();
+        return false;
+      }
+      return true; // the client cannot take a chunk yet
+    }
+    _lastWritable = millis();
+
+    uint32_t chunks = _response.chunks();
+    bool more = true;
+    size_t written;
+    do {
+      written = _written;
+      more = _generator(*this);
+    } while (more && _response.chunks() == chunks && _written != written);
+
+    if (!more) {
+      completed = true;
+      close();
+      return false;
+    }
+    if (_response.chunks() == chunks) {
+      _response.flush(); // the generator has nothing more for now
+    }
+    return true;
+  }
+
+  bool valid() const override {
+    return _response.valid();
+  }
+
+  size_t write(const toolbox::strref& content) override {
+    size_t written = _response.write(content);
+    _written += written;
+    return written;
+  }
+
+  size_t write(char c) override {
+    size_t written = _response.write(c);
+    _written += written;
+    return written;
+  }
+};
+
+/**
+ * Pool of generated responses. The responses (incl. their buffer) are only
+ * allocated once they are needed and are reused afterwards.
+ */
+template<typename C>
+class GeneratedResponses final {
+public:
+  static constexpr size_t MAX_RESPONSES = 2u;
+
+private:
+  std::unique_ptr<GeneratedResponse<C>> _responses[MAX_RESPONSES] {};
+  uint32_t _started = 0u;
+  uint32_t _completed = 0u;
+  uint32_t _aborted = 0u;
+  uint32_t _rejected = 0u;
+
+public:
+  /**
+   * Returns an inactive response to begin, or nullptr if all are active.
+   */
+  GeneratedResponse<C>* acquire() {
+    for (auto& response : _responses) {
+      if (!response) {
+        response.reset(new GeneratedResponse<C>());
+      }
+      if (!response->active()) {
+        _started += 1u;
+        return response.get();
+      }
+    }
+    _rejected += 1u;
+    return nullptr;
+  }
+
+  void loop() {
+    for (auto& response : _responses) {
+      bool completed;
+      if (response && response->active() && !response->loop(completed)) {
+        if (completed) {
+          _completed += 1u;
+        } else {
+          _aborted += 1u;
+        }
+      }
+    }
+  }
+
+  size_t active() const {
+    size_t count = 0u;
+    for (const auto& response : _responses) {
+      count += response && response->active() ? 1u : 0u;
+    }
+    return count;
+  }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const {
+    collector.addNumber(F("active"), active());
+    collector.addNumber(F("started"), _started);
+    collector.addNumber(F("completed"), _completed);
+    collector.addNumber(F("aborted"), _aborted);
+    collector.addNumber(F("rejected"), _rejected);
+  }
+};
+
+}
+
+#endif
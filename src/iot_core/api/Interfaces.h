@@ -1,7 +1,6 @@
 #ifndef IOT_CORE_API_INTERFACES_H_
 #define IOT_CORE_API_INTERFACES_H_
 
-#include <Uri.h> /* from ESP8266WebServer library */
 #include <functional>
 #include <toolbox.h>
 #include <toolbox/Streams.h>
@@ -19,7 +18,8 @@ enum struct ContentType {
   TextHtml,
   ApplicationOctetStream,
   ApplicationJson,
-  ApplicationXml
+  ApplicationXml,
+  ApplicationCbor
 };
 
 enum struct ResponseCode : int {
@@ -46,6 +46,7 @@ enum struct ResponseCode : int {
   BadRequestGone = 410,
   BadRequestLengthRequired = 411,
   BadRequestPreconditionFailed = 412,
+  BadRequestPayloadTooLarge = 413,
   BadRequestTooManyRequests = 429,
   InternalServerError = 500,
   NotImplemented = 501,
@@ -56,6 +57,23 @@ enum struct ResponseCode : int {
   InsufficientStorage = 507
 };
 
+int mapResponseCode(ResponseCode code) {
+  return static_cast<int>(code);
+}
+
+toolbox::strref mapContentType(ContentType contentType) {
+  switch (contentType) {
+    default:
+    case ContentType::TextPlain: return F("text/plain");
+    case ContentType::TextCsv: return F("text/csv");
+    case ContentType::TextHtml: return F("text/html");
+    case ContentType::ApplicationOctetStream: return F("application/octet-stream");
+    case ContentType::ApplicationJson: return F("application/json");
+    case ContentType::ApplicationXml: return F("application/xml");
+    case ContentType::ApplicationCbor: return F("application/cbor");
+  }
+}
+
 class IRequestBody : public toolbox::IInput {
 public:
   virtual const toolbox::strref& contentType() const = 0;
@@ -67,6 +85,11 @@ public:
   virtual bool hasArg(const toolbox::strref& name) const = 0;
   virtual toolbox::strref arg(const toolbox::strref& name) const = 0;
   virtual toolbox::strref pathArg(unsigned int i) const = 0;
+  /**
+   * Returns the value of a request header, only headers collected by the
+   * server are available (e.g. Accept, Accept-Encoding and If-None-Match).
+   */
+  virtual toolbox::strref header(const toolbox::strref& name) const = 0;
   virtual IRequestBody& body() = 0;
 };
 
@@ -76,6 +99,13 @@ public:
   operator bool() const { return valid(); }
 };
 
+/**
+ * Generates a response body step by step, each call writing the next (small)
+ * part of the body. Calls are spread over multiple loops until it returns
+ * false at the end of the body.
+ */
+using ResponseGenerator = std::function<bool(IResponseBody& body)>;
+
 class IResponse {
 public:
   virtual IResponse& code(ResponseCode code) = 0;
@@ -84,11 +114,74 @@ public:
   virtual IResponse& header(const toolbox::strref& name, const toolbox::strref& value) = 0;
   virtual IResponseBody& sendChunkedBody() = 0;
   virtual IResponseBody& sendSingleBody() = 0;
+  /**
+   * Sends content stored in PROGMEM as body, which is streamed directly from
+   * flash without copying it into RAM.
+   */
+  virtual void sendProgmemBody(const uint8_t* content, size_t size) = 0;
+  /**
+   * Sends the body produced by the generator over the following loops, so
+   * large bodies do not block the loop. The connection is closed at the end
+   * of the body. Returns false if too many bodies are being generated
+   * already, the response is then answered with 503.
+   */
+  virtual bool sendGeneratedBody(ResponseGenerator generator) = 0;
 };
 
+static constexpr uint8_t METHODS_ANY = 0xFFu;
+
+constexpr uint8_t methodMask(HttpMethod method) {
+  return method == HttpMethod::ANY ? METHODS_ANY : uint8_t(1u << (static_cast<uint8_t>(method) - 1u));
+}
+
+/**
+ * Function handling a request, with the context given when it was added.
+ */
+using RouteFunction = void (*)(void* context, IRequest& request, IResponse& response);
+
+/**
+ * Entry of a static route table, which can be stored in PROGMEM (including
+ * the path). The methods are a combination of methodMask() values.
+ */
+struct StaticRoute final {
+  PGM_P path;
+  uint8_t methods;
+  RouteFunction function;
+};
+
+/**
+ * Paths are separated into segments by "/", where a segment "{}" captures
+ * the value available via IRequest::pathArg() and a last segment "*" matches
+ * any remaining path.
+ */
 class IServer {
 public:
-  virtual void on(const Uri& uri, HttpMethod method, std::function<void(IRequest&, IResponse&)> handler) = 0;
+  virtual void on(const toolbox::strref& path, HttpMethod method, std::function<void(IRequest&, IResponse&)> handler) = 0;
+  virtual void on(const StaticRoute* routes, size_t count, void* context) = 0;
+
+  /**
+   * Enables caching of successful responses of the route for ttl ms. Only
+   * bodies up to maxSize bytes are cached, headers are not cached.
+   */
+  virtual bool cache(const toolbox::strref& path, HttpMethod method, uint32_t ttl, size_t maxSize) = 0;
+
+  /**
+   * Invalidates all cached responses, e.g. after a change of state.
+   */
+  virtual void invalidateCache() = 0;
+
+  /**
+   * Exempts the route from load shedding, so it stays available under load
+   * (e.g. to change the configuration). Rate limits still apply.
+   */
+  virtual bool exempt(const toolbox::strref& path, HttpMethod method) = 0;
+
+  /**
+   * Calls the GET route of the path internally (e.g. as part of a batch),
+   * with a request without args, headers or body. Returns false if no route
+   * matches the path.
+   */
+  virtual bool call(const char* path, IResponse& response) = 0;
 };
 
 class IProvider {
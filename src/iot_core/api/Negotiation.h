@@ -0,0 +1,115 @@
+#ifndef IOT_CORE_API_NEGOTIATION_H_
+#define IOT_CORE_API_NEGOTIATION_H_
+
+#include <toolbox.h>
+#include <algorithm>
+#include <cctype>
+#include <initializer_list>
+#include "Interfaces.h"
+
+namespace iot_core::api {
+
+namespace detail {
+
+inline toolbox::strref trimSpaces(toolbox::strref value) {
+  while (!value.empty() && value.cstr()[0] == ' ') {
+    value = value.skip(1u);
+  }
+  while (!value.empty() && value.cstr()[value.length() - 1u] == ' ') {
+    value = value.substring(0u, value.length() - 1u);
+  }
+  return value;
+}
+
+/**
+ * Parses the "q" parameter of a media range into thousandths, 1000 if it has
+ * none. Digits are read up to the first other character.
+ */
+inline uint16_t parseQuality(toolbox::strref parameters) {
+  while (!parameters.empty()) {
+    int end = parameters.indexOf(';');
+    toolbox::strref parameter = trimSpaces(end < 0 ? parameters : parameters.substring(0u, end));
+    parameters = end < 0 ? toolbox::strref() : parameters.skip(end + 1);
+    if (parameter.length() < 3u || parameter.substring(0u, 2u) != F("q=")) {
+      continue;
+    }
+    const char* value = parameter.cstr() + 2u;
+    size_t length = parameter.length() - 2u;
+    if (value[0] != '0') {
+      return 1000u;
+    }
+    uint16_t quality = 0u;
+    uint16_t factor = 100u;
+    for (size_t i = 2u; i < length && i < 5u && value[1] == '.' && isdigit(value[i]); ++i, factor /= 10u) {
+      quality += uint16_t(value[i] - '0') * factor;
+    }
+    return std::min(quality, uint16_t(1000u));
+  }
+  return 1000u;
+}
+
+/**
+ * Returns the quality of the content type in the Accept header, given by the
+ * most specific media range matching it (0 if none matches).
+ */
+inline uint16_t acceptQuality(toolbox::strref accept, const toolbox::strref& contentType) {
+  uint16_t quality = 0u;
+  uint8_t specificity = 0u;
+  while (!accept.empty()) {
+    int end = accept.indexOf(',');
+    toolbox::strref entry = end < 0 ? accept : accept.substring(0u, end);
+    accept = end < 0 ? toolbox::strref() : accept.skip(end + 1);
+
+    int parameters = entry.indexOf(';');
+    toolbox::strref range = trimSpaces(parameters < 0 ? entry : entry.substring(0u, parameters));
+    uint8_t rangeSpecificity = 0u;
+    if (range == contentType) {
+      rangeSpecificity = 3u;
+    } else if (range == F("*/*")) {
+      rangeSpecificity = 1u;
+    } else if (range.length() >= 2u && range.length() <= contentType.length() && range.skip(range.length() - 2u) == F("/*") && contentType.substring(0u, range.length() - 1u) == range.substring(0u, range.length() - 1u)) {
+      rangeSpecificity = 2u;
+    }
+    if (rangeSpecificity > specificity) {
+      specificity = rangeSpecificity;
+      quality = parameters < 0 ? 1000u : parseQuality(entry.skip(parameters + 1));
+    }
+  }
+  return quality;
+}
+
+}
+
+/**
+ * Selects the content type with the highest quality in the Accept header of
+ * the supported ones, which are given in the order of preference (the first
+ * is selected if there is no Accept header). Returns ContentType::Unknown if
+ * none is acceptable.
+ */
+inline ContentType negotiateContentType(const toolbox::strref& accept, std::initializer_list<ContentType> supported) {
+  if (detail::trimSpaces(accept).empty()) {
+    return supported.size() > 0u ? *supported.begin() : ContentType::Unknown;
+  }
+  ContentType selected = ContentType::Unknown;
+  uint16_t selectedQuality = 0u;
+  for (ContentType contentType : supported) {
+    uint16_t quality = detail::acceptQuality(accept, mapContentType(contentType));
+    if (quality > selectedQuality) {
+      selected = contentType;
+      selectedQuality = quality;
+    }
+  }
+  return selected;
+}
+
+/**
+ * Returns true if the content type is acceptable according to the Accept
+ * header (or there is none).
+ */
+inline bool acceptsContentType(const toolbox::strref& accept, const toolbox::strref& contentType) {
+  return detail::trimSpaces(accept).empty() || detail::acceptQuality(accept, contentType) > 0u;
+}
+
+}
+
+#endif
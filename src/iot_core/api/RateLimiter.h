@@ -0,0 +1,248 @@
+#ifndef IOT_CORE_API_RATELIMITER_H_
+#define IOT_CORE_API_RATELIMITER_H_
+
+#include <iot_core/Interfaces.h>
+#include <iot_core/Histogram.h>
+#include <iot_core/Clock.h>
+#include <toolbox.h>
+#include "Interfaces.h"
+
+namespace iot_core::api {
+
+/**
+ * Class of routes sharing a rate limit, derived from the request method.
+ */
+enum struct RouteClass : uint8_t {
+  Read, // GET, HEAD and OPTIONS
+  Write, // all other methods
+};
+
+static constexpr size_t ROUTE_CLASSES = 2u;
+
+constexpr RouteClass routeClassOf(uint8_t method) {
+  return (method & (methodMask(HttpMethod::GET) | methodMask(HttpMethod::HEAD) | methodMask(HttpMethod::OPTIONS))) != 0u ? RouteClass::Read : RouteClass::Write;
+}
+
+/**
+ * Token bucket which is refilled with rate tokens per second up to burst
+ * tokens. Tokens are counted in thousandths, so rates below one token per
+ * millisecond do not get lost.
+ */
+class TokenBucket final {
+  uint32_t _milliTokens = 0u;
+  uint32_t _updatedAt = 0u;
+
+public:
+  void fill(uint32_t burst, uint32_t now) {
+    _milliTokens = burst * 1000u;
+    _updatedAt = now;
+  }
+
+  /**
+   * Takes a token if available and returns 0, otherwise returns the time
+   * (in ms) until the next token is available.
+   */
+  uint32_t take(uint32_t rate, uint32_t burst, uint32_t now) {
+    uint32_t capacity = burst * 1000u;
+    uint64_t refilled = uint64_t(now - _updatedAt) * rate; // rate tokens/s are rate milli-tokens/ms
+    _milliTokens = uint32_t(std::min<uint64_t>(capacity, _milliTokens + refilled));
+    _updatedAt = now;
+    if (_milliTokens >= 1000u) {
+      _milliTokens -= 1000u;
+      return 0u;
+    }
+    return (1000u - _milliTokens + rate - 1u) / rate;
+  }
+};
+
+/**
+ * Rate limits per client IP and route class. Only the most recently seen
+ * clients are tracked, others start again with full buckets.
+ */
+class RateLimiter final {
+public:
+  static constexpr size_t MAX_CLIENTS = 8u;
+
+  struct Limit final {
+    uint32_t rate; // tokens per second, 0 disables the limit
+    uint32_t burst; // 0 is treated as 1
+  };
+
+private:
+  struct Client final {
+    uint32_t address;
+    uint32_t lastSeen;
+    TokenBucket buckets[ROUTE_CLASSES];
+  };
+
+  Client _clients[MAX_CLIENTS] = {};
+  size_t _clientCount = 0u;
+
+  Client& client(uint32_t address, uint32_t now) {
+    Client* leastRecent = &_clients[0];
+    for (size_t i = 0u; i < _clientCount; ++i) {
+      if (_clients[i].address == address) {
+        return _clients[i];
+      }
+      if (now - _clients[i].lastSeen > now - leastRecent->lastSeen) {
+        leastRecent = &_clients[i];
+      }
+    }
+    Client& client = _clientCount < MAX_CLIENTS ? _clients[_clientCount++] : *leastRecent;
+    client.address = address;
+    client.lastSeen = now;
+    for (auto& bucket : client.buckets) {
+      bucket.fill(UINT32_MAX / 1000u, now); // clamped to the burst on first use
+    }
+    return client;
+  }
+
+public:
+  /**
+   * Takes a token of the route class for the client, returns 0 if the
+   * request is allowed or the time (in ms) until it would be.
+   */
+  uint32_t take(uint32_t address, RouteClass routeClass, const Limit& limit, uint32_t now) {
+    if (limit.rate == 0u) {
+      return 0u;
+    }
+    Client& client = this->client(address, now);
+    client.lastSeen = now;
+    return client.buckets[static_cast<size_t>(routeClass)].take(limit.rate, std::max(limit.burst, 1u), now);
+  }
+
+  size_t clients() const { return _clientCount; }
+};
+
+/**
+ * Switches into shed mode, when the 90th percentile of the loop latency
+ * exceeds the threshold. The latency is taken from the current window of the
+ * system's yield timing (whose counters are halved instead of saturated on
+ * busy systems), the mode is re-evaluated every EVALUATION_LOOPS.
+ */
+class LoadShedder final {
+public:
+  static constexpr uint32_t EVALUATION_LOOPS = 64u;
+
+private:
+  uint32_t _loops = 0u;
+  bool _shedding = false;
+
+public:
+  void loop(const Histogram<>& latency, uint32_t threshold) {
+    _loops += 1u;
+    if (_loops == EVALUATION_LOOPS) {
+      _shedding = threshold > 0u && latency.window().percentile(90.0f) > threshold;
+      _loops = 0u;
+    }
+  }
+
+  bool shedding() const { return _shedding; }
+};
+
+/**
+ * Limits the requests a server handles, by a rate limit per client and a
+ * global shed mode when the loop latency gets too high. Both are disabled
+ * by default and configured on the server component. Routes exempted from
+ * shedding are only rate limited.
+ */
+class RequestLimiter final {
+public:
+  static constexpr uint32_t SHED_RETRY_AFTER = 1u;
+
+  enum struct Decision {
+    Accept,
+    RateLimited, // answer with 429
+    Shed, // answer with 503
+  };
+
+private:
+  const Histogram<>& _latency;
+  RateLimiter _rateLimiter {};
+  LoadShedder _shedder {};
+  RateLimiter::Limit _limits[ROUTE_CLASSES] = {};
+  uint32_t _shedLatency = 0u;
+  uint32_t _rateLimited = 0u;
+  uint32_t _shed = 0u;
+
+public:
+  explicit RequestLimiter(const Histogram<>& latency) : _latency(latency) {}
+
+  /**
+   * Has to be called on every loop, to evaluate the loop latency.
+   */
+  void loop() {
+    _shedder.loop(_latency, _shedLatency);
+  }
+
+  /**
+   * Decides whether to handle a request of the client, retryAfter is set
+   * (in seconds) if it is rejected.
+   */
+  Decision check(uint32_t address, uint8_t method, bool exempt, uint32_t& retryAfter) {
+    if (_shedLatency > 0u && _shedder.shedding() && !exempt) {
+      _shed += 1u;
+      retryAfter = SHED_RETRY_AFTER;
+      return Decision::Shed;
+    }
+    RouteClass routeClass = routeClassOf(method);
+    uint32_t wait = _rateLimiter.take(address, routeClass, _limits[static_cast<size_t>(routeClass)], millis());
+    if (wait > 0u) {
+      _rateLimited += 1u;
+      retryAfter = (wait + 999u) / 1000u;
+      return Decision::RateLimited;
+    }
+    return Decision::Accept;
+  }
+
+  /**
+   * Rates are requests per second per client, bursts the number of requests
+   * allowed at once. The shed latency is in microseconds, 0 disables it.
+   */
+  bool configure(const toolbox::strref& name, const toolbox::strref& value) {
+    RateLimiter::Limit& read = _limits[static_cast<size_t>(RouteClass::Read)];
+    RateLimiter::Limit& write = _limits[static_cast<size_t>(RouteClass::Write)];
+    if (name == F("readRate")) {
+      read.rate = strtoul(value.toString().c_str(), nullptr, 10);
+      return true;
+    }
+    if (name == F("readBurst")) {
+      read.burst = strtoul(value.toString().c_str(), nullptr, 10);
+      return true;
+    }
+    if (name == F("writeRate")) {
+      write.rate = strtoul(value.toString().c_str(), nullptr, 10);
+      return true;
+    }
+    if (name == F("writeBurst")) {
+      write.burst = strtoul(value.toString().c_str(), nullptr, 10);
+      return true;
+    }
+    if (name == F("shedLatency")) {
+      _shedLatency = strtoul(value.toString().c_str(), nullptr, 10);
+      return true;
+    }
+    return false;
+  }
+
+  void getConfig(ConfigWriter writer) const {
+    const RateLimiter::Limit& read = _limits[static_cast<size_t>(RouteClass::Read)];
+    const RateLimiter::Limit& write = _limits[static_cast<size_t>(RouteClass::Write)];
+    writer(F("readRate"), toolbox::convert<uint32_t>::toString(read.rate, 10));
+    writer(F("readBurst"), toolbox::convert<uint32_t>::toString(read.burst, 10));
+    writer(F("writeRate"), toolbox::convert<uint32_t>::toString(write.rate, 10));
+    writer(F("writeBurst"), toolbox::convert<uint32_t>::toString(write.burst, 10));
+    writer(F("shedLatency"), toolbox::convert<uint32_t>::toString(_shedLatency, 10));
+  }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const {
+    collector.addNumber(F("rateLimited"), _rateLimited);
+    collector.addNumber(F("shed"), _shed);
+    collector.addValue(F("shedding"), _shedder.shedding() ? F("true") : F("false"));
+    collector.addNumber(F("clients"), _rateLimiter.clients());
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef IOT_CORE_API_RESPONSECACHE_H_
+#define IOT_CORE_API_RESPONSECACHE_H_
+
+#include <Arduino.h>
+#include <toolbox.h>
+#include <memory>
+#include <new>
+#include <vector>
+#include "Router.h"
+#include "Interfaces.h"
+
+namespace iot_core::api {
+
+/**
+ * Cached response of a single route, i.e. the status code, content type and
+ * body of the last successful (2xx) response for a request path.
+ *
+ * The body is captured while the response is written into a buffer of fixed
+ * size, which is allocated once with the first captured response. Responses
+ * with larger bodies are not cached (but counted as skipped).
+ */
+class CachedResponse final {
+public:
+  static constexpr size_t MAX_CONTENT_TYPE_LENGTH = 47u;
+
+private:
+  size_t _route;
+  uint32_t _ttl;
+  size_t _capacity;
+  std::unique_ptr<char[]> _buffer;
+  size_t _size = 0u;
+  int _code = 0;
+  char _contentType[MAX_CONTENT_TYPE_LENGTH + 1u] = {};
+  char _path[RouteMatch::MAX_PATH_LENGTH + 1u] = {};
+  uint32_t _storedAt = 0u;
+  bool _valid = false;
+  bool _capturing = false;
+  bool _overflow = false;
+  uint32_t _hits = 0u;
+  uint32_t _misses = 0u;
+  uint32_t _skipped = 0u;
+
+public:
+  CachedResponse(size_t route, uint32_t ttl, size_t capacity) : _route(route), _ttl(ttl), _capacity(capacity), _buffer() {}
+
+  size_t route() const { return _route; }
+  uint32_t ttl() const { return _ttl; }
+  size_t capacity() const { return _capacity; }
+
+  /**
+   * Returns true if a response for the path is cached and not yet expired.
+   */
+  bool fresh(const char* path, uint32_t now) const {
+    return _valid && now - _storedAt < _ttl && strcmp(path, _path) == 0;
+  }
+
+  void hit() { _hits += 1u; }
+
+  /**
+   * Starts capturing the response for the path (counted as cache miss).
+   */
+  void begin(const char* path) {
+    _misses += 1u;
+    _valid = false;
+    _size = 0u;
+    if (!_buffer) {
+      _buffer.reset(new (std::nothrow) char[_capacity]);
+    }
+    _overflow = !_buffer || strlen(path) > RouteMatch::MAX_PATH_LENGTH;
+    _capturing = true;
+    if (!_overflow) {
+      strcpy(_path, path);
+    }
+  }
+
+  void append(const toolbox::strref& content) {
+    if (!_capturing || _overflow) {
+      return;
+    }
+    if (content.length() > _capacity - _size) {
+      _overflow = true;
+      return;
+    }
+    memcpy_P(_buffer.get() + _size, content.cstr(), content.length());
+    _size += content.length();
+  }
+
+  void append(char c) {
+    if (!_capturing || _overflow) {
+      return;
+    }
+    if (_size == _capacity) {
+      _overflow = true;
+      return;
+    }
+    _buffer[_size++] = c;
+  }
+
+  /**
+   * Prevents that the captured response is stored.
+   */
+  void skip() {
+    _overflow = true;
+  }
+
+  /**
+   * Ends capturing and stores the response, if it was successful and fitted
+   * into the buffer.
+   */
+  void end(int code, const toolbox::strref& contentType, uint32_t now) {
+    if (!_capturing) {
+      return;
+    }
+    _capturing = false;
+    if (_overflow || code < 200 || code >= 300 || contentType.length() > MAX_CONTENT_TYPE_LENGTH) {
+      _skipped += 1u;
+      return;
+    }
+    _code = code;
+    contentType.copy(_contentType, MAX_CONTENT_TYPE_LENGTH, true);
+    _storedAt = now;
+    _valid = true;
+  }
+
+  void invalidate() {
+    _valid = false;
+  }
+
+  int code() const { return _code; }
+  const char* contentType() const { return _contentType; }
+  const char* content() const { return _buffer.get(); }
+  size_t size() const { return _size; }
+
+  uint32_t hits() const { return _hits; }
+  uint32_t misses() const { return _misses; }
+  uint32_t skipped() const { return _skipped; }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const {
+    collector.addNumber(F("ttl"), _ttl);
+    collector.addNumber(F("capacity"), _capacity);
+    collector.addValue(F("allocated"), _buffer ? F("true") : F("false"));
+    collector.addNumber(F("size"), _valid ? _size : 0u);
+    collector.addNumber(F("hits"), _hits);
+    collector.addNumber(F("misses"), _misses);
+    collector.addNumber(F("skipped"), _skipped);
+  }
+};
+
+/**
+ * Opt-in cache of responses per route, with a limit on the total memory used
+ * for the cached bodies.
+ */
+class ResponseCache final {
+  size_t _memoryLimit;
+  size_t _memoryUsed = 0u;
+  std::vector<CachedResponse> _entries {};
+
+public:
+  explicit ResponseCache(size_t memoryLimit) : _memoryLimit(memoryLimit) {}
+
+  /**
+   * Enables caching of the route for the TTL (in ms) with bodies of up to
+   * maxSize bytes. Returns false if the memory limit would be exceeded or
+   * caching is already enabled for the route.
+   */
+  bool enable(size_t route, uint32_t ttl, size_t maxSize) {
+    if (find(route) != nullptr || maxSize == 0u || maxSize > _memoryLimit - _memoryUsed) {
+      return false;
+    }
+    _entries.emplace_back(route, ttl, maxSize);
+    _memoryUsed += maxSize;
+    return true;
+  }
+
+  CachedResponse* find(size_t route) {
+    for (auto& entry : _entries) {
+      if (entry.route() == route) {
+        return &entry;
+      }
+    }
+    return nullptr;
+  }
+
+  const CachedResponse* find(size_t route) const {
+    return const_cast<ResponseCache*>(this)->find(route);
+  }
+
+  void invalidate() {
+    for (auto& entry : _entries) {
+      entry.invalidate();
+    }
+  }
+
+  size_t memoryLimit() const { return _memoryLimit; }
+  size_t memoryUsed() const { return _memoryUsed; }
+};
+
+}
+
+#endif
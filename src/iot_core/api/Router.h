@@ -0,0 +1,348 @@
+#ifndef IOT_CORE_API_ROUTER_H_
+#define IOT_CORE_API_ROUTER_H_
+
+#include <iot_core/Histogram.h>
+#include <toolbox.h>
+#include <deque>
+#include <functional>
+#include <vector>
+#include "Interfaces.h"
+
+namespace iot_core::api {
+
+/**
+ * Statistics of the calls of a single route.
+ */
+class RouteStatistics final {
+  HistogramCounters<LogBuckets<20u, 1u>, uint32_t> _latency {};
+  uint32_t _statusClasses[5] = {};
+  uint32_t _bytesSent = 0u;
+
+public:
+  void record(int code, size_t bytesSent, uint32_t latency) {
+    _latency.record(latency);
+    if (code >= 100 && code < 600) {
+      _statusClasses[code / 100 - 1] += 1u;
+    }
+    _bytesSent += bytesSent;
+  }
+
+  uint32_t calls() const { return _latency.count(); }
+  uint32_t statusClass(uint8_t hundreds) const { return hundreds >= 1u && hundreds <= 5u ? _statusClasses[hundreds - 1u] : 0u; }
+  uint32_t bytesSent() const { return _bytesSent; }
+  const HistogramCounters<LogBuckets<20u, 1u>, uint32_t>& latency() const { return _latency; }
+
+  void getDiagnostics(IDiagnosticsCollector& collector) const {
+    _latency.getDiagnostics(collector);
+    collector.addNumber(F("1xx"), _statusClasses[0]);
+    collector.addNumber(F("2xx"), _statusClasses[1]);
+    collector.addNumber(F("3xx"), _statusClasses[2]);
+    collector.addNumber(F("4xx"), _statusClasses[3]);
+    collector.addNumber(F("5xx"), _statusClasses[4]);
+    collector.addNumber(F("bytesSent"), _bytesSent);
+  }
+};
+
+/**
+ * Result of matching a request path, i.e. the route and the values of the
+ * "{}" captures in the path.
+ */
+class RouteMatch final {
+public:
+  static constexpr size_t MAX_PATH_LENGTH = 128u;
+  static constexpr size_t MAX_SEGMENTS = 16u;
+  static constexpr size_t MAX_CAPTURES = 4u;
+
+private:
+  friend class Router;
+
+  char _path[MAX_PATH_LENGTH + 1u] = {};
+  const char* _segments[MAX_SEGMENTS] = {};
+  size_t _segmentCount = 0u;
+  const char* _captures[MAX_CAPTURES] = {};
+  size_t _captureCount = 0u;
+  size_t _route = SIZE_MAX;
+
+public:
+  bool valid() const { return _route != SIZE_MAX; }
+  size_t route() const { return _route; }
+  size_t captureCount() const { return _captureCount; }
+  toolbox::strref capture(size_t i) const { return i < _captureCount ? toolbox::strref(_captures[i]) : toolbox::strref(); }
+};
+
+/**
+ * Router which dispatches request paths via a tree of path segments, where
+ * each segment is either a literal, a "{}" capture or a "*" wildcard matching
+ * the remaining path (incl. none). Literals have precedence over captures and
+ * wildcards.
+ *
+ * Matching takes time linear in the path length (not the number of routes)
+ * and does not allocate. The tree is built while adding routes, so routes
+ * should be added during setup.
+ */
+class Router final {
+  using Handler = std::function<void(IRequest&, IResponse&)>;
+
+  static constexpr uint16_t NONE = UINT16_MAX;
+
+  enum struct SegmentKind : uint8_t { Literal, Capture, Wildcard };
+
+  struct Node final {
+    SegmentKind kind;
+    uint8_t segmentLength;
+    uint16_t segmentOffset;
+    uint16_t firstChild;
+    uint16_t nextSibling;
+    uint16_t firstRoute;
+  };
+
+  struct Route final {
+    toolbox::strref path;
+    uint8_t methods;
+    bool exempt; // from load shedding
+    RouteFunction function;
+    void* context;
+    uint16_t nextRoute;
+    RouteStatistics statistics;
+  };
+
+  std::vector<Node> _nodes {{SegmentKind::Literal, 0u, 0u, NONE, NONE, NONE}};
+  std::vector<char> _segments {};
+  std::vector<Route> _routes {};
+  std::deque<Handler> _handlers {};
+
+  static size_t split(char* path, const char** segments) {
+    size_t count = 0u;
+    char* segment = path;
+    while (*segment != '\0') {
+      char* end = strchr(segment, '/');
+      if (end != nullptr) {
+        *end = '\0';
+      }
+      if (*segment != '\0') {
+        if (count == RouteMatch::MAX_SEGMENTS) {
+          return SIZE_MAX;
+        }
+        segments[count++] = segment;
+      }
+      if (end == nullptr) {
+        break;
+      }
+      segment = end + 1;
+    }
+    return count;
+  }
+
+  static SegmentKind kindOf(const char* segment) {
+    if (strcmp(segment, "{}") == 0) {
+      return SegmentKind::Capture;
+    }
+    if (strcmp(segment, "*") == 0) {
+      return SegmentKind::Wildcard;
+    }
+    return SegmentKind::Literal;
+  }
+
+  bool matchesLiteral(const Node& node, const char* segment) const {
+    return strncmp(segment, _segments.data() + node.segmentOffset, node.segmentLength) == 0 && segment[node.segmentLength] == '\0';
+  }
+
+  uint16_t child(uint16_t parent, SegmentKind kind, const char* segment) const {
+    for (uint16_t index = _nodes[parent].firstChild; index != NONE; index = _nodes[index].nextSibling) {
+      const Node& node = _nodes[index];
+      if (node.kind == kind && (kind != SegmentKind::Literal || matchesLiteral(node, segment))) {
+        return index;
+      }
+    }
+    return NONE;
+  }
+
+  uint16_t addChild(uint16_t parent, SegmentKind kind, const char* segment) {
+    uint16_t index = child(parent, kind, segment);
+    if (index != NONE) {
+      return index;
+    }
+    Node node {kind, 0u, uint16_t(_segments.size()), NONE, NONE, NONE};
+    if (kind == SegmentKind::Literal) {
+      node.segmentLength = uint8_t(strlen(segment));
+      _segments.insert(_segments.end(), segment, segment + node.segmentLength);
+    }
+    // keep the children ordered by precedence: literals, captures, wildcards
+    uint16_t previous = NONE;
+    uint16_t next = _nodes[parent].firstChild;
+    while (next != NONE && _nodes[next].kind <= kind) {
+      previous = next;
+      next = _nodes[next].nextSibling;
+    }
+    node.nextSibling = next;
+    index = uint16_t(_nodes.size());
+    _nodes.push_back(node);
+    (previous == NONE ? _nodes[parent].firstChild : _nodes[previous].nextSibling) = index;
+    return index;
+  }
+
+  size_t findRoute(uint16_t node, uint8_t method) const {
+    for (uint16_t index = _nodes[node].firstRoute; index != NONE; index = _routes[index].nextRoute) {
+      if ((_routes[index].methods & method) != 0u) {
+        return index;
+      }
+    }
+    return SIZE_MAX;
+  }
+
+  bool match(uint16_t node, size_t segment, uint8_t method, RouteMatch& match) const {
+    if (segment == match._segmentCount) {
+      match._route = findRoute(node, method);
+      if (match.valid()) {
+        return true;
+      }
+    }
+
+    for (uint16_t index = _nodes[node].firstChild; index != NONE; index = _nodes[index].nextSibling) {
+      const Node& child = _nodes[index];
+      switch (child.kind) {
+        case SegmentKind::Literal:
+          if (segment < match._segmentCount && matchesLiteral(child, match._segments[segment]) && this->match(index, segment + 1u, method, match)) {
+            return true;
+          }
+          break;
+        case SegmentKind::Capture:
+          if (segment < match._segmentCount && match._captureCount < RouteMatch::MAX_CAPTURES) {
+            match._captures[match._captureCount++] = match._segments[segment];
+            if (this->match(index, segment + 1u, method, match)) {
+              return true;
+            }
+            match._captureCount -= 1u;
+          }
+          break;
+        case SegmentKind::Wildcard:
+          match._route = findRoute(index, method);
+          if (match.valid()) {
+            return true;
+          }
+          break;
+      }
+    }
+    return false;
+  }
+
+  static void callHandler(void* context, IRequest& request, IResponse& response) {
+    (*static_cast<Handler*>(context))(request, response);
+  }
+
+public:
+  Router() {}
+  Router(const Router&) = delete; // contexts of handler routes refer to the router
+  Router(Router&&) = default;
+
+  /**
+   * Adds a route for the given path and methods (see methodMask()), returns
+   * false if the path is invalid.
+   */
+  bool on(const toolbox::strref& path, uint8_t methods, RouteFunction function, void* context) {
+    char buffer[RouteMatch::MAX_PATH_LENGTH + 1u];
+    if (path.length() > RouteMatch::MAX_PATH_LENGTH) {
+      return false;
+    }
+    path.copy(buffer, RouteMatch::MAX_PATH_LENGTH, true);
+
+    const char* segments[RouteMatch::MAX_SEGMENTS];
+    size_t count = split(buffer, segments);
+    if (count == SIZE_MAX) {
+      return false;
+    }
+
+    uint16_t node = 0u;
+    for (size_t i = 0u; i < count; ++i) {
+      SegmentKind kind = kindOf(segments[i]);
+      if (kind == SegmentKind::Wildcard && i + 1u != count) {
+        return false;
+      }
+      node = addChild(node, kind, segments[i]);
+    }
+
+    uint16_t index = uint16_t(_routes.size());
+    _routes.push_back({path.materialize(), methods, false, function, context, NONE, {}});
+    uint16_t* link = &_nodes[node].firstRoute;
+    while (*link != NONE) {
+      link = &_routes[*link].nextRoute;
+    }
+    *link = index;
+    return true;
+  }
+
+  bool on(const toolbox::strref& path, uint8_t methods, Handler handler) {
+    _handlers.push_back(handler);
+    return on(path, methods, &Router::callHandler, &_handlers.back());
+  }
+
+  /**
+   * Adds all routes of a static table stored in PROGMEM.
+   */
+  bool on(const StaticRoute* routes, size_t count, void* context) {
+    bool success = true;
+    for (size_t i = 0u; i < count; ++i) {
+      StaticRoute route;
+      memcpy_P(&route, &routes[i], sizeof(StaticRoute));
+      success &= on(FPSTR(route.path), route.methods, route.function, context);
+    }
+    return success;
+  }
+
+  /**
+   * Matches the request path (without query) for the given method (see
+   * methodMask()), returns false if no route matches.
+   */
+  bool match(uint8_t method, const char* path, RouteMatch& match) const {
+    match._route = SIZE_MAX;
+    match._captureCount = 0u;
+    size_t length = strlen(path);
+    if (length > RouteMatch::MAX_PATH_LENGTH) {
+      return false;
+    }
+    memcpy(match._path, path, length + 1u);
+    match._segmentCount = split(match._path, match._segments);
+    if (match._segmentCount == SIZE_MAX) {
+      match._segmentCount = 0u;
+      return false;
+    }
+    return this->match(0u, 0u, method, match);
+  }
+
+  /**
+   * Calls the handler of the matched route. The code and bytes sent of the
+   * response have to be recorded afterwards via record().
+   */
+  void call(const RouteMatch& match, IRequest& request, IResponse& response) const {
+    const Route& route = _routes[match.route()];
+    route.function(route.context, request, response);
+  }
+
+  void record(const RouteMatch& match, int code, size_t bytesSent, uint32_t latency) {
+    _routes[match.route()].statistics.record(code, bytesSent, latency);
+  }
+
+  /**
+   * Returns the index of the route with exactly the given path and methods,
+   * or SIZE_MAX if there is none.
+   */
+  size_t routeIndex(const toolbox::strref& path, uint8_t methods) const {
+    for (size_t index = 0u; index < _routes.size(); ++index) {
+      if (_routes[index].methods == methods && _routes[index].path == path) {
+        return index;
+      }
+    }
+    return SIZE_MAX;
+  }
+
+  size_t routeCount() const { return _routes.size(); }
+  const toolbox::strref& routePath(size_t route) const { return _routes[route].path; }
+  uint8_t routeMethods(size_t route) const { return _routes[route].methods; }
+  bool exempt(size_t route) const { return _routes[route].exempt; }
+  void exempt(size_t route, bool exempt) { _routes[route].exempt = exempt; }
+  const RouteStatistics& routeStatistics(size_t route) const { return _routes[route].statistics; }
+};
+
+}
+
+#endif
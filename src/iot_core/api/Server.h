@@ -2,60 +2,128 @@
 #define IOT_CORE_API_SERVER_H_
 
 #include <iot_core/Interfaces.h>
-#include <iot_core/Utils.h>
+#include <iot_core/Histogram.h>
+#include <iot_core/Allocations.h>
 #include <toolbox.h>
 #include <ESP8266WebServer.h>
-#include <uri/UriGlob.h>
-#include <vector>
-#include "ChunkedResponse.h"
+#include <optional>
+#include "Dispatcher.h"
 #include "Interfaces.h"
 
 namespace iot_core::api {
 
 
-static const char HEADER_ACCEPT[] PROGMEM = "Accept";
-static const char HEADER_CONTENT_TYPE[] PROGMEM = "Content-Type";
-
-HTTPMethod mapHttpMethod(HttpMethod method) {
+HttpMethod mapHttpMethod(HTTPMethod method) {
   switch (method) {
-    case HttpMethod::ANY: return HTTP_ANY;
-    case HttpMethod::DELETE: return HTTP_DELETE;
-    case HttpMethod::GET: return HTTP_GET;
-    case HttpMethod::HEAD: return HTTP_HEAD;
-    case HttpMethod::OPTIONS: return HTTP_OPTIONS;
-    case HttpMethod::PATCH: return HTTP_PATCH;
-    case HttpMethod::POST: return HTTP_POST;
-    case HttpMethod::PUT: return HTTP_PUT;
-    default: return HTTP_ANY;
+    case HTTP_ANY: return HttpMethod::ANY;
+    case HTTP_DELETE: return HttpMethod::DELETE;
+    case HTTP_GET: return HttpMethod::GET;
+    case HTTP_HEAD: return HttpMethod::HEAD;
+    case HTTP_OPTIONS: return HttpMethod::OPTIONS;
+    case HTTP_PATCH: return HttpMethod::PATCH;
+    case HTTP_POST: return HttpMethod::POST;
+    case HTTP_PUT: return HttpMethod::PUT;
+    default: return HttpMethod::ANY;
   }
 }
 
-int mapResponseCode(ResponseCode code) {
-  return static_cast<int>(code);
-}
+/**
+ * Views of the query arguments and collected headers of the current request
+ * into the storage of the web server. They are taken once per request, so
+ * lookups do not need to allocate Strings for the names. Requests with more
+ * entries than fit into the table fall back to the web server's lookups.
+ */
+class RequestParameters final {
+public:
+  static constexpr size_t MAX_ENTRIES = 8u;
+
+private:
+  struct Entry final {
+    toolbox::strref name;
+    toolbox::strref value;
+  };
 
-toolbox::strref mapContentType(ContentType contentType) {
-  switch (contentType) {
-    default:
-    case ContentType::TextPlain: return F("text/plain");
-    case ContentType::TextCsv: return F("text/csv");
-    case ContentType::TextHtml: return F("text/html");
-    case ContentType::ApplicationOctetStream: return F("application/octet-stream");
-    case ContentType::ApplicationJson: return F("application/json");
-    case ContentType::ApplicationXml: return F("application/xml");
+  ESP8266WebServer& _server;
+  Entry _args[MAX_ENTRIES];
+  size_t _argCount;
+  bool _argsComplete;
+  Entry _headers[MAX_ENTRIES];
+  size_t _headerCount;
+  bool _headersComplete;
+
+  static bool equalsIgnoreCase(const toolbox::strref& name, const toolbox::strref& other) {
+    return name.length() == other.length() && strncasecmp_P(name.cstr(), other.cstr(), name.length()) == 0;
+  }
+
+public:
+  explicit RequestParameters(ESP8266WebServer& server) : _server(server), _args(), _argCount(std::min(size_t(server.args()), MAX_ENTRIES)), _argsComplete(size_t(server.args()) <= MAX_ENTRIES), _headers(), _headerCount(std::min(size_t(server.headers()), MAX_ENTRIES)), _headersComplete(size_t(server.headers()) <= MAX_ENTRIES) {
+    for (size_t i = 0u; i < _argCount; ++i) {
+      _args[i] = {server.argName(i), server.arg(i)};
+    }
+    for (size_t i = 0u; i < _headerCount; ++i) {
+      _headers[i] = {server.headerName(i), server.header(i)};
+    }
   }
-}
 
+  const toolbox::strref* findArg(const toolbox::strref& name) const {
+    for (size_t i = 0u; i < _argCount; ++i) {
+      if (_args[i].name == name) {
+        return &_args[i].value;
+      }
+    }
+    return nullptr;
+  }
+
+  bool hasArg(const toolbox::strref& name) const {
+    return findArg(name) != nullptr || (!_argsComplete && _server.hasArg(name.toString()));
+  }
+
+  toolbox::strref arg(const toolbox::strref& name) const {
+    const toolbox::strref* value = findArg(name);
+    if (value != nullptr) {
+      return *value;
+    }
+    return _argsComplete ? toolbox::strref() : toolbox::strref(_server.arg(name.toString()));
+  }
+
+  toolbox::strref header(const toolbox::strref& name) const {
+    for (size_t i = 0u; i < _headerCount; ++i) {
+      if (equalsIgnoreCase(_headers[i].name, name)) {
+        return _headers[i].value;
+      }
+    }
+    return _headersComplete ? toolbox::strref() : toolbox::strref(_server.header(name.toString()));
+  }
+};
+
+/**
+ * Body of a request, which is either taken from the "plain" argument or (for
+ * raw requests) streamed from the client as it is read. Streamed bodies are
+ * only held in RAM if the content is requested as a whole.
+ */
 class RequestBody final : public IRequestBody {
 private:
+  ESP8266WebServer& _server;
   toolbox::strref _contentTypeHeader;
+  HTTPRaw* _raw;
+  size_t _remaining;
+  String _content;
   toolbox::strref _plainArg;
   toolbox::StringInput _stream;
 
+  static size_t contentLength(const RequestParameters& parameters) {
+    toolbox::strref value = parameters.header(FPSTR(HEADER_CONTENT_LENGTH));
+    return value.empty() ? 0u : strtoul(value.cstr(), nullptr, 10); // values are null-terminated Strings
+  }
+
 public:
-  explicit RequestBody(ESP8266WebServer& server) :
-    _contentTypeHeader(server.header(FPSTR(HEADER_CONTENT_TYPE))),
-    _plainArg(server.arg(F("plain"))),
+  RequestBody(ESP8266WebServer& server, const RequestParameters& parameters, HTTPRaw* raw) :
+    _server(server),
+    _contentTypeHeader(parameters.header(FPSTR(HEADER_CONTENT_TYPE))),
+    _raw(raw),
+    _remaining(raw == nullptr ? 0u : contentLength(parameters)),
+    _content(),
+    _plainArg(raw == nullptr ? parameters.arg(F("plain")) : toolbox::strref()),
     _stream(_plainArg)
   {}
 
@@ -63,99 +131,148 @@ public:
     return _contentTypeHeader;
   }
 
+  /**
+   * Returns the (remaining) content, which reads a streamed body completely
+   * into RAM.
+   */
   const toolbox::strref& content() override {
+    if (_raw != nullptr) {
+      _content.reserve(_remaining);
+      char buffer[64];
+      size_t read;
+      while ((read = this->read(buffer, sizeof(buffer))) > 0u) {
+        _content.concat(buffer, read);
+      }
+      _raw = nullptr;
+      _plainArg = _content;
+      _stream = toolbox::StringInput(_plainArg);
+    }
     return _plainArg;
   }
 
   size_t available() const override {
-    return _stream.available();
+    return _raw != nullptr ? _remaining : _stream.available();
   }
 
   size_t read(char* buffer, size_t bufferSize) override {
-    return _stream.read(buffer, bufferSize);
+    if (_raw == nullptr) {
+      return _stream.read(buffer, bufferSize);
+    }
+    size_t read = _server.client().readBytes(buffer, std::min(bufferSize, _remaining));
+    _remaining -= read;
+    _raw->totalSize += read; // the web server only reads what is left
+    return read;
   }
 
   size_t readString(char* buffer, size_t bufferSize) override {
-    return _stream.readString(buffer, bufferSize);
+    if (_raw == nullptr) {
+      return _stream.readString(buffer, bufferSize);
+    }
+    if (bufferSize == 0u) {
+      return 0u;
+    }
+    size_t read = this->read(buffer, bufferSize - 1u);
+    buffer[read] = '\0';
+    return read;
   }
 };
 
-class SingleResponseBody final : public IResponseBody {
-private:
+/**
+ * Output of ChunkedResponse to the web server. HTTP/1.0 has no chunked
+ * encoding, so a streamed body is delimited by closing the connection
+ * instead: without Content-Length the web server neither frames the content
+ * for HTTP/1.0 clients nor keeps the connection alive.
+ */
+class WebServerOutput final {
   ESP8266WebServer& _server;
-  int _responseCode;
-  toolbox::strref _contentType;
-  bool _valid;
+
+  bool start(int code, PGM_P contentType) {
+    if (!_server.chunkedResponseModeStart_P(code, contentType)) {
+      _server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+      _server.send_P(code, contentType, "");
+    }
+    return true;
+  }
 
 public:
-  explicit SingleResponseBody(ESP8266WebServer& server) : _server(server), _responseCode(200), _contentType(mapContentType(ContentType::TextPlain)), _valid(false) {}
+  explicit WebServerOutput(ESP8266WebServer& server) : _server(server) {}
 
-  void begin(int code, const toolbox::strref& contentType) {
-    _responseCode = code;
-    _contentType = contentType;
-    _valid = true;
-  }
+  bool chunkedResponseModeStart(int code, const char* contentType) { return start(code, contentType); }
+  bool chunkedResponseModeStart(int code, const __FlashStringHelper* contentType) { return start(code, reinterpret_cast<PGM_P>(contentType)); }
 
-  void end() {
-    _valid = false;
-  }
+  void sendContent(const char* content, size_t size) { _server.sendContent(content, size); }
+  void chunkedResponseFinalize() { _server.chunkedResponseFinalize(); }
+  void send(int code, const char* contentType, const char* content, size_t size) { _server.send(code, contentType, content, size); }
+  void send_P(int code, PGM_P contentType, PGM_P content, size_t size) { _server.send_P(code, contentType, content, size); }
+};
 
-  bool valid() const override { return _valid; };
+/**
+ * Body of a response, which is either buffered and sent with an exact
+ * Content-Length (single body) or sent chunked. A single body is upgraded
+ * to a chunked one if it outgrows the buffer.
+ */
+template<typename T>
+class ResponseBody final : public IResponseBody {
+private:
+  ChunkedResponse<T> _response;
+  size_t _bytesSent = 0u;
+  CachedResponse* _capture = nullptr;
 
-  size_t write(const toolbox::strref& content) override {
-    if (!_valid) {
-      return 0u;
-    }
+public:
+  explicit ResponseBody(T& server) : _response(server) {}
+  void beginSingle(int code, const toolbox::strref& contentType) { _response.beginDeferred(code, contentType); }
+  void beginChunked(int code, const toolbox::strref& contentType, DeflateEncoder* encoder, ContentEncoding encoding) { _response.begin(code, contentType, encoder, encoding); }
+  void end() { _response.end(); }
+  bool encoded() const { return _response.encoded(); }
+  bool chunked() const { return _response.chunked(); }
+  bool failed() const { return _response.failed(); }
+  const ChunkedResponse<T>& response() const { return _response; }
+  bool valid() const override { return _response.valid(); };
+  size_t bytesSent() const { return _bytesSent; }
+  void capture(CachedResponse* capture) { _capture = capture; }
 
-    if (content.isInProgmem() || _contentType.isInProgmem()) {
-      _server.send_P(_responseCode, _contentType.cstr(), content.cstr(), content.length());
-    } else {
-      _server.send(_responseCode, _contentType.cstr(), content.cstr(), content.length());
+  size_t write(const toolbox::strref& content) override {
+    size_t written = _response.write(content);
+    _bytesSent += written;
+    if (_capture != nullptr) {
+      _capture->append(written == content.length() ? content : content.substring(0u, written));
     }
-    
-    return content.length();
+    return written;
   }
 
   size_t write(char c) override {
-    if (!_valid) {
-      return 0u;
+    size_t written = _response.write(c);
+    _bytesSent += written;
+    if (_capture != nullptr && written == 1u) {
+      _capture->append(c);
     }
-    _server.send(_responseCode, _contentType.cstr(), &c, 1);
-    return 1u;
+    return written;
   }
 };
 
-class ChunkedResponseBody final : public IResponseBody {
-private:
-  ChunkedResponse<ESP8266WebServer> _response;
-
-public:
-  explicit ChunkedResponseBody(ESP8266WebServer& server) : _response(server) {}
-  void begin(int code, const toolbox::strref& contentType) { _response.begin(code, contentType); }
-  void end() { _response.end(); }
-  bool valid() const override { return _response.valid(); };
-  size_t write(const toolbox::strref& content) override { return _response.write(content); }
-  size_t write(char c) override { return _response.write(c); }
-};
-
 class Request final : public IRequest {
 private:
-  ESP8266WebServer& _server;
+  const RouteMatch& _match;
+  RequestParameters _parameters;
   RequestBody _body;
 
 public:
-  explicit Request(ESP8266WebServer& server) : _server(server), _body(server) {}
+  Request(ESP8266WebServer& server, const RouteMatch& match, HTTPRaw* raw = nullptr) : _match(match), _parameters(server), _body(server, _parameters, raw) {}
 
   bool hasArg(const toolbox::strref& name) const override {
-    return _server.hasArg(name.toString());
+    return _parameters.hasArg(name);
   }
 
   toolbox::strref arg(const toolbox::strref& name) const override {
-    return _server.arg(name.toString());
+    return _parameters.arg(name);
   }
 
   toolbox::strref pathArg(unsigned int i) const override {
-    return _server.pathArg(i);
+    return _match.capture(i);
+  }
+
+  toolbox::strref header(const toolbox::strref& name) const override {
+    return _parameters.header(name);
   }
 
   IRequestBody& body() override {
@@ -164,21 +281,94 @@ public:
 };
 
 class Response final : public IResponse {
+public:
+  static constexpr size_t HEADER_BUFFER_SIZE = 256u;
+
 private:
   ESP8266WebServer& _server;
-  SingleResponseBody _singleBody;
-  ChunkedResponseBody _chunkedBody;
+  WebServerOutput _output;
+  ResponseBody<WebServerOutput> _body;
+  GeneratedResponses<WiFiClient>* _generated;
+  DeflateEncoder* _encoder;
+  ContentEncoding _encoding;
   int _code;
   toolbox::strref _contentType;
+  size_t _progmemBytesSent;
+  CachedResponse* _capture;
+  bool _ended;
+  bool _encoded;
+  char _headers[HEADER_BUFFER_SIZE + 1u];
+  size_t _headersSize;
+  bool _headersSent;
+
+  /**
+   * Hands the buffered headers to the web server and empties the buffer.
+   *
+   * ESP8266WebServer only takes headers as name and value Strings (which it
+   * appends to another String), so sending headers always allocates. This
+   * is a limit of the web server, to allocate as little as possible all
+   * buffered headers are passed as a single one. The first name usually
+   * fits into the inline buffer of String, so only the value is allocated.
+   */
+  void passHeaders() {
+    if (_headersSize == 0u) {
+      return;
+    }
+    _headers[_headersSize - 2u] = '\0'; // the last line break is added by the web server
+    char* separator = strchr(_headers, ':');
+    *separator = '\0';
+    _server.sendHeader(String(_headers), String(separator + 2), false);
+    _headersSize = 0u;
+  }
+
+  void sendHeaders() {
+    if (!_headersSent) {
+      _headersSent = true;
+      passHeaders();
+    }
+  }
   
 public:
-  explicit Response(ESP8266WebServer& server) : _server(server), _singleBody(server), _chunkedBody(server), _code(mapResponseCode(ResponseCode::NotImplemented)), _contentType(mapContentType(ContentType::TextPlain)) {}
+  /**
+   * Chunked bodies are compressed with the encoder if an encoding other than
+   * identity is given.
+   */
+  Response(ESP8266WebServer& server, GeneratedResponses<WiFiClient>* generated = nullptr, DeflateEncoder* encoder = nullptr, ContentEncoding encoding = ContentEncoding::Identity) : _server(server), _output(server), _body(_output), _generated(generated), _encoder(encoder), _encoding(encoder == nullptr ? ContentEncoding::Identity : encoding), _code(mapResponseCode(ResponseCode::NotImplemented)), _contentType(mapContentType(ContentType::TextPlain)), _progmemBytesSent(0u), _capture(nullptr), _ended(false), _encoded(false), _headers(), _headersSize(0u), _headersSent(false) {}
 
   virtual ~Response() {
-    if (_singleBody.valid()) {
-      _singleBody.end();
-    } else if (_chunkedBody.valid()) {
-      _chunkedBody.end();
+    end();
+  }
+
+  int statusCode() const { return _code; }
+
+  const toolbox::strref& contentTypeValue() const { return _contentType; }
+
+  /**
+   * Captures everything written to the body into the cached response.
+   */
+  void capture(CachedResponse* capture) {
+    _capture = capture;
+    _body.capture(capture);
+  }
+
+  size_t bytesSent() const { return _body.bytesSent() + _progmemBytesSent; }
+
+  /**
+   * Returns true if the body was compressed by the encoder.
+   */
+  bool encoded() const { return _encoded; }
+
+  bool chunked() const { return _body.chunked(); }
+  const ChunkedResponse<WebServerOutput>& chunkedResponse() const { return _body.response(); }
+
+  void end() {
+    if (_ended) {
+      return;
+    }
+    _ended = true;
+    sendHeaders();
+    if (_body.valid()) {
+      _body.end();
     } else {
       _server.send_P(_code, _contentType.ref(), "");
     }
@@ -199,78 +389,238 @@ public:
     return *this;
   }
 
+  /**
+   * Headers are written into a buffer until the body is sent, which is
+   * passed to the web server when it is full. Only headers larger than the
+   * buffer (or coming later) are passed to the web server directly.
+   */
   IResponse& header(const toolbox::strref& name, const toolbox::strref& value) override {
-    _server.sendHeader(name.toString(), value.toString(), false);
+    size_t length = name.length() + value.length() + 4u;
+    if (!_headersSent && length > HEADER_BUFFER_SIZE - _headersSize) {
+      passHeaders();
+    }
+    if (_headersSent || name.empty() || length > HEADER_BUFFER_SIZE) {
+      _server.sendHeader(name.toString(), value.toString(), false);
+      return *this;
+    }
+    _headersSize += name.copy(_headers + _headersSize, name.length(), false);
+    _headers[_headersSize++] = ':';
+    _headers[_headersSize++] = ' ';
+    _headersSize += value.copy(_headers + _headersSize, value.length(), false);
+    _headers[_headersSize++] = '\r';
+    _headers[_headersSize++] = '\n';
+    _headers[_headersSize] = '\0';
     return *this;
   }
   
   IResponseBody& sendChunkedBody() override {
-    _chunkedBody.begin(_code, _contentType);
-    if (!_chunkedBody.valid()) {
-      code(ResponseCode::HttpVersionNotSupported);
-      contentType(ContentType::TextPlain);
-      sendSingleBody().write(F("HTTP1.1 required"));
+    if (_encoding != ContentEncoding::Identity) {
+      header(F("Content-Encoding"), contentEncodingToString(_encoding));
+      header(F("Vary"), FPSTR(HEADER_ACCEPT_ENCODING));
     }
-    return _chunkedBody;
+    sendHeaders();
+    _body.beginChunked(_code, _contentType, _encoder, _encoding);
+    _encoded = _body.encoded();
+    return _body;
   }
   
+  void sendProgmemBody(const uint8_t* content, size_t size) override {
+    if (_ended || _body.valid()) {
+      return;
+    }
+    _ended = true;
+    sendHeaders();
+    _server.setContentLength(size);
+    _server.send_P(_code, _contentType.ref(), "");
+    for (size_t offset = 0u; offset < size; offset += TCP_SEGMENT_SIZE) {
+      _server.sendContent_P(reinterpret_cast<PGM_P>(content) + offset, std::min(size - offset, TCP_SEGMENT_SIZE));
+    }
+    _progmemBytesSent = size;
+    if (_capture != nullptr) {
+      _capture->skip(); // already in flash, no need to copy into RAM
+    }
+  }
+
   IResponseBody& sendSingleBody() override {
-    _singleBody.begin(_code, _contentType);
-    if (!_singleBody.valid()) {
-      code(ResponseCode::InternalServerError);
+    sendHeaders();
+    _body.beginSingle(_code, _contentType);
+    return _body;
+  }
+
+  /**
+   * The generated response takes over the client from the web server, so it
+   * writes the response head itself, incl. the buffered headers.
+   */
+  bool sendGeneratedBody(ResponseGenerator generator) override {
+    if (_ended || _body.valid()) {
+      return false;
+    }
+    GeneratedResponse<WiFiClient>* generated = _generated != nullptr ? _generated->acquire() : nullptr;
+    if (generated == nullptr) {
+      code(ResponseCode::ServiceUnavailable);
       contentType(ContentType::TextPlain);
+      sendSingleBody().write(F("too many responses"));
+      return false;
     }
-    return _singleBody;
+    header(F("Access-Control-Allow-Origin"), F("*")); // added by the web server otherwise
+    _ended = true;
+    _headersSent = true;
+    generated->begin(_server.client(), _code, _contentType, toolbox::strref(_headers, _headersSize), std::move(generator));
+    if (_capture != nullptr) {
+      _capture->skip();
+    }
+    return true;
   }
 };
 
 class Server final : public IServer, public IContainer, public IApplicationComponent {
 private:
-  Logger _logger;
-  ISystem& _system;
-  std::vector<IProvider*> _providers;
+  /**
+   * Handler of the web server dispatching all requests via the router.
+   */
+  class RouterRequestHandler final : public esp8266webserver::RequestHandler<WiFiServer> {
+    Server& _owner;
+    RouteMatch _match {};
+    bool _dispatched = false;
+
+  public:
+    explicit RouterRequestHandler(Server& owner) : _owner(owner) {}
+
+    bool canHandle(HTTPMethod method, const String& uri) override {
+      _dispatched = false;
+      return _owner._dispatcher.match(methodMask(mapHttpMethod(method)), uri.c_str(), _match);
+    }
+
+    /**
+     * Request bodies are always received raw, so they can be streamed.
+     */
+    bool canRaw(const String& /*uri*/) override {
+      return true;
+    }
+
+    /**
+     * Dispatches the request before the web server reads the body, which is
+     * then read from the client by the handler. Whatever is left over is
+     * read and discarded by the web server afterwards.
+     */
+    void raw(ESP8266WebServer& /*server*/, const String& /*uri*/, HTTPRaw& raw) override {
+      if (raw.status == RAW_START) {
+        _owner.dispatch(_match, &raw);
+        _dispatched = true;
+      }
+    }
+
+    bool handle(ESP8266WebServer& /*server*/, HTTPMethod method, const String& uri) override {
+      if (_dispatched) {
+        _dispatched = false;
+        return true;
+      }
+      if (!canHandle(method, uri)) {
+        return false;
+      }
+      _owner.dispatch(_match);
+      return true;
+    }
+  };
+
+  /**
+   * Current request of the web server, as dispatched by the dispatcher.
+   */
+  class Exchange final {
+    ESP8266WebServer& _server;
+    std::optional<Response>& _response;
+    Request _request;
+
+  public:
+    Exchange(ESP8266WebServer& server, std::optional<Response>& response, const RouteMatch& match, HTTPRaw* raw) : _server(server), _response(response), _request(server, match, raw) {}
+
+    uint8_t method() const { return methodMask(mapHttpMethod(_server.method())); }
+    uint32_t remoteIP() { return uint32_t(_server.client().remoteIP()); }
+    bool hasQuery() const { return _server.args() > 0; }
+    const char* path() const { return _server.uri().c_str(); }
+    Request& request() { return _request; }
+
+    void reject(int code, uint32_t retryAfter) {
+      _server.sendHeader(String(F("Retry-After")), String(toolbox::convert<uint32_t>::toString(retryAfter, 10)));
+      _server.send_P(code, PSTR("text/plain"), "");
+    }
+
+    void respond(int code, const char* contentType, const char* content, size_t size) {
+      _server.send(code, contentType, content, size);
+    }
+
+    Response& beginResponse(GeneratedResponses<WiFiClient>& generated, DeflateEncoder* encoder, ContentEncoding encoding) {
+      return _response.emplace(_server, &generated, encoder, encoding);
+    }
+
+    void endResponse() {
+      _response.reset();
+    }
+  };
+
   ESP8266WebServer _server;
-  TimingStatistics<10u> _callStatistics;
+  Dispatcher _dispatcher;
+  std::optional<Response> _response; // kept out of the (4 KiB) loop stack, as it contains the chunk buffer
+
+  void dispatch(const RouteMatch& match, HTTPRaw* raw = nullptr) {
+    Exchange exchange {_server, _response, match, raw};
+    _dispatcher.dispatch(match, exchange);
+  }
   
 public:
-  Server(ISystem& system, int port = 80) : _logger(system.logger(F("api"))), _system(system), _providers(), _server(port) {}
+  static constexpr size_t DEFAULT_CACHE_MEMORY = Dispatcher::DEFAULT_CACHE_MEMORY;
+
+  Server(ISystem& system, int port = 80, size_t cacheMemory = DEFAULT_CACHE_MEMORY) : _server(port), _dispatcher(system, cacheMemory), _response() {}
   
-  void on(const Uri& uri, HttpMethod method, std::function<void(IRequest&, IResponse&)> handler) override {
-    _server.on(uri, mapHttpMethod(method), _callStatistics.wrap([this,handler]() {
-      Request request {_server};
-      Response response {_server};
-      handler(request, response);
-    }));
+  void on(const toolbox::strref& path, HttpMethod method, std::function<void(IRequest&, IResponse&)> handler) override {
+    _dispatcher.on(path, method, handler);
+  }
+
+  void on(const StaticRoute* routes, size_t count, void* context) override {
+    _dispatcher.on(routes, count, context);
+  }
+
+  bool cache(const toolbox::strref& path, HttpMethod method, uint32_t ttl, size_t maxSize) override {
+    return _dispatcher.cache(path, method, ttl, maxSize);
+  }
+
+  void invalidateCache() override {
+    _dispatcher.invalidateCache();
+  }
+
+  bool exempt(const toolbox::strref& path, HttpMethod method) override {
+    return _dispatcher.exempt(path, method);
+  }
+
+  bool call(const char* path, IResponse& response) override {
+    return _dispatcher.call(path, response);
   }
 
   void addProvider(IProvider* provider) override {
-    _providers.emplace_back(provider);
+    _dispatcher.addProvider(provider);
   }
 
   toolbox::strref name() const override {
     return F("api");
   }
 
-  bool configure(const toolbox::strref& /*name*/, const toolbox::strref& /*value*/) override {
-    return false;
+  bool configure(const toolbox::strref& name, const toolbox::strref& value) override {
+    return _dispatcher.configure(name, value);
   }
 
-  void getConfig(iot_core::ConfigWriter /*writer*/) const override {
+  void getConfig(iot_core::ConfigWriter writer) const override {
+    _dispatcher.getConfig(writer);
   }
 
   void setup(bool /*connected*/) override {
     _server.enableCORS(true);
     _server.collectHeaders(FPSTR(HEADER_ACCEPT));
     _server.collectHeaders(FPSTR(HEADER_CONTENT_TYPE));
-
-    // generic OPTIONS reply to make "pre-flight" checks work
-    on(UriGlob(F("*")), HttpMethod::OPTIONS, [](IRequest&, IResponse& response) {  
-      response.code(ResponseCode::OkNoContent).header(F("Access-Control-Allow-Methods"), F("GET, POST, PUT, DELETE, OPTIONS"));
-    });
-    
-    for (auto provider : _providers) {
-      provider->setupApi(*this);
-    }
+    _server.collectHeaders(FPSTR(HEADER_CONTENT_LENGTH));
+    _server.collectHeaders(FPSTR(HEADER_ACCEPT_ENCODING));
+    _server.collectHeaders(FPSTR(HEADER_IF_NONE_MATCH));
+    _server.addHandler(new RouterRequestHandler(*this)); // owned by the web server
+    _dispatcher.setup(*this);
   }
 
   void loop(ConnectionStatus status) override {
@@ -279,7 +629,7 @@ public:
         _server.begin();
         break;
       case ConnectionStatus::Connected:
-        _server.handleClient();
+        _dispatcher.loop([this]() { _server.handleClient(); });
         break;
       case ConnectionStatus::Disconnecting:
         _server.close();
@@ -291,10 +641,7 @@ public:
   }
 
   void getDiagnostics(IDiagnosticsCollector& collector) const override {
-    collector.addValue(F("callCount"), toolbox::convert<size_t>::toString(_callStatistics.count(), 10));
-    collector.addValue(F("callAvg"), toolbox::convert<unsigned long>::toString(_callStatistics.avg(), 10));
-    collector.addValue(F("callMin"), toolbox::convert<unsigned long>::toString(_callStatistics.min(), 10));
-    collector.addValue(F("callMax"), toolbox::convert<unsigned long>::toString(_callStatistics.max(), 10));
+    _dispatcher.getDiagnostics(collector);
   }
 };
 
@@ -0,0 +1,112 @@
+#ifndef IOT_CORE_API_STATICASSETS_H_
+#define IOT_CORE_API_STATICASSETS_H_
+
+#include <toolbox.h>
+#include "Deflate.h"
+#include "Interfaces.h"
+
+namespace iot_core::api {
+
+/**
+ * Entry of a static asset table, which is stored in PROGMEM (incl. all
+ * strings and the content). Tables are generated at build time by
+ * extras/assets/generate_assets.py.
+ */
+struct StaticAsset final {
+  PGM_P path;
+  PGM_P contentType;
+  PGM_P etag; // incl. quotes
+  const uint8_t* content;
+  uint32_t size;
+  bool gzipped;
+};
+
+/**
+ * Returns true if the If-None-Match header matches the entity tag, using the
+ * weak comparison as required by RFC 9110.
+ */
+inline bool matchesETag(const toolbox::strref& ifNoneMatch, const toolbox::strref& etag) {
+  toolbox::strref remaining = ifNoneMatch;
+  while (!remaining.empty()) {
+    int end = remaining.indexOf(',');
+    toolbox::strref candidate = detail::trimSpaces(end < 0 ? remaining : remaining.substring(0u, end));
+    remaining = end < 0 ? toolbox::strref() : remaining.skip(end + 1);
+
+    if (candidate == F("*")) {
+      return true;
+    }
+    if (candidate.length() > 2u && candidate.cstr()[0] == 'W' && candidate.cstr()[1] == '/') {
+      candidate = candidate.skip(2u);
+    }
+    if (candidate == etag) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Serves the assets of a static asset table, streamed directly from flash.
+ *
+ * Responses carry the (strong) ETag and Cache-Control header, and requests
+ * revalidating a cached asset are answered with 304. Gzipped assets are only
+ * sent to clients accepting gzip.
+ */
+class StaticAssetProvider final : public IProvider {
+  const StaticAsset* _assets;
+  size_t _count;
+  toolbox::strref _cacheControl;
+
+  void serve(size_t index, IRequest& request, IResponse& response) const {
+    StaticAsset asset;
+    memcpy_P(&asset, &_assets[index], sizeof(StaticAsset));
+
+    response.header(F("ETag"), FPSTR(asset.etag));
+    response.header(F("Cache-Control"), _cacheControl);
+    if (asset.gzipped) {
+      response.header(F("Vary"), F("Accept-Encoding"));
+    }
+
+    if (matchesETag(request.header(F("If-None-Match")), FPSTR(asset.etag))) {
+      response.code(ResponseCode::RedirectNotModified);
+      return;
+    }
+
+    if (asset.gzipped) {
+      if (negotiateContentEncoding(request.header(F("Accept-Encoding"))) != ContentEncoding::Gzip) {
+        response.code(ResponseCode::BadRequestNotAcceptable)
+          .contentType(ContentType::TextPlain)
+          .sendSingleBody()
+          .write(F("gzip encoding required"));
+        return;
+      }
+      response.header(F("Content-Encoding"), F("gzip"));
+    }
+
+    response
+      .code(ResponseCode::Ok)
+      .contentType(FPSTR(asset.contentType))
+      .sendProgmemBody(asset.content, asset.size);
+  }
+
+public:
+  /**
+   * The default Cache-Control lets clients store assets but revalidate them
+   * via the ETag before use, which is cheap due to the 304 response.
+   */
+  StaticAssetProvider(const StaticAsset* assets, size_t count, const toolbox::strref& cacheControl = F("no-cache")) : _assets(assets), _count(count), _cacheControl(cacheControl) {}
+
+  void setupApi(IServer& server) override {
+    for (size_t i = 0u; i < _count; ++i) {
+      StaticAsset asset;
+      memcpy_P(&asset, &_assets[i], sizeof(StaticAsset));
+      server.on(FPSTR(asset.path), HttpMethod::GET, [this, i] (IRequest& request, IResponse& response) {
+        serve(i, request, response);
+      });
+    }
+  }
+};
+
+}
+
+#endif
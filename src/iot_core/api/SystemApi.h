@@ -3,21 +3,152 @@
 
 #include <iot_core/Interfaces.h>
 #include <iot_core/Config.h>
-#include <uri/UriBraces.h>
 #include <jsons.h>
+#include "Batch.h"
+#include "CborDiagnosticsCollector.h"
+#include "CsvDiagnosticsCollector.h"
+#include "DiagnosticsDelta.h"
 #include "Interfaces.h"
 #include "JsonDiagnosticsCollector.h"
+#include "Negotiation.h"
 
 namespace iot_core::api {
 
 class SystemApi final : public IProvider {
+public:
+  static constexpr uint32_t STATUS_CACHE_TTL = 1000u;
+  static constexpr size_t STATUS_CACHE_SIZE = 6144u;
+
 private:
   iot_core::Logger _logger;
   iot_core::ISystem& _system;
   iot_core::IApplicationContainer& _application;
+  bool _cacheStatus;
+  char _batchContentType[BatchGenerator::CONTENT_TYPE_SIZE] = {}; // of the last batch, the head is sent right away
+
+  static void writeConfigEntry(IResponseBody& body, const toolbox::strref& name, const toolbox::strref& value) {
+    body.write(name);
+    body.write(iot_core::ConfigParser::SEPARATOR);
+    body.write(value);
+    body.write(iot_core::ConfigParser::END);
+    body.write('\n');
+  }
+
+  /**
+   * Provides the name, config, log level and diagnostics of a component.
+   */
+  class ComponentDetails final : public iot_core::IDiagnosticsProvider {
+    const iot_core::IApplicationComponent& _component;
+    iot_core::LogLevel _logLevel;
+
+  public:
+    ComponentDetails(const iot_core::IApplicationComponent& component, iot_core::LogLevel logLevel) : _component(component), _logLevel(logLevel) {}
+
+    void getDiagnostics(iot_core::IDiagnosticsCollector& collector) const override {
+      collector.addValue(F("name"), _component.name());
+      collector.beginSection(F("config"));
+      _component.getConfig([&] (const toolbox::strref& name, const toolbox::strref& value) {
+        collector.addValue(name, value);
+      });
+      collector.endSection();
+      collector.addValue(F("logLevel"), iot_core::logLevelToString(_logLevel));
+      collector.beginSection(F("diagnostics"));
+      _component.getDiagnostics(collector);
+      collector.endSection();
+    }
+  };
+
+  /**
+   * Selects the format of diagnostics by the Accept header of the request,
+   * responds with 406 and returns ContentType::Unknown if none is acceptable.
+   */
+  static ContentType negotiateDiagnostics(IRequest& request, IResponse& response) {
+    ContentType contentType = negotiateContentType(request.header(F("Accept")), {ContentType::ApplicationJson, ContentType::ApplicationCbor, ContentType::TextCsv});
+    if (contentType == ContentType::Unknown) {
+      response.code(ResponseCode::BadRequestNotAcceptable)
+        .contentType(ContentType::TextPlain)
+        .sendSingleBody()
+        .write(F("Supported are application/json, application/cbor and text/csv"));
+    }
+    return contentType;
+  }
+
+  /**
+   * Writes the diagnostics in the format, returns false if writing failed.
+   */
+  static bool writeDiagnostics(IResponseBody& body, ContentType contentType, const iot_core::IDiagnosticsProvider& provider) {
+    switch (contentType) {
+      case ContentType::ApplicationCbor: {
+        CborWriter writer {body};
+        CborDiagnosticsCollector collector {writer};
+        provider.getDiagnostics(collector);
+        collector.end();
+        return true;
+      }
+      case ContentType::TextCsv: {
+        CsvDiagnosticsCollector collector {body};
+        provider.getDiagnostics(collector);
+        return true;
+      }
+      default: {
+        auto writer = jsons::makeWriter(body);
+        JsonDiagnosticsCollector collector {writer};
+        provider.getDiagnostics(collector);
+        writer.end();
+        return !writer.failed();
+      }
+    }
+  }
+
+  static void writeJsonString(IResponseBody& body, const char* string, size_t length) {
+    body.write('"');
+    for (size_t i = 0u; i < length; ++i) {
+      char c = string[i];
+      if (c == '"' || c == '\\') {
+        body.write('\\');
+        body.write(c);
+      } else if (uint8_t(c) < 0x20u) {
+        body.write(toolbox::format("\\u%04x", unsigned(c)));
+      } else {
+        body.write(c);
+      }
+    }
+    body.write('"');
+  }
+
+  /**
+   * Writes a log entry (without the line break) as element of the list in
+   * the format.
+   */
+  static void writeLogEntry(IResponseBody& body, ContentType contentType, const char* entry, size_t index) {
+    size_t length = strlen(entry);
+    if (length > 0u && entry[length - 1u] == '\n') {
+      length -= 1u;
+    }
+    switch (contentType) {
+      case ContentType::ApplicationJson:
+        body.write(index == 0u ? '[' : ',');
+        writeJsonString(body, entry, length);
+        break;
+      case ContentType::ApplicationCbor:
+        CborWriter(body).string(toolbox::strref(entry, length));
+        break;
+      case ContentType::TextCsv:
+        writeCsvField(body, toolbox::strref(entry, length));
+        body.write(F("\r\n"));
+        break;
+      default:
+        body.write(entry);
+        break;
+    }
+  }
 
 public:
-  SystemApi(iot_core::ISystem& system, iot_core::IApplicationContainer& application) : _logger(system.logger(F("api"))), _system(system), _application(application) {}
+  /**
+   * With cacheStatus, the status is cached for STATUS_CACHE_TTL (using up to
+   * STATUS_CACHE_SIZE bytes of heap once it was requested).
+   */
+  SystemApi(iot_core::ISystem& system, iot_core::IApplicationContainer& application, bool cacheStatus = false) : _logger(system.logger(F("api"))), _system(system), _application(application), _cacheStatus(cacheStatus) {}
 
   void setupApi(IServer& server) override {
     server.on(F("/api/system/reset"), HttpMethod::POST, [this](IRequest&, IResponse& response) {
@@ -35,82 +166,121 @@ public:
       response.code(ResponseCode::OkNoContent);
     });
 
-    server.on(F("/api/system/status"), HttpMethod::GET, [this](IRequest&, IResponse& response) {
+    server.on(F("/api/system/status"), HttpMethod::GET, [this](IRequest& request, IResponse& response) {
+      ContentType contentType = negotiateDiagnostics(request, response);
+      if (contentType == ContentType::Unknown) {
+        return;
+      }
+
       IResponseBody& body = response
         .code(ResponseCode::Ok)
-        .contentType(ContentType::ApplicationJson)
+        .contentType(contentType)
         .sendChunkedBody();
       
       if (!body.valid()) {
         return;
       }
 
-      auto writer = jsons::makeWriter(body);
-      JsonDiagnosticsCollector collector {writer};
-      _application.getDiagnostics(collector);
-      writer.end();
-      if (writer.failed()) {
-        _logger.log(LogLevel::Warning, F("Failed to write diagnostics JSON response."));
+      if (contentType == ContentType::TextCsv) {
+        CsvDiagnosticsCollector::header(body);
+      }
+      if (!writeDiagnostics(body, contentType, _application)) {
+        _logger.log(LogLevel::Warning, F("Failed to write diagnostics response."));
       }
     });
 
-    server.on(F("/api/system/logs"), HttpMethod::GET, [this](IRequest&, IResponse& response) {
-      IResponseBody& body = response
-        .code(ResponseCode::Ok)
-        .contentType(ContentType::TextPlain)
-        .sendChunkedBody();
-      
-      if (!body.valid()) {
+    server.on(F("/api/system/logs"), HttpMethod::GET, [this](IRequest& request, IResponse& response) {
+      ContentType contentType = negotiateContentType(request.header(F("Accept")), {ContentType::TextPlain, ContentType::ApplicationJson, ContentType::ApplicationCbor, ContentType::TextCsv});
+      if (contentType == ContentType::Unknown) {
+        response.code(ResponseCode::BadRequestNotAcceptable).sendSingleBody();
         return;
       }
-      
-      _system.localLogSink().output([&] (const char* entry) {
-        body.write(entry);
-      });
+      iot_core::LogCursor cursor = _system.localLogSink().cursor();
+      size_t index = 0u;
+      response
+        .code(ResponseCode::Ok)
+        .contentType(contentType)
+        .sendGeneratedBody([this, cursor, contentType, index] (IResponseBody& body) mutable {
+          if (index == 0u && contentType == ContentType::ApplicationCbor) {
+            CborWriter(body).openArray();
+          } else if (index == 0u && contentType == ContentType::TextCsv) {
+            body.write(F("entry\r\n"));
+          }
+          bool more = _system.localLogSink().outputNext(cursor, [&] (const char* entry) {
+            writeLogEntry(body, contentType, entry, index);
+          });
+          if (more) {
+            index += 1u;
+          } else if (contentType == ContentType::ApplicationJson) {
+            body.write(index == 0u ? F("[]") : F("]"));
+          } else if (contentType == ContentType::ApplicationCbor) {
+            CborWriter(body).close();
+          }
+          return more;
+        });
     });
 
-    server.on(F("/api/system/components"), HttpMethod::GET, [this](IRequest&, IResponse& response) {
-      IResponseBody& body = response
-        .code(ResponseCode::Ok)
-        .contentType(ContentType::ApplicationJson)
-        .sendChunkedBody();
-      
-      if (!body.valid()) {
+    server.on(F("/api/system/batch"), HttpMethod::GET, [this, &server](IRequest& request, IResponse& response) {
+      toolbox::strref paths = request.arg(F("paths"));
+      if (!BatchGenerator::valid(paths)) {
+        response.code(ResponseCode::BadRequest)
+          .contentType(ContentType::TextPlain)
+          .sendSingleBody()
+          .write(F("Expected 1 to 8 paths separated by ','"));
         return;
       }
+      BatchGenerator generator {server, paths};
+      response
+        .code(ResponseCode::Ok)
+        .contentType(generator.contentType(_batchContentType))
+        .sendGeneratedBody(std::move(generator));
+    });
 
-      auto writer = jsons::makeWriter(body);
-      writer.openList();
-
-      _application.forEachComponent([&] (const IApplicationComponent* component) {
-        writer.openObject();
-        writer.property(F("name")).string(component->name());
-        
-        writer.property(F("config")).openObject();
-        component->getConfig([&] (const toolbox::strref& name, const toolbox::strref& value) {
-          writer.property(name).string(value);
-        });
-        writer.close();
-
-        writer.property(F("logLevel")).string(iot_core::logLevelToString(_system.logs().logLevel(component->name())));
-
-        writer.property(F("diagnostics"));
-        JsonDiagnosticsCollector collector {writer};
-        component->getDiagnostics(collector);
-        collector.end();
-        
-        writer.close();
-      });
-
-      writer.close();
-      writer.end();
-      
-      if (writer.failed()) {
-        _logger.log(LogLevel::Warning, F("Failed to write components JSON response."));
+    server.on(F("/api/system/components"), HttpMethod::GET, [this](IRequest& request, IResponse& response) {
+      ContentType contentType = negotiateDiagnostics(request, response);
+      if (contentType == ContentType::Unknown) {
+        return;
       }
+      size_t index = 0u;
+      response
+        .code(ResponseCode::Ok)
+        .contentType(contentType)
+        .sendGeneratedBody([this, contentType, index] (IResponseBody& body) mutable {
+          // one component per call
+          const IApplicationComponent* component = _application.getComponent(ComponentHandle{index});
+          if (index == 0u && contentType == ContentType::TextCsv) {
+            CsvDiagnosticsCollector::header(body);
+          } else if (index == 0u && contentType == ContentType::ApplicationCbor) {
+            CborWriter(body).openArray();
+          }
+          if (component == nullptr) {
+            if (contentType == ContentType::ApplicationJson) {
+              body.write(index == 0u ? F("[]") : F("]"));
+            } else if (contentType == ContentType::ApplicationCbor) {
+              CborWriter(body).close();
+            }
+            return false;
+          }
+          if (contentType == ContentType::ApplicationJson) {
+            body.write(index == 0u ? '[' : ',');
+          }
+          index += 1u;
+
+          ComponentDetails details {*component, _system.logs().logLevel(component->name())};
+          if (contentType == ContentType::TextCsv) {
+            CsvDiagnosticsCollector collector {body};
+            collector.beginSection(component->name());
+            details.getDiagnostics(collector);
+            collector.endSection();
+          } else if (!writeDiagnostics(body, contentType, details)) {
+            _logger.log(LogLevel::Warning, F("Failed to write components response."));
+            return false;
+          }
+          return true;
+        });
     });
 
-    server.on(UriBraces(F("/api/system/components/{}")), HttpMethod::GET, [this](IRequest& request, IResponse& response) {
+    server.on(F("/api/system/components/{}"), HttpMethod::GET, [this](IRequest& request, IResponse& response) {
       const auto& name = request.pathArg(0);
 
       const auto component = _application.getComponent(name);
@@ -122,40 +292,29 @@ public:
         return;
       }
 
+      ContentType contentType = negotiateDiagnostics(request, response);
+      if (contentType == ContentType::Unknown) {
+        return;
+      }
+
       IResponseBody& body = response
         .code(ResponseCode::Ok)
-        .contentType(ContentType::ApplicationJson)
+        .contentType(contentType)
         .sendChunkedBody();
       
       if (!body.valid()) {
         return;
       }
 
-      auto writer = jsons::makeWriter(body);      
-      writer.openObject();
-      writer.property(F("name")).string(component->name());
-      
-      writer.property(F("config")).openObject();
-      component->getConfig([&] (const toolbox::strref& name, const toolbox::strref& value) {
-        writer.property(name).string(value);
-      });
-      writer.close();
-
-      writer.property(F("logLevel")).string(iot_core::logLevelToString(_system.logs().logLevel(component->name())));
-      writer.property(F("diagnostics"));
-      JsonDiagnosticsCollector collector {writer};
-      component->getDiagnostics(collector);
-      collector.end();
-      
-      writer.close();
-      writer.end();
-      
-      if (writer.failed()) {
-        _logger.log(LogLevel::Warning, F("Failed to write components JSON response."));
+      if (contentType == ContentType::TextCsv) {
+        CsvDiagnosticsCollector::header(body);
+      }
+      if (!writeDiagnostics(body, contentType, ComponentDetails{*component, _system.logs().logLevel(component->name())})) {
+        _logger.log(LogLevel::Warning, F("Failed to write components response."));
       }
     });
 
-    server.on(UriBraces(F("/api/system/components/{}/log-level")), HttpMethod::GET, [this](IRequest& request, IResponse& response) {
+    server.on(F("/api/system/components/{}/log-level"), HttpMethod::GET, [this](IRequest& request, IResponse& response) {
       const auto& name = request.pathArg(0);
 
       const auto component = _application.getComponent(name);
@@ -174,7 +333,7 @@ public:
         .write(iot_core::logLevelToString(_system.logs().logLevel(name)));
     });
 
-    server.on(UriBraces(F("/api/system/components/{}/log-level")), HttpMethod::PUT, [this](IRequest& request, IResponse& response) {
+    server.on(F("/api/system/components/{}/log-level"), HttpMethod::PUT, [this](IRequest& request, IResponse& response) {
       const auto& name = request.pathArg(0);
       const auto component = _application.getComponent(name);
       if (component == nullptr) {
@@ -203,7 +362,7 @@ public:
         .write(iot_core::logLevelToString(_system.logs().logLevel(name)));
     });
 
-    server.on(UriBraces(F("/api/system/components/{}/log-level")), HttpMethod::DELETE, [this](IRequest& request, IResponse& response) {
+    server.on(F("/api/system/components/{}/log-level"), HttpMethod::DELETE, [this](IRequest& request, IResponse& response) {
       const auto& name = request.pathArg(0);
 
       const auto component = _application.getComponent(name);
@@ -251,31 +410,28 @@ public:
       }
 
       _application.getAllConfig([&] (const toolbox::strref& path, const toolbox::strref& value) {
-        body.write(path);
-        body.write(iot_core::ConfigParser::SEPARATOR);
-        body.write(value);
-        body.write(iot_core::ConfigParser::END);
-        body.write('\n');
+        writeConfigEntry(body, path, value);
       });
     });
 
-    server.on(F("/api/system/config"), HttpMethod::PUT, [this](IRequest& request, IResponse& response) {
-      const char* body = request.body().content().cstr();
-
-      iot_core::ConfigParser config {const_cast<char*>(body)};
+    server.on(F("/api/system/config"), HttpMethod::PUT, [this, &server](IRequest& request, IResponse& response) {
+      iot_core::StreamingConfigParser config {request.body()};
 
       if (_application.configureAll(config)) {
-        response
+        server.invalidateCache();
+        IResponseBody& body = response
           .code(ResponseCode::Ok)
           .contentType(ContentType::TextPlain)
-          .sendSingleBody()
-          .write(body);
+          .sendSingleBody();
+        _application.getAllConfig([&] (const toolbox::strref& path, const toolbox::strref& value) {
+          writeConfigEntry(body, path, value);
+        });
       } else {
         response.code(ResponseCode::BadRequest);
       }
     });
 
-    server.on(UriBraces(F("/api/system/config/{}")), HttpMethod::GET, [this](IRequest& request, IResponse& response) {
+    server.on(F("/api/system/config/{}"), HttpMethod::GET, [this](IRequest& request, IResponse& response) {
       const auto& category = request.pathArg(0);
 
       IResponseBody& body = response
@@ -288,30 +444,54 @@ public:
       }
 
       _application.getConfig(category, [&] (const toolbox::strref& name, const toolbox::strref& value) {
-        body.write(name);
-        body.write(iot_core::ConfigParser::SEPARATOR);
-        body.write(value);
-        body.write(iot_core::ConfigParser::END);
-        body.write('\n');
+        writeConfigEntry(body, name, value);
       });
     });
 
-    server.on(UriBraces(F("/api/system/config/{}")), HttpMethod::PUT, [this](IRequest& request, IResponse& response) {
+    server.on(F("/api/system/config/{}"), HttpMethod::PUT, [this, &server](IRequest& request, IResponse& response) {
       const auto& category = request.pathArg(0);
-      const char* body = request.body().content().cstr();
-
-      iot_core::ConfigParser config {const_cast<char*>(body)};
+      iot_core::StreamingConfigParser config {request.body()};
 
       if (_application.configure(category, config)) {
-        response
+        server.invalidateCache();
+        IResponseBody& body = response
           .code(ResponseCode::Ok)
           .contentType(ContentType::TextPlain)
-          .sendSingleBody()
-          .write(body);
+          .sendSingleBody();
+        _application.getConfig(category, [&] (const toolbox::strref& name, const toolbox::strref& value) {
+          writeConfigEntry(body, name, value);
+        });
       } else {
         response.code(ResponseCode::BadRequest);
       }
     });
+
+    // control and configuration have to stay available under load, e.g. to raise the shed latency
+    server.exempt(F("/api/system/reset"), HttpMethod::POST);
+    server.exempt(F("/api/system/factory-reset"), HttpMethod::POST);
+    server.exempt(F("/api/system/stop"), HttpMethod::POST);
+    server.exempt(F("/api/system/config"), HttpMethod::GET);
+    server.exempt(F("/api/system/config"), HttpMethod::PUT);
+    server.exempt(F("/api/system/config/{}"), HttpMethod::GET);
+    server.exempt(F("/api/system/config/{}"), HttpMethod::PUT);
+
+    if (_cacheStatus) {
+      // the status is expensive to collect but is often polled
+      server.cache(F("/api/system/status"), HttpMethod::GET, STATUS_CACHE_TTL, STATUS_CACHE_SIZE);
+    }
+
+    server.on(F("/api/system/status/events"), HttpMethod::GET, [this](IRequest& request, IResponse& response) {
+      toolbox::strref interval = request.arg(F("interval"));
+      response
+        .code(ResponseCode::Ok)
+        .contentType(F("text/event-stream"))
+        .header(F("Cache-Control"), F("no-cache"))
+        .sendGeneratedBody(DiagnosticsEvents{
+          _application,
+          request.arg(F("filter")),
+          interval.empty() ? DiagnosticsEvents::DEFAULT_INTERVAL : uint32_t(strtoul(interval.toString().c_str(), nullptr, 10))
+        });
+    });
   }
 };
 
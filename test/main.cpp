@@ -4,6 +4,25 @@
 
 // Include all individual test suites
 #include "test_Logger.h"
+#include "test_ChunkedResponse.h"
+#include "test_Deflate.h"
+#include "test_Router.h"
+#include "test_CoroutineComponent.h"
+#include "test_ComponentRegistry.h"
+#include "test_StaticSystem.h"
+#include "test_EventBus.h"
+#include "test_InputEvents.h"
+#include "test_Histogram.h"
+#include "test_TimingStatistics.h"
+#include "test_RateLimiter.h"
+#include "test_DiagnosticsDelta.h"
+#include "test_DiagnosticsFormats.h"
+#include "test_SystemApi.h"
+#include "test_ConnectionServer.h"
+#include "test_StaticAssets.h"
+#include "test_Allocations.h"
+
+IOT_CORE_ALLOCATION_HOOKS
 
 int main() {
   return yatest::run();
@@ -0,0 +1,137 @@
+#include <yatest/TestSuite.h>
+#include <Arduino.h>
+
+#include <memory>
+#include <vector>
+
+#include "../src/iot_core/Allocations.h"
+#include "../src/iot_core/EventBus.h"
+#include "../src/iot_core/Logger.h"
+#include "../src/iot_core/LogSinks.h"
+#include "../src/iot_core/api/ChunkedResponse.h"
+
+namespace {
+  struct AllocationTopic : iot_core::EventTopic<2u, int, 4u, 2u> {
+    static toolbox::strref name() { return "allocation"; }
+  };
+
+  /** Bytes counted for an allocation of the given size, malloc rounds up to its block size. */
+  size_t allocatedSize(size_t size) {
+#ifdef IOT_CORE_MALLOC_ALLOCATIONS
+    void* pointer = __libc_malloc(size);
+    size_t allocated = malloc_usable_size(pointer);
+    __libc_free(pointer);
+    return allocated;
+#else
+    return size;
+#endif
+  }
+
+  struct DiscardingServer {
+    bool chunkedResponseModeStart(int, const char*) { return true; }
+    bool chunkedResponseModeStart(int, const __FlashStringHelper*) { return true; }
+    void sendContent(const char*, size_t) {}
+    void chunkedResponseFinalize() {}
+    void send(int, const char*, const char*, size_t) {}
+    void send_P(int, PGM_P, PGM_P, size_t) {}
+  };
+
+  static const yatest::TestSuite& TestAllocations =
+  yatest::suite("Allocations")
+    .tests("allocations within scope are counted", [] () {
+      iot_core::AllocationCounters counters;
+      {
+        iot_core::AllocationScope scope {counters};
+        auto value = std::make_unique<uint64_t>(42u);
+        std::vector<char> buffer(100u);
+      }
+      yatest::expect(counters.count == 2u, "both allocations should be counted");
+      size_t bytes = allocatedSize(sizeof(uint64_t)) + allocatedSize(100u);
+      yatest::expect(counters.bytes == bytes, "allocated bytes should be counted");
+      yatest::expect(counters.peak == bytes, "peak should be all live bytes");
+    })
+    .tests("peak is measured relative to scope start", [] () {
+      auto outside = std::make_unique<std::vector<char>>(1000u);
+      iot_core::AllocationCounters outer;
+      iot_core::AllocationCounters inner;
+      {
+        iot_core::AllocationScope outerScope {outer};
+        {
+          std::vector<char> first(64u);
+        }
+        {
+          iot_core::AllocationScope innerScope {inner};
+          std::vector<char> second(32u);
+        }
+      }
+      yatest::expect(inner.count == 1u && inner.peak == allocatedSize(32u), "inner scope should only see its allocation");
+      yatest::expect(outer.count == 2u && outer.bytes == allocatedSize(64u) + allocatedSize(32u), "outer scope should include nested allocations");
+      yatest::expect(outer.peak == allocatedSize(64u), "outer peak should be the largest live amount");
+    })
+    .tests("statistics accumulate passes", [] () {
+      iot_core::AllocationStatistics statistics;
+      for (size_t size = 1u; size <= 3u; ++size) {
+        iot_core::AllocationScope scope {statistics};
+        std::vector<char> buffer(size * 10u);
+      }
+      yatest::expect(statistics.passes() == 3u, "all passes should be counted");
+      yatest::expect(statistics.count() == 3u, "all allocations should be counted");
+      yatest::expect(statistics.bytes() == allocatedSize(10u) + allocatedSize(20u) + allocatedSize(30u), "all bytes should be counted");
+      yatest::expect(statistics.peak() == allocatedSize(30u), "peak should be the maximum of all passes");
+      yatest::expect(statistics.last().bytes == allocatedSize(30u), "last pass should be kept");
+    })
+    .tests("log does not allocate", [] () {
+      iot_core::Time time;
+      iot_core::LogService logService {time};
+      iot_core::InMemoryLogSink sink;
+      logService.addLogSink(sink);
+      iot_core::Logger logger = logService.logger(F("test"));
+
+      iot_core::AllocationCounters counters;
+      {
+        iot_core::AllocationScope scope {counters};
+        logger.log(iot_core::LogLevel::Debug, F("filtered"));
+        logger.log(iot_core::LogLevel::Info, F("logged"));
+        logger.log(iot_core::LogLevel::Info, toolbox::format(F("formatted %u"), 42u));
+      }
+      yatest::expect(counters.count == 0u, "logging should not allocate");
+    })
+    .tests("event publishing and delivery does not allocate", [] () {
+      iot_core::EventBus bus;
+      int sum = 0;
+      bus.subscribe<AllocationTopic>([&] (const int& value) { sum += value; });
+
+      iot_core::AllocationCounters counters;
+      {
+        iot_core::AllocationScope scope {counters};
+        bus.publish<AllocationTopic>(1);
+        bus.publish<AllocationTopic>(2);
+        bus.deliver();
+      }
+      yatest::expect(sum == 3, "events should be delivered");
+      yatest::expect(counters.count == 0u, "events should not allocate");
+    })
+    .tests("chunked response does not allocate", [] () {
+      DiscardingServer server;
+      iot_core::AllocationCounters counters;
+      {
+        iot_core::AllocationScope scope {counters};
+        iot_core::api::ChunkedResponse<DiscardingServer, 16u> response {server};
+        response.begin(200, F("text/plain"));
+        response.write(F("some text longer than the buffer"));
+        response.end();
+      }
+      yatest::expect(counters.count == 0u, "response should not allocate");
+    })
+    .tests("strings are counted", [] () {
+      iot_core::AllocationCounters counters;
+      {
+        iot_core::AllocationScope scope {counters};
+        String inlined {"eleven char"};
+        String allocated {"twelve chars"};
+        const char* formatted = toolbox::format(F("formatted %u"), 42u);
+        (void) formatted;
+      }
+      yatest::expect(counters.count == 1u, "only the string longer than the inline buffer should allocate");
+    });
+}
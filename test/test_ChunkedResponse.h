@@ -0,0 +1,222 @@
+#include <yatest/TestSuite.h>
+
+#include <string>
+#include <vector>
+
+#include "../src/iot_core/api/ChunkedResponse.h"
+
+namespace {
+  struct ServerMock {
+    int _code {0};
+    std::string _contentType {};
+    std::vector<std::string> _sentContent {};
+    bool _finalized {false};
+    bool _http10 {false};
+    int _singleResponses {0};
+
+    bool chunkedResponseModeStart(int code, const char* contentType) {
+      if (_http10) {
+        return false;
+      }
+      _code = code;
+      _contentType = contentType;
+      return true;
+    }
+
+    bool chunkedResponseModeStart(int code, const __FlashStringHelper* contentType) {
+      return chunkedResponseModeStart(code, reinterpret_cast<const char*>(contentType));
+    }
+
+    void sendContent(const char* content, size_t size) {
+      _sentContent.push_back(std::string{content, size});
+    }
+
+    void chunkedResponseFinalize() { _finalized = true; }
+
+    void send(int code, const char* contentType, const char* content, size_t size) {
+      _code = code;
+      _contentType = contentType;
+      _sentContent.push_back(std::string{content, size});
+      _singleResponses += 1;
+    }
+
+    void send_P(int code, PGM_P contentType, PGM_P content, size_t size) {
+      send(code, contentType, content, size);
+    }
+  };
+
+  using ChunkedResponse = iot_core::api::ChunkedResponse<ServerMock, 10u>;
+
+  static const yatest::TestSuite& TestChunkedResponse =
+  yatest::suite("ChunkedResponse")
+    .tests("send nothing", [] () {
+      ServerMock server;
+      ChunkedResponse response {server};
+
+      yatest::expect(response.begin(123, "text/plain"), "begin should succeed");
+      yatest::expect(response.size() == 0u, "buffer should be empty");
+      yatest::expect(server._code == 123, "code should be passed on");
+      yatest::expect(server._contentType == "text/plain", "content type should be passed on");
+
+      response.end();
+      yatest::expect(server._sentContent.empty(), "nothing should be sent");
+      yatest::expect(server._finalized, "response should be finalized");
+    })
+    .tests("send data until buffer is exactly full", [] () {
+      ServerMock server;
+      ChunkedResponse response {server};
+      response.begin(200, "text/plain");
+
+      response.write("test1");
+      yatest::expect(response.size() == 5u, "data should be buffered");
+      yatest::expect(server._sentContent.empty(), "nothing should be sent yet");
+
+      response.write("test2");
+      yatest::expect(response.size() == 0u, "full buffer should be flushed");
+      yatest::expect(server._sentContent.back() == "test1test2", "full buffer should be sent");
+
+      response.end();
+      yatest::expect(server._sentContent.size() == 1u, "no empty chunk should be sent");
+      yatest::expect(server._finalized, "response should be finalized");
+    })
+    .tests("send data larger than buffer capacity", [] () {
+      ServerMock server;
+      ChunkedResponse response {server};
+      response.begin(200, "text/plain");
+
+      response.write("1");
+      response.write("12345678910");
+      yatest::expect(response.size() == 2u, "remainder should be buffered");
+      yatest::expect(server._sentContent.back() == "1123456789", "full buffer should be sent");
+
+      response.end();
+      yatest::expect(server._sentContent.back() == "10", "remainder should be sent");
+    })
+    .tests("large data is written through", [] () {
+      ServerMock server;
+      ChunkedResponse response {server};
+      response.begin(200, "text/plain");
+
+      response.write("12345678910");
+      yatest::expect(response.size() == 0u, "nothing should be buffered");
+      yatest::expect(server._sentContent.size() == 1u && server._sentContent.back() == "12345678910", "data should be sent as one chunk");
+
+      response.write("abc");
+      response.write("12345678910abcdefghij");
+      yatest::expect(server._sentContent.size() == 3u, "buffer should be filled before writing through");
+      yatest::expect(server._sentContent[1] == "abc1234567" && server._sentContent[2] == "8910abcdefghij", "remaining data should be sent as one chunk");
+      yatest::expect(response.writeThroughs() == 2u, "write throughs should be counted");
+    })
+    .tests("chunks and segments are counted", [] () {
+      ServerMock server;
+      iot_core::api::ChunkedResponse<ServerMock, 16u> response {server};
+      response.begin(200, "text/plain");
+      response.write("small");
+      response.flush();
+      response.write(std::string(iot_core::api::TCP_SEGMENT_SIZE * 2u, 'x').c_str());
+      response.end();
+      yatest::expect(response.chunks() == 2u, "chunks should be counted");
+      yatest::expect(response.segments() == 4u, "segments should be counted incl. chunk overhead");
+    })
+    .tests("segment size is not the socket option", [] () {
+      // <netinet/tcp.h> defines TCP_MSS as the number of a socket option
+      yatest::expect(iot_core::api::TCP_SEGMENT_SIZE == 1460u, "Ethernet MSS should be used on the host");
+    })
+    .tests("send data to fill buffer multiple times", [] () {
+      ServerMock server;
+      ChunkedResponse response {server};
+      response.begin(200, "text/plain");
+
+      response.write("foo");
+      response.write("bar");
+      response.write("baz");
+      response.write("xyz");
+      yatest::expect(response.size() == 2u, "remainder should be buffered");
+      yatest::expect(server._sentContent.back() == "foobarbazx", "first chunk should be sent");
+
+      response.write("qwe");
+      response.write("asd");
+      response.write("iop");
+      yatest::expect(response.size() == 1u, "remainder should be buffered");
+      yatest::expect(server._sentContent.back() == "yzqweasdio", "second chunk should be sent");
+
+      response.write('j');
+      response.end();
+      yatest::expect(server._sentContent.back() == "pj", "last chunk should be sent");
+      yatest::expect(server._finalized, "response should be finalized");
+    })
+    .tests("flush data explicitly", [] () {
+      ServerMock server;
+      ChunkedResponse response {server};
+      response.begin(200, "text/plain");
+
+      response.write("bar");
+      response.flush();
+      yatest::expect(response.size() == 0u, "buffer should be empty");
+      yatest::expect(server._sentContent.back() == "bar", "data should be sent");
+      yatest::expect(!server._finalized, "response should not be finalized");
+    })
+    .tests("clear buffer", [] () {
+      ServerMock server;
+      ChunkedResponse response {server};
+      response.begin(200, "text/plain");
+
+      response.write("foo");
+      response.clear();
+      response.write("bar");
+      response.end();
+      yatest::expect(server._sentContent.size() == 1u && server._sentContent.back() == "bar", "only new data should be sent");
+    })
+    .tests("deferred response is sent once", [] () {
+      ServerMock server;
+      ChunkedResponse response {server};
+      response.beginDeferred(201, "text/plain");
+
+      response.write("foo");
+      response.write('-');
+      response.write("barbaz");
+      yatest::expect(server._sentContent.empty(), "nothing should be sent yet");
+      yatest::expect(response.size() == 10u, "exactly full buffer should be kept");
+
+      response.end();
+      yatest::expect(server._singleResponses == 1 && server._code == 201, "single response should be sent");
+      yatest::expect(server._sentContent.size() == 1u && server._sentContent.back() == "foo-barbaz", "content should be sent at once");
+      yatest::expect(!response.chunked() && !server._finalized, "response should not be chunked");
+    })
+    .tests("deferred response is upgraded to chunked", [] () {
+      ServerMock server;
+      ChunkedResponse response {server};
+      response.beginDeferred(200, "text/plain");
+
+      response.write("1234567890");
+      response.write("abc");
+      yatest::expect(response.chunked() && server._code == 200, "chunked response should be started");
+      yatest::expect(server._sentContent.size() == 1u && server._sentContent.back() == "1234567890", "buffer should be sent as chunk");
+
+      response.write("12345678910");
+      response.end();
+      yatest::expect(server._singleResponses == 0 && server._finalized, "response should be finalized as chunked");
+      yatest::expect(server._sentContent.back() == "8910", "remainder should be sent");
+    })
+    .tests("deferred response fails to upgrade for HTTP/1.0", [] () {
+      ServerMock server;
+      server._http10 = true;
+      ChunkedResponse response {server};
+      response.beginDeferred(200, "text/plain");
+
+      yatest::expect(response.write("12345678") == 8u, "content should be buffered");
+      yatest::expect(response.write("abcdef") == 2u, "only buffered content should be accepted");
+      yatest::expect(!response.valid() && response.failed(), "response should fail");
+      response.end();
+      yatest::expect(server._sentContent.empty(), "nothing should be sent");
+    })
+    .tests("nothing written after end", [] () {
+      ServerMock server;
+      ChunkedResponse response {server};
+      response.begin(200, "text/plain");
+      response.end();
+
+      yatest::expect(response.write("foo") == 0u, "write should fail");
+      yatest::expect(!response.valid(), "response should be invalid");
+    });
+}
@@ -0,0 +1,76 @@
+#include <yatest/TestSuite.h>
+#include <Arduino.h>
+
+#include "../src/iot_core/ComponentRegistry.h"
+#include "../src/iot_core/System.h"
+
+namespace {
+  class NamedComponent final : public iot_core::IApplicationComponent {
+    const char* _name;
+
+  public:
+    int setups = 0;
+    int loops = 0;
+
+    explicit NamedComponent(const char* name) : _name(name) {}
+
+    toolbox::strref name() const override { return _name; }
+    bool configure(const toolbox::strref&, const toolbox::strref&) override { return false; }
+    void getConfig(iot_core::ConfigWriter) const override {}
+    void setup(bool) override { setups += 1; }
+    void loop(iot_core::ConnectionStatus) override { loops += 1; }
+    void getDiagnostics(iot_core::IDiagnosticsCollector&) const override {}
+  };
+
+  static const yatest::TestSuite& TestComponentRegistry =
+  yatest::suite("ComponentRegistry")
+    .tests("handles resolve to components in order", [] () {
+      iot_core::ComponentRegistry registry;
+      NamedComponent a {"a"};
+      NamedComponent b {"b"};
+      iot_core::ComponentHandle first = registry.add(&a);
+      iot_core::ComponentHandle second = registry.add(&b);
+      yatest::expect(first.index == 0u && second.index == 1u, "handles should be indices");
+      yatest::expect(registry.get(first) == &a && registry.get(second) == &b, "handles should resolve");
+      yatest::expect(registry.get(iot_core::INVALID_COMPONENT_HANDLE) == nullptr, "invalid handle should not resolve");
+    })
+    .tests("names with colliding hashes are found", [] () {
+      yatest::expect(iot_core::hashComponentName("costarring") == iot_core::hashComponentName("liquid"), "names should collide");
+      iot_core::ComponentRegistry registry;
+      NamedComponent a {"costarring"};
+      NamedComponent b {"liquid"};
+      NamedComponent c {"other"};
+      registry.add(&a);
+      registry.add(&b);
+      registry.add(&c);
+      yatest::expect(registry.find("costarring") == &a && registry.find("liquid") == &b && registry.find("other") == &c, "names should be resolved");
+      yatest::expect(registry.find("unknown") == nullptr, "unknown name should not be found");
+    })
+    .tests("duplicate names are rejected", [] () {
+      iot_core::ComponentRegistry registry;
+      NamedComponent a {"a"};
+      NamedComponent duplicate {"a"};
+      registry.add(&a);
+      yatest::expect(!registry.add(&duplicate).valid(), "duplicate should be rejected");
+      yatest::expect(registry.size() == 1u && registry.find("a") == &a, "first component should be kept");
+    })
+    .tests("component added after setup is set up and looped", [] () {
+      host::TemporaryFileSystem fileSystem;
+      gpiobj::DigitalOutput statusLed {2u, false};
+      gpiobj::DigitalInput otaEnable {false};
+      gpiobj::DigitalInput update {false};
+      gpiobj::DigitalInput factoryReset {false};
+      gpiobj::DigitalInput debugEnable {false};
+      iot_core::VersionInfo version {"0000000", "0.0.0"};
+      iot_core::System system {"test", version, "", statusLed, otaEnable, update, factoryReset, debugEnable};
+      NamedComponent early {"early"};
+      NamedComponent late {"late"};
+      system.addComponent(&early);
+      system.setup();
+      WiFi.setStatus(WL_CONNECTED);
+
+      yatest::expect(system.addComponent(&late).valid(), "late component should be added");
+      system.loop();
+      yatest::expect(late.setups == 1 && late.loops == 1 && early.loops == 1, "late component should be set up and looped");
+    });
+}
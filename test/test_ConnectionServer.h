@@ -0,0 +1,229 @@
+#include <yatest/TestSuite.h>
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiClient.h>
+
+#include <string>
+
+#include "../src/iot_core/System.h"
+#include "../src/iot_core/api/ConnectionServer.h"
+#include "../src/iot_core/api/SystemApi.h"
+
+namespace {
+  void connectionEchoRoute(void* /*context*/, iot_core::api::IRequest& request, iot_core::api::IResponse& response) {
+    response.code(iot_core::api::ResponseCode::Ok).sendSingleBody().write(toolbox::format("echo:%s:%s", request.pathArg(0).cstr(), request.arg(F("q")).cstr()));
+  }
+
+  void connectionSlowRoute(void* /*context*/, iot_core::api::IRequest& /*request*/, iot_core::api::IResponse& response) {
+    host::advanceTimeMs(30); // longer than the loop budget
+    response.code(iot_core::api::ResponseCode::Ok).sendSingleBody().write(F("slow"));
+  }
+
+  void connectionLargeRoute(void* /*context*/, iot_core::api::IRequest& /*request*/, iot_core::api::IResponse& response) {
+    response.code(iot_core::api::ResponseCode::Ok).sendSingleBody().write(std::string(3000u, 'x').c_str());
+  }
+
+  static const char CONNECTION_ECHO_PATH[] PROGMEM = "/api/echo/{}";
+  static const char CONNECTION_SLOW_PATH[] PROGMEM = "/api/slow";
+  static const char CONNECTION_LARGE_PATH[] PROGMEM = "/api/large";
+
+  static const iot_core::api::StaticRoute CONNECTION_TEST_ROUTES[] PROGMEM = {
+    {CONNECTION_ECHO_PATH, iot_core::api::methodMask(iot_core::api::HttpMethod::GET), connectionEchoRoute},
+    {CONNECTION_SLOW_PATH, iot_core::api::methodMask(iot_core::api::HttpMethod::GET), connectionSlowRoute},
+    {CONNECTION_LARGE_PATH, iot_core::api::methodMask(iot_core::api::HttpMethod::GET), connectionLargeRoute},
+  };
+
+  /**
+   * Runs a system with the connection server on a local port, clients are
+   * served concurrently in the same thread by looping the system.
+   */
+  struct ConnectionServerFixture {
+    host::TemporaryFileSystem fileSystem;
+    gpiobj::DigitalOutput statusLed {2u, false};
+    gpiobj::DigitalInput otaEnable {false};
+    gpiobj::DigitalInput update {false};
+    gpiobj::DigitalInput factoryReset {false};
+    gpiobj::DigitalInput debugEnable {false};
+    iot_core::VersionInfo version {"0000000", "0.0.0"};
+    uint16_t port = host::freeLocalPort();
+
+    iot_core::System system {"test", version, "", statusLed, otaEnable, update, factoryReset, debugEnable};
+    iot_core::api::ConnectionServer server {system, port};
+    iot_core::api::SystemApi systemApi {system, system};
+
+    ConnectionServerFixture() {
+      server.addProvider(&systemApi);
+      server.on(CONNECTION_TEST_ROUTES, 3u, nullptr);
+      system.addComponent(&server);
+      system.setup();
+
+      host::advanceTimeMs(1000);
+      WiFi.setStatus(WL_DISCONNECTED);
+      system.loop();
+      host::advanceTimeMs(1000);
+      WiFi.setStatus(WL_CONNECTED);
+      system.loop();
+    }
+
+    WiFiClient connect() {
+      WiFiClient client;
+      client.connect(host::LOOPBACK, port);
+      return client;
+    }
+
+    /**
+     * Reads the next complete response (with a Content-Length or chunked),
+     * looping the system until it is received.
+     */
+    std::string response(WiFiClient& client) {
+      std::string response;
+      for (int i = 0; i < 1000; ++i) {
+        while (client.available() > 0) {
+          response += char(client.read());
+        }
+        size_t headEnd = response.find("\r\n\r\n");
+        if (headEnd != std::string::npos) {
+          size_t length = response.find("Content-Length: ");
+          if (length < headEnd && response.size() >= headEnd + 4u + std::stoul(response.substr(length + 16u))) {
+            return response;
+          }
+          if (length > headEnd && response.compare(response.size() - 5u, 5u, "0\r\n\r\n") == 0) {
+            return response;
+          }
+        }
+        system.loop();
+      }
+      return response;
+    }
+
+    std::string request(WiFiClient& client, const char* path, const char* headers = "") {
+      client.print(toolbox::format("GET %s HTTP/1.1\r\nHost: localhost\r\n%s\r\n", path, headers));
+      return response(client);
+    }
+  };
+
+  static const yatest::TestSuite& TestConnectionServer =
+  yatest::suite("ConnectionServer")
+    .tests("connection is kept alive", [] () {
+      ConnectionServerFixture fixture;
+      WiFiClient client = fixture.connect();
+      std::string first = fixture.request(client, "/api/echo/a?q=1%202");
+      std::string second = fixture.request(client, "/api/echo/b");
+      yatest::expect(first.rfind("HTTP/1.1 200", 0u) == 0u && first.find("Connection: keep-alive\r\n") != std::string::npos, first.c_str());
+      yatest::expect(first.find("\r\n\r\necho:a:1 2") != std::string::npos, "first response should be sent");
+      yatest::expect(second.find("\r\n\r\necho:b:") != std::string::npos, "second response should be sent on the same connection");
+
+      std::string status = fixture.request(client, "/api/system/status");
+      yatest::expect(status.find("\"accepted\":\"1\",\"reused\":\"2\"") != std::string::npos, "connection should be reused");
+    })
+    .tests("pipelined requests are answered in order", [] () {
+      ConnectionServerFixture fixture;
+      WiFiClient client = fixture.connect();
+      client.print(F("GET /api/echo/a HTTP/1.1\r\n\r\nGET /api/echo/b HTTP/1.1\r\n\r\nGET /api/echo/c HTTP/1.1\r\nConnection: close\r\n\r\n"));
+      std::string responses;
+      for (int i = 0; i < 100 && (client.connected() || client.available() > 0); ++i) {
+        fixture.system.loop();
+        while (client.available() > 0) {
+          responses += char(client.read());
+        }
+      }
+      size_t a = responses.find("echo:a:");
+      size_t b = responses.find("echo:b:");
+      size_t c = responses.find("echo:c:");
+      yatest::expect(a < b && b < c && c != std::string::npos, responses.c_str());
+      yatest::expect(responses.find("Connection: close\r\n") < c, "last response should close the connection");
+      yatest::expect(!client.connected(), "connection should be closed");
+    })
+    .tests("slow client does not block others", [] () {
+      ConnectionServerFixture fixture;
+      WiFiClient slow = fixture.connect();
+      slow.print(F("GET /api/echo/slow HTTP/1.1\r\nHost: loc"));
+      fixture.system.loop();
+
+      WiFiClient other = fixture.connect();
+      std::string response = fixture.request(other, "/api/echo/other");
+      yatest::expect(response.find("echo:other:") != std::string::npos, "other client should be served");
+      yatest::expect(slow.available() == 0, "slow client should still be pending");
+
+      slow.print(F("alhost\r\n\r\n"));
+      response = fixture.response(slow);
+      yatest::expect(response.find("echo:slow:") != std::string::npos, "slow client should be served once complete");
+    })
+    .tests("idle connection is closed", [] () {
+      ConnectionServerFixture fixture;
+      WiFiClient client = fixture.connect();
+      fixture.request(client, "/api/echo/a");
+      fixture.system.loop();
+      yatest::expect(client.connected(), "connection should be kept alive");
+      host::advanceTimeMs(iot_core::api::ConnectionServer::DEFAULT_IDLE_TIMEOUT);
+      fixture.system.loop();
+      yatest::expect(!client.connected(), "idle connection should be closed");
+    })
+    .tests("loop budget defers connections", [] () {
+      ConnectionServerFixture fixture;
+      WiFiClient first = fixture.connect();
+      WiFiClient second = fixture.connect();
+      first.print(F("GET /api/slow HTTP/1.1\r\n\r\n"));
+      second.print(F("GET /api/slow HTTP/1.1\r\n\r\n"));
+      while (first.available() == 0 && second.available() == 0) {
+        fixture.system.loop();
+      }
+      yatest::expect((first.available() > 0) != (second.available() > 0), "only one request should be handled in the loop");
+      yatest::expect(fixture.response(first).find("slow") != std::string::npos && fixture.response(second).find("slow") != std::string::npos, "both requests should be handled");
+    })
+    .tests("invalid request is rejected", [] () {
+      ConnectionServerFixture fixture;
+      WiFiClient client = fixture.connect();
+      client.print(F("BREW /pot HTTP/1.1\r\n\r\n"));
+      std::string response = fixture.response(client);
+      yatest::expect(response.rfind("HTTP/1.1 501", 0u) == 0u && response.find("Connection: close\r\n") != std::string::npos, response.c_str());
+      fixture.system.loop();
+      yatest::expect(!client.connected(), "connection should be closed");
+    })
+    .tests("invalid content length is rejected", [] () {
+      ConnectionServerFixture fixture;
+      const std::pair<const char*, const char*> cases[] = {
+        {"18446744073709551615", "HTTP/1.1 413"},
+        {"99999999999999999999999", "HTTP/1.1 413"},
+        {"65537", "HTTP/1.1 413"},
+        {"-1", "HTTP/1.1 400"},
+        {"1x", "HTTP/1.1 400"},
+        {"4\r\nContent-Length: 5", "HTTP/1.1 400"},
+      };
+      for (const auto& [value, status] : cases) {
+        WiFiClient client = fixture.connect();
+        client.print(toolbox::format("PUT /api/system/config HTTP/1.1\r\nContent-Length: %s\r\n\r\nabcd", value));
+        std::string response = fixture.response(client);
+        yatest::expect(response.rfind(status, 0u) == 0u, (std::string(value) + ": " + response).c_str());
+      }
+    })
+    .tests("request body is read", [] () {
+      ConnectionServerFixture fixture;
+      WiFiClient client = fixture.connect();
+      std::string body = "api.compression=false;" + std::string(2000u, '\n');
+      client.print(toolbox::format("PUT /api/system/config HTTP/1.1\r\nContent-Length: %u\r\n\r\n", unsigned(body.size())));
+      client.write(body.data(), body.size());
+      std::string response = fixture.response(client);
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u && response.find("api.compression=false;") != std::string::npos, response.c_str());
+      response = fixture.request(client, "/api/echo/next");
+      yatest::expect(response.find("echo:next:") != std::string::npos, "connection should be usable after a large body");
+    })
+    .tests("large single body is sent to HTTP/1.0 clients", [] () {
+      ConnectionServerFixture fixture;
+      WiFiClient client = fixture.connect();
+      client.print(F("GET /api/large HTTP/1.0\r\nConnection: keep-alive\r\n\r\n"));
+      std::string response;
+      for (int i = 0; i < 100 && (client.connected() || client.available() > 0); ++i) {
+        fixture.system.loop();
+        while (client.available() > 0) {
+          response += char(client.read());
+        }
+      }
+      size_t body = response.find("\r\n\r\n") + 4u;
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u && response.find("Connection: close\r\n") < body, response.substr(0u, body).c_str());
+      yatest::expect(response.find("Content-Length") > body && response.find("Transfer-Encoding") > body, "body should be delimited by closing the connection");
+      yatest::expect(response.compare(body, std::string::npos, std::string(3000u, 'x')) == 0, "body should be sent without framing");
+      yatest::expect(!client.connected(), "connection should be closed");
+    })
+    ;
+}
@@ -0,0 +1,183 @@
+#include <yatest/TestSuite.h>
+#include <Arduino.h>
+
+#include <string>
+#include <vector>
+
+#include "../src/iot_core/CoroutineComponent.h"
+#include "../src/iot_core/System.h"
+
+#ifdef IOT_CORE_COROUTINES_AVAILABLE
+
+namespace {
+  using Events = std::vector<std::string>;
+
+  class TestComponent : public iot_core::CoroutineComponent {
+  protected:
+    Events& _events;
+    const char* _name;
+
+    void event(const char* what) {
+      _events.push_back(std::string(_name) + ":" + what);
+    }
+
+  public:
+    TestComponent(Events& events, const char* name) : _events(events), _name(name) {}
+
+    toolbox::strref name() const override { return _name; }
+    bool configure(const toolbox::strref&, const toolbox::strref&) override { return false; }
+    void getConfig(iot_core::ConfigWriter) const override {}
+    void setup(bool) override {}
+    void getDiagnostics(iot_core::IDiagnosticsCollector&) const override {}
+  };
+
+  class SteppingComponent final : public TestComponent {
+  public:
+    using TestComponent::TestComponent;
+
+    iot_core::ComponentTask run() override {
+      event("1");
+      co_await nextLoop();
+      event("2");
+      co_await nextLoop();
+      event("3");
+    }
+  };
+
+  class SleepingComponent final : public TestComponent {
+  public:
+    using TestComponent::TestComponent;
+
+    iot_core::ComponentTask run() override {
+      event("sleep");
+      co_await sleepFor(100u);
+      event("wake");
+      co_await nextLoop();
+    }
+  };
+
+  class ConnectingComponent final : public TestComponent {
+  public:
+    using TestComponent::TestComponent;
+
+    iot_core::ComponentTask run() override {
+      event("wait");
+      co_await connected();
+      event("connected");
+      co_await connected();
+      event("still connected");
+      co_await nextLoop();
+    }
+  };
+
+  class LargeFrameComponent final : public TestComponent {
+  public:
+    using TestComponent::TestComponent;
+
+    iot_core::ComponentTask run() override {
+      char buffer[2u * IOT_CORE_COROUTINE_FRAME_SIZE] = {};
+      event("started");
+      co_await nextLoop();
+      event(buffer);
+    }
+  };
+
+  std::string join(const Events& events) {
+    std::string result;
+    for (auto& event : events) {
+      result += event;
+      result += ' ';
+    }
+    return result;
+  }
+
+  static const yatest::TestSuite& TestCoroutineComponent =
+  yatest::suite("CoroutineComponent")
+    .tests("runs until first suspension on first loop", [] () {
+      Events events;
+      SteppingComponent a {events, "a"};
+      a.loop(iot_core::ConnectionStatus::Connected);
+      yatest::expect(join(events) == "a:1 ", join(events).c_str());
+    })
+    .tests("components are resumed in loop order", [] () {
+      Events events;
+      SteppingComponent a {events, "a"};
+      SteppingComponent b {events, "b"};
+      for (int i = 0; i < 3; ++i) {
+        a.loop(iot_core::ConnectionStatus::Connected);
+        b.loop(iot_core::ConnectionStatus::Connected);
+      }
+      yatest::expect(join(events) == "a:1 b:1 a:2 b:2 a:3 b:3 ", join(events).c_str());
+    })
+    .tests("routine is restarted after it finished", [] () {
+      Events events;
+      SteppingComponent a {events, "a"};
+      for (int i = 0; i < 4; ++i) {
+        a.loop(iot_core::ConnectionStatus::Connected);
+      }
+      yatest::expect(join(events) == "a:1 a:2 a:3 a:1 ", join(events).c_str());
+    })
+    .tests("sleep resumes only after virtual time passed", [] () {
+      Events events;
+      SleepingComponent a {events, "a"};
+      a.loop(iot_core::ConnectionStatus::Connected);
+      host::advanceTimeMs(50);
+      a.loop(iot_core::ConnectionStatus::Connected);
+      yatest::expect(join(events) == "a:sleep ", join(events).c_str());
+      host::advanceTimeMs(49);
+      a.loop(iot_core::ConnectionStatus::Connected);
+      yatest::expect(join(events) == "a:sleep ", join(events).c_str());
+      host::advanceTimeMs(1);
+      a.loop(iot_core::ConnectionStatus::Connected);
+      yatest::expect(join(events) == "a:sleep a:wake ", join(events).c_str());
+    })
+    .tests("connected waits for connection and continues if already connected", [] () {
+      Events events;
+      ConnectingComponent a {events, "a"};
+      a.loop(iot_core::ConnectionStatus::Disconnected);
+      a.loop(iot_core::ConnectionStatus::Disconnecting);
+      yatest::expect(join(events) == "a:wait ", join(events).c_str());
+      a.loop(iot_core::ConnectionStatus::Reconnected);
+      yatest::expect(join(events) == "a:wait a:connected a:still connected ", join(events).c_str());
+    })
+    .tests("frames are allocated from and returned to the pool", [] () {
+      Events events;
+      size_t usedBefore = iot_core::g_coroutineFrames.used();
+      {
+        SteppingComponent a {events, "a"};
+        a.loop(iot_core::ConnectionStatus::Connected);
+        yatest::expect(iot_core::g_coroutineFrames.used() == usedBefore + 1u, "frame should be taken from pool");
+      }
+      yatest::expect(iot_core::g_coroutineFrames.used() == usedBefore, "frame should be returned to pool");
+    })
+    .tests("frame larger than a block is logged once", [] () {
+      host::TemporaryFileSystem fileSystem;
+      gpiobj::DigitalOutput statusLed {2u, false};
+      gpiobj::DigitalInput otaEnable {false};
+      gpiobj::DigitalInput update {false};
+      gpiobj::DigitalInput factoryReset {false};
+      gpiobj::DigitalInput debugEnable {false};
+      iot_core::VersionInfo version {"0000000", "0.0.0"};
+      iot_core::System system {"test", version, "", statusLed, otaEnable, update, factoryReset, debugEnable};
+      Events events;
+      LargeFrameComponent a {events, "a"};
+      system.addComponent(&a);
+      system.setup();
+      WiFi.setStatus(WL_CONNECTED);
+
+      size_t failedBefore = iot_core::g_coroutineFrames.failed();
+      for (int i = 0; i < 3; ++i) {
+        system.loop();
+      }
+      yatest::expect(events.empty(), "component should not run");
+      yatest::expect(iot_core::g_coroutineFrames.failed() == failedBefore + 3u && iot_core::g_coroutineFrames.failedSize() > IOT_CORE_COROUTINE_FRAME_SIZE, "failures should be counted");
+
+      size_t logged = 0u;
+      system.localLogSink().output([&] (const char* entry) {
+        logged += strstr(entry, "Coroutine frame of") != nullptr ? 1u : 0u;
+      });
+      yatest::expect(logged == 1u, "failure should be logged once");
+    });
+}
+
+#endif
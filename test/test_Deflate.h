@@ -0,0 +1,151 @@
+#include <yatest/TestSuite.h>
+
+#include <memory>
+#include <string>
+
+#include "../src/iot_core/api/Deflate.h"
+#include "../src/iot_core/api/ChunkedResponse.h"
+
+#if IOT_CORE_HOST_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+  using iot_core::api::ContentEncoding;
+
+  void appendOutput(void* context, const char* data, size_t size) {
+    static_cast<std::string*>(context)->append(data, size);
+  }
+
+  std::string compress(ContentEncoding encoding, const std::string& input, size_t pieceSize) {
+    auto encoder = std::make_unique<iot_core::api::DeflateEncoder>();
+    std::string output;
+    encoder->begin(encoding, appendOutput, &output);
+    for (size_t offset = 0u; offset < input.size(); offset += pieceSize) {
+      std::string piece = input.substr(offset, pieceSize);
+      encoder->write(toolbox::strref(piece.c_str(), piece.size()));
+    }
+    encoder->end();
+    yatest::expect(encoder->bytesIn() == input.size(), "all input should be counted");
+    yatest::expect(encoder->bytesOut() == output.size(), "all output should be counted");
+    return output;
+  }
+
+  std::string jsonInput() {
+    std::string json = "[";
+    for (int i = 0; i < 200; ++i) {
+      json += "{\"name\":\"component" + std::to_string(i % 7) + "\",\"count\":\"" + std::to_string(i * 37) + "\",\"logLevel\":\"info\"},";
+    }
+    json += "{}]";
+    return json;
+  }
+
+  std::string randomInput(size_t size) {
+    std::string input;
+    uint32_t state = 12345u;
+    for (size_t i = 0u; i < size; ++i) {
+      state = state * 1103515245u + 12345u;
+      input += char(state >> 16);
+    }
+    return input;
+  }
+
+#if IOT_CORE_HOST_ZLIB
+  std::string inflate(const std::string& compressed, int windowBits) {
+    z_stream stream {};
+    if (inflateInit2(&stream, windowBits) != Z_OK) {
+      return "<init failed>";
+    }
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+    stream.avail_in = uInt(compressed.size());
+    std::string output;
+    char buffer[1024];
+    int result = Z_OK;
+    while (result == Z_OK) {
+      stream.next_out = reinterpret_cast<Bytef*>(buffer);
+      stream.avail_out = sizeof(buffer);
+      result = ::inflate(&stream, Z_NO_FLUSH);
+      output.append(buffer, sizeof(buffer) - stream.avail_out);
+    }
+    inflateEnd(&stream);
+    return result == Z_STREAM_END && stream.avail_in == 0u ? output : "<inflate failed>";
+  }
+
+  void expectRoundTrip(const std::string& input, size_t pieceSize) {
+    std::string gzip = compress(ContentEncoding::Gzip, input, pieceSize);
+    yatest::expect(inflate(gzip, 16 + 15) == input, "gzip should be decompressed by zlib");
+    std::string deflate = compress(ContentEncoding::Deflate, input, pieceSize);
+    // the zlib header declares the smallest window that suffices
+    yatest::expect(inflate(deflate, IOT_CORE_DEFLATE_WINDOW_BITS + 1) == input, "deflate should be decompressed by zlib");
+  }
+#endif
+
+  struct CollectingServer {
+    std::string content {};
+    bool chunkedResponseModeStart(int, const char*) { return true; }
+    bool chunkedResponseModeStart(int, const __FlashStringHelper*) { return true; }
+    void sendContent(const char* data, size_t size) { content.append(data, size); }
+    void chunkedResponseFinalize() {}
+    void send(int, const char*, const char*, size_t) {}
+    void send_P(int, PGM_P, PGM_P, size_t) {}
+  };
+
+  static const yatest::TestSuite& TestDeflate =
+  yatest::suite("Deflate")
+    .tests("content encoding is negotiated", [] () {
+      yatest::expect(iot_core::api::negotiateContentEncoding("gzip, deflate, br") == ContentEncoding::Gzip, "gzip should be preferred");
+      yatest::expect(iot_core::api::negotiateContentEncoding("br;q=1.0, deflate") == ContentEncoding::Deflate, "deflate should be accepted");
+      yatest::expect(iot_core::api::negotiateContentEncoding("gzip;q=0, deflate;q=0.5") == ContentEncoding::Deflate, "rejected coding should be skipped");
+      yatest::expect(iot_core::api::negotiateContentEncoding("") == ContentEncoding::Identity, "no header should mean identity");
+      yatest::expect(iot_core::api::negotiateContentEncoding("br") == ContentEncoding::Identity, "unknown codings should mean identity");
+      yatest::expect(iot_core::api::negotiateContentEncoding("gzip;q=0.0, deflate") == ContentEncoding::Deflate, "q=0.0 should refuse");
+      yatest::expect(iot_core::api::negotiateContentEncoding("gzip; q=0.000") == ContentEncoding::Identity, "q=0.000 should refuse");
+      yatest::expect(iot_core::api::negotiateContentEncoding("*") == ContentEncoding::Gzip, "any should accept gzip");
+      yatest::expect(iot_core::api::negotiateContentEncoding("gzip;q=0, *") == ContentEncoding::Deflate, "any should not apply to listed codings");
+      yatest::expect(iot_core::api::negotiateContentEncoding("*;q=0") == ContentEncoding::Identity, "any refused should fall back to identity");
+      yatest::expect(iot_core::api::negotiateContentEncoding("identity;q=0, deflate;q=0.1") == ContentEncoding::Deflate, "refused identity should select a coding");
+      yatest::expect(iot_core::api::negotiateContentEncoding("gzip;q=0.5, identity") == ContentEncoding::Identity, "preferred identity should be selected");
+      yatest::expect(iot_core::api::negotiateContentEncoding("deflate;q=0.9, gzip;q=0.8") == ContentEncoding::Deflate, "higher quality should be selected");
+    })
+    .tests("repetitive text is compressed", [] () {
+      std::string input = jsonInput();
+      std::string output = compress(ContentEncoding::Gzip, input, 100u);
+      yatest::expect(output.size() * 4u < input.size(), "JSON should be compressed at least 4:1");
+    })
+    .tests("compression time does not saturate", [] () {
+      iot_core::api::CompressionStatistics statistics;
+      for (uint32_t i = 0u; i < 100000u; ++i) {
+        statistics.record(100u, 20u, 10000u);
+      }
+      for (uint32_t i = 0u; i < 1000u; ++i) {
+        statistics.record(100u, 20u, 1000000u);
+      }
+      yatest::expect(statistics.cpuTime().percentile(99.0f) < 1000u, "p99 should reflect all responses");
+    })
+#if IOT_CORE_HOST_ZLIB
+    .tests("output is decompressed by zlib", [] () {
+      expectRoundTrip("", 1u);
+      expectRoundTrip("a", 1u);
+      expectRoundTrip("hello hello hello hello", 3u);
+      expectRoundTrip(std::string(5000u, 'x'), 700u);
+      expectRoundTrip(jsonInput(), 1u);
+      expectRoundTrip(jsonInput(), 333u);
+      expectRoundTrip(jsonInput(), 100000u);
+      expectRoundTrip(randomInput(5000u), 512u);
+    })
+    .tests("chunked response is compressed", [] () {
+      CollectingServer server;
+      auto encoder = std::make_unique<iot_core::api::DeflateEncoder>();
+      std::string input = jsonInput();
+      {
+        iot_core::api::ChunkedResponse<CollectingServer, 64u> response {server};
+        response.begin(200, "application/json", encoder.get(), ContentEncoding::Gzip);
+        yatest::expect(response.encoded(), "response should be encoded");
+        response.write(toolbox::strref(input.c_str(), input.size()));
+        response.write('!');
+      }
+      yatest::expect(inflate(server.content, 16 + 15) == input + "!", "response should be decompressed by zlib");
+    })
+#endif
+    ;
+}
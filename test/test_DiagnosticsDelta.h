@@ -0,0 +1,139 @@
+#include <yatest/TestSuite.h>
+
+#include <functional>
+#include <string>
+
+#include "../src/iot_core/api/DiagnosticsDelta.h"
+
+namespace {
+  struct StringOutput final : public toolbox::IOutput {
+    std::string content;
+
+    size_t write(const toolbox::strref& string) override {
+      content.append(string.cstr(), string.length());
+      return string.length();
+    }
+
+    size_t write(char c) override {
+      content += c;
+      return 1u;
+    }
+  };
+
+  struct TestDiagnostics final : public iot_core::IDiagnosticsProvider {
+    std::string count = "1";
+    std::string heap = "100";
+    bool extra = false;
+
+    void getDiagnostics(iot_core::IDiagnosticsCollector& collector) const override {
+      collector.beginSection(F("api"));
+      collector.beginSection(F("calls"));
+      collector.addValue(F("count"), count.c_str());
+      collector.endSection();
+      collector.beginSection(F("routes"));
+      collector.addValue(F("total"), "2");
+      collector.endSection();
+      collector.endSection();
+      collector.beginSection(F("system"));
+      if (extra) {
+        collector.addValue(F("extra"), "x");
+      }
+      collector.addValue(F("heap"), heap.c_str());
+      collector.endSection();
+    }
+  };
+
+  std::string collect(const TestDiagnostics& diagnostics, iot_core::api::DiagnosticsSnapshot& snapshot, const char* filter, bool full) {
+    StringOutput output;
+    auto writer = jsons::makeWriter(output);
+    iot_core::api::DiagnosticsDeltaCollector collector {writer, snapshot, filter, full};
+    diagnostics.getDiagnostics(collector);
+    collector.end();
+    writer.end();
+    return output.content;
+  }
+
+  /**
+   * Collects in passes of one value each, the diagnostics may be changed
+   * before each pass.
+   */
+  std::string collectInPasses(TestDiagnostics& diagnostics, iot_core::api::DiagnosticsSnapshot& snapshot, size_t& passes, std::function<void(size_t)> change = nullptr) {
+    StringOutput output;
+    auto writer = jsons::makeWriter(output);
+    iot_core::api::DiagnosticsDeltaCollector collector {writer, snapshot, "", true};
+    collector.limit(1u);
+    passes = 0u;
+    do {
+      if (change) {
+        change(passes);
+      }
+      collector.resume();
+      diagnostics.getDiagnostics(collector);
+      passes += 1u;
+    } while (collector.stopped());
+    collector.end();
+    writer.end();
+    return output.content;
+  }
+
+  static const yatest::TestSuite& TestDiagnosticsDelta =
+  yatest::suite("DiagnosticsDelta")
+    .tests("only changed values are collected", [] () {
+      TestDiagnostics diagnostics;
+      iot_core::api::DiagnosticsSnapshot snapshot;
+      std::string full = collect(diagnostics, snapshot, "", true);
+      yatest::expect(full == R"({"api":{"calls":{"count":"1"},"routes":{"total":"2"}},"system":{"heap":"100"}})", full.c_str());
+      yatest::expect(snapshot.size() == 3u, "snapshot should have an entry per value");
+
+      std::string unchanged = collect(diagnostics, snapshot, "", false);
+      yatest::expect(unchanged == "{}", unchanged.c_str());
+
+      diagnostics.count = "2";
+      std::string delta = collect(diagnostics, snapshot, "", false);
+      yatest::expect(delta == R"({"api":{"calls":{"count":"2"}}})", delta.c_str());
+    })
+    .tests("new values are collected", [] () {
+      TestDiagnostics diagnostics;
+      iot_core::api::DiagnosticsSnapshot snapshot;
+      collect(diagnostics, snapshot, "", true);
+      diagnostics.extra = true;
+      std::string delta = collect(diagnostics, snapshot, "", false);
+      yatest::expect(delta == R"({"system":{"extra":"x"}})", delta.c_str());
+      diagnostics.heap = "50";
+      delta = collect(diagnostics, snapshot, "", false);
+      yatest::expect(delta == R"({"system":{"heap":"50"}})", delta.c_str());
+    })
+    .tests("values are filtered by path", [] () {
+      TestDiagnostics diagnostics;
+      iot_core::api::DiagnosticsSnapshot snapshot;
+      std::string full = collect(diagnostics, snapshot, "api/calls,system/heap,api/rout", true);
+      yatest::expect(full == R"({"api":{"calls":{"count":"1"}},"system":{"heap":"100"}})", full.c_str());
+      yatest::expect(snapshot.size() == 2u, "only filtered values should be kept");
+      diagnostics.count = "2";
+      diagnostics.heap = "50";
+      std::string delta = collect(diagnostics, snapshot, "system", false);
+      yatest::expect(delta == R"({"system":{"heap":"50"}})", delta.c_str());
+    })
+    .tests("values are collected in passes", [] () {
+      TestDiagnostics diagnostics;
+      iot_core::api::DiagnosticsSnapshot snapshot;
+      size_t passes;
+      std::string full = collectInPasses(diagnostics, snapshot, passes);
+      yatest::expect(full == R"({"api":{"calls":{"count":"1"},"routes":{"total":"2"}},"system":{"heap":"100"}})", full.c_str());
+      yatest::expect(passes == 3u, "each pass should write one value");
+      yatest::expect(snapshot.size() == 3u, "snapshot should have an entry per value");
+    })
+    .tests("passes end early when the structure changes", [] () {
+      TestDiagnostics diagnostics;
+      iot_core::api::DiagnosticsSnapshot snapshot;
+      size_t passes;
+      std::string full = collectInPasses(diagnostics, snapshot, passes, [&] (size_t pass) {
+        diagnostics.extra = pass == 1u; // the value to continue with is gone in the third pass
+      });
+      yatest::expect(full == R"({"api":{"calls":{"count":"1"},"routes":{"total":"2"}}})", full.c_str());
+      yatest::expect(passes == 3u, "collection should end at the changed value");
+      std::string delta = collect(diagnostics, snapshot, "", false);
+      yatest::expect(delta == R"({"system":{"heap":"100"}})", delta.c_str());
+    })
+    ;
+}
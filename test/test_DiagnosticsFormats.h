@@ -0,0 +1,69 @@
+#include <yatest/TestSuite.h>
+
+#include <string>
+
+#include "../src/iot_core/api/CborDiagnosticsCollector.h"
+#include "../src/iot_core/api/CsvDiagnosticsCollector.h"
+#include "../src/iot_core/api/Negotiation.h"
+
+namespace {
+  struct FormatOutput final : public toolbox::IOutput {
+    std::string content;
+
+    size_t write(const toolbox::strref& string) override {
+      content.append(string.cstr(), string.length());
+      return string.length();
+    }
+
+    size_t write(char c) override {
+      content += c;
+      return 1u;
+    }
+  };
+
+  void collectFormatDiagnostics(iot_core::IDiagnosticsCollector& collector) {
+    collector.beginSection(F("api"));
+    collector.addNumber(F("count"), 500u);
+    collector.addValue(F("name"), "a, \"b\"");
+    collector.endSection();
+    collector.addNumber(F("zero"), 0u);
+    collector.addValue(F("text"), "42");
+  }
+
+  static const yatest::TestSuite& TestDiagnosticsFormats =
+  yatest::suite("DiagnosticsFormats")
+    .tests("content type is negotiated", [] () {
+      using iot_core::api::ContentType;
+      auto negotiate = [] (const char* accept) {
+        return iot_core::api::negotiateContentType(accept, {ContentType::ApplicationJson, ContentType::ApplicationCbor, ContentType::TextCsv});
+      };
+      yatest::expect(negotiate("") == ContentType::ApplicationJson, "first should be default");
+      yatest::expect(negotiate("text/html, */*;q=0.8") == ContentType::ApplicationJson, "any should select the first");
+      yatest::expect(negotiate("application/cbor") == ContentType::ApplicationCbor, "CBOR should be selected");
+      yatest::expect(negotiate("application/json;q=0.5, text/csv") == ContentType::TextCsv, "higher quality should be selected");
+      yatest::expect(negotiate("application/*;q=0.2, application/json;q=0") == ContentType::ApplicationCbor, "most specific range should apply");
+      yatest::expect(negotiate("text/html") == ContentType::Unknown, "unsupported should not be selected");
+      yatest::expect(iot_core::api::detail::parseQuality("q=0.5") == 500u, "quality should be parsed");
+      yatest::expect(iot_core::api::detail::parseQuality("q=0.x9") == 0u && iot_core::api::detail::parseQuality("q=0.5;") == 500u, "quality should end at a non-digit");
+      yatest::expect(iot_core::api::detail::parseQuality("q=0.~~~") == 0u, "quality should not exceed 1000");
+      yatest::expect(iot_core::api::acceptsContentType("text/*", "text/csv") && !iot_core::api::acceptsContentType("text/*", "application/json"), "type ranges should be matched");
+    })
+    .tests("diagnostics are written as CBOR", [] () {
+      FormatOutput output;
+      iot_core::api::CborWriter writer {output};
+      iot_core::api::CborDiagnosticsCollector collector {writer};
+      collectFormatDiagnostics(collector);
+      collector.end();
+      static const char expected[] = "\xBF" "\x63" "api" "\xBF" "\x65" "count" "\x19\x01\xF4" "\x64" "name" "\x66" "a, \"b\"" "\xFF"
+        "\x64" "zero" "\x00" "\x64" "text" "\x62" "42" "\xFF";
+      yatest::expect(output.content == std::string(expected, sizeof(expected) - 1u), "CBOR should match");
+    })
+    .tests("diagnostics are written as CSV", [] () {
+      FormatOutput output;
+      iot_core::api::CsvDiagnosticsCollector::header(output);
+      iot_core::api::CsvDiagnosticsCollector collector {output};
+      collectFormatDiagnostics(collector);
+      yatest::expect(output.content == "path,value\r\napi/count,500\r\napi/name,\"a, \"\"b\"\"\"\r\nzero,0\r\ntext,42\r\n", output.content.c_str());
+    })
+    ;
+}
@@ -0,0 +1,60 @@
+#include <yatest/TestSuite.h>
+
+#include <string>
+#include <vector>
+
+#include "../src/iot_core/EventBus.h"
+
+namespace {
+  struct NumberTopic : iot_core::EventTopic<1u, int, 2u, 2u> {
+    static toolbox::strref name() { return "number"; }
+  };
+
+  struct OtherNumberTopic : iot_core::EventTopic<1u, int> {
+    static toolbox::strref name() { return "otherNumber"; }
+  };
+
+  static const yatest::TestSuite& TestEventBus =
+  yatest::suite("EventBus")
+    .tests("events are delivered only on deliver", [] () {
+      iot_core::EventBus bus;
+      std::vector<int> received;
+      bus.subscribe<NumberTopic>([&] (const int& number) { received.push_back(number); });
+      bus.publish<NumberTopic>(1);
+      bus.publish<NumberTopic>(2);
+      yatest::expect(received.empty(), "nothing should be delivered before deliver()");
+      bus.deliver();
+      yatest::expect(received == std::vector<int>{1, 2}, "events should be delivered in order");
+    })
+    .tests("events exceeding the queue capacity are dropped", [] () {
+      iot_core::EventBus bus;
+      std::vector<int> received;
+      bus.subscribe<NumberTopic>([&] (const int& number) { received.push_back(number); });
+      yatest::expect(bus.publish<NumberTopic>(1), "first event should be queued");
+      yatest::expect(bus.publish<NumberTopic>(2), "second event should be queued");
+      yatest::expect(!bus.publish<NumberTopic>(3), "third event should be dropped");
+      bus.deliver();
+      yatest::expect(received == std::vector<int>{1, 2}, "only queued events should be delivered");
+    })
+    .tests("events published by subscribers are delivered on next run", [] () {
+      iot_core::EventBus bus;
+      std::vector<int> received;
+      bus.subscribe<NumberTopic>([&] (const int& number) {
+        received.push_back(number);
+        if (number < 3) {
+          bus.publish<NumberTopic>(number + 1);
+        }
+      });
+      bus.publish<NumberTopic>(1);
+      bus.deliver();
+      yatest::expect(received == std::vector<int>{1}, "only first event should be delivered");
+      bus.deliver();
+      bus.deliver();
+      yatest::expect(received == std::vector<int>{1, 2, 3}, "follow-up events should be delivered");
+    })
+    .tests("topics with conflicting IDs are rejected", [] () {
+      iot_core::EventBus bus;
+      yatest::expect(bus.subscribe<NumberTopic>([] (const int&) {}), "first topic should be accepted");
+      yatest::expect(!bus.publish<OtherNumberTopic>(1), "topic with same ID should be rejected");
+    });
+}
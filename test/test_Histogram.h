@@ -0,0 +1,104 @@
+#include <yatest/TestSuite.h>
+
+#include <string>
+
+#include "../src/iot_core/Histogram.h"
+
+namespace {
+  using Buckets = iot_core::LogBuckets<27u, 2u>;
+
+  bool withinRelativeError(uint32_t actual, uint32_t expected) {
+    uint32_t difference = actual > expected ? actual - expected : expected - actual;
+    return difference * Buckets::SUB_BUCKETS <= expected;
+  }
+
+  static const yatest::TestSuite& TestHistogram =
+  yatest::suite("Histogram")
+    .tests("values are mapped into bucket bounds", [] () {
+      for (uint32_t value = 0u; value < 100000u; value += 7u) {
+        size_t index = Buckets::index(value);
+        yatest::expect(index < Buckets::COUNT, "index out of range");
+        yatest::expect(Buckets::lowerBound(index) <= value && value <= Buckets::upperBound(index), std::to_string(value).c_str());
+      }
+      yatest::expect(Buckets::index(0xFFFFFFFFu) == Buckets::COUNT - 1u, "too large values must go into last bucket");
+    })
+    .tests("empty histogram", [] () {
+      iot_core::Histogram<> histogram;
+      yatest::expect(histogram.lifetime().count() == 0u, "count");
+      yatest::expect(histogram.lifetime().min() == 0u, "min");
+      yatest::expect(histogram.lifetime().max() == 0u, "max");
+      yatest::expect(histogram.lifetime().percentile(99.0f) == 0u, "p99");
+    })
+    .tests("percentiles of uniform values", [] () {
+      iot_core::Histogram<> histogram;
+      for (uint32_t value = 1u; value <= 10000u; ++value) {
+        histogram.record(value);
+      }
+      auto& lifetime = histogram.lifetime();
+      yatest::expect(lifetime.count() == 10000u, "count");
+      yatest::expect(lifetime.min() == 1u, "min");
+      yatest::expect(lifetime.max() == 10000u, "max");
+      yatest::expect(lifetime.avg() == 5000u, "avg");
+      yatest::expect(withinRelativeError(lifetime.percentile(50.0f), 5000u), std::to_string(lifetime.percentile(50.0f)).c_str());
+      yatest::expect(withinRelativeError(lifetime.percentile(99.0f), 9900u), std::to_string(lifetime.percentile(99.0f)).c_str());
+      yatest::expect(withinRelativeError(lifetime.percentile(99.9f), 9990u), std::to_string(lifetime.percentile(99.9f)).c_str());
+      yatest::expect(lifetime.percentile(100.0f) == 10000u, "p100 is max");
+    })
+    .tests("tail latency is visible in p999", [] () {
+      iot_core::Histogram<> histogram;
+      for (uint32_t i = 0u; i < 9990u; ++i) {
+        histogram.record(100u);
+      }
+      for (uint32_t i = 0u; i < 10u; ++i) {
+        histogram.record(50000u);
+      }
+      yatest::expect(withinRelativeError(histogram.lifetime().percentile(99.0f), 100u), "p99");
+      yatest::expect(withinRelativeError(histogram.lifetime().percentile(99.95f), 50000u), "p9995");
+    })
+    .tests("window is reset independently of lifetime", [] () {
+      iot_core::Histogram<> histogram;
+      histogram.record(10u);
+      histogram.record(20u);
+      histogram.resetWindow();
+      histogram.record(30u);
+      yatest::expect(histogram.lifetime().count() == 3u, "lifetime count");
+      yatest::expect(histogram.window().count() == 1u, "window count");
+      yatest::expect(histogram.window().min() == 30u, "window min");
+    })
+    .tests("window is not reset by reading", [] () {
+      struct NullCollector final : public iot_core::IDiagnosticsCollector {
+        void beginSection(const toolbox::strref&) override {}
+        void addValue(const toolbox::strref&, const toolbox::strref&) override {}
+        void endSection() override {}
+      } collector;
+      iot_core::Histogram<> histogram;
+      histogram.record(10u);
+      histogram.getDiagnostics(collector);
+      histogram.getDiagnostics(collector);
+      yatest::expect(histogram.window().count() == 1u, "window should be kept for all readers");
+      histogram.getDiagnosticsAndReset(collector);
+      yatest::expect(histogram.window().count() == 0u && histogram.lifetime().count() == 1u, "window should be reset on request");
+    })
+    .tests("full window buckets keep the percentiles", [] () {
+      iot_core::Histogram<> histogram {0u};
+      for (uint32_t i = 0u; i < 220000u; ++i) {
+        histogram.record(i % 11u == 10u ? 1000u : 10u);
+      }
+      yatest::expect(histogram.window().count() == 220000u, "all values should be counted");
+      yatest::expect(withinRelativeError(histogram.window().percentile(50.0f), 10u), "p50");
+      yatest::expect(withinRelativeError(histogram.window().percentile(90.0f), 10u), "p90 should not move into the tail");
+      yatest::expect(withinRelativeError(histogram.window().percentile(99.0f), 1000u), "p99");
+      yatest::expect(histogram.window().percentile(90.0f) == histogram.lifetime().percentile(90.0f), "window should match the lifetime");
+    })
+    .tests("window covers a time slice", [] () {
+      iot_core::Histogram<> histogram {1000u};
+      histogram.record(10u);
+      host::advanceTimeMs(999);
+      histogram.record(20u);
+      yatest::expect(histogram.window().count() == 2u, "values within the slice should be kept");
+      host::advanceTimeMs(1);
+      histogram.record(30u);
+      yatest::expect(histogram.window().count() == 1u && histogram.window().min() == 30u, "new slice should start");
+      yatest::expect(histogram.lifetime().count() == 3u, "lifetime should be kept");
+    });
+}
@@ -0,0 +1,114 @@
+#include <yatest/TestSuite.h>
+#include <Arduino.h>
+
+#include <string>
+#include <vector>
+
+#include "../src/iot_core/InputEvents.h"
+
+namespace {
+  /**
+   * Stand-in for the GPIOs, which calls the attached "ISR" on level changes.
+   */
+  struct SimulatedGpio {
+    static constexpr uint8_t PINS = 4u;
+    static inline bool levels[PINS] = {};
+    static inline void (*isrs[PINS])(void*) = {};
+    static inline void* args[PINS] = {};
+
+    static bool read(uint8_t pin) { return levels[pin]; }
+    static void attach(uint8_t pin, void (*isr)(void*), void* arg) { isrs[pin] = isr; args[pin] = arg; }
+    static void detach(uint8_t pin) { isrs[pin] = nullptr; args[pin] = nullptr; }
+    static unsigned long micros() { return ::micros(); }
+
+    static void set(uint8_t pin, bool level) {
+      if (levels[pin] != level) {
+        levels[pin] = level;
+        if (isrs[pin] != nullptr) {
+          isrs[pin](args[pin]);
+        }
+      }
+    }
+  };
+
+  using Events = std::vector<std::string>;
+
+  std::string describe(const iot_core::InputEvent& event) {
+    switch (event.type) {
+      case iot_core::InputEventType::Pressed: return "pressed";
+      case iot_core::InputEventType::Released: return "released:" + std::to_string(event.durationMs);
+      case iot_core::InputEventType::LongPressed: return "long:" + std::to_string(event.durationMs);
+      default: return "?";
+    }
+  }
+
+  template<typename TestCaseFunction>
+  std::function<void()> testInputs(iot_core::InputOptions options, TestCaseFunction testCase) {
+    return [=] () {
+      SimulatedGpio::levels[1] = true; // idle level with pull-up
+      iot_core::BasicInputEvents<SimulatedGpio> inputs;
+      Events events;
+      inputs.watch(1u, [&] (const iot_core::InputEvent& event) { events.push_back(describe(event)); }, options);
+      testCase(inputs, events);
+    };
+  }
+
+  std::string joinInputEvents(const Events& events) {
+    std::string result;
+    for (auto& event : events) {
+      result += event;
+      result += ' ';
+    }
+    return result;
+  }
+
+  static const yatest::TestSuite& TestInputEvents =
+  yatest::suite("InputEvents")
+    .tests("press and release are delivered after debounce time", testInputs({}, [] (auto& inputs, Events& events) {
+      SimulatedGpio::set(1u, false);
+      inputs.process();
+      yatest::expect(events.empty(), "press must not be reported before debounce time");
+      host::advanceTimeMs(20);
+      inputs.process();
+      yatest::expect(joinInputEvents(events) == "pressed ", joinInputEvents(events).c_str());
+      host::advanceTimeMs(30);
+      SimulatedGpio::set(1u, true);
+      host::advanceTimeMs(20);
+      inputs.process();
+      yatest::expect(joinInputEvents(events) == "pressed released:50 ", joinInputEvents(events).c_str());
+    }))
+    .tests("pulse shorter than loop period is not missed", testInputs({}, [] (auto& inputs, Events& events) {
+      SimulatedGpio::set(1u, false);
+      host::advanceTimeMs(25);
+      SimulatedGpio::set(1u, true);
+      host::advanceTimeMs(100);
+      inputs.process();
+      yatest::expect(joinInputEvents(events) == "pressed released:25 ", joinInputEvents(events).c_str());
+    }))
+    .tests("bouncing is filtered", testInputs({}, [] (auto& inputs, Events& events) {
+      SimulatedGpio::set(1u, false);
+      host::advanceTimeMs(2);
+      SimulatedGpio::set(1u, true);
+      host::advanceTimeMs(1);
+      SimulatedGpio::set(1u, false);
+      host::advanceTimeMs(2);
+      SimulatedGpio::set(1u, true);
+      host::advanceTimeMs(50);
+      inputs.process();
+      yatest::expect(events.empty(), joinInputEvents(events).c_str());
+    }))
+    .tests("long press is reported once while pressed", testInputs({true, 20u, 1000u}, [] (auto& inputs, Events& events) {
+      SimulatedGpio::set(1u, false);
+      host::advanceTimeMs(500);
+      inputs.process();
+      yatest::expect(joinInputEvents(events) == "pressed ", joinInputEvents(events).c_str());
+      host::advanceTimeMs(600);
+      inputs.process();
+      inputs.process();
+      yatest::expect(joinInputEvents(events) == "pressed long:1100 ", joinInputEvents(events).c_str());
+      SimulatedGpio::set(1u, true);
+      host::advanceTimeMs(20);
+      inputs.process();
+      yatest::expect(joinInputEvents(events) == "pressed long:1100 released:1100 ", joinInputEvents(events).c_str());
+    }));
+}
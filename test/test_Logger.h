@@ -1,55 +1,96 @@
 #include <yatest/TestSuite.h>
-#include <yatest/Mocks.h>
+#include <Arduino.h>
 
 #include <iostream>
 #include <sstream>
 
-#include "../src/Logger.h"
+#include "../src/iot_core/Logger.h"
+#include "../src/iot_core/LogSinks.h"
 
 namespace {
   template<typename TestCaseFunction>
   std::function<void()> testLogger(TestCaseFunction testCase, std::string expected) {
     return [=] () {
+      host::setTimeUs(0u);
       iot_core::Time time;
-      iot_core::Logger logger {time};
+      iot_core::LogService logService {time};
+      iot_core::InMemoryLogSink sink;
+      sink.logLevel(iot_core::LogLevel::All);
+      logService.addLogSink(sink);
 
-      testCase(logger, time);
+      iot_core::Logger logger = logService.logger("test");
+      testCase(logService, logger, time);
 
       std::stringstream output;
-      logger.output([&](const char* entry){ output << entry; });
+      sink.output([&](const char* entry){ output << entry; });
       yatest::expect(output.str() == expected, output.str().c_str());
     };
   }
 
   static const yatest::TestSuite& TestLogger =
   yatest::suite("Logger")
-    .tests("log plain message without level", testLogger([] (iot_core::Logger& logger, iot_core::Time& time) {
-      logger.log("test", "message 1");
-    }, "[0e0w0d00h00m00s000|test|   ] message 1\n"))
-    .tests("log multiple plain messages without level", testLogger([] (iot_core::Logger& logger, iot_core::Time& time) {
-      logger.log("test", "message 1");
-      advanceTimeMs(123); time.update();
-      logger.log("test", "message 2");
-    }, "[0e0w0d00h00m00s000|test|   ] message 1\n[0e0w0d00h00m00s123|test|   ] message 2\n"))
-    .tests("log plain message with error level", testLogger([] (iot_core::Logger& logger, iot_core::Time& time) {
-      logger.log(iot_core::LogLevel::Error, "test", "message 1");
+    .tests("log plain message without level", testLogger([] (iot_core::LogService&, iot_core::Logger& logger, iot_core::Time& time) {
+      logger.log("message 1");
+    }, "[0e0w0d00h00m00s000|test|---] message 1\n"))
+    .tests("log multiple plain messages without level", testLogger([] (iot_core::LogService&, iot_core::Logger& logger, iot_core::Time& time) {
+      logger.log("message 1");
+      host::advanceTimeMs(123); time.update();
+      logger.log("message 2");
+    }, "[0e0w0d00h00m00s000|test|---] message 1\n[0e0w0d00h00m00s123|test|---] message 2\n"))
+    .tests("log plain message with error level", testLogger([] (iot_core::LogService&, iot_core::Logger& logger, iot_core::Time& time) {
+      logger.log(iot_core::LogLevel::Error, "message 1");
     }, "[0e0w0d00h00m00s000|test|ERR] message 1\n"))
-    .tests("log plain message with info level", testLogger([] (iot_core::Logger& logger, iot_core::Time& time) {
-      logger.log(iot_core::LogLevel::Info, "test", "message 1");
+    .tests("log plain message with info level", testLogger([] (iot_core::LogService&, iot_core::Logger& logger, iot_core::Time& time) {
+      logger.log(iot_core::LogLevel::Info, "message 1");
     }, "[0e0w0d00h00m00s000|test|INF] message 1\n"))
-    .tests("plain message with debug level not logged by default", testLogger([] (iot_core::Logger& logger, iot_core::Time& time) {
-      logger.log(iot_core::LogLevel::Debug, "test", "message 1");
+    .tests("plain message with debug level not logged by default", testLogger([] (iot_core::LogService&, iot_core::Logger& logger, iot_core::Time& time) {
+      logger.log(iot_core::LogLevel::Debug, "message 1");
     }, ""))
-    .tests("log plain message with debug level", testLogger([] (iot_core::Logger& logger, iot_core::Time& time) {
-      logger.logLevel("test", iot_core::LogLevel::Debug);
-      logger.log(iot_core::LogLevel::Debug, "test", "message 1");
+    .tests("log plain message with debug level", testLogger([] (iot_core::LogService& logService, iot_core::Logger& logger, iot_core::Time& time) {
+      logService.logLevel("test", iot_core::LogLevel::Debug);
+      logger.log(iot_core::LogLevel::Debug, "message 1");
     }, "[0e0w0d00h00m00s000|test|DBG] message 1\n"))
-    .tests("log message function", testLogger([] (iot_core::Logger& logger, iot_core::Time& time) {
-      logger.log(iot_core::LogLevel::Info, "test", [] () { return "message 1"; });
+    .tests("log message function", testLogger([] (iot_core::LogService&, iot_core::Logger& logger, iot_core::Time& time) {
+      logger.log(iot_core::LogLevel::Info, [] () { return "message 1"; });
     }, "[0e0w0d00h00m00s000|test|INF] message 1\n"))
-    .tests("log message function not called if level to high", testLogger([] (iot_core::Logger& logger, iot_core::Time& time) {
+    .tests("log message function not called if level to high", testLogger([] (iot_core::LogService&, iot_core::Logger& logger, iot_core::Time& time) {
       bool functionCalled = false;
-      logger.log(iot_core::LogLevel::Trace, "test", [&] () { functionCalled = true; return "message 1"; });
+      logger.log(iot_core::LogLevel::Trace, [&] () { functionCalled = true; return "message 1"; });
       yatest::expect(!functionCalled, "message function should not be called");
-    }, ""));
+    }, ""))
+    .tests("sink log level filters entries", testLogger([] (iot_core::LogService& logService, iot_core::Logger& logger, iot_core::Time& time) {
+      logService.logSinks().front()->logLevel(iot_core::LogLevel::Warning);
+      logger.log(iot_core::LogLevel::Info, "message 1");
+      logger.log(iot_core::LogLevel::Error, "message 2");
+    }, "[0e0w0d00h00m00s000|test|ERR] message 2\n"))
+    .tests("cursor outputs stored entries one by one", [] () {
+      iot_core::InMemoryLogSink sink;
+      sink.commitLogEntry("entry 1\n");
+      sink.commitLogEntry("entry 2\n");
+      iot_core::LogCursor cursor = sink.cursor();
+      sink.commitLogEntry("entry 3\n");
+
+      std::string output;
+      yatest::expect(sink.outputNext(cursor, [&](const char* entry){ output += entry; }), "first entry should be output");
+      yatest::expect(output == "entry 1\n", output.c_str());
+      yatest::expect(sink.outputNext(cursor, [&](const char* entry){ output += entry; }), "second entry should be output");
+      yatest::expect(!sink.outputNext(cursor, [&](const char* entry){ output += entry; }), "later entries should not be output");
+      yatest::expect(output == "entry 1\nentry 2\n", output.c_str());
+    })
+    .tests("cursor skips dropped entries", [] () {
+      iot_core::InMemoryLogSink sink;
+      sink.commitLogEntry("first\n");
+      iot_core::LogCursor cursor = sink.cursor();
+      std::string entry(99u, 'x');
+      entry += '\n';
+      for (int i = 0; i < 100; ++i) {
+        sink.commitLogEntry(entry.c_str());
+      }
+
+      size_t count = 0u;
+      iot_core::LogCursor all = sink.cursor();
+      while (sink.outputNext(all, [&](const char* output){ count += std::string(output) == entry ? 1u : 0u; })) {}
+      yatest::expect(count == 40u, "only the latest entries should be kept");
+      yatest::expect(!sink.outputNext(cursor, [](const char*){}), "dropped entries should be skipped");
+    });
 }
@@ -0,0 +1,74 @@
+#include <yatest/TestSuite.h>
+#include <Arduino.h>
+
+#include "../src/iot_core/api/RateLimiter.h"
+
+namespace {
+  static const yatest::TestSuite& TestRateLimiter =
+  yatest::suite("RateLimiter")
+    .tests("bucket is refilled over time", [] () {
+      iot_core::api::TokenBucket bucket;
+      bucket.fill(2u, 0u);
+      yatest::expect(bucket.take(4u, 2u, 0u) == 0u && bucket.take(4u, 2u, 0u) == 0u, "burst should be allowed");
+      yatest::expect(bucket.take(4u, 2u, 0u) == 250u, "wait time should be returned");
+      yatest::expect(bucket.take(4u, 2u, 100u) == 150u, "partial refill should shorten the wait time");
+      yatest::expect(bucket.take(4u, 2u, 250u) == 0u, "token should be refilled");
+      yatest::expect(bucket.take(4u, 2u, 10000u) == 0u && bucket.take(4u, 2u, 10000u) == 0u && bucket.take(4u, 2u, 10000u) > 0u, "refill should be capped by the burst");
+    })
+    .tests("clients and route classes are limited separately", [] () {
+      iot_core::api::RateLimiter limiter;
+      iot_core::api::RateLimiter::Limit limit {1u, 1u};
+      yatest::expect(limiter.take(1u, iot_core::api::RouteClass::Read, limit, 0u) == 0u, "first read should be allowed");
+      yatest::expect(limiter.take(1u, iot_core::api::RouteClass::Read, limit, 0u) == 1000u, "second read should be limited");
+      yatest::expect(limiter.take(1u, iot_core::api::RouteClass::Write, limit, 0u) == 0u, "write should be allowed");
+      yatest::expect(limiter.take(2u, iot_core::api::RouteClass::Read, limit, 0u) == 0u, "other client should be allowed");
+      yatest::expect(limiter.take(1u, iot_core::api::RouteClass::Read, {0u, 0u}, 0u) == 0u, "disabled limit should allow all");
+
+      for (uint32_t address = 3u; address < 3u + iot_core::api::RateLimiter::MAX_CLIENTS; ++address) {
+        limiter.take(address, iot_core::api::RouteClass::Read, limit, 1u);
+      }
+      yatest::expect(limiter.clients() == iot_core::api::RateLimiter::MAX_CLIENTS, "clients should be limited");
+      yatest::expect(limiter.take(1u, iot_core::api::RouteClass::Read, limit, 1u) == 0u, "least recent client should be replaced");
+    })
+    .tests("routes are classified by method", [] () {
+      yatest::expect(iot_core::api::routeClassOf(iot_core::api::methodMask(iot_core::api::HttpMethod::GET)) == iot_core::api::RouteClass::Read, "GET");
+      yatest::expect(iot_core::api::routeClassOf(iot_core::api::methodMask(iot_core::api::HttpMethod::OPTIONS)) == iot_core::api::RouteClass::Read, "OPTIONS");
+      yatest::expect(iot_core::api::routeClassOf(iot_core::api::methodMask(iot_core::api::HttpMethod::PUT)) == iot_core::api::RouteClass::Write, "PUT");
+    })
+    .tests("load is shed on high loop latency", [] () {
+      iot_core::Histogram<> latency {0u};
+      iot_core::api::LoadShedder shedder;
+      for (uint32_t i = 0u; i < iot_core::api::LoadShedder::EVALUATION_LOOPS; ++i) {
+        latency.record(500u);
+        shedder.loop(latency, 1000u);
+      }
+      yatest::expect(!shedder.shedding(), "low latency should not be shed");
+      latency.resetWindow();
+      for (uint32_t i = 0u; i < iot_core::api::LoadShedder::EVALUATION_LOOPS; ++i) {
+        latency.record(2000u);
+        shedder.loop(latency, 1000u);
+      }
+      yatest::expect(shedder.shedding(), "high latency should be shed");
+      latency.resetWindow();
+      for (uint32_t i = 0u; i < iot_core::api::LoadShedder::EVALUATION_LOOPS; ++i) {
+        latency.record(500u);
+        shedder.loop(latency, 1000u);
+      }
+      yatest::expect(!shedder.shedding(), "shedding should stop once the latency recovers");
+    })
+    .tests("load is not shed on a full window with a low tail", [] () {
+      iot_core::Histogram<> latency;
+      iot_core::api::LoadShedder shedder;
+      for (uint32_t i = 0u; i < 200000u; ++i) { // beyond the range of the window counters
+        latency.record(i % 20u == 0u ? 2000u : 500u);
+        shedder.loop(latency, 1000u);
+      }
+      yatest::expect(!shedder.shedding(), "5% of slow loops should not be shed");
+      for (uint32_t i = 0u; i < 100000u; ++i) {
+        latency.record(2000u);
+        shedder.loop(latency, 1000u);
+      }
+      yatest::expect(shedder.shedding(), "a slow majority should be shed");
+    })
+    ;
+}
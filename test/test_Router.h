@@ -0,0 +1,121 @@
+#include <yatest/TestSuite.h>
+
+#include <string>
+#include <vector>
+
+#include "../src/iot_core/Allocations.h"
+#include "../src/iot_core/api/Router.h"
+
+namespace {
+  using iot_core::api::HttpMethod;
+  using iot_core::api::methodMask;
+
+  void staticRoute(void*, iot_core::api::IRequest&, iot_core::api::IResponse&) {}
+
+  static const char STATIC_PATH_1[] PROGMEM = "/api/static/{}";
+  static const char STATIC_PATH_2[] PROGMEM = "/api/static";
+
+  static const iot_core::api::StaticRoute STATIC_ROUTES[] PROGMEM = {
+    {STATIC_PATH_1, methodMask(HttpMethod::GET), staticRoute},
+    {STATIC_PATH_2, methodMask(HttpMethod::GET) | methodMask(HttpMethod::POST), staticRoute},
+  };
+
+  iot_core::api::Router makeRouter() {
+    iot_core::api::Router router;
+    auto noop = [] (iot_core::api::IRequest&, iot_core::api::IResponse&) {};
+    router.on("/api/system/status", methodMask(HttpMethod::GET), noop);
+    router.on("/api/system/components", methodMask(HttpMethod::GET), noop);
+    router.on("/api/system/components/{}", methodMask(HttpMethod::GET), noop);
+    router.on("/api/system/components/{}/log-level", methodMask(HttpMethod::GET), noop);
+    router.on("/api/system/components/{}/log-level", methodMask(HttpMethod::PUT), noop);
+    router.on("/api/system/components/special", methodMask(HttpMethod::GET), noop);
+    router.on("/api/{}/{}", methodMask(HttpMethod::POST), noop);
+    router.on("*", methodMask(HttpMethod::OPTIONS), noop);
+    return router;
+  }
+
+  static const yatest::TestSuite& TestRouter =
+  yatest::suite("Router")
+    .tests("literal paths are matched", [] () {
+      auto router = makeRouter();
+      iot_core::api::RouteMatch match;
+      yatest::expect(router.match(methodMask(HttpMethod::GET), "/api/system/status", match), "path should match");
+      yatest::expect(match.route() == 0u, "status route should be matched");
+      yatest::expect(router.match(methodMask(HttpMethod::GET), "/api/system/components/", match) && match.route() == 1u, "trailing slash should be ignored");
+      yatest::expect(!router.match(methodMask(HttpMethod::GET), "/api/system", match), "prefix should not match");
+      yatest::expect(!router.match(methodMask(HttpMethod::GET), "/api/system/status/more", match), "longer path should not match");
+    })
+    .tests("captures are available", [] () {
+      auto router = makeRouter();
+      iot_core::api::RouteMatch match;
+      yatest::expect(router.match(methodMask(HttpMethod::PUT), "/api/system/components/wifi/log-level", match), "path should match");
+      yatest::expect(match.route() == 4u, "route for method should be matched");
+      yatest::expect(match.captureCount() == 1u && match.capture(0u) == "wifi", "capture should be available");
+      yatest::expect(router.match(methodMask(HttpMethod::POST), "/api/a/b", match), "path should match");
+      yatest::expect(match.captureCount() == 2u && match.capture(0u) == "a" && match.capture(1u) == "b", "all captures should be available");
+    })
+    .tests("literals have precedence over captures", [] () {
+      auto router = makeRouter();
+      iot_core::api::RouteMatch match;
+      yatest::expect(router.match(methodMask(HttpMethod::GET), "/api/system/components/special", match) && match.route() == 5u, "literal should be preferred");
+      yatest::expect(router.match(methodMask(HttpMethod::GET), "/api/system/components/other", match) && match.route() == 2u, "capture should match others");
+      yatest::expect(router.match(methodMask(HttpMethod::POST), "/api/system/status", match) && match.route() == 6u, "capture should match if literal route has other method");
+    })
+    .tests("methods are matched", [] () {
+      auto router = makeRouter();
+      iot_core::api::RouteMatch match;
+      yatest::expect(!router.match(methodMask(HttpMethod::DELETE), "/api/system/status", match), "other method should not match");
+      yatest::expect(router.match(methodMask(HttpMethod::OPTIONS), "/api/system/status", match) && match.route() == 7u, "wildcard should match any path");
+      yatest::expect(router.match(methodMask(HttpMethod::OPTIONS), "/", match) && match.route() == 7u, "wildcard should match empty path");
+    })
+    .tests("invalid paths are rejected", [] () {
+      iot_core::api::Router router;
+      auto noop = [] (iot_core::api::IRequest&, iot_core::api::IResponse&) {};
+      yatest::expect(!router.on("/a/*/b", methodMask(HttpMethod::GET), noop), "wildcard must be last");
+      yatest::expect(!router.on(std::string(200u, 'a').c_str(), methodMask(HttpMethod::GET), noop), "path must not be too long");
+      iot_core::api::RouteMatch match;
+      yatest::expect(!makeRouter().match(methodMask(HttpMethod::GET), ("/" + std::string(200u, 'a')).c_str(), match), "request path must not be too long");
+    })
+    .tests("static routes", [] () {
+      iot_core::api::Router router;
+      yatest::expect(router.on(STATIC_ROUTES, 2u, nullptr), "static routes should be added");
+      iot_core::api::RouteMatch match;
+      yatest::expect(router.match(methodMask(HttpMethod::POST), "/api/static", match) && match.route() == 1u, "static route should match");
+      yatest::expect(router.match(methodMask(HttpMethod::GET), "/api/static/x", match) && match.capture(0u) == "x", "static route with capture should match");
+    })
+    .tests("statistics are kept per route", [] () {
+      auto router = makeRouter();
+      iot_core::api::RouteMatch match;
+      router.match(methodMask(HttpMethod::GET), "/api/system/status", match);
+      router.record(match, 200, 100u, 1000u);
+      router.record(match, 404, 10u, 10u);
+      const auto& statistics = router.routeStatistics(match.route());
+      yatest::expect(statistics.calls() == 2u, "calls should be counted");
+      yatest::expect(statistics.statusClass(2u) == 1u && statistics.statusClass(4u) == 1u, "status classes should be counted");
+      yatest::expect(statistics.bytesSent() == 110u, "bytes sent should be counted");
+      yatest::expect(router.routeStatistics(0u).calls() == 2u && router.routeStatistics(1u).calls() == 0u, "other routes should be unaffected");
+    })
+    .tests("route latency does not saturate", [] () {
+      auto router = makeRouter();
+      iot_core::api::RouteMatch match;
+      router.match(methodMask(HttpMethod::GET), "/api/system/status", match);
+      for (uint32_t i = 0u; i < 100000u; ++i) {
+        router.record(match, 200, 0u, 10u);
+      }
+      for (uint32_t i = 0u; i < 1000u; ++i) {
+        router.record(match, 200, 0u, 1000u);
+      }
+      yatest::expect(router.routeStatistics(match.route()).latency().percentile(99.0f) < 1000u, "p99 should reflect all calls");
+    })
+    .tests("matching does not allocate", [] () {
+      auto router = makeRouter();
+      iot_core::api::RouteMatch match;
+      iot_core::AllocationCounters counters;
+      {
+        iot_core::AllocationScope scope {counters};
+        router.match(methodMask(HttpMethod::PUT), "/api/system/components/wifi/log-level", match);
+        router.match(methodMask(HttpMethod::OPTIONS), "/api/system/status", match);
+      }
+      yatest::expect(counters.count == 0u, "matching should not allocate");
+    });
+}
@@ -0,0 +1,38 @@
+#include <yatest/TestSuite.h>
+
+#include <string>
+
+#include "../src/iot_core/api/StaticAssets.h"
+
+#if IOT_CORE_HOST_ASSETS
+#include <TestAssets.h>
+#endif
+
+namespace {
+  static const yatest::TestSuite& TestStaticAssets =
+  yatest::suite("StaticAssets")
+    .tests("entity tags are matched", [] () {
+      yatest::expect(iot_core::api::matchesETag("\"abc\"", "\"abc\""), "same tag should match");
+      yatest::expect(iot_core::api::matchesETag("\"x\", W/\"abc\"", "\"abc\""), "weak tag in list should match");
+      yatest::expect(iot_core::api::matchesETag("*", "\"abc\""), "wildcard should match");
+      yatest::expect(!iot_core::api::matchesETag("\"abcd\"", "\"abc\""), "other tag should not match");
+      yatest::expect(!iot_core::api::matchesETag("", "\"abc\""), "no tag should not match");
+    })
+#if IOT_CORE_HOST_ASSETS
+    .tests("generated asset table", [] () {
+      yatest::expect(test_assets::ASSET_COUNT == 4u, "all files and the index should be listed");
+      iot_core::api::StaticAsset index = test_assets::ASSETS[0];
+      iot_core::api::StaticAsset root = test_assets::ASSETS[1];
+      yatest::expect(std::string(index.path) == "/index.html" && std::string(root.path) == "/", "index should also be served for its directory");
+      yatest::expect(index.content == root.content, "index content should not be duplicated");
+      yatest::expect(index.gzipped && index.content[0] == 0x1f && index.content[1] == 0x8b, "text should be gzipped");
+      yatest::expect(std::string(index.contentType) == "text/html", "content type should be derived from the extension");
+      yatest::expect(strlen(index.etag) == 18u && index.etag[0] == '"', "strong ETag should be generated");
+
+      iot_core::api::StaticAsset tiny = test_assets::ASSETS[2];
+      yatest::expect(!tiny.gzipped && tiny.size == 1u && tiny.content[0] == 'x', "content should not be gzipped if it gets larger");
+      yatest::expect(std::string(test_assets::ASSETS[3].path) == "/css/style.css", "files in subdirectories should be included");
+    })
+#endif
+    ;
+}
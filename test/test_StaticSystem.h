@@ -0,0 +1,139 @@
+#include <yatest/TestSuite.h>
+#include <Arduino.h>
+
+#include <string>
+
+#include "../src/iot_core/System.h"
+
+namespace {
+  template<int ID>
+  class StaticComponent final : public iot_core::IApplicationComponent {
+    const char* _name;
+
+  public:
+    int setups = 0;
+    int loops = 0;
+    uint32_t value = 0u;
+
+    explicit StaticComponent(const char* name) : _name(name) {}
+
+    toolbox::strref name() const override { return _name; }
+
+    bool configure(const toolbox::strref& name, const toolbox::strref& value) override {
+      if (name == F("value")) {
+        this->value = strtoul(value.toString().c_str(), nullptr, 10);
+        return true;
+      }
+      return false;
+    }
+
+    void getConfig(iot_core::ConfigWriter writer) const override {
+      writer(F("value"), toolbox::convert<uint32_t>::toString(value, 10));
+    }
+
+    void setup(bool) override { setups += 1; }
+    void loop(iot_core::ConnectionStatus) override { loops += 1; }
+
+    void getDiagnostics(iot_core::IDiagnosticsCollector& collector) const override {
+      collector.addValue(F("loops"), toolbox::convert<uint32_t>::toString(loops, 10));
+    }
+  };
+
+  class UnlistedComponent final : public iot_core::IApplicationComponent {
+  public:
+    toolbox::strref name() const override { return "unlisted"; }
+    bool configure(const toolbox::strref&, const toolbox::strref&) override { return false; }
+    void getConfig(iot_core::ConfigWriter) const override {}
+    void setup(bool) override {}
+    void loop(iot_core::ConnectionStatus) override {}
+    void getDiagnostics(iot_core::IDiagnosticsCollector&) const override {}
+  };
+
+  /**
+   * Collects top-level sections and their values as "section/name=value ".
+   */
+  struct SectionCollector final : public iot_core::IDiagnosticsCollector {
+    std::string values;
+    std::string section;
+    int depth = 0;
+
+    void beginSection(const toolbox::strref& name) override {
+      depth += 1;
+      section = std::string(name.cstr(), name.length());
+    }
+
+    void addValue(const toolbox::strref& name, const toolbox::strref& value) override {
+      if (depth == 1) {
+        values += section + "/" + std::string(name.cstr(), name.length()) + "=" + std::string(value.cstr(), value.length()) + " ";
+      }
+    }
+
+    void endSection() override { depth -= 1; }
+  };
+
+  using TestStaticSystem = iot_core::StaticSystem<StaticComponent<0>, StaticComponent<1>>;
+
+  struct StaticSystemFixture {
+    host::TemporaryFileSystem fileSystem;
+    gpiobj::DigitalOutput statusLed {2u, false};
+    gpiobj::DigitalInput otaEnable {false};
+    gpiobj::DigitalInput update {false};
+    gpiobj::DigitalInput factoryReset {false};
+    gpiobj::DigitalInput debugEnable {false};
+    iot_core::VersionInfo version {"0000000", "0.0.0"};
+    TestStaticSystem system {"test", version, "", statusLed, otaEnable, update, factoryReset, debugEnable};
+    StaticComponent<0> first {"first"};
+    StaticComponent<1> second {"second"};
+
+    StaticSystemFixture() {
+      system.addComponent(&first);
+      system.addComponent(&second);
+      system.setup();
+      WiFi.setStatus(WL_CONNECTED);
+    }
+  };
+
+  static const yatest::TestSuite& TestStaticSystemSuite =
+  yatest::suite("StaticSystem")
+    .tests("components are set up and looped", [] () {
+      StaticSystemFixture fixture;
+      fixture.system.loop();
+      fixture.system.loop();
+      yatest::expect(fixture.first.setups == 1 && fixture.second.setups == 1, "components should be set up once");
+      yatest::expect(fixture.first.loops == 2 && fixture.second.loops == 2, "components should be looped");
+    })
+    .tests("components are found by name", [] () {
+      StaticSystemFixture fixture;
+      yatest::expect(fixture.system.getComponent("first") == &fixture.first && fixture.system.getComponent("second") == &fixture.second, "components should be found");
+      yatest::expect(fixture.system.getComponent("third") == nullptr, "unknown component should not be found");
+    })
+    .tests("config is routed by name", [] () {
+      StaticSystemFixture fixture;
+      char config[] = "value=42;";
+      yatest::expect(fixture.system.configure("second", iot_core::ConfigParser{config}), "config should be applied");
+      yatest::expect(fixture.first.value == 0u && fixture.second.value == 42u, "only the named component should be configured");
+
+      std::string all;
+      fixture.system.getAllConfig([&] (const toolbox::strref& name, const toolbox::strref& value) {
+        all += std::string(name.cstr(), name.length()) + "=" + std::string(value.cstr(), value.length()) + ";";
+      });
+      yatest::expect(all == "first.value=0;second.value=42;", all.c_str());
+    })
+    .tests("diagnostics include all components", [] () {
+      StaticSystemFixture fixture;
+      fixture.system.loop();
+      SectionCollector collector;
+      fixture.system.getDiagnostics(collector);
+      yatest::expect(collector.values.find("first/loops=1 second/loops=1 ") != std::string::npos, collector.values.c_str());
+    })
+    .tests("component not in the type list is rejected", [] () {
+      StaticSystemFixture fixture;
+      UnlistedComponent unlisted;
+      yatest::expect(!fixture.system.addComponent(static_cast<iot_core::IApplicationComponent*>(&unlisted)).valid(), "component should be rejected");
+      size_t logged = 0u;
+      fixture.system.localLogSink().output([&] (const char* entry) {
+        logged += strstr(entry, "Cannot add component 'unlisted'.") != nullptr ? 1u : 0u;
+      });
+      yatest::expect(logged == 1u, "failure should be logged");
+    });
+}
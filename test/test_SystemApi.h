@@ -0,0 +1,579 @@
+#include <yatest/TestSuite.h>
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiClient.h>
+
+#include <string>
+
+#include "../src/iot_core/System.h"
+#include "../src/iot_core/api/Server.h"
+#include "../src/iot_core/api/StaticAssets.h"
+#include "../src/iot_core/api/SystemApi.h"
+
+namespace {
+  void echoRoute(void* context, iot_core::api::IRequest& request, iot_core::api::IResponse& response) {
+    response.code(iot_core::api::ResponseCode::Ok).sendSingleBody().write(toolbox::format("%s:%s", static_cast<const char*>(context), request.pathArg(0).cstr()));
+  }
+
+  void lookupRoute(void*, iot_core::api::IRequest& request, iot_core::api::IResponse& response) {
+    iot_core::AllocationCounters allocations;
+    toolbox::strref name;
+    toolbox::strref accept;
+    bool hasUnknown;
+    {
+      iot_core::AllocationScope scope {allocations};
+      name = request.arg(F("name"));
+      hasUnknown = request.hasArg(F("unknown"));
+      accept = request.header(F("accept"));
+      response.header(F("X-Lookup"), name).header(F("Cache-Control"), F("no-store"));
+    }
+    response.code(iot_core::api::ResponseCode::Ok).sendSingleBody().write(toolbox::format("%s:%s:%d:%u", name.cstr(), accept.cstr(), int(hasUnknown), unsigned(allocations.count)));
+  }
+
+  void largeRoute(void*, iot_core::api::IRequest&, iot_core::api::IResponse& response) {
+    response.code(iot_core::api::ResponseCode::Ok).sendSingleBody().write(std::string(3000u, 'x').c_str());
+  }
+
+  static const char ECHO_PATH[] PROGMEM = "/api/echo/{}";
+  static const char LOOKUP_PATH[] PROGMEM = "/api/lookup";
+  static const char LARGE_PATH[] PROGMEM = "/api/large";
+
+  static const iot_core::api::StaticRoute TEST_ROUTES[] PROGMEM = {
+    {ECHO_PATH, iot_core::api::methodMask(iot_core::api::HttpMethod::GET), echoRoute},
+    {LOOKUP_PATH, iot_core::api::methodMask(iot_core::api::HttpMethod::GET), lookupRoute},
+    {LARGE_PATH, iot_core::api::methodMask(iot_core::api::HttpMethod::GET), largeRoute},
+  };
+
+  static const char PLAIN_ASSET_PATH[] PROGMEM = "/static/plain.txt";
+  static const char PACKED_ASSET_PATH[] PROGMEM = "/static/packed.txt";
+  static const char ASSET_CONTENT_TYPE[] PROGMEM = "text/plain";
+  static const char PLAIN_ASSET_ETAG[] PROGMEM = "\"plain\"";
+  static const char PACKED_ASSET_ETAG[] PROGMEM = "\"packed\"";
+  static const uint8_t PLAIN_ASSET_CONTENT[] PROGMEM = {'p', 'l', 'a', 'i', 'n'};
+  static const uint8_t PACKED_ASSET_CONTENT[] PROGMEM = {0x1f, 0x8b};
+
+  static const iot_core::api::StaticAsset TEST_ASSETS[] PROGMEM = {
+    {PLAIN_ASSET_PATH, ASSET_CONTENT_TYPE, PLAIN_ASSET_ETAG, PLAIN_ASSET_CONTENT, sizeof(PLAIN_ASSET_CONTENT), false},
+    {PACKED_ASSET_PATH, ASSET_CONTENT_TYPE, PACKED_ASSET_ETAG, PACKED_ASSET_CONTENT, sizeof(PACKED_ASSET_CONTENT), true},
+  };
+
+  /**
+   * Decodes a chunked body, returns the response unchanged if not chunked.
+   */
+  std::string dechunk(const std::string& response) {
+    size_t headerEnd = response.find("\r\n\r\n");
+    if (headerEnd == std::string::npos || response.find("Transfer-Encoding: chunked") > headerEnd) {
+      return response;
+    }
+    std::string decoded = response.substr(0u, headerEnd + 4u);
+    size_t position = headerEnd + 4u;
+    while (position < response.size()) {
+      size_t sizeEnd = response.find("\r\n", position);
+      size_t size = std::stoul(response.substr(position, sizeEnd - position), nullptr, 16);
+      if (size == 0u) {
+        break;
+      }
+      decoded += response.substr(sizeEnd + 2u, size);
+      position = sizeEnd + 2u + size + 2u;
+    }
+    return decoded;
+  }
+
+  /**
+   * Runs a system with the system API on a local port, which is started the
+   * same way as on the device, i.e. when the WiFi (re)connects.
+   */
+  struct SystemApiFixture {
+    host::TemporaryFileSystem fileSystem;
+    gpiobj::DigitalOutput statusLed {2u, false};
+    gpiobj::DigitalInput otaEnable {false};
+    gpiobj::DigitalInput update {false};
+    gpiobj::DigitalInput factoryReset {false};
+    gpiobj::DigitalInput debugEnable {false};
+    iot_core::VersionInfo version {"0000000", "0.0.0"};
+    uint16_t port = host::freeLocalPort();
+    size_t loops = 0u;
+    const char* httpVersion = "HTTP/1.1";
+    bool cacheStatus;
+
+    iot_core::System system {"test", version, "", statusLed, otaEnable, update, factoryReset, debugEnable};
+    iot_core::api::Server server {system, port};
+    iot_core::api::SystemApi systemApi {system, system, cacheStatus};
+    iot_core::api::StaticAssetProvider assets {TEST_ASSETS, 2u};
+
+    explicit SystemApiFixture(bool cacheStatus = false) : cacheStatus(cacheStatus) {
+      server.addProvider(&systemApi);
+      server.addProvider(&assets);
+      server.on(TEST_ROUTES, 3u, const_cast<char*>("context"));
+      system.addComponent(&server);
+      system.setup();
+
+      host::advanceTimeMs(1000);
+      WiFi.setStatus(WL_DISCONNECTED);
+      system.loop();
+      host::advanceTimeMs(1000);
+      WiFi.setStatus(WL_CONNECTED);
+      system.loop();
+    }
+
+    /**
+     * Sends a request and returns the response with a decoded body. The
+     * system keeps looping until the response is complete.
+     */
+    std::string request(const char* method, const char* path, const char* headers = "", const std::string& body = "") {
+      WiFiClient client;
+      if (!client.connect(host::LOOPBACK, port)) {
+        return {};
+      }
+      client.print(method);
+      client.print(' ');
+      client.print(path);
+      client.print(' ');
+      client.print(httpVersion);
+      client.print(F("\r\nHost: localhost\r\nConnection: close\r\n"));
+      client.print(headers);
+      if (!body.empty()) {
+        client.print(toolbox::format("Content-Length: %u\r\n", unsigned(body.size())));
+      }
+      client.print(F("\r\n"));
+      client.write(body.data(), body.size());
+
+      system.loop();
+      loops = 1u;
+
+      std::string response;
+      while (client.connected() || client.available() > 0) {
+        int c = client.read();
+        if (c >= 0) {
+          response += char(c);
+        } else if (client.connected()) {
+          system.loop(); // generated responses continue in the following loops
+          loops += 1u;
+        }
+      }
+      return dechunk(response);
+    }
+  };
+
+  static const yatest::TestSuite& TestSystemApi =
+  yatest::suite("SystemApi")
+    .tests("get status", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("GET", "/api/system/status");
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u, response.c_str());
+      yatest::expect(response.find("application/json") != std::string::npos, "content type should be JSON");
+      yatest::expect(response.find("\"uptime\"") != std::string::npos, "status should contain uptime");
+      yatest::expect(response.find("\"allocations\"") != std::string::npos, "status should contain allocations");
+    })
+    .tests("large single body is sent to HTTP/1.0 clients", [] () {
+      SystemApiFixture fixture;
+      fixture.httpVersion = "HTTP/1.0";
+      std::string response = fixture.request("GET", "/api/large");
+      size_t body = response.find("\r\n\r\n") + 4u;
+      yatest::expect(response.rfind("HTTP/1.0 200", 0u) == 0u, response.substr(0u, body).c_str());
+      yatest::expect(response.find("Content-Length") > body && response.find("Transfer-Encoding") > body, "body should be delimited by closing the connection");
+      yatest::expect(response.compare(body, std::string::npos, std::string(3000u, 'x')) == 0, "body should be sent without framing");
+    })
+    .tests("headers larger than the buffer are sent", [] () {
+      SystemApiFixture fixture;
+      std::string value(40u, 'v');
+      fixture.server.on(F("/api/headers"), iot_core::api::HttpMethod::GET, [&] (iot_core::api::IRequest&, iot_core::api::IResponse& response) {
+        for (const char* name : {"X-First", "X-Second", "X-Third", "X-Fourth", "X-Fifth", "X-Sixth", "X-Seventh", "X-Eighth"}) {
+          response.header(name, value.c_str());
+        }
+        response.header("X-Large", std::string(300u, 'l').c_str());
+        response.code(iot_core::api::ResponseCode::Ok).sendSingleBody().write(F("headers"));
+      });
+      std::string response = fixture.request("GET", "/api/headers");
+      size_t position = 0u;
+      for (const char* name : {"X-First", "X-Second", "X-Third", "X-Fourth", "X-Fifth", "X-Sixth", "X-Seventh", "X-Eighth"}) {
+        position = response.find(std::string(name) + ": " + value + "\r\n", position);
+        yatest::expect(position != std::string::npos, name);
+      }
+      yatest::expect(response.find("X-Large: " + std::string(300u, 'l') + "\r\n", position) != std::string::npos, "header larger than the buffer should be sent");
+      yatest::expect(response.find("\r\n\r\nheaders") != std::string::npos, "body should be sent");
+    })
+    .tests("get component with path argument", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("GET", "/api/system/components/api");
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u, response.c_str());
+      yatest::expect(response.find("\"api\"") != std::string::npos, "component should be returned");
+    })
+    .tests("components are generated", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("GET", "/api/system/components");
+      size_t body = response.find("\r\n\r\n") + 4u;
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u, response.c_str());
+      yatest::expect(response.find("Connection: close\r\n") < body, "body should be delimited by closing the connection");
+      yatest::expect(response.find("Access-Control-Allow-Origin: *\r\n") < body, "CORS header should be sent");
+      yatest::expect(response.compare(body, 14u, "[{\"name\":\"api\"") == 0 && response.compare(response.size() - 2u, 2u, "}]") == 0, "body should be a list of components");
+    })
+    .tests("large logs are generated over multiple loops", [] () {
+      SystemApiFixture fixture;
+      iot_core::Logger logger = fixture.system.logger(F("test"));
+      for (int i = 0; i < 100; ++i) {
+        logger.log(iot_core::LogLevel::Warning, toolbox::format("entry %d of a rather long log message to fill the buffer", i));
+      }
+      std::string logs;
+      fixture.system.localLogSink().output([&] (const char* entry) { logs += entry; });
+
+      std::string response = fixture.request("GET", "/api/system/logs");
+      size_t body = response.find("\r\n\r\n") + 4u;
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u, response.c_str());
+      yatest::expect(logs.size() > 3000u && response.compare(body, std::string::npos, logs) == 0, "all log entries should be sent");
+      yatest::expect(fixture.loops > 1u, "logs should be sent over multiple loops");
+    })
+    .tests("generated response waits for the client", [] () {
+      SystemApiFixture fixture;
+      WiFiClient client;
+      client.connect(host::LOOPBACK, fixture.port);
+      client.print(F("GET /api/system/logs HTTP/1.1\r\n\r\n"));
+      host::setWriteCapacity(0);
+      for (int i = 0; i < 10; ++i) {
+        fixture.system.loop();
+      }
+      bool waited = client.available() == 0;
+      host::setWriteCapacity(1460);
+      std::string response;
+      for (int i = 0; i < 100 && (client.connected() || client.available() > 0); ++i) {
+        fixture.system.loop();
+        while (client.available() > 0) {
+          response += char(client.read());
+        }
+      }
+      yatest::expect(waited, "nothing should be sent while the client cannot take a chunk");
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u && response.find("System setup done.") != std::string::npos, response.c_str());
+    })
+    .tests("stalled client of a generated response is closed", [] () {
+      SystemApiFixture fixture;
+      WiFiClient client;
+      client.connect(host::LOOPBACK, fixture.port);
+      client.print(F("GET /api/system/logs HTTP/1.1\r\n\r\n"));
+      host::setWriteCapacity(0);
+      fixture.system.loop();
+      host::advanceTimeMs(iot_core::api::GeneratedResponse<WiFiClient>::STALL_TIMEOUT);
+      fixture.system.loop();
+      host::setWriteCapacity(1460);
+      std::string status = fixture.request("GET", "/api/system/status");
+      size_t generated = status.find("\"generated\"");
+      yatest::expect(generated != std::string::npos && status.find("\"aborted\":\"1\"", generated) != std::string::npos, "stalled response should be aborted");
+    })
+    .tests("batch of paths is generated", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("GET", "/api/system/batch?paths=/api/echo/a,/api/unknown,/static/plain.txt,/api/system/logs,/api/system/status");
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u, response.c_str());
+      size_t contentType = response.find("Content-Type: multipart/mixed; boundary=iot-core-batch-");
+      yatest::expect(contentType != std::string::npos, "multipart content type should be sent");
+      size_t boundaryStart = response.find('=', contentType) + 1u;
+      std::string boundary = response.substr(boundaryStart, response.find("\r\n", boundaryStart) - boundaryStart);
+      yatest::expect(boundary.size() == iot_core::api::BatchGenerator::BOUNDARY_LENGTH, boundary.c_str());
+      size_t echo = response.find("--" + boundary + "\r\nContent-Type: application/http\r\nContent-Location: /api/echo/a\r\n\r\nHTTP/1.1 200 \r\nContent-Type: text/plain\r\n\r\ncontext:a\r\n");
+      size_t unknown = response.find("Content-Location: /api/unknown\r\n\r\nHTTP/1.1 404 ");
+      size_t asset = response.find("Content-Location: /static/plain.txt\r\n\r\nHTTP/1.1 200 ");
+      size_t logs = response.find("Content-Location: /api/system/logs\r\n");
+      yatest::expect(echo < unknown && unknown < asset && asset < logs && logs != std::string::npos, "parts should be sent in order");
+      yatest::expect(response.find("ETag: \"plain\"\r\n", asset) < response.find("\r\n\r\nplain\r\n", asset), "headers and body of the part should be sent");
+      yatest::expect(response.find("System setup done.", logs) != std::string::npos, "generated body should be continued");
+      std::string end = "\r\n--" + boundary + "--\r\n";
+      yatest::expect(response.compare(response.size() - end.size(), end.size(), end) == 0, "batch should be closed");
+      yatest::expect(fixture.loops > 1u, "paths should be called over multiple loops");
+
+      response = fixture.request("GET", "/api/system/batch?paths=/api/echo/a");
+      yatest::expect(response.find("boundary=" + boundary) == std::string::npos, "boundary should be unique per batch");
+
+      response = fixture.request("GET", "/api/system/batch");
+      yatest::expect(response.rfind("HTTP/1.1 400", 0u) == 0u, response.c_str());
+    })
+    .tests("batch calls are cached and recorded", [] () {
+      SystemApiFixture fixture {true};
+      std::string response = fixture.request("GET", "/api/system/batch?paths=/api/system/status,/api/system/status,/api/echo/a");
+      size_t first = response.find("Content-Location: /api/system/status\r\n");
+      size_t second = response.find("Content-Location: /api/system/status\r\n", first + 1u);
+      yatest::expect(second != std::string::npos && response.find("\"uptime\"", second) != std::string::npos, "cached status should be sent");
+
+      response = fixture.request("GET", "/api/system/components/api");
+      size_t status = response.find("\"GET /api/system/status\"");
+      size_t cache = response.find("\"cache\"", status);
+      yatest::expect(cache != std::string::npos && response.find("\"hits\":\"1\"", cache) != std::string::npos, "second call should be a cache hit");
+      yatest::expect(response.find("\"misses\":\"1\"", cache) != std::string::npos, "first call should be a miss");
+      yatest::expect(response.find("\"2xx\":\"1\"", response.find("\"GET /api/echo/{}\"")) != std::string::npos, "call should be recorded for the route");
+    })
+    .tests("diagnostics deltas are pushed", [] () {
+      SystemApiFixture fixture;
+      WiFiClient client;
+      client.connect(host::LOOPBACK, fixture.port);
+      client.print(F("GET /api/system/status/events?interval=500&filter=system/uptime,system/version,api/calls HTTP/1.1\r\n\r\n"));
+      std::string events;
+      auto receive = [&] () {
+        for (int i = 0; i < 10; ++i) {
+          fixture.system.loop();
+          while (client.available() > 0) {
+            events += char(client.read());
+          }
+        }
+      };
+      receive();
+      yatest::expect(events.find("Content-Type: text/event-stream\r\n") != std::string::npos, events.c_str());
+      size_t snapshot = events.find("event: snapshot\ndata: {");
+      yatest::expect(snapshot != std::string::npos && events.find("\"uptime\"", snapshot) != std::string::npos, "snapshot should be sent");
+      yatest::expect(events.find("\"version\"", snapshot) != std::string::npos && events.find("\"chunked\"") == std::string::npos, "values should be filtered");
+      yatest::expect(events.find("event: delta") == std::string::npos, "delta should wait for the interval");
+
+      host::advanceTimeMs(500);
+      receive();
+      size_t delta = events.find("event: delta\ndata: {");
+      yatest::expect(delta != std::string::npos && events.find("\"uptime\"", delta) != std::string::npos, "changed value should be sent");
+      yatest::expect(events.find("\"version\"", delta) == std::string::npos, "unchanged values should not be sent");
+      client.stop();
+      fixture.system.loop();
+    })
+    .tests("diagnostics snapshot is spread over loops", [] () {
+      SystemApiFixture fixture;
+      WiFiClient client;
+      client.connect(host::LOOPBACK, fixture.port);
+      client.print(F("GET /api/system/status/events HTTP/1.1\r\n\r\n"));
+      host::setWriteCapacity(1460);
+      std::string events;
+      size_t loops = 0u;
+      size_t maxLoopSize = 0u;
+      for (; loops < 100u && events.find("}\n\n") == std::string::npos; ++loops) {
+        fixture.system.loop();
+        size_t size = events.size();
+        while (client.available() > 0) {
+          events += char(client.read());
+        }
+        maxLoopSize = std::max(maxLoopSize, events.size() - size);
+      }
+      size_t snapshot = events.find("event: snapshot\ndata: {");
+      yatest::expect(snapshot != std::string::npos && events.find("\"routes\"", snapshot) != std::string::npos, "full snapshot should be sent");
+      yatest::expect(events.size() - snapshot > 4000u && loops > 3u, toolbox::format("snapshot should take multiple loops (%u)", unsigned(loops)));
+      yatest::expect(maxLoopSize < 2u * 1460u, toolbox::format("each loop should write about a chunk (%u bytes)", unsigned(maxLoopSize)));
+      client.stop();
+      fixture.system.loop();
+    })
+    .tests("static route", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("GET", "/api/echo/value");
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u, response.c_str());
+      yatest::expect(response.find("\r\n\r\ncontext:value") != std::string::npos, response.c_str());
+    })
+    .tests("single body is sent with content length", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("GET", "/api/echo/value");
+      yatest::expect(response.find("Content-Length: 13\r\n") != std::string::npos, response.c_str());
+      yatest::expect(response.find("Transfer-Encoding") == std::string::npos, "body should not be chunked");
+    })
+    .tests("args and headers are looked up without allocations", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("GET", "/api/lookup?other=1&name=value", "Accept: text/csv\r\n");
+      yatest::expect(response.find("\r\n\r\nvalue:text/csv:0:0") != std::string::npos, response.c_str());
+      yatest::expect(response.find("X-Lookup: value\r\nCache-Control: no-store\r\n") != std::string::npos, "headers should be sent");
+    })
+    .tests("preflight request", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("OPTIONS", "/api/system/status");
+      yatest::expect(response.rfind("HTTP/1.1 204", 0u) == 0u, response.c_str());
+      yatest::expect(response.find("Access-Control-Allow-Methods") != std::string::npos, "allowed methods should be sent");
+    })
+    .tests("route statistics", [] () {
+      SystemApiFixture fixture;
+      fixture.request("GET", "/api/echo/value");
+      std::string response = fixture.request("GET", "/api/system/status");
+      size_t route = response.find("\"GET /api/echo/{}\"");
+      yatest::expect(route != std::string::npos, "route should be listed");
+      yatest::expect(response.find("\"count\":\"1\"", route) != std::string::npos, "call should be counted");
+      yatest::expect(response.find("\"2xx\":\"1\"", route) != std::string::npos, "status should be counted");
+    })
+    .tests("status is not cached by default", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("GET", "/api/system/status");
+      size_t route = response.find("\"GET /api/system/status\"");
+      yatest::expect(route != std::string::npos && response.find("\"cache\"", route) == std::string::npos, "status should not be cached");
+    })
+    .tests("status is cached", [] () {
+      SystemApiFixture fixture {true};
+      std::string first = fixture.request("GET", "/api/system/status");
+      std::string second = fixture.request("GET", "/api/system/status");
+      yatest::expect(second.rfind("HTTP/1.1 200", 0u) == 0u, second.c_str());
+      yatest::expect(second.find("application/json") != std::string::npos, "content type should be cached");
+      yatest::expect(first.find("\"uptime\"") != std::string::npos && second.find(first.substr(first.find("\"uptime\""), 40u)) != std::string::npos, "cached status should be returned");
+
+      host::advanceTimeMs(iot_core::api::SystemApi::STATUS_CACHE_TTL);
+      std::string third = fixture.request("GET", "/api/system/status");
+      size_t cache = third.find("\"cache\"", third.find("\"GET /api/system/status\""));
+      yatest::expect(cache != std::string::npos, "cache should be listed");
+      yatest::expect(third.find("\"hits\":\"1\"", cache) != std::string::npos, "hit should be counted");
+      yatest::expect(third.find("\"misses\":\"2\"", cache) != std::string::npos, "expired response should be a miss");
+      yatest::expect(third.find("\"skipped\":\"0\"", cache) != std::string::npos, "status should fit into the cache");
+    })
+    .tests("diagnostics format is negotiated", [] () {
+      SystemApiFixture fixture;
+      std::string cbor = fixture.request("GET", "/api/system/status", "Accept: application/cbor\r\n");
+      size_t body = cbor.find("\r\n\r\n") + 4u;
+      yatest::expect(cbor.rfind("HTTP/1.1 200", 0u) == 0u && cbor.find("Content-Type: application/cbor\r\n") < body, cbor.c_str());
+      yatest::expect(cbor.size() > body && uint8_t(cbor[body]) == 0xBFu, "body should be a CBOR map");
+
+      std::string csv = fixture.request("GET", "/api/system/components/api", "Accept: text/csv;q=0.9, application/json;q=0.1\r\n");
+      yatest::expect(csv.find("\r\n\r\npath,value\r\nname,api\r\n") != std::string::npos, csv.c_str());
+
+      std::string json = fixture.request("GET", "/api/system/status");
+      yatest::expect(json.find("Content-Type: application/json\r\n") != std::string::npos, "JSON should be sent without Accept header");
+
+      std::string unsupported = fixture.request("GET", "/api/system/status", "Accept: image/png\r\n");
+      yatest::expect(unsupported.rfind("HTTP/1.1 406", 0u) == 0u, unsupported.c_str());
+    })
+    .tests("logs format is negotiated", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("GET", "/api/system/logs", "Accept: application/json\r\n");
+      size_t body = response.find("\r\n\r\n") + 4u;
+      yatest::expect(response.find("Content-Type: application/json\r\n") < body, response.c_str());
+      yatest::expect(response.compare(body, 2u, "[\"") == 0 && response.compare(response.size() - 1u, 1u, "]") == 0, "logs should be a list of strings");
+    })
+    .tests("cached status is only sent if acceptable", [] () {
+      SystemApiFixture fixture {true};
+      std::string first = fixture.request("GET", "/api/system/status");
+      std::string csv = fixture.request("GET", "/api/system/status", "Accept: text/csv\r\n");
+      yatest::expect(csv.find("Content-Type: text/csv\r\n") != std::string::npos, "cached JSON should not be sent");
+      std::string json = fixture.request("GET", "/api/system/status", "Accept: */*\r\n");
+      yatest::expect(json.substr(json.find("\r\n\r\n")) == first.substr(first.find("\r\n\r\n")), "cached JSON should still be sent to any client");
+    })
+    .tests("cached response limits", [] () {
+      iot_core::api::ResponseCache cache {100u};
+      iot_core::AllocationCounters allocations;
+      {
+        iot_core::AllocationScope scope {allocations};
+        yatest::expect(cache.enable(0u, 1000u, 60u), "route should be cached");
+      }
+      yatest::expect(allocations.count == 1u, "only the entry should be allocated before the first response");
+      yatest::expect(!cache.enable(1u, 1000u, 60u), "memory limit should be respected");
+      auto& cached = *cache.find(0u);
+      cached.begin("/a");
+      cached.append(toolbox::strref(std::string(61u, 'x').c_str()));
+      cached.end(200, "text/plain", 0u);
+      yatest::expect(!cached.fresh("/a", 0u) && cached.skipped() == 1u, "too large response should be skipped");
+      cached.begin("/a");
+      cached.append("content");
+      cached.end(200, "text/plain", 0u);
+      yatest::expect(cached.fresh("/a", 999u) && cached.size() == 7u, "response should be cached");
+      yatest::expect(!cached.fresh("/b", 0u) && !cached.fresh("/a", 1000u), "other path or expired response should not be fresh");
+      cache.invalidate();
+      yatest::expect(!cached.fresh("/a", 0u), "response should be invalidated");
+    })
+    .tests("compressed response", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("GET", "/api/system/components/api", "Accept-Encoding: gzip, deflate\r\n");
+      size_t body = response.find("\r\n\r\n") + 4u;
+      yatest::expect(response.find("Content-Encoding: gzip\r\n") < body, "content encoding should be sent");
+      yatest::expect(response.compare(body, 2u, "\x1f\x8b") == 0, "body should be gzip");
+
+      std::string status = fixture.request("GET", "/api/system/status");
+      size_t compression = status.find("\"compression\"");
+      yatest::expect(status.find("Content-Encoding") == std::string::npos, "uncompressed response should be sent if not accepted");
+      yatest::expect(compression != std::string::npos && status.find("\"count\":\"1\"", compression) < status.find("\"routes\""), "compression should be recorded");
+    })
+    .tests("static asset", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("GET", "/static/plain.txt");
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u, response.c_str());
+      yatest::expect(response.find("Content-Length: 5\r\n") != std::string::npos, "content length should be sent");
+      yatest::expect(response.find("ETag: \"plain\"\r\n") != std::string::npos, "ETag should be sent");
+      yatest::expect(response.find("Cache-Control: no-cache\r\n") != std::string::npos, "cache control should be sent");
+      yatest::expect(response.find("\r\n\r\nplain") != std::string::npos, "content should be sent");
+    })
+    .tests("static asset revalidation", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("GET", "/static/plain.txt", "If-None-Match: \"other\", W/\"plain\"\r\n");
+      yatest::expect(response.rfind("HTTP/1.1 304", 0u) == 0u, response.c_str());
+      yatest::expect(response.find("ETag: \"plain\"\r\n") != std::string::npos, "ETag should be sent");
+      yatest::expect(response.find("plain", response.find("\r\n\r\n")) == std::string::npos, "content should not be sent");
+    })
+    .tests("gzipped static asset", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("GET", "/static/packed.txt", "Accept-Encoding: gzip\r\n");
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u, response.c_str());
+      yatest::expect(response.find("Content-Encoding: gzip\r\n") != std::string::npos, "content encoding should be sent");
+      yatest::expect(response.find("\r\n\r\n\x1f\x8b") != std::string::npos, "gzipped content should be sent");
+      response = fixture.request("GET", "/static/packed.txt");
+      yatest::expect(response.rfind("HTTP/1.1 406", 0u) == 0u, response.c_str());
+    })
+    .tests("config is updated", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("PUT", "/api/system/config/api", "Content-Type: text/plain\r\n", "compression=false;\n");
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u, response.c_str());
+      yatest::expect(response.find("compression=false;") != std::string::npos, "config should be returned");
+      response = fixture.request("PUT", "/api/system/config", "", "api.compression=true;api.unknown=1;");
+      yatest::expect(response.rfind("HTTP/1.1 400", 0u) == 0u, response.c_str());
+    })
+    .tests("whole body is read", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("PUT", "/api/system/log-level", "", "DBG");
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u, response.c_str());
+      yatest::expect(response.find("\r\n\r\nDBG") != std::string::npos, response.c_str());
+    })
+    .tests("config body is streamed", [] () {
+      SystemApiFixture fixture;
+      std::string body;
+      while (body.size() < 16384u) {
+        body += "compression=true;\n";
+      }
+      body += "compression=false;";
+      iot_core::AllocationCounters allocations;
+      std::string response;
+      {
+        iot_core::AllocationScope scope {allocations};
+        response = fixture.request("PUT", "/api/system/config/api", "", body);
+      }
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u, response.c_str());
+      yatest::expect(response.find("compression=false;") != std::string::npos, "all entries should be applied");
+      yatest::expect(allocations.peak < body.size() / 2u, "body should not be held in RAM");
+    })
+    .tests("requests are rate limited", [] () {
+      SystemApiFixture fixture;
+      fixture.request("PUT", "/api/system/config/api", "", "readRate=1;readBurst=2;");
+      yatest::expect(fixture.request("GET", "/api/echo/a").rfind("HTTP/1.1 200", 0u) == 0u, "first request should be allowed");
+      yatest::expect(fixture.request("GET", "/api/echo/b").rfind("HTTP/1.1 200", 0u) == 0u, "burst should be allowed");
+      std::string response = fixture.request("GET", "/api/echo/c");
+      yatest::expect(response.rfind("HTTP/1.1 429", 0u) == 0u, response.c_str());
+      yatest::expect(response.find("Retry-After: 1\r\n") != std::string::npos, "retry after should be sent");
+
+      host::advanceTimeMs(1000);
+      response = fixture.request("GET", "/api/system/status");
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u, "request should be allowed after the refill");
+      size_t limits = response.find("\"limits\"");
+      yatest::expect(limits != std::string::npos && response.find("\"rateLimited\":\"1\"", limits) != std::string::npos, "rejected request should be counted");
+      yatest::expect(response.find("\"4xx\":\"1\"", response.find("\"GET /api/echo/{}\"")) != std::string::npos, "rejected request should be recorded for the route");
+    })
+    .tests("load is shed", [] () {
+      SystemApiFixture fixture;
+      fixture.request("PUT", "/api/system/config/api", "", "shedLatency=1000;");
+      for (uint32_t i = 0u; i < iot_core::api::LoadShedder::EVALUATION_LOOPS; ++i) {
+        fixture.system.schedule([] () { host::advanceTimeMs(5); }); // slow loop
+        fixture.system.loop();
+      }
+      std::string response = fixture.request("GET", "/api/echo/a");
+      yatest::expect(response.rfind("HTTP/1.1 503", 0u) == 0u, response.c_str());
+      yatest::expect(response.find("Retry-After: 1\r\n") != std::string::npos, "retry after should be sent");
+      response = fixture.request("GET", "/api/system/config/api");
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u, "config should not be shed");
+
+      host::advanceTimeMs(iot_core::Histogram<>::DEFAULT_WINDOW_MS);
+      for (uint32_t i = 0u; i < iot_core::api::LoadShedder::EVALUATION_LOOPS; ++i) {
+        fixture.system.loop();
+      }
+      response = fixture.request("GET", "/api/echo/a");
+      yatest::expect(response.rfind("HTTP/1.1 200", 0u) == 0u, "shedding should stop once the latency recovers");
+    })
+    .tests("unknown path", [] () {
+      SystemApiFixture fixture;
+      std::string response = fixture.request("GET", "/api/unknown");
+      yatest::expect(response.rfind("HTTP/1.1 404", 0u) == 0u, response.c_str());
+    })
+    .tests("reset restarts device", [] () {
+      SystemApiFixture fixture;
+      size_t restarts = ESP.restartCount();
+      std::string response = fixture.request("POST", "/api/system/reset");
+      yatest::expect(response.rfind("HTTP/1.1 204", 0u) == 0u, response.c_str());
+      fixture.system.loop();
+      yatest::expect(ESP.restartCount() == restarts + 1u, "device should be restarted");
+    });
+}
@@ -0,0 +1,143 @@
+#include <yatest/TestSuite.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <random>
+#include <string>
+
+#include "../src/iot_core/Utils.h"
+
+namespace {
+  /**
+   * Straight-forward reference implementation of the statistics.
+   */
+  template<size_t SAMPLES>
+  struct ReferenceStatistics {
+    std::deque<unsigned long> window;
+    std::vector<unsigned long> all;
+
+    void add(unsigned long value) {
+      window.push_back(value);
+      if (window.size() > SAMPLES) {
+        window.pop_front();
+      }
+      all.push_back(value);
+    }
+
+    unsigned long min() const { return *std::min_element(window.begin(), window.end()); }
+    unsigned long max() const { return *std::max_element(window.begin(), window.end()); }
+    unsigned long avg() const {
+      uint64_t sum = 0u;
+      for (auto value : window) sum += value;
+      return sum / window.size();
+    }
+    unsigned long lifetimeMin() const { return *std::min_element(all.begin(), all.end()); }
+    unsigned long lifetimeMax() const { return *std::max_element(all.begin(), all.end()); }
+    double variance() const {
+      double mean = 0.0;
+      for (auto value : all) mean += value;
+      mean /= all.size();
+      double sum = 0.0;
+      for (auto value : all) sum += (value - mean) * (value - mean);
+      return sum / (all.size() - 1u);
+    }
+  };
+
+  struct ManualClock {
+    static uint32_t ticks;
+    static uint32_t now() { return ticks; }
+    static uint32_t since(uint32_t startTicks) { return now() - startTicks; }
+  };
+  uint32_t ManualClock::ticks = 0u;
+
+  template<size_t SAMPLES>
+  void compareWithReference(unsigned int seed, unsigned long maxValue, size_t sampleCount) {
+    std::mt19937 random {seed};
+    std::uniform_int_distribution<unsigned long> distribution {0u, maxValue};
+    iot_core::TimingStatistics<SAMPLES> statistics;
+    ReferenceStatistics<SAMPLES> reference;
+
+    for (size_t i = 0u; i < sampleCount; ++i) {
+      unsigned long value = distribution(random);
+      statistics.add(value);
+      reference.add(value);
+
+      std::string context = "seed " + std::to_string(seed) + ", sample " + std::to_string(i);
+      yatest::expect(statistics.count() == reference.window.size(), ("count at " + context).c_str());
+      yatest::expect(statistics.min() == reference.min(), ("min at " + context).c_str());
+      yatest::expect(statistics.max() == reference.max(), ("max at " + context).c_str());
+      yatest::expect(statistics.avg() == reference.avg(), ("avg at " + context).c_str());
+      yatest::expect(statistics.lifetimeMin() == reference.lifetimeMin(), ("lifetime min at " + context).c_str());
+      yatest::expect(statistics.lifetimeMax() == reference.lifetimeMax(), ("lifetime max at " + context).c_str());
+      if (i > 0u) {
+        double expectedVariance = reference.variance();
+        yatest::expect(std::fabs(statistics.variance() - expectedVariance) <= 1e-3 * expectedVariance + 1e-3, ("variance at " + context).c_str());
+      }
+    }
+  }
+
+  static const yatest::TestSuite& TestTimingStatistics =
+  yatest::suite("TimingStatistics")
+    .tests("empty statistics", [] () {
+      iot_core::TimingStatistics<10> statistics;
+      yatest::expect(statistics.count() == 0u, "count");
+      yatest::expect(statistics.min() == 0u, "min");
+      yatest::expect(statistics.max() == 0u, "max");
+      yatest::expect(statistics.avg() == 0u, "avg");
+    })
+    .tests("average does not lose precision for small values", [] () {
+      iot_core::TimingStatistics<10> statistics;
+      for (int i = 0; i < 10; ++i) {
+        statistics.add(9u);
+      }
+      yatest::expect(statistics.avg() == 9u, std::to_string(statistics.avg()).c_str());
+    })
+    .tests("EWMA converges to constant value", [] () {
+      iot_core::TimingStatistics<10> statistics;
+      statistics.add(0u);
+      for (int i = 0; i < 200; ++i) {
+        statistics.add(1000u);
+      }
+      yatest::expect(statistics.ewma() >= 992u && statistics.ewma() <= 1000u, std::to_string(statistics.ewma()).c_str());
+    })
+    .tests("matches reference implementation for random samples", [] () {
+      for (unsigned int seed = 1u; seed <= 20u; ++seed) {
+        compareWithReference<10>(seed, 1000u, 200u);
+        compareWithReference<1>(seed, 1000000u, 20u);
+        compareWithReference<20>(seed, 50u, 300u);
+      }
+    })
+    .tests("measures with the given clock across wrap-around", [] () {
+      iot_core::TimingStatistics<10, ManualClock> statistics;
+      ManualClock::ticks = 0xFFFFFFF0u;
+      statistics.start();
+      ManualClock::ticks = 0x10u;
+      statistics.stop();
+      yatest::expect(statistics.max() == 0x20u, std::to_string(statistics.max()).c_str());
+    })
+    .tests("cycle clock measures in nanoseconds", [] () {
+      auto start = std::chrono::steady_clock::now();
+      uint32_t startTicks = iot_core::CycleClock::now();
+      while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(2)) {}
+      uint32_t elapsedNs = iot_core::CycleClock::since(startTicks);
+      yatest::expect(elapsedNs >= 1000000u && elapsedNs < 100000000u, std::to_string(elapsedNs).c_str());
+    })
+    .tests("matches reference implementation for monotonic samples", [] () {
+      iot_core::TimingStatistics<5> statistics;
+      ReferenceStatistics<5> reference;
+      for (unsigned long value = 100u; value > 0u; --value) {
+        statistics.add(value);
+        reference.add(value);
+        yatest::expect(statistics.min() == reference.min() && statistics.max() == reference.max(), std::to_string(value).c_str());
+      }
+    })
+    .tests("variance is updated beyond the float precision", [] () {
+      iot_core::TimingStatistics<5> statistics;
+      for (uint32_t i = 0u; i < (1u << 25u); ++i) {
+        statistics.add(1000u + (i % 2u) * 2u);
+      }
+      yatest::expect(std::fabs(statistics.variance() - 1.0f) < 1e-3f, std::to_string(statistics.variance()).c_str());
+    });
+}